@@ -0,0 +1,46 @@
+#pragma once
+
+#include "core/concurrency/task.h"
+
+namespace kw {
+
+class TaskScheduler;
+
+// Task that runs `run(begin, end)` for subranges of [0, count) on worker threads. The range is split in halves
+// recursively: each split enqueues the right half as a new task and keeps the left half, until the range is not larger
+// than grain size. Idle worker threads steal the largest halves and split them further. The given end task runs
+// after every subrange has completed, so tasks that need results of this parallel for must depend on the end task.
+//
+// Unlike creating one task per element, this costs one allocation and one dependency per subrange.
+class ParallelForTask : public Task {
+public:
+    // When `grain_size` is 0, it's computed from the number of elements and the number of threads.
+    ParallelForTask(TaskScheduler& task_scheduler, MemoryResource& transient_memory_resource,
+                    Task* end_task, size_t count, size_t grain_size = 0);
+
+    // Splits the range and runs the first subrange. Must not be overriden.
+    void run() final;
+
+    // Must be overriden by the user. Called concurrently for non-overlapping subranges.
+    virtual void run(size_t begin, size_t end) = 0;
+
+protected:
+    // Park the running subrange until the given tasks have completed, then call `run(begin, end)` again for the same
+    // subrange. Must only be called from `run(begin, end)`, which must return right after. Other subranges are not
+    // affected, and the end task doesn't run until every suspended subrange has completed.
+    void suspend(MemoryResource& transient_memory_resource, std::initializer_list<Task*> input_dependencies);
+
+private:
+    class ChunkTask;
+
+    // Shrinks `end` to the first subrange, so a suspended task doesn't split its range again when it runs again.
+    void run_chunk(size_t begin, size_t& end);
+
+    TaskScheduler& m_task_scheduler;
+    MemoryResource& m_transient_memory_resource;
+    Task* m_end_task;
+    size_t m_count;
+    size_t m_grain_size;
+};
+
+} // namespace kw
@@ -8,6 +8,17 @@ namespace kw {
 class MemoryResource;
 class TaskNode;
 
+// Worker threads always prefer ready tasks of higher priority.
+enum class TaskPriority : uint8_t {
+    // Tasks that gate frame presentation.
+    CRITICAL,
+    NORMAL,
+    // Long-latency work like streaming that may be delayed in favor of anything else.
+    BACKGROUND,
+};
+
+constexpr size_t TASK_PRIORITY_COUNT = 3;
+
 class Task {
 public:
     Task();
@@ -32,10 +43,40 @@ public:
     // Could be overriden by the user.
     virtual const char* get_name() const;
 
+    // Must be set before this task is enqueued. Normal by default. When a task becomes ready, it runs with the highest
+    // priority among itself and all tasks that transitively depend on it, so work on the critical path of
+    // a frame-critical task is never delayed in favor of normal or background tasks.
+    TaskPriority get_priority() const;
+    void set_priority(TaskPriority priority);
+
+    // Whether tasks this one transitively depends on inherit its priority. True by default. Frame synchronization tasks
+    // that depend on streaming must disable it, otherwise streaming inherits their priority.
+    bool is_priority_inherited() const;
+    void set_priority_inherited(bool value);
+
+protected:
+    // Park this task until the given tasks have completed, then call `run` again from the start. Must only be called
+    // from `run`, which must return right after. The worker thread runs other tasks in the meantime instead of blocking,
+    // and output dependencies of this task don't run until `run` returns without suspending. `run` must keep its own
+    // state to know where to continue. To wait for a counter, suspend on a no-op task that depends on its producers.
+    void suspend(MemoryResource& transient_memory_resource, Task* const* input_dependencies, size_t input_dependency_count);
+
+    // Shortcut for the previous method.
+    void suspend(MemoryResource& transient_memory_resource, std::initializer_list<Task*> input_dependencies);
+
 private:
     std::atomic<TaskNode*> m_output_dependencies;
     std::atomic<uint32_t> m_input_dependency_count;
 
+    TaskPriority m_priority;
+    bool m_is_priority_inherited;
+
+    // Set by `suspend` and consumed by the task scheduler to enqueue this task again after `run` returns.
+    MemoryResource* m_suspend_memory_resource;
+
+    // Set by the task scheduler when this task becomes ready, used to measure how long it waits for a worker thread.
+    uint64_t m_ready_timestamp;
+
     friend class TaskScheduler;
 };
 
@@ -1,5 +1,11 @@
 #pragma once
 
+#include "core/concurrency/spinlock.h"
+#include "core/concurrency/task.h"
+#include "core/containers/pair.h"
+#include "core/containers/queue.h"
+#include "core/containers/shared_ptr.h"
+#include "core/containers/unique_ptr.h"
 #include "core/containers/vector.h"
 
 #include <atomic>
@@ -9,33 +15,179 @@
 
 namespace kw {
 
-class Task;
+class TaskDeque;
 class TaskNode;
 
+// Returned from `TaskScheduler::enqueue_background_task`. Can be polled from any thread, even after the scheduler has
+// been destroyed.
+class BackgroundTaskHandle {
+public:
+    BackgroundTaskHandle() = default;
+
+    // Empty handle is considered completed.
+    bool is_completed() const;
+
+    // Block the current thread until the task has completed. Must not be called from background threads.
+    void wait() const;
+
+private:
+    struct State {
+        std::atomic<bool> is_completed;
+        std::mutex mutex;
+        std::condition_variable condition_variable;
+    };
+
+    explicit BackgroundTaskHandle(SharedPtr<State> state);
+
+    static void complete(State& state);
+
+    SharedPtr<State> m_state;
+
+    friend class TaskScheduler;
+};
+
+// Each worker thread (and the thread that calls `join`) owns a work stealing deque per task priority. Tasks enqueued
+// or released from a worker thread go to its own deque, idle worker threads steal tasks from other deques. Tasks
+// enqueued from any other thread go to the global ready stack of their priority. Higher priority tasks are always
+// acquired first.
+//
+// Background tasks run on a separate set of threads in FIFO order and `join` doesn't wait for them, so they may span
+// multiple frames.
 class TaskScheduler {
 public:
-    TaskScheduler(MemoryResource& persistent_memory_resource, size_t thread_count);
+    // All durations are in nanoseconds.
+    struct ThreadStatistics {
+        // Time spent running tasks.
+        uint64_t busy_time;
+
+        // Time spent looking for tasks to run. For the thread that calls `join` this also includes the time outside
+        // of `join`.
+        uint64_t idle_time;
+
+        // Time spent waiting for new tasks on condition variable.
+        uint64_t sleep_time;
+
+        uint64_t task_count;
+        uint64_t steal_count;
+        uint64_t wake_up_count;
+    };
+
+    // A frame is the time between two consecutive `join` returns. Background tasks are not accounted.
+    struct Statistics {
+        uint64_t frame_duration;
+
+        // Time between a task becoming ready and starting running on some thread.
+        uint64_t total_task_latency;
+        uint64_t max_task_latency;
+
+        uint64_t task_count;
+
+        // Highest number of ready and running tasks at once.
+        size_t max_pending_task_count;
+
+        // Worker threads first, the thread that calls `join` last.
+        Vector<ThreadStatistics> threads;
+    };
+
+    TaskScheduler(MemoryResource& persistent_memory_resource, size_t thread_count, size_t background_thread_count = 0);
     ~TaskScheduler();
 
     // Start running the given task when all its dependencies have completed.
     void enqueue_task(MemoryResource& transient_memory_resource, Task* task);
 
+    // Start running the given task on a background thread. The task must not have any dependencies and must outlive its
+    // execution, so it can't be allocated from transient memory resource. The task must not enqueue regular tasks.
+    // Background tasks that haven't started by the time the scheduler is destroyed are discarded.
+    BackgroundTaskHandle enqueue_background_task(Task* task);
+
     // Help worker threads running tasks. Return when there's no tasks left and all worker threads have completed.
     void join();
 
+    // The number of worker threads plus the thread that calls `join`.
+    size_t get_thread_count() const;
+
+    // Statistics of the last frame. Must not be called concurrently with `join`.
+    const Statistics& get_statistics() const;
+
 private:
+    // Counters of the current frame. Atomic counters are only incremented by the owner thread. The other counters
+    // are protected with `m_mutex`.
+    struct alignas(64) ThreadCounters {
+        std::atomic<uint64_t> busy_time;
+        std::atomic<uint64_t> task_count;
+        std::atomic<uint64_t> steal_count;
+        std::atomic<uint64_t> total_task_latency;
+        std::atomic<uint64_t> max_task_latency;
+
+        // Zero when the thread is not sleeping.
+        uint64_t sleep_begin_timestamp;
+        uint64_t sleep_time;
+        uint64_t wake_up_count;
+    };
+
     void worker_thread(size_t thread_index);
+    void background_thread(size_t thread_index);
     void run_task(Task* task);
 
+    // Must be called for every task that becomes ready, right before it's pushed to a deque or the ready stack.
+    void register_ready_task(Task* task);
+
+    // Move current frame counters to statistics.
+    void update_statistics();
+
+    // Push ready task to the current thread's deque. Return false if the current thread doesn't own a deque or it's
+    // full.
+    bool push_local_task(Task* task, TaskPriority priority);
+
+    // Push ready task to the global ready stack.
+    void push_global_task(TaskNode* task_node, TaskPriority priority);
+
+    // Highest priority among the given task and its transitive output dependencies. Computed when the task becomes
+    // ready, so output dependencies added before that are always accounted.
+    TaskPriority compute_effective_priority(Task* task);
+
+    // For each priority from the highest: pop from own deque, then from the global ready stack, then steal from other
+    // deques.
+    Task* acquire_task(size_t thread_index);
+
+    // Wake up a sleeping thread, if any, after a new task became ready.
+    void notify_task();
+
+    // Block until a task is available or, when `is_joining` is true, until there's no ready or running tasks left.
+    Task* wait_for_task(size_t thread_index, bool is_joining);
+
+    MemoryResource& m_persistent_memory_resource;
+
+    // `TASK_PRIORITY_COUNT` deques per thread. The last ones are owned by the thread that calls `join`.
+    Vector<UniquePtr<TaskDeque>> m_task_deques;
+
+    Spinlock m_ready_tasks_spinlock;
+    TaskNode* m_ready_tasks[TASK_PRIORITY_COUNT];
+
+    // The number of ready tasks and tasks that are currently running.
+    std::atomic<size_t> m_pending_tasks;
+
+    // Mutex and condition variable are only used to put idle threads to sleep.
     std::mutex m_mutex;
-    TaskNode* m_ready_tasks;
-    size_t m_busy_threads;
     std::condition_variable m_ready_task_condition_variable;
-    std::condition_variable m_busy_thread_condition_variable;
+    std::atomic<size_t> m_sleeping_threads;
 
     std::atomic<bool> m_is_running;
 
     Vector<std::thread> m_threads;
+
+    // One per thread, including the thread that calls `join`.
+    UniquePtr<ThreadCounters[]> m_thread_counters;
+    std::atomic<size_t> m_max_pending_tasks;
+    uint64_t m_frame_begin_timestamp;
+    Statistics m_statistics;
+
+    // Background lane doesn't share anything with regular tasks, so it has its own mutex and condition variable.
+    Queue<Pair<Task*, SharedPtr<BackgroundTaskHandle::State>>> m_background_tasks;
+    std::mutex m_background_mutex;
+    std::condition_variable m_background_task_condition_variable;
+
+    Vector<std::thread> m_background_threads;
 };
 
 } // namespace kw
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "core/concurrency/spinlock.h"
+
+#include <shared_mutex>
+
+namespace kw {
+
+class MemoryResource;
+class Task;
+class TaskScheduler;
+
+// Shared mutex whose readers are tasks that park instead of blocking their worker thread while a writer holds the
+// lock. Writers block as usual, they're expected to be short and rare compared to readers. Writers must be tasks or
+// the thread that calls `TaskScheduler::join`, otherwise `join` may return while some readers are still parked.
+class TaskSharedMutex {
+public:
+    explicit TaskSharedMutex(TaskScheduler& task_scheduler);
+
+    void lock();
+    void unlock();
+
+    // Returns null when the shared lock is acquired. Otherwise returns a task that completes when the current writer
+    // releases the lock. The calling task must suspend on it and try again when it runs again.
+    Task* try_lock_shared(MemoryResource& transient_memory_resource);
+
+    void unlock_shared();
+
+private:
+    TaskScheduler& m_task_scheduler;
+
+    std::shared_mutex m_mutex;
+
+    // Protects the members below. Writers release `m_mutex` under this spinlock, so a reader that fails to acquire
+    // the shared lock while a writer is registered can't miss its unlock.
+    Spinlock m_spinlock;
+    size_t m_writer_count;
+    Task* m_unlock_task;
+    MemoryResource* m_unlock_task_memory_resource;
+};
+
+} // namespace kw
@@ -3,19 +3,28 @@
 #include "core/containers/vector.h"
 
 #include <atomic>
+#include <mutex>
 
 namespace kw {
 
+// Each thread records scopes to its own ring buffer, so recording never contends with other threads. Timestamps are
+// recorded in CPU ticks and converted to nanoseconds when scopes are read. Scope names are interned, an entry stores
+// only a 32-bit scope id. Buffers of all threads are merged when scopes are read.
 class CpuProfiler {
 public:
-    class Counter {
+    class ScopeRecorder {
     public:
-        explicit Counter(const char* name);
-        ~Counter();
+        // Scope id must be obtained from `intern_scope`.
+        explicit ScopeRecorder(uint32_t scope_id);
+
+        // Slower than the constructor above, looks up scope id in a per-thread cache.
+        explicit ScopeRecorder(const char* name);
+
+        ~ScopeRecorder();
 
     private:
-        const char* m_scope_name;
-        uint64_t m_begin_timestamp;
+        uint32_t m_scope_id;
+        uint64_t m_begin_tick;
     };
 
     struct Scope {
@@ -27,6 +36,19 @@ public:
 
     static CpuProfiler& instance();
 
+    // Timestamps of scopes are in nanoseconds.
+    static uint64_t get_timestamp();
+
+    // Scopes with equal names get equal ids. The name is copied. Thread-safe.
+    uint32_t intern_scope(const char* name);
+
+    // Counters accumulate values added during a frame, e.g. draw call count or uploaded bytes. Counters with equal
+    // names get equal ids. The name is copied. Thread-safe.
+    uint32_t intern_counter(const char* name);
+
+    // Thread-safe and doesn't contend with other threads.
+    void add_counter_value(uint32_t counter_id, int64_t value);
+
     // Must be called after frame execution.
     void update();
 
@@ -35,18 +57,59 @@ public:
 
     size_t get_frame_count() const;
 
+    // Incremented by every `update` that's not paused.
+    uint64_t get_frame_index() const;
+
     // `relative_frame = 0` is current frame. `relative_frame = -1` is previous frame. And so on.
     Vector<Scope> get_scopes(MemoryResource& memory_resource, size_t relative_frame = 0) const;
 
+    // Unlike `get_scopes`, scopes are appended grouped by thread and not sorted.
+    void append_scopes(Vector<Scope>& output, size_t relative_frame = 0) const;
+    size_t get_scope_count(size_t relative_frame = 0) const;
+
+    size_t get_counter_count() const;
+    const char* get_counter_name(uint32_t counter_id) const;
+
+    // Sum of values added to the given counter during the given frame.
+    int64_t get_counter_value(uint32_t counter_id, size_t relative_frame = 0) const;
+
 private:
+    struct ThreadBuffer;
+
     CpuProfiler();
 
-    Vector<Scope> m_scopes;
-    std::atomic_size_t m_current_scope;
+    ThreadBuffer& get_thread_buffer();
+    uint32_t intern(Vector<const char*>& names, const char* name);
 
-    Vector<size_t> m_frames;
+    // Range of entries of the given thread buffer recorded during the given frame.
+    void get_entry_range(size_t thread_index, size_t relative_frame, uint64_t& begin, uint64_t& end) const;
+
+    uint64_t to_timestamp(uint64_t tick) const;
+
+    // Thread buffers are never destroyed, so threads that exit can still be shown.
+    Vector<ThreadBuffer*> m_thread_buffers;
+
+    Vector<const char*> m_scope_names;
+    Vector<const char*> m_counter_names;
+
+    // Protects thread buffer registration and interning.
+    mutable std::mutex m_mutex;
+
+    // Write index of each thread buffer at the end of each frame, `FRAME_COUNT` rows of `MAX_THREAD_COUNT` entries.
+    Vector<uint64_t> m_frames;
     size_t m_current_frame;
 
+    // Sums of all values added to each counter since startup, at the end of the previous frame.
+    Vector<int64_t> m_counter_totals;
+
+    // Values of each counter during each frame, `FRAME_COUNT` rows of `MAX_COUNTER_COUNT` entries.
+    Vector<int64_t> m_counter_values;
+
+    // Ticks are converted to nanoseconds relative to the calibration point. Ratio is refined on every update.
+    uint64_t m_calibration_tick;
+    uint64_t m_calibration_timestamp;
+    double m_nanoseconds_per_tick;
+
     bool m_is_paused;
 
     bool m_is_pause_scheduled;
@@ -58,7 +121,21 @@ private:
 #ifndef KW_CPU_PROFILER_DISABLE
 #define KW_CONCAT_IMPL(x, y) x##y
 #define KW_CONCAT(x, y) KW_CONCAT_IMPL(x, y)
-#define KW_CPU_PROFILER(name) CpuProfiler::Counter KW_CONCAT(__CPU_PROFILER_COUNTER_, __COUNTER__ )(name)
+
+// The name must be the same every time this line is executed. Use `KW_CPU_PROFILER_DYNAMIC` otherwise.
+#define KW_CPU_PROFILER(name)                                                                                                 \
+    static const uint32_t KW_CONCAT(__CPU_PROFILER_SCOPE_ID_, __LINE__) = CpuProfiler::instance().intern_scope(name);         \
+    CpuProfiler::ScopeRecorder KW_CONCAT(__CPU_PROFILER_SCOPE_, __LINE__)(KW_CONCAT(__CPU_PROFILER_SCOPE_ID_, __LINE__))
+
+#define KW_CPU_PROFILER_DYNAMIC(name) CpuProfiler::ScopeRecorder KW_CONCAT(__CPU_PROFILER_SCOPE_, __LINE__)(name)
+
+#define KW_CPU_PROFILER_COUNTER(name, value)                                                                                  \
+do {                                                                                                                          \
+    static const uint32_t counter_id = CpuProfiler::instance().intern_counter(name);                                          \
+    CpuProfiler::instance().add_counter_value(counter_id, static_cast<int64_t>(value));                                       \
+} while (false)
 #else
 #define KW_CPU_PROFILER(name) ((void)0)
+#define KW_CPU_PROFILER_DYNAMIC(name) ((void)0)
+#define KW_CPU_PROFILER_COUNTER(name, value) ((void)0)
 #endif // KW_CPU_PROFILER_DISABLE
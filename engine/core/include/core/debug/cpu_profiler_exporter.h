@@ -0,0 +1,125 @@
+#pragma once
+
+#include "core/containers/vector.h"
+#include "core/debug/cpu_profiler.h"
+#include "core/io/binary_writer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace kw {
+
+struct CpuProfilerExporterDescriptor {
+    // Maximum size in bytes of scopes that are recorded but not yet written. When the writer thread falls behind,
+    // scopes of the frames that don't fit are dropped.
+    size_t memory_budget;
+
+    MemoryResource* persistent_memory_resource;
+};
+
+// Streams `CpuProfiler` scopes to a Chrome trace JSON file, which can be opened in `chrome://tracing` or Perfetto UI.
+// Each scope becomes a complete event on its thread's track, nesting is inferred from timestamps. Frames are marked
+// with global instant events, counter values are written once per frame. Formatting and file IO are done on
+// a background writer thread, so a capture may span any number of frames. Doesn't depend on render or ImGui, so it can
+// be used in headless benchmarks.
+class CpuProfilerExporter {
+public:
+    explicit CpuProfilerExporter(const CpuProfilerExporterDescriptor& descriptor);
+    ~CpuProfilerExporter();
+
+    // Start writing the scopes of the next `frame_count` frames to the given file. Waits for the previous capture to be
+    // written. Return false if a capture is already running or the file can't be opened.
+    bool begin_capture(const char* path, uint64_t frame_count = UINT64_MAX);
+
+    // Stop capturing. The rest of the file is written asynchronously.
+    void end_capture();
+
+    bool is_capturing() const;
+
+    // The number of scopes dropped because of the memory budget in the current or the last capture.
+    uint64_t get_dropped_scope_count() const;
+
+    // Must be called every frame after `CpuProfiler::update`.
+    void update();
+
+private:
+    struct Event {
+        const char* scope_name;
+        uint32_t thread_id;
+        uint64_t begin_timestamp;
+        uint64_t end_timestamp;
+    };
+
+    struct ThreadName {
+        uint32_t thread_id;
+        const char* name;
+    };
+
+    struct FrameMarker {
+        uint64_t frame_index;
+        uint64_t timestamp;
+    };
+
+    struct CounterSample {
+        const char* counter_name;
+        int64_t value;
+        uint64_t timestamp;
+    };
+
+    // Pending data of the writer thread, swapped between the recording side and the writing side.
+    struct Batch {
+        explicit Batch(MemoryResource& memory_resource);
+
+        Vector<Event> events;
+        Vector<ThreadName> thread_names;
+        Vector<FrameMarker> frame_markers;
+        Vector<CounterSample> counter_samples;
+    };
+
+    void writer_thread();
+    void write_batch(const Batch& batch, uint64_t base_timestamp);
+
+    // Write a comma unless it's the first event of the capture.
+    void begin_event();
+
+    // Write a string escaping JSON special characters.
+    void write_string(const char* string);
+    void write_format(const char* format, ...);
+    void flush_buffer();
+
+    uint32_t get_thread_id(const char* thread_name);
+
+    MemoryResource& m_persistent_memory_resource;
+
+    // Recording side, accessed only from the thread that calls `update`.
+    Vector<CpuProfiler::Scope> m_scopes;
+    Vector<const char*> m_thread_names;
+    uint64_t m_last_frame_index;
+    uint64_t m_remaining_frame_count;
+    bool m_is_capturing;
+
+    // Writing side, accessed only from the writer thread.
+    Batch m_written_batch;
+    BinaryWriter m_writer;
+    Vector<char> m_buffer;
+    size_t m_buffer_size;
+    bool m_is_first_event;
+
+    // Protected by `m_mutex`.
+    Batch m_pending_batch;
+    uint64_t m_base_timestamp;
+    bool m_is_finish_requested;
+    bool m_is_destroy_requested;
+
+    std::mutex m_mutex;
+    std::condition_variable m_writer_condition_variable;
+    std::condition_variable m_finish_condition_variable;
+
+    std::atomic<uint64_t> m_dropped_scope_count;
+
+    std::thread m_thread;
+};
+
+} // namespace kw
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/math/float3.h"
+#include "core/math/simd.h"
 
 namespace kw {
 
@@ -185,6 +186,12 @@ public:
 };
 
 constexpr float dot(const float4& lhs, const float4& rhs) {
+#ifdef KW_SIMD
+    if (!KW_IS_CONSTANT_EVALUATED()) {
+        return simd::get_x(simd::dot4(simd::load(lhs.data), simd::load(rhs.data)));
+    }
+#endif // KW_SIMD
+
     return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w;
 }
 
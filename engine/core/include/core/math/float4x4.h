@@ -2,6 +2,7 @@
 
 #include "core/math/float3x3.h"
 #include "core/math/float4.h"
+#include "core/math/simd.h"
 
 namespace kw {
 
@@ -99,6 +100,14 @@ public:
     }
 
     constexpr float4x4 operator*(const float4x4& rhs) const {
+#ifdef KW_SIMD
+        if (!KW_IS_CONSTANT_EVALUATED()) {
+            float4x4 result;
+            simd::store4x4(result.cells, simd::mul(simd::load4x4(cells), simd::load4x4(rhs.cells)));
+            return result;
+        }
+#endif // KW_SIMD
+
         return float4x4(_11 * rhs._11 + _12 * rhs._21 + _13 * rhs._31 + _14 * rhs._41,
                         _11 * rhs._12 + _12 * rhs._22 + _13 * rhs._32 + _14 * rhs._42,
                         _11 * rhs._13 + _12 * rhs._23 + _13 * rhs._33 + _14 * rhs._43,
@@ -160,6 +169,13 @@ public:
     }
 
     constexpr float4x4& operator*=(const float4x4& value) {
+#ifdef KW_SIMD
+        if (!KW_IS_CONSTANT_EVALUATED()) {
+            simd::store4x4(cells, simd::mul(simd::load4x4(cells), simd::load4x4(value.cells)));
+            return *this;
+        }
+#endif // KW_SIMD
+
         float4x4 temp(
             _11 * value._11 + _12 * value._21 + _13 * value._31 + _14 * value._41,
             _11 * value._12 + _12 * value._22 + _13 * value._32 + _14 * value._42,
@@ -326,6 +342,14 @@ public:
 };
 
 constexpr float4x4 transpose(const float4x4& value) {
+#ifdef KW_SIMD
+    if (!KW_IS_CONSTANT_EVALUATED()) {
+        float4x4 result;
+        simd::store4x4(result.cells, simd::transpose(simd::load4x4(value.cells)));
+        return result;
+    }
+#endif // KW_SIMD
+
     return float4x4(value._11, value._21, value._31, value._41,
                     value._12, value._22, value._32, value._42,
                     value._13, value._23, value._33, value._43,
@@ -355,6 +379,20 @@ constexpr float3 normal_transform(const float3& normal, const float4x4& inverse_
 }
 
 constexpr float4x4 inverse(const float4x4& value) {
+#ifdef KW_SIMD
+    if (!KW_IS_CONSTANT_EVALUATED()) {
+        float determinant = 0.f;
+        simd::vfloat4x4 rows = simd::inverse(simd::load4x4(value.cells), determinant);
+        if (equal(determinant, 0.f)) {
+            return float4x4();
+        }
+
+        float4x4 result;
+        simd::store4x4(result.cells, rows);
+        return result;
+    }
+#endif // KW_SIMD
+
     float _1 = value._33  * value._44;
     float _2 = value._43  * value._34;
     float _3 = value._23  * value._44;
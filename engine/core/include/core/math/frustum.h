@@ -112,4 +112,21 @@ constexpr bool intersect(const aabbox& box, const frustum& frustum) {
     return true;
 }
 
+// Return whether the box is fully inside the frustum.
+constexpr bool inside(const aabbox& box, const frustum& frustum) {
+    for (const plane& plane : frustum.data) {
+        if (dot(box.center, plane.normal) + plane.distance < dot(box.extent, abs(plane.normal))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same as `intersect(const aabbox&, const frustum&)` for `count` boxes stored as structure of arrays. Bit `i % 64` of
+// `intersect_mask[i / 64]` is set when box `i` intersects the frustum. Optional `inside_mask` is filled the same way
+// for boxes that are fully inside the frustum. Both masks must have at least `(count + 63) / 64` elements.
+void intersect(const float* center_x, const float* center_y, const float* center_z,
+               const float* extent_x, const float* extent_y, const float* extent_z,
+               size_t count, const frustum& frustum, uint64_t* intersect_mask, uint64_t* inside_mask = nullptr);
+
 } // namespace kw
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/math/float4.h"
+#include "core/math/simd.h"
 
 namespace kw {
 
@@ -170,6 +171,28 @@ inline quaternion slerp(const quaternion& from, quaternion to, float factor) {
         to = -to;
     }
     
+#ifdef KW_SIMD
+    simd::vfloat4 from_ = simd::load(from.data);
+    simd::vfloat4 to_ = simd::load(to.data);
+    simd::vfloat4 blend;
+
+    if (cos_a > 0.995f) {
+        blend = simd::madd(simd::sub(to_, from_), simd::splat(factor), from_);
+    } else {
+        factor = factor * 0.5f;
+
+        float a = std::acos(cos_a);
+        float b = 1.f / std::sin(a);
+        float c = std::sin((1 - factor) * a) * b;
+        float d = std::sin(factor * a) * b;
+
+        blend = simd::madd(simd::splat(c), from_, simd::mul(simd::splat(d), to_));
+    }
+
+    quaternion result;
+    simd::store(result.data, simd::div(blend, simd::sqrt(simd::dot4(blend, blend))));
+    return result;
+#else
     if (cos_a > 0.995f) {
         return normalize(quaternion(lerp(float4(from), float4(to), factor)));
     }
@@ -187,6 +210,7 @@ inline quaternion slerp(const quaternion& from, quaternion to, float factor) {
         c * from.z + d * to.z,
         c * from.w + d * to.w
     ));
+#endif // KW_SIMD
 }
 
 constexpr bool equal(const quaternion& lhs, const quaternion& rhs, float epsilon = EPSILON) {
@@ -0,0 +1,385 @@
+#pragma once
+
+// SIMD backend for the math types. SSE is used on x86 (with FMA when compiled with AVX2), NEON is used on ARM64.
+// Define `KW_MATH_SCALAR` to compile math types without any SIMD code. The scalar code path is always used in
+// constant expressions, because intrinsics are not constexpr.
+
+#if !defined(KW_MATH_SCALAR) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KW_SIMD_SSE
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define KW_SIMD_NEON
+#endif
+#endif
+
+#if defined(KW_SIMD_SSE) || defined(KW_SIMD_NEON)
+#define KW_SIMD
+#define KW_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+#if defined(KW_SIMD_SSE)
+#include <immintrin.h>
+#elif defined(KW_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifdef KW_SIMD
+
+namespace kw::simd {
+
+#if defined(KW_SIMD_SSE)
+
+using vfloat4 = __m128;
+
+inline vfloat4 load(const float* data) {
+    return _mm_loadu_ps(data);
+}
+
+inline vfloat4 load3(const float* data) {
+    return _mm_setr_ps(data[0], data[1], data[2], 0.f);
+}
+
+inline void store(float* data, vfloat4 value) {
+    _mm_storeu_ps(data, value);
+}
+
+inline void store3(float* data, vfloat4 value) {
+    _mm_store_sd(reinterpret_cast<double*>(data), _mm_castps_pd(value));
+    _mm_store_ss(data + 2, _mm_movehl_ps(value, value));
+}
+
+inline vfloat4 set(float x, float y, float z, float w) {
+    return _mm_setr_ps(x, y, z, w);
+}
+
+inline vfloat4 splat(float value) {
+    return _mm_set1_ps(value);
+}
+
+inline float get_x(vfloat4 value) {
+    return _mm_cvtss_f32(value);
+}
+
+// Return `(lhs[x], lhs[y], rhs[z], rhs[w])`.
+template <int x, int y, int z, int w>
+inline vfloat4 shuffle(vfloat4 lhs, vfloat4 rhs) {
+    return _mm_shuffle_ps(lhs, rhs, _MM_SHUFFLE(w, z, y, x));
+}
+
+inline vfloat4 add(vfloat4 lhs, vfloat4 rhs) {
+    return _mm_add_ps(lhs, rhs);
+}
+
+inline vfloat4 sub(vfloat4 lhs, vfloat4 rhs) {
+    return _mm_sub_ps(lhs, rhs);
+}
+
+inline vfloat4 mul(vfloat4 lhs, vfloat4 rhs) {
+    return _mm_mul_ps(lhs, rhs);
+}
+
+inline vfloat4 div(vfloat4 lhs, vfloat4 rhs) {
+    return _mm_div_ps(lhs, rhs);
+}
+
+// Return `a * b + c`.
+inline vfloat4 madd(vfloat4 a, vfloat4 b, vfloat4 c) {
+#ifdef __AVX2__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+// Return `c - a * b`.
+inline vfloat4 nmadd(vfloat4 a, vfloat4 b, vfloat4 c) {
+#ifdef __AVX2__
+    return _mm_fnmadd_ps(a, b, c);
+#else
+    return _mm_sub_ps(c, _mm_mul_ps(a, b));
+#endif
+}
+
+inline vfloat4 min(vfloat4 lhs, vfloat4 rhs) {
+    return _mm_min_ps(lhs, rhs);
+}
+
+inline vfloat4 max(vfloat4 lhs, vfloat4 rhs) {
+    return _mm_max_ps(lhs, rhs);
+}
+
+inline vfloat4 abs(vfloat4 value) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.f), value);
+}
+
+inline vfloat4 sqrt(vfloat4 value) {
+    return _mm_sqrt_ps(value);
+}
+
+// Return all bits set in components where `lhs < rhs`, zero otherwise.
+inline vfloat4 less(vfloat4 lhs, vfloat4 rhs) {
+    return _mm_cmplt_ps(lhs, rhs);
+}
+
+// Return the highest bit of each component packed into the lower 4 bits.
+inline int movemask(vfloat4 value) {
+    return _mm_movemask_ps(value);
+}
+
+// Return `lhs` in components where all bits of `mask` are set, `rhs` where none are.
+inline vfloat4 select(vfloat4 mask, vfloat4 lhs, vfloat4 rhs) {
+    return _mm_or_ps(_mm_and_ps(mask, lhs), _mm_andnot_ps(mask, rhs));
+}
+
+#elif defined(KW_SIMD_NEON)
+
+using vfloat4 = float32x4_t;
+
+inline vfloat4 load(const float* data) {
+    return vld1q_f32(data);
+}
+
+inline vfloat4 load3(const float* data) {
+    return vsetq_lane_f32(data[2], vcombine_f32(vld1_f32(data), vdup_n_f32(0.f)), 2);
+}
+
+inline void store(float* data, vfloat4 value) {
+    vst1q_f32(data, value);
+}
+
+inline void store3(float* data, vfloat4 value) {
+    vst1_f32(data, vget_low_f32(value));
+    vst1q_lane_f32(data + 2, value, 2);
+}
+
+inline vfloat4 set(float x, float y, float z, float w) {
+    float data[4] = { x, y, z, w };
+    return vld1q_f32(data);
+}
+
+inline vfloat4 splat(float value) {
+    return vdupq_n_f32(value);
+}
+
+inline float get_x(vfloat4 value) {
+    return vgetq_lane_f32(value, 0);
+}
+
+// Return `(lhs[x], lhs[y], rhs[z], rhs[w])`.
+template <int x, int y, int z, int w>
+inline vfloat4 shuffle(vfloat4 lhs, vfloat4 rhs) {
+    vfloat4 result = vmovq_n_f32(vgetq_lane_f32(lhs, x));
+    result = vsetq_lane_f32(vgetq_lane_f32(lhs, y), result, 1);
+    result = vsetq_lane_f32(vgetq_lane_f32(rhs, z), result, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(rhs, w), result, 3);
+}
+
+inline vfloat4 add(vfloat4 lhs, vfloat4 rhs) {
+    return vaddq_f32(lhs, rhs);
+}
+
+inline vfloat4 sub(vfloat4 lhs, vfloat4 rhs) {
+    return vsubq_f32(lhs, rhs);
+}
+
+inline vfloat4 mul(vfloat4 lhs, vfloat4 rhs) {
+    return vmulq_f32(lhs, rhs);
+}
+
+inline vfloat4 div(vfloat4 lhs, vfloat4 rhs) {
+    return vdivq_f32(lhs, rhs);
+}
+
+// Return `a * b + c`.
+inline vfloat4 madd(vfloat4 a, vfloat4 b, vfloat4 c) {
+    return vfmaq_f32(c, a, b);
+}
+
+// Return `c - a * b`.
+inline vfloat4 nmadd(vfloat4 a, vfloat4 b, vfloat4 c) {
+    return vfmsq_f32(c, a, b);
+}
+
+inline vfloat4 min(vfloat4 lhs, vfloat4 rhs) {
+    return vminq_f32(lhs, rhs);
+}
+
+inline vfloat4 max(vfloat4 lhs, vfloat4 rhs) {
+    return vmaxq_f32(lhs, rhs);
+}
+
+inline vfloat4 abs(vfloat4 value) {
+    return vabsq_f32(value);
+}
+
+inline vfloat4 sqrt(vfloat4 value) {
+    return vsqrtq_f32(value);
+}
+
+// Return all bits set in components where `lhs < rhs`, zero otherwise.
+inline vfloat4 less(vfloat4 lhs, vfloat4 rhs) {
+    return vreinterpretq_f32_u32(vcltq_f32(lhs, rhs));
+}
+
+// Return the highest bit of each component packed into the lower 4 bits.
+inline int movemask(vfloat4 value) {
+    static const int32_t shifts[4] = { 0, 1, 2, 3 };
+    uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(value), 31);
+    return static_cast<int>(vaddvq_u32(vshlq_u32(bits, vld1q_s32(shifts))));
+}
+
+// Return `lhs` in components where all bits of `mask` are set, `rhs` where none are.
+inline vfloat4 select(vfloat4 mask, vfloat4 lhs, vfloat4 rhs) {
+    return vbslq_f32(vreinterpretq_u32_f32(mask), lhs, rhs);
+}
+
+#endif
+
+// Return `(value[x], value[y], value[z], value[w])`.
+template <int x, int y, int z, int w>
+inline vfloat4 swizzle(vfloat4 value) {
+    return shuffle<x, y, z, w>(value, value);
+}
+
+// Return `value[i]` in all components.
+template <int i>
+inline vfloat4 broadcast(vfloat4 value) {
+    return shuffle<i, i, i, i>(value, value);
+}
+
+// Return dot product in all components.
+inline vfloat4 dot4(vfloat4 lhs, vfloat4 rhs) {
+    vfloat4 product = mul(lhs, rhs);
+    vfloat4 sum = add(product, swizzle<1, 0, 3, 2>(product));
+    return add(sum, swizzle<2, 3, 0, 1>(sum));
+}
+
+// Return cross product of xyz components. The w component is undefined.
+inline vfloat4 cross3(vfloat4 lhs, vfloat4 rhs) {
+    vfloat4 result = mul(lhs, swizzle<1, 2, 0, 3>(rhs));
+    result = nmadd(swizzle<1, 2, 0, 3>(lhs), rhs, result);
+    return swizzle<1, 2, 0, 3>(result);
+}
+
+// Row-major 4x4 matrix in four registers.
+struct vfloat4x4 {
+    vfloat4 rows[4];
+};
+
+inline vfloat4x4 load4x4(const float* data) {
+    return vfloat4x4{ { load(data), load(data + 4), load(data + 8), load(data + 12) } };
+}
+
+inline void store4x4(float* data, const vfloat4x4& value) {
+    store(data, value.rows[0]);
+    store(data + 4, value.rows[1]);
+    store(data + 8, value.rows[2]);
+    store(data + 12, value.rows[3]);
+}
+
+// Row vector by matrix multiplication.
+inline vfloat4 mul(vfloat4 lhs, const vfloat4x4& rhs) {
+    vfloat4 result = mul(broadcast<0>(lhs), rhs.rows[0]);
+    result = madd(broadcast<1>(lhs), rhs.rows[1], result);
+    result = madd(broadcast<2>(lhs), rhs.rows[2], result);
+    return madd(broadcast<3>(lhs), rhs.rows[3], result);
+}
+
+inline vfloat4x4 mul(const vfloat4x4& lhs, const vfloat4x4& rhs) {
+    return vfloat4x4{ { mul(lhs.rows[0], rhs), mul(lhs.rows[1], rhs), mul(lhs.rows[2], rhs), mul(lhs.rows[3], rhs) } };
+}
+
+inline vfloat4x4 transpose(const vfloat4x4& value) {
+    vfloat4 a = shuffle<0, 1, 0, 1>(value.rows[0], value.rows[1]);
+    vfloat4 b = shuffle<2, 3, 2, 3>(value.rows[0], value.rows[1]);
+    vfloat4 c = shuffle<0, 1, 0, 1>(value.rows[2], value.rows[3]);
+    vfloat4 d = shuffle<2, 3, 2, 3>(value.rows[2], value.rows[3]);
+
+    return vfloat4x4{ {
+        shuffle<0, 2, 0, 2>(a, c),
+        shuffle<1, 3, 1, 3>(a, c),
+        shuffle<0, 2, 0, 2>(b, d),
+        shuffle<1, 3, 1, 3>(b, d),
+    } };
+}
+
+// 2x2 matrices are stored in one register as `(_11, _12, _21, _22)`.
+inline vfloat4 mul2x2(vfloat4 lhs, vfloat4 rhs) {
+    return madd(lhs, swizzle<0, 3, 0, 3>(rhs), mul(swizzle<1, 0, 3, 2>(lhs), swizzle<2, 1, 2, 1>(rhs)));
+}
+
+// Return `adjugate(lhs) * rhs`.
+inline vfloat4 adjugate_mul2x2(vfloat4 lhs, vfloat4 rhs) {
+    return nmadd(swizzle<1, 1, 2, 2>(lhs), swizzle<2, 3, 0, 1>(rhs), mul(swizzle<3, 3, 0, 0>(lhs), rhs));
+}
+
+// Return `lhs * adjugate(rhs)`.
+inline vfloat4 mul_adjugate2x2(vfloat4 lhs, vfloat4 rhs) {
+    return nmadd(swizzle<1, 0, 3, 2>(lhs), swizzle<2, 1, 2, 1>(rhs), mul(lhs, swizzle<3, 0, 3, 0>(rhs)));
+}
+
+// Blockwise inversion of a general 4x4 matrix. The result is undefined when the determinant is zero.
+inline vfloat4x4 inverse(const vfloat4x4& value, float& determinant) {
+    vfloat4 a = shuffle<0, 1, 0, 1>(value.rows[0], value.rows[1]);
+    vfloat4 b = shuffle<2, 3, 2, 3>(value.rows[0], value.rows[1]);
+    vfloat4 c = shuffle<0, 1, 0, 1>(value.rows[2], value.rows[3]);
+    vfloat4 d = shuffle<2, 3, 2, 3>(value.rows[2], value.rows[3]);
+
+    // Determinants of `a`, `b`, `c` and `d`.
+    vfloat4 sub_determinants = nmadd(shuffle<1, 3, 1, 3>(value.rows[0], value.rows[2]), shuffle<0, 2, 0, 2>(value.rows[1], value.rows[3]),
+                                     mul(shuffle<0, 2, 0, 2>(value.rows[0], value.rows[2]), shuffle<1, 3, 1, 3>(value.rows[1], value.rows[3])));
+
+    vfloat4 determinant_a = broadcast<0>(sub_determinants);
+    vfloat4 determinant_b = broadcast<1>(sub_determinants);
+    vfloat4 determinant_c = broadcast<2>(sub_determinants);
+    vfloat4 determinant_d = broadcast<3>(sub_determinants);
+
+    vfloat4 d_c = adjugate_mul2x2(d, c);
+    vfloat4 a_b = adjugate_mul2x2(a, b);
+
+    vfloat4 x = sub(mul(determinant_d, a), mul2x2(b, d_c));
+    vfloat4 w = sub(mul(determinant_a, d), mul2x2(c, a_b));
+    vfloat4 y = sub(mul(determinant_b, c), mul_adjugate2x2(d, a_b));
+    vfloat4 z = sub(mul(determinant_c, b), mul_adjugate2x2(a, d_c));
+
+    vfloat4 trace = mul(a_b, swizzle<0, 2, 1, 3>(d_c));
+    trace = add(trace, swizzle<1, 0, 3, 2>(trace));
+    trace = add(trace, swizzle<2, 3, 0, 1>(trace));
+
+    vfloat4 determinant_m = sub(madd(determinant_b, determinant_c, mul(determinant_a, determinant_d)), trace);
+    determinant = get_x(determinant_m);
+
+    vfloat4 multiplier = div(set(1.f, -1.f, -1.f, 1.f), determinant_m);
+
+    x = mul(x, multiplier);
+    y = mul(y, multiplier);
+    z = mul(z, multiplier);
+    w = mul(w, multiplier);
+
+    return vfloat4x4{ {
+        shuffle<3, 1, 3, 1>(x, y),
+        shuffle<2, 0, 2, 0>(x, y),
+        shuffle<3, 1, 3, 1>(z, w),
+        shuffle<2, 0, 2, 0>(z, w),
+    } };
+}
+
+// Quaternions are stored as `(x, y, z, w)`. Same as `quaternion::operator*`.
+inline vfloat4 mul_quaternion(vfloat4 lhs, vfloat4 rhs) {
+    vfloat4 result = mul(broadcast<3>(lhs), rhs);
+    result = madd(mul(broadcast<0>(lhs), set(1.f, -1.f, 1.f, -1.f)), swizzle<3, 2, 1, 0>(rhs), result);
+    result = madd(mul(broadcast<1>(lhs), set(1.f, 1.f, -1.f, -1.f)), swizzle<2, 3, 0, 1>(rhs), result);
+    return madd(mul(broadcast<2>(lhs), set(-1.f, 1.f, 1.f, -1.f)), swizzle<1, 0, 3, 2>(rhs), result);
+}
+
+// Rotate xyz components of the given vector by the given quaternion. The w component is undefined.
+inline vfloat4 rotate(vfloat4 vector, vfloat4 quaternion) {
+    vfloat4 b = cross3(quaternion, vector);
+    vfloat4 c = cross3(quaternion, b);
+    vfloat4 d = madd(b, broadcast<3>(quaternion), c);
+    return madd(d, splat(2.f), vector);
+}
+
+} // namespace kw::simd
+
+#endif // KW_SIMD
@@ -2,6 +2,7 @@
 
 #include "core/math/float4x4.h"
 #include "core/math/quaternion.h"
+#include "core/math/simd.h"
 
 namespace kw {
 
@@ -54,6 +55,19 @@ public:
     }
 
     constexpr transform operator*(const transform& rhs) const {
+#ifdef KW_SIMD
+        if (!KW_IS_CONSTANT_EVALUATED()) {
+            simd::vfloat4 rhs_rotation = simd::load(rhs.rotation.data);
+            simd::vfloat4 rotated = simd::rotate(simd::load3(translation.data), rhs_rotation);
+
+            transform result;
+            simd::store3(result.translation.data, simd::madd(rotated, simd::load3(rhs.scale.data), simd::load3(rhs.translation.data)));
+            simd::store(result.rotation.data, simd::mul_quaternion(rhs_rotation, simd::load(rotation.data)));
+            result.scale = rhs.scale * scale;
+            return result;
+        }
+#endif // KW_SIMD
+
         return transform(
             translation * rhs.rotation * rhs.scale + rhs.translation,
             rhs.rotation * rotation,
@@ -62,6 +76,12 @@ public:
     }
 
     constexpr transform& operator*=(const transform& value) {
+#ifdef KW_SIMD
+        if (!KW_IS_CONSTANT_EVALUATED()) {
+            return *this = *this * value;
+        }
+#endif // KW_SIMD
+
         translation = translation * value.rotation * value.scale + value.translation;
         rotation = value.rotation * rotation;
         scale = value.scale * scale;
@@ -115,6 +135,10 @@ constexpr transform inverse(const transform& value) {
     );
 }
 
+// Same as `result[i] = lhs[i] * rhs` for all `i` in `[0, count)`, but processes multiple transforms at once.
+// `result` may be the same array as `lhs`.
+void multiply(const transform* lhs, const transform& rhs, transform* result, size_t count);
+
 inline transform lerp(const transform& from, const transform& to, float factor) {
     transform result;
     result.translation = lerp(from.translation, to.translation, factor);
@@ -4,6 +4,9 @@
 
 namespace kw {
 
+// Free nodes of every depth are stored in doubly linked lists, so a node can be removed from the list when its buddy
+// is deallocated in constant time. A bit mask of non-empty depths allows to find the smallest suitable node without
+// iterating over all depths. Reallocation is performed in place when the buddy nodes are free.
 class BuddyMemoryResource : public MemoryResource {
 public:
     BuddyMemoryResource(MemoryResource& memory_resource, size_t root_size_log2, size_t leaf_size_log2);
@@ -19,6 +22,13 @@ public:
 
     using MemoryResource::allocate;
 
+    // Size of the largest free node. Greater allocations fail even if total free memory is enough.
+    size_t get_largest_free_size() const;
+
+    // Total size of free nodes that are smaller than the given size and therefore can't serve allocations of it.
+    // Walks the free lists, meant for diagnostics.
+    size_t get_free_size_below(size_t size) const;
+
 private:
     static constexpr uint32_t END = 0x07FFFFFF;
     static constexpr uint32_t BUSY = 0x07FFFFFE;
@@ -26,13 +36,29 @@ private:
     struct Leaf {
         uint32_t next : 27;
         uint32_t depth : 5;
+        uint32_t previous;
     };
 
+    // Return the smallest depth that fits the given size or `m_max_depth + 1` if the size is too large.
+    uint32_t get_depth(size_t size) const;
+
+    // Insert the given node into the given depth's linked list.
+    void push_node(uint32_t local_offset, uint32_t depth);
+
+    // Remove the given node from the given depth's linked list.
+    void remove_node(uint32_t local_offset, uint32_t depth);
+
+    // Return the local offset of the given allocation.
+    uint32_t get_local_offset(void* memory) const;
+
     MemoryResource& m_memory_resource;
 
     uint32_t m_leaf_size_log2;
     uint32_t m_max_depth;
 
+    // Bit `i` is set when depth `i` has at least one free node.
+    uint32_t m_free_mask;
+
     uint32_t* m_heads;
     Leaf* m_leafs;
     void* m_memory;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "core/concurrency/spinlock.h"
+#include "core/memory/memory_resource.h"
+
+#include <atomic>
+
+namespace kw {
+
+// Thread-safe version of `PagedPoolMemoryResource`. Free items are stored in a lock-free stack with a tagged head to
+// avoid ABA problem. New pages are allocated under a spinlock, which is only taken when the free list is empty.
+class ConcurrentPagedPoolMemoryResource final : public MemoryResource {
+public:
+    ConcurrentPagedPoolMemoryResource(MemoryResource& memory_resource, size_t allocation_size, size_t allocations_per_page);
+    ConcurrentPagedPoolMemoryResource(const ConcurrentPagedPoolMemoryResource& original) = delete;
+    ConcurrentPagedPoolMemoryResource(ConcurrentPagedPoolMemoryResource&& original) = delete;
+    ~ConcurrentPagedPoolMemoryResource() override;
+    ConcurrentPagedPoolMemoryResource& operator=(const ConcurrentPagedPoolMemoryResource& original) = delete;
+    ConcurrentPagedPoolMemoryResource& operator=(ConcurrentPagedPoolMemoryResource&& original) = delete;
+
+    void* allocate(size_t size, size_t alignment) override;
+    void* reallocate(void* memory, size_t size, size_t alignment) override;
+    void deallocate(void* memory) override;
+
+    // Return all the given items to the pool with a single atomic operation. Null items are skipped.
+    void deallocate(void* const* memory, size_t count);
+
+    using MemoryResource::allocate;
+
+    // The number of items that are currently allocated.
+    size_t get_live_count() const;
+
+    // The highest number of items that were allocated at once.
+    size_t get_peak_count() const;
+
+private:
+    // Push a linked chain of items to the free list.
+    void push_items(void* first, void* last);
+
+    // Allocate a new page and push all its items but the first one to the free list. Return the first item.
+    void* allocate_new_page();
+
+    bool is_valid_item(void* memory) const;
+
+    MemoryResource& m_memory_resource;
+
+    size_t m_allocation_size;
+    size_t m_allocations_per_page;
+
+    // Lower 48 bits store the pointer to the first free item, the upper 16 bits store a counter that is incremented
+    // on every change.
+    alignas(64) std::atomic<uint64_t> m_data_head;
+
+    alignas(64) std::atomic<size_t> m_live_count;
+    std::atomic<size_t> m_peak_count;
+
+    mutable Spinlock m_page_spinlock;
+    void* m_page_head;
+};
+
+} // namespace kw
@@ -6,6 +6,9 @@
 
 namespace kw {
 
+// Linear allocator that is reset every frame. Each thread allocates from its own chunk, which is taken from the shared
+// buffer in large blocks, so threads don't contend on every allocation. Allocations that are too large for a chunk
+// are taken from the shared buffer directly.
 class ScratchMemoryResource : public MemoryResource {
 public:
     ScratchMemoryResource(MemoryResource& memory_resource, size_t capacity);
@@ -16,20 +19,43 @@ public:
     ScratchMemoryResource& operator=(const ScratchMemoryResource& original) = delete;
     ScratchMemoryResource& operator=(ScratchMemoryResource&& original) = delete;
 
+    // Return nullptr on overflow.
     void* allocate(size_t size, size_t alignment) override;
     void* reallocate(void* memory, size_t size, size_t alignment) override;
     void deallocate(void* memory) override;
 
     using MemoryResource::allocate;
 
+    // Must not be called concurrently with allocations.
     void reset();
 
+    // The number of bytes taken from the shared buffer since the last reset, including unused chunk tails and
+    // allocations that didn't fit. Greater than capacity on overflow.
+    size_t get_allocated_size() const;
+
+    // The largest allocated size among all frames, including the current one.
+    size_t get_high_water_mark() const;
+
 private:
+    // Allocate from the current thread's chunk. Return nullptr on overflow.
+    void* allocate_local(size_t size, size_t alignment);
+
+    // Allocate from the shared buffer. Return nullptr on overflow.
+    void* allocate_shared(size_t size, size_t alignment);
+
     MemoryResource* m_memory_resource;
 
-    void* m_begin;
-    std::atomic<void*> m_current;
-    void* m_end;
+    uint8_t* m_begin;
+    uint8_t* m_end;
+    size_t m_chunk_size;
+
+    // Thread chunks taken with a different token are stale. Tokens are unique across all scratch memory resources.
+    uint64_t m_token;
+
+    alignas(64) std::atomic<size_t> m_offset;
+    std::atomic<size_t> m_overflow;
+
+    size_t m_high_water_mark;
 };
 
 } // namespace kw
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "core/concurrency/spinlock.h"
+#include "core/memory/memory_resource.h"
+
+#include <atomic>
+
+namespace kw {
+
+// Segregated-fit allocator for small long-living objects like container nodes. Allocations up to `MAX_SMALL_SIZE`
+// are rounded up to one of the size classes and taken from slabs of that size class, larger allocations are forwarded
+// to the upstream memory resource. Each thread caches a few free blocks of every size class, so most allocations and
+// deallocations don't take any locks. Blocks cached by a thread that has exited are lost until this memory resource
+// is destroyed.
+class SmallObjectMemoryResource : public MemoryResource {
+public:
+    static constexpr size_t MAX_SMALL_SIZE = 2048;
+    static constexpr size_t SIZE_CLASS_COUNT = 24;
+
+    struct SizeClassStatistics {
+        size_t block_size;
+        size_t slab_count;
+
+        // Blocks cached by threads are considered live.
+        size_t live_bytes;
+        size_t free_bytes;
+    };
+
+    explicit SmallObjectMemoryResource(MemoryResource& memory_resource);
+    SmallObjectMemoryResource(const SmallObjectMemoryResource& other) = delete;
+    SmallObjectMemoryResource(SmallObjectMemoryResource&& other) = delete;
+    ~SmallObjectMemoryResource() override;
+    SmallObjectMemoryResource& operator=(const SmallObjectMemoryResource& other) = delete;
+    SmallObjectMemoryResource& operator=(SmallObjectMemoryResource&& other) = delete;
+
+    void* allocate(size_t size, size_t alignment) override;
+    void* reallocate(void* memory, size_t size, size_t alignment) override;
+    void deallocate(void* memory) override;
+
+    using MemoryResource::allocate;
+
+    SizeClassStatistics get_size_class_statistics(size_t size_class) const;
+
+    // The ratio of free bytes to all bytes in slabs, including slab headers and tails.
+    float get_fragmentation() const;
+
+private:
+    struct alignas(64) SizeClass {
+        mutable Spinlock spinlock;
+        void* head;
+        size_t free_count;
+        size_t block_count;
+        size_t slab_count;
+    };
+
+    // Return `SIZE_CLASS_COUNT` if allocation must be forwarded to upstream memory resource.
+    static size_t get_size_class(size_t size, size_t alignment);
+
+    // Return size class of the given small block or `SIZE_CLASS_COUNT` if it's not from any slab.
+    size_t find_size_class(void* memory) const;
+
+    // Move up to `count` blocks from the given size class to the given free list. Allocate new slab if needed.
+    size_t acquire_blocks(size_t size_class, void*& head, size_t count);
+
+    // Same as above, but the size class must be locked and must have free blocks.
+    static size_t detach_blocks(SizeClass& size_class_data, void*& head, size_t count);
+
+    // Move `count` blocks from the given free list to the given size class.
+    void release_blocks(size_t size_class, void*& head, size_t count);
+
+    void* allocate_slab();
+
+    MemoryResource& m_memory_resource;
+
+    // Thread caches with a different token belong to some other (possibly destroyed) memory resource.
+    uint64_t m_token;
+
+    SizeClass m_size_classes[SIZE_CLASS_COUNT];
+
+    // Slabs are taken from large segments. Segments are only added. Segment begins are kept sorted, so the segment of
+    // any address is found with binary search. Readers don't lock, they retry if the sequence has changed meanwhile.
+    static constexpr size_t MAX_SEGMENT_COUNT = 1024;
+
+    Spinlock m_segment_spinlock;
+    uint8_t* m_segments[MAX_SEGMENT_COUNT];
+    std::atomic<uint8_t*> m_segment_begins[MAX_SEGMENT_COUNT];
+    std::atomic<size_t> m_segment_count;
+
+    // Odd while segment begins are being modified.
+    std::atomic<uint64_t> m_segment_sequence;
+
+    uint8_t* m_current_segment_begin;
+    size_t m_segment_slab_count;
+};
+
+} // namespace kw
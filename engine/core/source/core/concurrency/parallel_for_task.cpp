@@ -0,0 +1,95 @@
+#include "core/concurrency/parallel_for_task.h"
+#include "core/concurrency/task_scheduler.h"
+#include "core/debug/assert.h"
+#include "core/memory/memory_resource.h"
+
+#include <algorithm>
+
+namespace kw {
+
+// Chunk task that is running `run(begin, end)` on this thread, null when it's the parallel for task itself.
+static thread_local Task* current_chunk_task = nullptr;
+
+class ParallelForTask::ChunkTask final : public Task {
+public:
+    ChunkTask(ParallelForTask& parallel_for_task, size_t begin, size_t end)
+        : m_parallel_for_task(parallel_for_task)
+        , m_begin(begin)
+        , m_end(end)
+    {
+        set_priority(parallel_for_task.get_priority());
+        set_priority_inherited(parallel_for_task.is_priority_inherited());
+    }
+
+    void run() override {
+        current_chunk_task = this;
+        m_parallel_for_task.run_chunk(m_begin, m_end);
+        current_chunk_task = nullptr;
+    }
+
+    void suspend_chunk(MemoryResource& transient_memory_resource, std::initializer_list<Task*> input_dependencies) {
+        suspend(transient_memory_resource, input_dependencies);
+    }
+
+    const char* get_name() const override {
+        return m_parallel_for_task.get_name();
+    }
+
+private:
+    ParallelForTask& m_parallel_for_task;
+    size_t m_begin;
+    size_t m_end;
+};
+
+ParallelForTask::ParallelForTask(TaskScheduler& task_scheduler, MemoryResource& transient_memory_resource,
+                                 Task* end_task, size_t count, size_t grain_size)
+    : m_task_scheduler(task_scheduler)
+    , m_transient_memory_resource(transient_memory_resource)
+    , m_end_task(end_task)
+    , m_count(count)
+    , m_grain_size(grain_size)
+{
+    KW_ASSERT(end_task != nullptr);
+
+    if (m_grain_size == 0) {
+        // Roughly 4 subranges per thread is enough for stealing to even out the load.
+        m_grain_size = std::max(count / (task_scheduler.get_thread_count() * 4), size_t(1));
+    }
+
+    // End task must not run before this task is split.
+    add_output_dependencies(transient_memory_resource, { end_task });
+}
+
+void ParallelForTask::run() {
+    if (m_count > 0) {
+        run_chunk(0, m_count);
+    }
+}
+
+void ParallelForTask::suspend(MemoryResource& transient_memory_resource, std::initializer_list<Task*> input_dependencies) {
+    if (current_chunk_task != nullptr) {
+        static_cast<ChunkTask*>(current_chunk_task)->suspend_chunk(transient_memory_resource, input_dependencies);
+    } else {
+        Task::suspend(transient_memory_resource, input_dependencies);
+    }
+}
+
+void ParallelForTask::run_chunk(size_t begin, size_t& end) {
+    while (end - begin > m_grain_size) {
+        size_t middle = begin + (end - begin) / 2;
+
+        ChunkTask* chunk_task = m_transient_memory_resource.construct<ChunkTask>(*this, middle, end);
+        KW_ASSERT(chunk_task != nullptr);
+
+        // This chunk is running, so end task has at least one dependency and adding more is allowed.
+        chunk_task->add_output_dependencies(m_transient_memory_resource, { m_end_task });
+
+        m_task_scheduler.enqueue_task(m_transient_memory_resource, chunk_task);
+
+        end = middle;
+    }
+
+    run(begin, end);
+}
+
+} // namespace kw
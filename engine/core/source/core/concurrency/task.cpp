@@ -9,6 +9,10 @@ namespace kw {
 Task::Task()
     : m_output_dependencies(nullptr)
     , m_input_dependency_count(1)
+    , m_priority(TaskPriority::NORMAL)
+    , m_is_priority_inherited(true)
+    , m_suspend_memory_resource(nullptr)
+    , m_ready_timestamp(0)
 {
 }
 
@@ -92,6 +96,38 @@ const char* Task::get_name() const {
     return "Nameless Task";
 }
 
+TaskPriority Task::get_priority() const {
+    return m_priority;
+}
+
+void Task::set_priority(TaskPriority priority) {
+    m_priority = priority;
+}
+
+bool Task::is_priority_inherited() const {
+    return m_is_priority_inherited;
+}
+
+void Task::set_priority_inherited(bool value) {
+    m_is_priority_inherited = value;
+}
+
+void Task::suspend(MemoryResource& transient_memory_resource, Task* const* input_dependencies, size_t input_dependency_count) {
+    KW_ASSERT(m_input_dependency_count == 0, "Suspend must be called from the running task.");
+    KW_ASSERT(m_suspend_memory_resource == nullptr, "Task is already suspended.");
+
+    // Just like a new task, this one must not run again before the task scheduler enqueues it after `run` returns.
+    m_input_dependency_count = 1;
+
+    add_input_dependencies(transient_memory_resource, input_dependencies, input_dependency_count);
+
+    m_suspend_memory_resource = &transient_memory_resource;
+}
+
+void Task::suspend(MemoryResource& transient_memory_resource, std::initializer_list<Task*> input_dependencies) {
+    return suspend(transient_memory_resource, input_dependencies.begin(), input_dependencies.size());
+}
+
 NoopTask::NoopTask()
     : m_name("Nameless No-op Task")
 {
@@ -0,0 +1,96 @@
+#include "core/concurrency/task_deque.h"
+#include "core/debug/assert.h"
+#include "core/memory/memory_resource.h"
+
+#include <new>
+
+namespace kw {
+
+TaskDeque::TaskDeque(MemoryResource& memory_resource, size_t capacity)
+    : m_memory_resource(memory_resource)
+    , m_mask(static_cast<int64_t>(capacity) - 1)
+    , m_top(0)
+    , m_bottom(0)
+{
+    KW_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0, "Capacity must be power of two.");
+
+    m_tasks = memory_resource.allocate<std::atomic<Task*>>(capacity);
+    KW_ASSERT(m_tasks != nullptr);
+
+    for (size_t i = 0; i < capacity; i++) {
+        new (&m_tasks[i]) std::atomic<Task*>(nullptr);
+    }
+}
+
+TaskDeque::~TaskDeque() {
+    KW_ASSERT(m_top.load(std::memory_order_relaxed) >= m_bottom.load(std::memory_order_relaxed), "Not all tasks have run.");
+
+    m_memory_resource.deallocate(m_tasks);
+}
+
+bool TaskDeque::push(Task* task) {
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    int64_t top = m_top.load(std::memory_order_acquire);
+
+    if (bottom - top > m_mask) {
+        // The deque is full.
+        return false;
+    }
+
+    m_tasks[bottom & m_mask].store(task, std::memory_order_relaxed);
+
+    // Thieves must see the task before they see the new bottom.
+    m_bottom.store(bottom + 1, std::memory_order_release);
+
+    return true;
+}
+
+Task* TaskDeque::pop() {
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+
+    // The new bottom must be visible to thieves before we read top.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t top = m_top.load(std::memory_order_relaxed);
+    if (top <= bottom) {
+        Task* task = m_tasks[bottom & m_mask].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // This is the last task in the deque. Race with thieves for it.
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                // Some thief has stolen it.
+                task = nullptr;
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return task;
+    } else {
+        // The deque is empty.
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+}
+
+Task* TaskDeque::steal() {
+    int64_t top = m_top.load(std::memory_order_acquire);
+
+    while (true) {
+        // Top must be read before bottom.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            // The deque is empty.
+            return nullptr;
+        }
+
+        Task* task = m_tasks[top & m_mask].load(std::memory_order_relaxed);
+        if (m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return task;
+        }
+
+        // Another thief or the owner has taken this task, `top` is updated by the failed exchange. Try again.
+    }
+}
+
+} // namespace kw
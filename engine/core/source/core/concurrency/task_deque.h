@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace kw {
+
+class MemoryResource;
+class Task;
+
+// Chase-Lev work stealing deque. Only the owner thread is allowed to push and pop tasks from the bottom, while any
+// other thread is allowed to steal tasks from the top. The capacity is fixed, so the owner must handle failed pushes.
+class alignas(64) TaskDeque {
+public:
+    TaskDeque(MemoryResource& memory_resource, size_t capacity);
+    TaskDeque(const TaskDeque& other) = delete;
+    TaskDeque(TaskDeque&& other) = delete;
+    ~TaskDeque();
+    TaskDeque& operator=(const TaskDeque& other) = delete;
+    TaskDeque& operator=(TaskDeque&& other) = delete;
+
+    // Owner thread only. Return false when the deque is full.
+    bool push(Task* task);
+
+    // Owner thread only. Return nullptr when the deque is empty.
+    Task* pop();
+
+    // Any thread. Return nullptr when the deque is empty.
+    Task* steal();
+
+private:
+    MemoryResource& m_memory_resource;
+
+    std::atomic<Task*>* m_tasks;
+    int64_t m_mask;
+
+    // Top is modified by thieves, bottom is modified by the owner. Keep them on different cache lines.
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+};
+
+} // namespace kw
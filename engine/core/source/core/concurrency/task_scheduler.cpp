@@ -1,22 +1,86 @@
 #include "core/concurrency/task_scheduler.h"
 #include "core/concurrency/concurrency_utils.h"
 #include "core/concurrency/task.h"
+#include "core/concurrency/task_deque.h"
 #include "core/concurrency/task_node.h"
 #include "core/debug/assert.h"
 #include "core/debug/cpu_profiler.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace kw {
 
-TaskScheduler::TaskScheduler(MemoryResource& persistent_memory_resource, size_t thread_count)
-    : m_ready_tasks(nullptr)
-    , m_busy_threads(0)
+static constexpr size_t TASK_DEQUE_CAPACITY = 4096;
+
+// Priority inheritance is an estimate, so dependency graph traversal is bounded by the number of visited tasks and
+// by the number of pending output dependency lists.
+static constexpr size_t PRIORITY_INHERITANCE_MAX_VISIT_COUNT = 256;
+static constexpr size_t PRIORITY_INHERITANCE_STACK_SIZE = 64;
+
+// Task scheduler and deque index the current thread is running tasks for.
+static thread_local TaskScheduler* current_task_scheduler = nullptr;
+static thread_local size_t current_thread_index = SIZE_MAX;
+
+inline uint64_t get_current_timestamp() {
+    return std::chrono::high_resolution_clock::now().time_since_epoch().count();
+}
+
+BackgroundTaskHandle::BackgroundTaskHandle(SharedPtr<State> state)
+    : m_state(std::move(state))
+{
+}
+
+bool BackgroundTaskHandle::is_completed() const {
+    return !m_state || m_state->is_completed.load(std::memory_order_acquire);
+}
+
+void BackgroundTaskHandle::wait() const {
+    if (m_state) {
+        std::unique_lock lock(m_state->mutex);
+
+        while (!m_state->is_completed.load(std::memory_order_acquire)) {
+            m_state->condition_variable.wait(lock);
+        }
+    }
+}
+
+void BackgroundTaskHandle::complete(State& state) {
+    std::lock_guard lock(state.mutex);
+    state.is_completed.store(true, std::memory_order_release);
+    state.condition_variable.notify_all();
+}
+
+TaskScheduler::TaskScheduler(MemoryResource& persistent_memory_resource, size_t thread_count, size_t background_thread_count)
+    : m_persistent_memory_resource(persistent_memory_resource)
+    , m_task_deques(persistent_memory_resource)
+    , m_ready_tasks{}
+    , m_pending_tasks(0)
+    , m_sleeping_threads(0)
     , m_is_running(true)
     , m_threads(persistent_memory_resource)
+    , m_thread_counters(allocate_unique<ThreadCounters[]>(persistent_memory_resource, thread_count + 1))
+    , m_max_pending_tasks(0)
+    , m_frame_begin_timestamp(get_current_timestamp())
+    , m_statistics{ 0, 0, 0, 0, 0, Vector<ThreadStatistics>(thread_count + 1, persistent_memory_resource) }
+    , m_background_tasks(MemoryResourceAllocator<Pair<Task*, SharedPtr<BackgroundTaskHandle::State>>>(persistent_memory_resource))
+    , m_background_threads(persistent_memory_resource)
 {
+    // Extra deques for the thread that calls `join`.
+    m_task_deques.reserve((thread_count + 1) * TASK_PRIORITY_COUNT);
+    for (size_t i = 0; i < (thread_count + 1) * TASK_PRIORITY_COUNT; i++) {
+        m_task_deques.push_back(allocate_unique<TaskDeque>(persistent_memory_resource, persistent_memory_resource, TASK_DEQUE_CAPACITY));
+    }
+
     m_threads.reserve(thread_count);
     for (size_t i = 0; i < thread_count; i++) {
         m_threads.push_back(std::thread(&TaskScheduler::worker_thread, this, i));
     }
+
+    m_background_threads.reserve(background_thread_count);
+    for (size_t i = 0; i < background_thread_count; i++) {
+        m_background_threads.push_back(std::thread(&TaskScheduler::background_thread, this, i));
+    }
 }
 
 TaskScheduler::~TaskScheduler() {
@@ -28,11 +92,28 @@ TaskScheduler::~TaskScheduler() {
         m_ready_task_condition_variable.notify_all();
     }
 
+    {
+        std::lock_guard lock(m_background_mutex);
+        m_background_task_condition_variable.notify_all();
+    }
+
     for (std::thread& thread : m_threads) {
         if (thread.joinable()) {
             thread.join();
         }
     }
+
+    for (std::thread& thread : m_background_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    // Discarded background tasks will never run, don't let anyone wait for them forever.
+    while (!m_background_tasks.empty()) {
+        BackgroundTaskHandle::complete(*m_background_tasks.front().second);
+        m_background_tasks.pop();
+    }
 }
 
 void TaskScheduler::enqueue_task(MemoryResource& transient_memory_resource, Task* task) {
@@ -40,110 +121,385 @@ void TaskScheduler::enqueue_task(MemoryResource& transient_memory_resource, Task
     // If task has more dependencies, completion of those dependencies will trigger this task's run.
     size_t input_dependency_count = --task->m_input_dependency_count;
     if (input_dependency_count == 0) {
-        // Task doesn't have any dependencies. Add it to ready stack.
+        // Task doesn't have any dependencies. Worker threads push it to their own deque, which doesn't need a node.
+        TaskPriority priority = compute_effective_priority(task);
 
-        TaskNode* new_head = transient_memory_resource.allocate<TaskNode>();
-        new_head->task = task;
+        register_ready_task(task);
 
-        {
-            std::lock_guard lock(m_mutex);
-            new_head->next = m_ready_tasks;
-            m_ready_tasks = new_head;
-            m_ready_task_condition_variable.notify_one();
+        if (!push_local_task(task, priority)) {
+            TaskNode* task_node = transient_memory_resource.allocate<TaskNode>();
+            KW_ASSERT(task_node != nullptr);
+
+            task_node->task = task;
+            push_global_task(task_node, priority);
         }
+
+        notify_task();
+    }
+}
+
+BackgroundTaskHandle TaskScheduler::enqueue_background_task(Task* task) {
+    KW_ASSERT(task != nullptr);
+    KW_ASSERT(!m_background_threads.empty(), "Task scheduler doesn't have any background threads.");
+    KW_ASSERT(
+        task->m_input_dependency_count == 1 && task->m_output_dependencies.load(std::memory_order_relaxed) == nullptr,
+        "Background tasks can't have dependencies."
+    );
+
+    SharedPtr<BackgroundTaskHandle::State> state = allocate_shared<BackgroundTaskHandle::State>(m_persistent_memory_resource);
+    state->is_completed.store(false, std::memory_order_relaxed);
+
+    {
+        std::lock_guard lock(m_background_mutex);
+        m_background_tasks.emplace(task, state);
+        m_background_task_condition_variable.notify_one();
     }
+
+    return BackgroundTaskHandle(std::move(state));
 }
 
 void TaskScheduler::join() {
-    while (true) {
-        std::unique_lock lock(m_mutex);
+    TaskScheduler* previous_task_scheduler = current_task_scheduler;
+    size_t previous_thread_index = current_thread_index;
 
-        if (m_ready_tasks != nullptr) {
-            // Ready task is available, pop it from stack.
-            TaskNode* head = m_ready_tasks;
-            m_ready_tasks = head->next;
+    // Run tasks released by this thread from the last deque.
+    size_t thread_index = m_threads.size();
+    current_task_scheduler = this;
+    current_thread_index = thread_index;
 
-            // Run task in parallel.
-            lock.unlock();
-            run_task(head->task);
-        } else if (m_busy_threads > 0) {
-            // No ready tasks are available, but there're busy worker threads that might add them.
-            m_busy_thread_condition_variable.wait(lock);
-        } else {
-            // No ready tasks available, all worker threads are idle, so no new tasks will be produced.
-            return;
+    while (true) {
+        Task* task = acquire_task(thread_index);
+        if (task == nullptr) {
+            // Returns null when there's no ready tasks, no running tasks and so no new tasks will be produced.
+            task = wait_for_task(thread_index, true);
+            if (task == nullptr) {
+                break;
+            }
         }
+
+        run_task(task);
     }
+
+    current_task_scheduler = previous_task_scheduler;
+    current_thread_index = previous_thread_index;
+
+    update_statistics();
 }
 
-void TaskScheduler::worker_thread(size_t thread_index) {
-    // Other than running a task and waiting on condition variable, worker thread is locking the mutex.
-    std::unique_lock lock(m_mutex);
+size_t TaskScheduler::get_thread_count() const {
+    return m_task_deques.size() / TASK_PRIORITY_COUNT;
+}
+
+const TaskScheduler::Statistics& TaskScheduler::get_statistics() const {
+    return m_statistics;
+}
 
+void TaskScheduler::worker_thread(size_t thread_index) {
     {
         char name_buffer[24];
         sprintf_s(name_buffer, sizeof(name_buffer), "Worker Thread %zu", thread_index);
         ConcurrencyUtils::set_current_thread_name(name_buffer);
     }
 
+    current_task_scheduler = this;
+    current_thread_index = thread_index;
+
     while (m_is_running) {
-        while (m_ready_tasks == nullptr) {
-            // Wait for new ready tasks (or when `m_is_running` becomes false).
-            m_ready_task_condition_variable.wait(lock);
+        Task* task = acquire_task(thread_index);
+        if (task == nullptr) {
+            // Returns null when scheduler's destructor sets `m_is_running` to false.
+            task = wait_for_task(thread_index, false);
+            if (task == nullptr) {
+                return;
+            }
+        }
+
+        run_task(task);
+    }
+}
+
+void TaskScheduler::background_thread(size_t thread_index) {
+    {
+        char name_buffer[28];
+        sprintf_s(name_buffer, sizeof(name_buffer), "Background Thread %zu", thread_index);
+        ConcurrencyUtils::set_current_thread_name(name_buffer);
+    }
+
+    while (true) {
+        Task* task;
+        SharedPtr<BackgroundTaskHandle::State> state;
+
+        {
+            std::unique_lock lock(m_background_mutex);
+
+            while (m_is_running && m_background_tasks.empty()) {
+                m_background_task_condition_variable.wait(lock);
+            }
 
-            // Scheduler's destructor notifies `m_ready_task_condition_variable` when `m_is_running` is set to false.
             if (!m_is_running) {
                 return;
             }
+
+            task = m_background_tasks.front().first;
+            state = std::move(m_background_tasks.front().second);
+            m_background_tasks.pop();
         }
 
-        // Ready task is available, pop it from stack.
-        TaskNode* head = m_ready_tasks;
-        m_ready_tasks = head->next;
+        {
+            KW_CPU_PROFILER_DYNAMIC(task->get_name());
 
-        // Run task in parallel.
-        m_busy_threads++;
-        lock.unlock();
-        run_task(head->task);
-        lock.lock();
-        m_busy_threads--;
+            task->run();
+        }
+
+        KW_ASSERT(task->m_suspend_memory_resource == nullptr, "Background tasks can't suspend.");
 
-        // Main thread might be waiting for worker threads to finish.
-        m_busy_thread_condition_variable.notify_one();
+        // The task may be destroyed by its owner as soon as this is visible, don't access it afterwards.
+        BackgroundTaskHandle::complete(*state);
     }
 }
 
 void TaskScheduler::run_task(Task* task) {
+    ThreadCounters& thread_counters = m_thread_counters[current_thread_index];
+
+    uint64_t begin_timestamp = get_current_timestamp();
+
+    uint64_t task_latency = begin_timestamp - std::min(task->m_ready_timestamp, begin_timestamp);
+    thread_counters.total_task_latency.fetch_add(task_latency, std::memory_order_relaxed);
+    if (task_latency > thread_counters.max_task_latency.load(std::memory_order_relaxed)) {
+        // Only this thread increases it, so no need for compare exchange.
+        thread_counters.max_task_latency.store(task_latency, std::memory_order_relaxed);
+    }
+
     // Run task.
 
     {
-        KW_CPU_PROFILER(task->get_name());
+        KW_CPU_PROFILER_DYNAMIC(task->get_name());
 
         task->run();
     }
 
-    // Notify future dependencies that this task has completed.
+    if (task->m_suspend_memory_resource != nullptr) {
+        // Task is waiting for its new input dependencies, it's not completed yet. Enqueue it again just like a new
+        // task, it runs again when the last of those dependencies completes. It may run on another thread right after
+        // it's enqueued, so reset the memory resource first.
+        MemoryResource& transient_memory_resource = *task->m_suspend_memory_resource;
+        task->m_suspend_memory_resource = nullptr;
+
+        enqueue_task(transient_memory_resource, task);
+    } else {
+        // Notify future dependencies that this task has completed.
+
+        TaskNode* task_dependency = task->m_output_dependencies.load(std::memory_order_relaxed);
+        while (!task->m_output_dependencies.compare_exchange_weak(task_dependency, &INVALID_TASK_NODE, std::memory_order_release, std::memory_order_relaxed));
+
+        // Notify past dependencies that this task has completed.
 
-    TaskNode* task_dependency = task->m_output_dependencies.load(std::memory_order_relaxed);
-    while (!task->m_output_dependencies.compare_exchange_weak(task_dependency, &INVALID_TASK_NODE, std::memory_order_release, std::memory_order_relaxed));
+        while (task_dependency != nullptr) {
+            // We may reuse `task_dependency` for ready stack and overwrite `next`.
+            TaskNode* next_task_dependency = task_dependency->next;
+
+            size_t input_dependency_count = --task_dependency->task->m_input_dependency_count;
+            if (input_dependency_count == 0) {
+                // Task doesn't have any dependencies left. Move it to this thread's deque.
+                TaskPriority priority = compute_effective_priority(task_dependency->task);
+
+                register_ready_task(task_dependency->task);
+
+                if (!push_local_task(task_dependency->task, priority)) {
+                    // The deque is full. Reuse dependency node for the global ready stack.
+                    push_global_task(task_dependency, priority);
+                }
+
+                notify_task();
+            }
 
-    // Notify past dependencies that this task has completed.
+            task_dependency = next_task_dependency;
+        }
+    }
 
-    while (task_dependency != nullptr) {
-        // We may reuse `task_dependency` for ready stack and overwrite `next`.
-        TaskNode* next_task_dependency = task_dependency->next;
+    // Must be accounted before pending tasks are decremented, otherwise it could end up in the next frame's statistics.
+    thread_counters.busy_time.fetch_add(get_current_timestamp() - begin_timestamp, std::memory_order_relaxed);
+    thread_counters.task_count.fetch_add(1, std::memory_order_relaxed);
 
-        size_t input_dependency_count = --task_dependency->task->m_input_dependency_count;
-        if (input_dependency_count == 0) {
-            // Task doesn't have any dependencies left. Move it from dependency stack to ready stack.
+    // This task is no longer running. Pending tasks must be decremented after dependencies are pushed, otherwise
+    // `join` might return too early.
+    if (--m_pending_tasks == 0) {
+        // The thread that is waiting in `join` might be sleeping.
+        if (m_sleeping_threads > 0) {
             std::lock_guard lock(m_mutex);
-            task_dependency->next = m_ready_tasks;
-            m_ready_tasks = task_dependency;
-            m_ready_task_condition_variable.notify_one();
+            m_ready_task_condition_variable.notify_all();
+        }
+    }
+}
+
+void TaskScheduler::register_ready_task(Task* task) {
+    task->m_ready_timestamp = get_current_timestamp();
+
+    size_t pending_tasks = ++m_pending_tasks;
+
+    size_t max_pending_tasks = m_max_pending_tasks.load(std::memory_order_relaxed);
+    while (pending_tasks > max_pending_tasks && !m_max_pending_tasks.compare_exchange_weak(max_pending_tasks, pending_tasks, std::memory_order_relaxed));
+}
+
+void TaskScheduler::update_statistics() {
+    uint64_t timestamp = get_current_timestamp();
+
+    // Sleep counters are protected with this mutex.
+    std::lock_guard lock(m_mutex);
+
+    m_statistics.frame_duration = timestamp - m_frame_begin_timestamp;
+    m_statistics.total_task_latency = 0;
+    m_statistics.max_task_latency = 0;
+    m_statistics.task_count = 0;
+    m_statistics.max_pending_task_count = m_max_pending_tasks.exchange(0, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < m_statistics.threads.size(); i++) {
+        ThreadCounters& thread_counters = m_thread_counters[i];
+        ThreadStatistics& thread_statistics = m_statistics.threads[i];
+
+        if (thread_counters.sleep_begin_timestamp != 0) {
+            // Worker threads sleep between frames. Split the sleep between this frame and the next one.
+            thread_counters.sleep_time += timestamp - thread_counters.sleep_begin_timestamp;
+            thread_counters.sleep_begin_timestamp = timestamp;
+        }
+
+        thread_statistics.busy_time = thread_counters.busy_time.exchange(0, std::memory_order_relaxed);
+        thread_statistics.sleep_time = thread_counters.sleep_time;
+        thread_statistics.idle_time = m_statistics.frame_duration - std::min(thread_statistics.busy_time + thread_statistics.sleep_time, m_statistics.frame_duration);
+        thread_statistics.task_count = thread_counters.task_count.exchange(0, std::memory_order_relaxed);
+        thread_statistics.steal_count = thread_counters.steal_count.exchange(0, std::memory_order_relaxed);
+        thread_statistics.wake_up_count = thread_counters.wake_up_count;
+
+        thread_counters.sleep_time = 0;
+        thread_counters.wake_up_count = 0;
+
+        m_statistics.total_task_latency += thread_counters.total_task_latency.exchange(0, std::memory_order_relaxed);
+        m_statistics.max_task_latency = std::max(m_statistics.max_task_latency, thread_counters.max_task_latency.exchange(0, std::memory_order_relaxed));
+        m_statistics.task_count += thread_statistics.task_count;
+    }
+
+    m_frame_begin_timestamp = timestamp;
+}
+
+bool TaskScheduler::push_local_task(Task* task, TaskPriority priority) {
+    if (current_task_scheduler == this) {
+        return m_task_deques[current_thread_index * TASK_PRIORITY_COUNT + static_cast<size_t>(priority)]->push(task);
+    }
+    return false;
+}
+
+void TaskScheduler::push_global_task(TaskNode* task_node, TaskPriority priority) {
+    std::lock_guard lock(m_ready_tasks_spinlock);
+    task_node->next = m_ready_tasks[static_cast<size_t>(priority)];
+    m_ready_tasks[static_cast<size_t>(priority)] = task_node;
+}
+
+TaskPriority TaskScheduler::compute_effective_priority(Task* task) {
+    uint8_t effective_priority = static_cast<uint8_t>(task->m_priority);
+
+    // Output dependency lists that are not traversed yet. Transitive output dependencies can't run before this task,
+    // so their nodes are not reused for ready stacks yet.
+    TaskNode* stack[PRIORITY_INHERITANCE_STACK_SIZE];
+    size_t stack_size = 0;
+
+    TaskNode* output_dependencies = task->m_output_dependencies.load(std::memory_order_acquire);
+    if (output_dependencies != nullptr && output_dependencies != &INVALID_TASK_NODE) {
+        stack[stack_size++] = output_dependencies;
+    }
+
+    // Critical priority can't be raised any further, so stop early.
+    for (size_t visit_count = 0; stack_size > 0 && effective_priority > 0 && visit_count < PRIORITY_INHERITANCE_MAX_VISIT_COUNT; visit_count++) {
+        TaskNode* task_dependency = stack[--stack_size];
+
+        // The rest of the list is traversed after this dependency's own output dependencies.
+        if (task_dependency->next != nullptr) {
+            stack[stack_size++] = task_dependency->next;
+        }
+
+        Task* dependency = task_dependency->task;
+        if (dependency->m_is_priority_inherited) {
+            effective_priority = std::min(effective_priority, static_cast<uint8_t>(dependency->m_priority));
+
+            output_dependencies = dependency->m_output_dependencies.load(std::memory_order_acquire);
+            if (output_dependencies != nullptr && output_dependencies != &INVALID_TASK_NODE && stack_size < PRIORITY_INHERITANCE_STACK_SIZE) {
+                stack[stack_size++] = output_dependencies;
+            }
+        }
+    }
+
+    return static_cast<TaskPriority>(effective_priority);
+}
+
+Task* TaskScheduler::acquire_task(size_t thread_index) {
+    size_t thread_count = m_task_deques.size() / TASK_PRIORITY_COUNT;
+
+    for (size_t priority = 0; priority < TASK_PRIORITY_COUNT; priority++) {
+        Task* task = m_task_deques[thread_index * TASK_PRIORITY_COUNT + priority]->pop();
+        if (task != nullptr) {
+            return task;
+        }
+
+        {
+            std::lock_guard lock(m_ready_tasks_spinlock);
+
+            if (m_ready_tasks[priority] != nullptr) {
+                TaskNode* head = m_ready_tasks[priority];
+                m_ready_tasks[priority] = head->next;
+                return head->task;
+            }
         }
 
-        task_dependency = next_task_dependency;
+        // Start with the next thread so different threads steal from different victims.
+        for (size_t i = 1; i < thread_count; i++) {
+            task = m_task_deques[((thread_index + i) % thread_count) * TASK_PRIORITY_COUNT + priority]->steal();
+            if (task != nullptr) {
+                m_thread_counters[thread_index].steal_count.fetch_add(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
     }
+
+    return nullptr;
+}
+
+void TaskScheduler::notify_task() {
+    // Pairs with the sequentially consistent increment of `m_sleeping_threads` in `wait_for_task`. Either this thread
+    // sees a sleeping thread or the sleeping thread sees the new task.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_sleeping_threads.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard lock(m_mutex);
+        m_ready_task_condition_variable.notify_one();
+    }
+}
+
+Task* TaskScheduler::wait_for_task(size_t thread_index, bool is_joining) {
+    std::unique_lock lock(m_mutex);
+
+    ++m_sleeping_threads;
+
+    Task* task = nullptr;
+    while (m_is_running) {
+        // Check again after `m_sleeping_threads` is incremented, new task might have been pushed in between.
+        task = acquire_task(thread_index);
+        if (task != nullptr || (is_joining && m_pending_tasks == 0)) {
+            break;
+        }
+
+        ThreadCounters& thread_counters = m_thread_counters[thread_index];
+        thread_counters.sleep_begin_timestamp = get_current_timestamp();
+
+        m_ready_task_condition_variable.wait(lock);
+
+        // `update_statistics` might have moved the sleep begin timestamp while this thread was sleeping.
+        thread_counters.sleep_time += get_current_timestamp() - thread_counters.sleep_begin_timestamp;
+        thread_counters.sleep_begin_timestamp = 0;
+        thread_counters.wake_up_count++;
+    }
+
+    --m_sleeping_threads;
+
+    return task;
 }
 
 } // namespace kw
@@ -0,0 +1,79 @@
+#include "core/concurrency/task_shared_mutex.h"
+#include "core/concurrency/task.h"
+#include "core/concurrency/task_scheduler.h"
+#include "core/debug/assert.h"
+#include "core/memory/memory_resource.h"
+
+#include <mutex>
+
+namespace kw {
+
+TaskSharedMutex::TaskSharedMutex(TaskScheduler& task_scheduler)
+    : m_task_scheduler(task_scheduler)
+    , m_writer_count(0)
+    , m_unlock_task(nullptr)
+    , m_unlock_task_memory_resource(nullptr)
+{
+}
+
+void TaskSharedMutex::lock() {
+    {
+        std::lock_guard lock(m_spinlock);
+        m_writer_count++;
+    }
+
+    m_mutex.lock();
+}
+
+void TaskSharedMutex::unlock() {
+    Task* unlock_task;
+    MemoryResource* unlock_task_memory_resource;
+
+    {
+        std::lock_guard lock(m_spinlock);
+
+        m_mutex.unlock();
+
+        KW_ASSERT(m_writer_count > 0);
+        m_writer_count--;
+
+        unlock_task = m_unlock_task;
+        unlock_task_memory_resource = m_unlock_task_memory_resource;
+
+        m_unlock_task = nullptr;
+        m_unlock_task_memory_resource = nullptr;
+    }
+
+    // Readers that have suspended on this task run again once it completes.
+    if (unlock_task != nullptr) {
+        m_task_scheduler.enqueue_task(*unlock_task_memory_resource, unlock_task);
+    }
+}
+
+Task* TaskSharedMutex::try_lock_shared(MemoryResource& transient_memory_resource) {
+    while (!m_mutex.try_lock_shared()) {
+        std::lock_guard lock(m_spinlock);
+
+        // A writer that is registered here hasn't released the lock yet, so it will enqueue the unlock task.
+        if (m_writer_count > 0) {
+            if (m_unlock_task == nullptr) {
+                m_unlock_task = transient_memory_resource.construct<NoopTask>("Task Shared Mutex Unlock");
+                KW_ASSERT(m_unlock_task != nullptr);
+
+                m_unlock_task_memory_resource = &transient_memory_resource;
+            }
+
+            return m_unlock_task;
+        }
+
+        // The writer has released the lock in between, try again.
+    }
+
+    return nullptr;
+}
+
+void TaskSharedMutex::unlock_shared() {
+    m_mutex.unlock_shared();
+}
+
+} // namespace kw
@@ -1,52 +1,144 @@
 #include "core/debug/cpu_profiler.h"
 #include "core/concurrency/concurrency_utils.h"
+#include "core/debug/assert.h"
+#include "core/error.h"
 #include "core/memory/malloc_memory_resource.h"
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define KW_CPU_PROFILER_RDTSC
+#endif
 
 namespace kw {
 
 #ifndef KW_CPU_PROFILER_DISABLE
-static constexpr size_t SCOPE_COUNT = 1048576;
+static constexpr size_t ENTRY_COUNT = 65536;
 static constexpr size_t FRAME_COUNT = 64;
 #else
-static constexpr size_t SCOPE_COUNT = 0;
-static constexpr size_t FRAME_COUNT = 0;
+// Nothing is recorded, minimal sizes keep the code valid.
+static constexpr size_t ENTRY_COUNT = 1;
+static constexpr size_t FRAME_COUNT = 2;
 #endif
 
-static constexpr size_t SCOPE_MASK = SCOPE_COUNT - 1;
+static constexpr size_t ENTRY_MASK = ENTRY_COUNT - 1;
 static constexpr size_t FRAME_MASK = FRAME_COUNT - 1;
 
-inline uint64_t get_current_timestamp() {
-    return std::chrono::high_resolution_clock::now().time_since_epoch().count();
+static constexpr size_t MAX_THREAD_COUNT = 64;
+static constexpr size_t MAX_COUNTER_COUNT = 64;
+
+static constexpr size_t CACHE_SIZE = 256;
+static constexpr size_t CACHE_MASK = CACHE_SIZE - 1;
+
+inline uint64_t get_current_tick() {
+#ifdef KW_CPU_PROFILER_RDTSC
+    // Invariant TSC, which is available on all modern x86 CPUs, ticks at a constant rate on all cores.
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+inline uint64_t get_current_nanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-CpuProfiler::Counter::Counter(const char* name)
-    : m_scope_name(name)
-    , m_begin_timestamp(get_current_timestamp())
+struct CpuProfiler::ThreadBuffer {
+    struct Entry {
+        uint64_t begin_tick;
+        uint64_t end_tick;
+        uint32_t scope_id;
+    };
+
+    // Scope ids of dynamic scope names.
+    struct CacheEntry {
+        const char* name;
+        uint32_t scope_id;
+    };
+
+    Entry entries[ENTRY_COUNT];
+
+    // Only the owner thread writes to the buffer, other threads read entries before this index.
+    std::atomic<uint64_t> write_index;
+
+    // Sums of all values added to each counter by the owner thread.
+    std::atomic<int64_t> counters[MAX_COUNTER_COUNT];
+
+    CacheEntry cache[CACHE_SIZE];
+
+    char name[32];
+};
+
+CpuProfiler::ScopeRecorder::ScopeRecorder(uint32_t scope_id)
+    : m_scope_id(scope_id)
+    , m_begin_tick(get_current_tick())
 {
 }
 
-CpuProfiler::Counter::~Counter() {
+CpuProfiler::ScopeRecorder::ScopeRecorder(const char* name) {
+    CpuProfiler& cpu_profiler = CpuProfiler::instance();
+
+    // Names are identified by pointers, so dynamic names must be immutable.
+    ThreadBuffer::CacheEntry& cache_entry = cpu_profiler.get_thread_buffer().cache[(reinterpret_cast<uintptr_t>(name) >> 3) & CACHE_MASK];
+    if (cache_entry.name != name) {
+        cache_entry.name = name;
+        cache_entry.scope_id = cpu_profiler.intern_scope(name);
+    }
+
+    m_scope_id = cache_entry.scope_id;
+    m_begin_tick = get_current_tick();
+}
+
+CpuProfiler::ScopeRecorder::~ScopeRecorder() {
     CpuProfiler& cpu_profiler = CpuProfiler::instance();
     if (!cpu_profiler.m_is_paused) {
-        Scope& scope = cpu_profiler.m_scopes[++cpu_profiler.m_current_scope & SCOPE_MASK];
-        scope.scope_name = m_scope_name;
-        scope.thread_name = ConcurrencyUtils::get_current_thread_name();
-        scope.begin_timestamp = m_begin_timestamp;
-        scope.end_timestamp = get_current_timestamp();
+        uint64_t end_tick = get_current_tick();
+
+        ThreadBuffer& thread_buffer = cpu_profiler.get_thread_buffer();
+
+        uint64_t write_index = thread_buffer.write_index.load(std::memory_order_relaxed);
+
+        ThreadBuffer::Entry& entry = thread_buffer.entries[write_index & ENTRY_MASK];
+        entry.begin_tick = m_begin_tick;
+        entry.end_tick = end_tick;
+        entry.scope_id = m_scope_id;
+
+        thread_buffer.write_index.store(write_index + 1, std::memory_order_release);
     }
 }
 
 CpuProfiler::CpuProfiler()
-    : m_scopes(SCOPE_COUNT, MallocMemoryResource::instance())
-    , m_current_scope(0)
-    , m_frames(FRAME_COUNT, MallocMemoryResource::instance())
+    : m_thread_buffers(MallocMemoryResource::instance())
+    , m_scope_names(MallocMemoryResource::instance())
+    , m_counter_names(MallocMemoryResource::instance())
+    , m_frames(FRAME_COUNT * MAX_THREAD_COUNT, MallocMemoryResource::instance())
     , m_current_frame(0)
+    , m_counter_totals(MAX_COUNTER_COUNT, MallocMemoryResource::instance())
+    , m_counter_values(FRAME_COUNT * MAX_COUNTER_COUNT, MallocMemoryResource::instance())
     , m_is_paused(false)
     , m_is_pause_scheduled(false)
+    , m_is_resume_scheduled(false)
 {
+    // Thread buffers are read without locking, so they must never be reallocated.
+    m_thread_buffers.reserve(MAX_THREAD_COUNT);
+
+    // Initial estimate, it gets more precise with each update.
+    m_calibration_timestamp = get_current_nanoseconds();
+    m_calibration_tick = get_current_tick();
+
+    uint64_t timestamp;
+    do {
+        timestamp = get_current_nanoseconds();
+    } while (timestamp - m_calibration_timestamp < 1000000);
+
+    m_nanoseconds_per_tick = static_cast<double>(timestamp - m_calibration_timestamp) / std::max(get_current_tick() - m_calibration_tick, uint64_t(1));
 }
 
 CpuProfiler& CpuProfiler::instance() {
@@ -54,9 +146,64 @@ CpuProfiler& CpuProfiler::instance() {
     return cpu_profiler;
 }
 
+uint64_t CpuProfiler::get_timestamp() {
+    return instance().to_timestamp(get_current_tick());
+}
+
+uint32_t CpuProfiler::intern_scope(const char* name) {
+    return intern(m_scope_names, name);
+}
+
+uint32_t CpuProfiler::intern_counter(const char* name) {
+    uint32_t counter_id = intern(m_counter_names, name);
+    KW_ERROR(counter_id < MAX_COUNTER_COUNT, "Too many profiler counters.");
+    return counter_id;
+}
+
+void CpuProfiler::add_counter_value(uint32_t counter_id, int64_t value) {
+    KW_ASSERT(counter_id < MAX_COUNTER_COUNT);
+
+    // Only the owner thread writes to its counters, so no need for atomic increment.
+    std::atomic<int64_t>& counter = get_thread_buffer().counters[counter_id];
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
 void CpuProfiler::update() {
+    size_t thread_count;
+    size_t counter_count;
+
+    {
+        std::lock_guard lock(m_mutex);
+        thread_count = m_thread_buffers.size();
+        counter_count = m_counter_names.size();
+    }
+
     if (!m_is_paused) {
-        m_frames[++m_current_frame & FRAME_MASK] = m_current_scope & SCOPE_MASK;
+        uint64_t* frame = &m_frames[(++m_current_frame & FRAME_MASK) * MAX_THREAD_COUNT];
+        for (size_t i = 0; i < thread_count; i++) {
+            frame[i] = m_thread_buffers[i]->write_index.load(std::memory_order_acquire);
+        }
+    }
+
+    // Counters keep accumulating while paused, those values are not shown.
+    for (size_t i = 0; i < counter_count; i++) {
+        int64_t total = 0;
+        for (size_t j = 0; j < thread_count; j++) {
+            total += m_thread_buffers[j]->counters[i].load(std::memory_order_relaxed);
+        }
+
+        if (!m_is_paused) {
+            m_counter_values[(m_current_frame & FRAME_MASK) * MAX_COUNTER_COUNT + i] = total - m_counter_totals[i];
+        }
+
+        m_counter_totals[i] = total;
+    }
+
+    // The longer the time since calibration, the more precise the ratio.
+    uint64_t tick = get_current_tick();
+    uint64_t timestamp = get_current_nanoseconds();
+    if (tick > m_calibration_tick && timestamp > m_calibration_timestamp) {
+        m_nanoseconds_per_tick = static_cast<double>(timestamp - m_calibration_timestamp) / (tick - m_calibration_tick);
     }
 
     if (m_is_resume_scheduled) {
@@ -97,27 +244,14 @@ size_t CpuProfiler::get_frame_count() const {
     return FRAME_COUNT - 1;
 }
 
+uint64_t CpuProfiler::get_frame_index() const {
+    return m_current_frame;
+}
+
 Vector<CpuProfiler::Scope> CpuProfiler::get_scopes(MemoryResource& memory_resource, size_t relative_frame) const {
     Vector<Scope> result(memory_resource);
 
-    // One extra frame is needed for `rend` calculation.
-    relative_frame = std::min(relative_frame, FRAME_COUNT - 2);
-
-    size_t scope_index_rbegin = m_frames[(m_current_frame + FRAME_COUNT - relative_frame) & FRAME_MASK];
-    size_t scope_index_rend = m_frames[(m_current_frame + FRAME_COUNT - relative_frame - 1) & FRAME_MASK];
-
-    size_t scope_count;
-    if (scope_index_rbegin >= scope_index_rend) {
-        scope_count = scope_index_rbegin - scope_index_rend;
-    } else {
-        scope_count = SCOPE_COUNT - scope_index_rend + scope_index_rbegin;
-    }
-
-    result.resize(scope_count);
-
-    for (size_t i = 0, j = scope_index_rend + 1; i < scope_count; i++, j++) {
-        result[i] = m_scopes[j & SCOPE_MASK];
-    }
+    append_scopes(result, relative_frame);
 
     std::sort(result.begin(), result.end(), [](const Scope& lhs, const Scope& rhs) {
         if (lhs.begin_timestamp == rhs.begin_timestamp) {
@@ -129,4 +263,121 @@ Vector<CpuProfiler::Scope> CpuProfiler::get_scopes(MemoryResource& memory_resour
     return result;
 }
 
+void CpuProfiler::append_scopes(Vector<Scope>& output, size_t relative_frame) const {
+    output.reserve(output.size() + get_scope_count(relative_frame));
+
+    // Scope names may be reallocated by `intern_scope`.
+    std::lock_guard lock(m_mutex);
+
+    for (size_t i = 0; i < m_thread_buffers.size(); i++) {
+        const ThreadBuffer& thread_buffer = *m_thread_buffers[i];
+
+        uint64_t begin;
+        uint64_t end;
+        get_entry_range(i, relative_frame, begin, end);
+
+        for (uint64_t j = begin; j < end; j++) {
+            const ThreadBuffer::Entry& entry = thread_buffer.entries[j & ENTRY_MASK];
+            output.push_back(Scope{
+                m_scope_names[entry.scope_id], thread_buffer.name, to_timestamp(entry.begin_tick), to_timestamp(entry.end_tick)
+            });
+        }
+    }
+}
+
+size_t CpuProfiler::get_scope_count(size_t relative_frame) const {
+    std::lock_guard lock(m_mutex);
+
+    size_t result = 0;
+
+    for (size_t i = 0; i < m_thread_buffers.size(); i++) {
+        uint64_t begin;
+        uint64_t end;
+        get_entry_range(i, relative_frame, begin, end);
+
+        result += end - begin;
+    }
+
+    return result;
+}
+
+size_t CpuProfiler::get_counter_count() const {
+    std::lock_guard lock(m_mutex);
+    return m_counter_names.size();
+}
+
+const char* CpuProfiler::get_counter_name(uint32_t counter_id) const {
+    std::lock_guard lock(m_mutex);
+    KW_ASSERT(counter_id < m_counter_names.size());
+    return m_counter_names[counter_id];
+}
+
+int64_t CpuProfiler::get_counter_value(uint32_t counter_id, size_t relative_frame) const {
+    KW_ASSERT(counter_id < MAX_COUNTER_COUNT);
+
+    relative_frame = std::min(relative_frame, FRAME_COUNT - 1);
+
+    return m_counter_values[((m_current_frame + FRAME_COUNT - relative_frame) & FRAME_MASK) * MAX_COUNTER_COUNT + counter_id];
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::get_thread_buffer() {
+    thread_local ThreadBuffer* thread_buffer = nullptr;
+
+    if (thread_buffer == nullptr) {
+        std::lock_guard lock(m_mutex);
+
+        KW_ERROR(m_thread_buffers.size() < MAX_THREAD_COUNT, "Too many profiled threads.");
+
+        // Thread name is copied because thread's name storage is destroyed when the thread exits.
+        thread_buffer = MallocMemoryResource::instance().construct<ThreadBuffer>();
+        std::strncpy(thread_buffer->name, ConcurrencyUtils::get_current_thread_name(), sizeof(thread_buffer->name) - 1);
+
+        m_thread_buffers.push_back(thread_buffer);
+    }
+
+    return *thread_buffer;
+}
+
+uint32_t CpuProfiler::intern(Vector<const char*>& names, const char* name) {
+    KW_ASSERT(name != nullptr);
+
+    std::lock_guard lock(m_mutex);
+
+    // Interning happens once per call site, so linear search is fine.
+    for (size_t i = 0; i < names.size(); i++) {
+        if (std::strcmp(names[i], name) == 0) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+
+    size_t length = std::strlen(name) + 1;
+
+    char* copy = MallocMemoryResource::instance().allocate<char>(length);
+    std::memcpy(copy, name, length);
+
+    names.push_back(copy);
+
+    return static_cast<uint32_t>(names.size() - 1);
+}
+
+void CpuProfiler::get_entry_range(size_t thread_index, size_t relative_frame, uint64_t& begin, uint64_t& end) const {
+    // One extra frame is needed for `rend` calculation.
+    relative_frame = std::min(relative_frame, FRAME_COUNT - 2);
+
+    end = m_frames[((m_current_frame + FRAME_COUNT - relative_frame) & FRAME_MASK) * MAX_THREAD_COUNT + thread_index];
+    begin = m_frames[((m_current_frame + FRAME_COUNT - relative_frame - 1) & FRAME_MASK) * MAX_THREAD_COUNT + thread_index];
+
+    // Older entries are overwritten.
+    uint64_t write_index = m_thread_buffers[thread_index]->write_index.load(std::memory_order_acquire);
+    if (write_index > ENTRY_COUNT) {
+        begin = std::max(begin, write_index - ENTRY_COUNT);
+        end = std::max(end, begin);
+    }
+}
+
+uint64_t CpuProfiler::to_timestamp(uint64_t tick) const {
+    int64_t relative_tick = static_cast<int64_t>(tick - m_calibration_tick);
+    return m_calibration_timestamp + static_cast<int64_t>(relative_tick * m_nanoseconds_per_tick);
+}
+
 } // namespace kw
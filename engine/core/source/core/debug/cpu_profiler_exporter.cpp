@@ -0,0 +1,333 @@
+#include "core/debug/cpu_profiler_exporter.h"
+#include "core/concurrency/concurrency_utils.h"
+#include "core/debug/assert.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace kw {
+
+static constexpr size_t BUFFER_SIZE = 65536;
+
+CpuProfilerExporter::Batch::Batch(MemoryResource& memory_resource)
+    : events(memory_resource)
+    , thread_names(memory_resource)
+    , frame_markers(memory_resource)
+    , counter_samples(memory_resource)
+{
+}
+
+CpuProfilerExporter::CpuProfilerExporter(const CpuProfilerExporterDescriptor& descriptor)
+    : m_persistent_memory_resource(*descriptor.persistent_memory_resource)
+    , m_scopes(*descriptor.persistent_memory_resource)
+    , m_thread_names(*descriptor.persistent_memory_resource)
+    , m_last_frame_index(0)
+    , m_remaining_frame_count(0)
+    , m_is_capturing(false)
+    , m_written_batch(*descriptor.persistent_memory_resource)
+    , m_buffer(BUFFER_SIZE, *descriptor.persistent_memory_resource)
+    , m_buffer_size(0)
+    , m_is_first_event(true)
+    , m_pending_batch(*descriptor.persistent_memory_resource)
+    , m_base_timestamp(0)
+    , m_is_finish_requested(false)
+    , m_is_destroy_requested(false)
+    , m_dropped_scope_count(0)
+{
+    KW_ASSERT(descriptor.persistent_memory_resource != nullptr);
+
+    // Half of the budget is being filled while the other half is being written.
+    size_t event_count = descriptor.memory_budget / sizeof(Event) / 2;
+    KW_ASSERT(event_count > 0, "Memory budget is too small.");
+
+    m_pending_batch.events.reserve(event_count);
+    m_written_batch.events.reserve(event_count);
+
+    m_thread = std::thread(&CpuProfilerExporter::writer_thread, this);
+}
+
+CpuProfilerExporter::~CpuProfilerExporter() {
+    if (m_is_capturing) {
+        end_capture();
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_is_destroy_requested = true;
+    }
+
+    m_writer_condition_variable.notify_one();
+
+    m_thread.join();
+}
+
+bool CpuProfilerExporter::begin_capture(const char* path, uint64_t frame_count) {
+    KW_ASSERT(path != nullptr);
+    KW_ASSERT(frame_count > 0);
+
+    if (m_is_capturing) {
+        return false;
+    }
+
+    std::unique_lock lock(m_mutex);
+
+    // The writer thread owns the file until the previous capture is finished.
+    m_finish_condition_variable.wait(lock, [this] { return !m_is_finish_requested; });
+
+    m_writer = BinaryWriter(path);
+    if (!m_writer) {
+        return false;
+    }
+
+    const char* header = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    if (!m_writer.write(header, std::strlen(header))) {
+        m_writer = BinaryWriter();
+        return false;
+    }
+
+    m_base_timestamp = CpuProfiler::get_timestamp();
+    m_dropped_scope_count = 0;
+
+    // Thread names are written once per capture.
+    m_thread_names.clear();
+
+    m_last_frame_index = CpuProfiler::instance().get_frame_index();
+    m_remaining_frame_count = frame_count;
+    m_is_capturing = true;
+
+    return true;
+}
+
+void CpuProfilerExporter::end_capture() {
+    KW_ASSERT(m_is_capturing);
+
+    m_is_capturing = false;
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_is_finish_requested = true;
+    }
+
+    m_writer_condition_variable.notify_one();
+}
+
+bool CpuProfilerExporter::is_capturing() const {
+    return m_is_capturing;
+}
+
+uint64_t CpuProfilerExporter::get_dropped_scope_count() const {
+    return m_dropped_scope_count;
+}
+
+void CpuProfilerExporter::update() {
+    if (!m_is_capturing) {
+        return;
+    }
+
+    CpuProfiler& cpu_profiler = CpuProfiler::instance();
+
+    // Paused profiler doesn't record new frames.
+    uint64_t frame_index = cpu_profiler.get_frame_index();
+    if (frame_index == m_last_frame_index) {
+        return;
+    }
+
+    m_last_frame_index = frame_index;
+
+    // Copy scopes outside of the lock, the ring buffer may be overwritten on the next frame.
+    m_scopes.clear();
+    cpu_profiler.append_scopes(m_scopes);
+
+    {
+        std::lock_guard lock(m_mutex);
+
+        Vector<Event>& events = m_pending_batch.events;
+
+        // Drop the entire frame rather than a part of it, so the frames that are written are complete.
+        if (events.size() + m_scopes.size() <= events.capacity()) {
+            for (const CpuProfiler::Scope& scope : m_scopes) {
+                events.push_back(Event{ scope.scope_name, get_thread_id(scope.thread_name), scope.begin_timestamp, scope.end_timestamp });
+            }
+        } else {
+            m_dropped_scope_count += m_scopes.size();
+        }
+
+        uint64_t timestamp = CpuProfiler::get_timestamp();
+
+        m_pending_batch.frame_markers.push_back(FrameMarker{ frame_index, timestamp });
+
+        for (uint32_t i = 0; i < cpu_profiler.get_counter_count(); i++) {
+            m_pending_batch.counter_samples.push_back(CounterSample{ cpu_profiler.get_counter_name(i), cpu_profiler.get_counter_value(i), timestamp });
+        }
+    }
+
+    m_writer_condition_variable.notify_one();
+
+    if (--m_remaining_frame_count == 0) {
+        end_capture();
+    }
+}
+
+void CpuProfilerExporter::writer_thread() {
+    ConcurrencyUtils::set_current_thread_name("Profiler Exporter");
+
+    std::unique_lock lock(m_mutex);
+
+    while (true) {
+        m_writer_condition_variable.wait(lock, [this] {
+            return !m_pending_batch.events.empty() || !m_pending_batch.thread_names.empty() ||
+                   !m_pending_batch.frame_markers.empty() || !m_pending_batch.counter_samples.empty() ||
+                   m_is_finish_requested || m_is_destroy_requested;
+        });
+
+        std::swap(m_pending_batch.events, m_written_batch.events);
+        std::swap(m_pending_batch.thread_names, m_written_batch.thread_names);
+        std::swap(m_pending_batch.frame_markers, m_written_batch.frame_markers);
+        std::swap(m_pending_batch.counter_samples, m_written_batch.counter_samples);
+
+        uint64_t base_timestamp = m_base_timestamp;
+        bool is_finish_requested = m_is_finish_requested;
+        bool is_destroy_requested = m_is_destroy_requested;
+
+        lock.unlock();
+
+        write_batch(m_written_batch, base_timestamp);
+
+        m_written_batch.events.clear();
+        m_written_batch.thread_names.clear();
+        m_written_batch.frame_markers.clear();
+        m_written_batch.counter_samples.clear();
+
+        if (is_finish_requested) {
+            write_format("\n]}\n");
+            flush_buffer();
+
+            m_writer = BinaryWriter();
+            m_is_first_event = true;
+        }
+
+        lock.lock();
+
+        if (is_finish_requested) {
+            m_is_finish_requested = false;
+            m_finish_condition_variable.notify_all();
+        }
+
+        if (is_destroy_requested) {
+            break;
+        }
+    }
+}
+
+void CpuProfilerExporter::write_batch(const Batch& batch, uint64_t base_timestamp) {
+    for (const ThreadName& thread_name : batch.thread_names) {
+        begin_event();
+        write_format("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"", thread_name.thread_id);
+        write_string(thread_name.name);
+        write_format("\"}}");
+    }
+
+    for (const Event& event : batch.events) {
+        // Scopes on background threads may begin before the capture.
+        double begin = static_cast<int64_t>(event.begin_timestamp - base_timestamp) / 1e3;
+        double duration = (event.end_timestamp - event.begin_timestamp) / 1e3;
+
+        begin_event();
+        write_format("{\"name\":\"");
+        write_string(event.scope_name);
+        write_format("\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", event.thread_id, begin, duration);
+    }
+
+    for (const FrameMarker& frame_marker : batch.frame_markers) {
+        double timestamp = static_cast<int64_t>(frame_marker.timestamp - base_timestamp) / 1e3;
+
+        begin_event();
+        write_format(
+            "{\"name\":\"Frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}",
+            static_cast<unsigned long long>(frame_marker.frame_index), timestamp
+        );
+    }
+
+    for (const CounterSample& counter_sample : batch.counter_samples) {
+        double timestamp = static_cast<int64_t>(counter_sample.timestamp - base_timestamp) / 1e3;
+
+        begin_event();
+        write_format("{\"name\":\"");
+        write_string(counter_sample.counter_name);
+        write_format(
+            "\",\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+            timestamp, static_cast<long long>(counter_sample.value)
+        );
+    }
+}
+
+void CpuProfilerExporter::begin_event() {
+    if (!m_is_first_event) {
+        write_format(",\n");
+    }
+    m_is_first_event = false;
+}
+
+void CpuProfilerExporter::write_string(const char* string) {
+    // Escape JSON special characters, which are unlikely in scope and thread names.
+    for (const char* character = string; *character != '\0'; character++) {
+        if (m_buffer_size + 6 > BUFFER_SIZE) {
+            flush_buffer();
+        }
+
+        if (*character == '"' || *character == '\\') {
+            m_buffer[m_buffer_size++] = '\\';
+            m_buffer[m_buffer_size++] = *character;
+        } else if (static_cast<unsigned char>(*character) < 0x20) {
+            m_buffer_size += std::snprintf(m_buffer.data() + m_buffer_size, 7, "\\u%04x", static_cast<unsigned>(*character));
+        } else {
+            m_buffer[m_buffer_size++] = *character;
+        }
+    }
+}
+
+void CpuProfilerExporter::write_format(const char* format, ...) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t available = BUFFER_SIZE - m_buffer_size;
+
+        va_list arguments;
+        va_start(arguments, format);
+        int length = std::vsnprintf(m_buffer.data() + m_buffer_size, available, format, arguments);
+        va_end(arguments);
+
+        KW_ASSERT(length >= 0 && static_cast<size_t>(length) < BUFFER_SIZE, "Invalid format.");
+
+        if (static_cast<size_t>(length) < available) {
+            m_buffer_size += length;
+            return;
+        }
+
+        flush_buffer();
+    }
+}
+
+void CpuProfilerExporter::flush_buffer() {
+    m_writer.write(m_buffer.data(), m_buffer_size);
+    m_buffer_size = 0;
+}
+
+uint32_t CpuProfilerExporter::get_thread_id(const char* thread_name) {
+    // Thread names are owned by the profiler's thread buffers, so the pointer identifies a thread. Only a few threads
+    // are expected, so linear search is fine.
+    for (size_t i = 0; i < m_thread_names.size(); i++) {
+        if (m_thread_names[i] == thread_name) {
+            return static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    m_thread_names.push_back(thread_name);
+
+    uint32_t thread_id = static_cast<uint32_t>(m_thread_names.size());
+
+    m_pending_batch.thread_names.push_back(ThreadName{ thread_id, thread_name });
+
+    return thread_id;
+}
+
+} // namespace kw
@@ -1,10 +1,30 @@
 #include "core/math/aabbox.h"
+#include "core/math/simd.h"
 #include "core/math/transform.h"
 
 namespace kw {
 
 // Transforming Axis-Aligned Bounding Boxes by Jim Arvo from "Graphics Gems", Academic Press, 1990.
 aabbox aabbox::operator*(const float4x4& rhs) const {
+#ifdef KW_SIMD
+    // Equivalent to the method below: the center is transformed as a point, the extent is scaled by absolute values.
+    simd::vfloat4x4 matrix = simd::load4x4(rhs.cells);
+    simd::vfloat4 old_center = simd::load3(center.data);
+    simd::vfloat4 old_extent = simd::load3(extent.data);
+
+    simd::vfloat4 new_center = simd::madd(simd::broadcast<0>(old_center), matrix.rows[0], matrix.rows[3]);
+    new_center = simd::madd(simd::broadcast<1>(old_center), matrix.rows[1], new_center);
+    new_center = simd::madd(simd::broadcast<2>(old_center), matrix.rows[2], new_center);
+
+    simd::vfloat4 new_extent = simd::mul(simd::broadcast<0>(old_extent), simd::abs(matrix.rows[0]));
+    new_extent = simd::madd(simd::broadcast<1>(old_extent), simd::abs(matrix.rows[1]), new_extent);
+    new_extent = simd::madd(simd::broadcast<2>(old_extent), simd::abs(matrix.rows[2]), new_extent);
+
+    aabbox result;
+    simd::store3(result.center.data, new_center);
+    simd::store3(result.extent.data, new_extent);
+    return result;
+#else
     float3 old_min = center - extent;
     float3 old_max = center + extent;
 
@@ -26,6 +46,7 @@ aabbox aabbox::operator*(const float4x4& rhs) const {
     }
 
     return from_min_max(new_min, new_max);
+#endif // KW_SIMD
 }
 
 aabbox aabbox::operator*(const transform& rhs) const {
@@ -0,0 +1,99 @@
+#include "core/math/frustum.h"
+#include "core/math/simd.h"
+
+namespace kw {
+
+// Near and far planes are tested first, because they usually reject the most boxes.
+static constexpr size_t PLANE_ORDER[] = { 4, 5, 0, 1, 2, 3 };
+
+void intersect(const float* center_x, const float* center_y, const float* center_z,
+               const float* extent_x, const float* extent_y, const float* extent_z,
+               size_t count, const frustum& frustum, uint64_t* intersect_mask, uint64_t* inside_mask)
+{
+    for (size_t i = 0; i < (count + 63) / 64; i++) {
+        intersect_mask[i] = 0;
+    }
+
+    if (inside_mask != nullptr) {
+        for (size_t i = 0; i < (count + 63) / 64; i++) {
+            inside_mask[i] = 0;
+        }
+    }
+
+    size_t i = 0;
+
+#ifdef KW_SIMD
+    simd::vfloat4 normal_x[6];
+    simd::vfloat4 normal_y[6];
+    simd::vfloat4 normal_z[6];
+    simd::vfloat4 distance[6];
+    simd::vfloat4 abs_normal_x[6];
+    simd::vfloat4 abs_normal_y[6];
+    simd::vfloat4 abs_normal_z[6];
+
+    for (size_t j = 0; j < 6; j++) {
+        const plane& plane = frustum.data[PLANE_ORDER[j]];
+
+        normal_x[j] = simd::splat(plane.normal.x);
+        normal_y[j] = simd::splat(plane.normal.y);
+        normal_z[j] = simd::splat(plane.normal.z);
+        distance[j] = simd::splat(plane.distance);
+        abs_normal_x[j] = simd::abs(normal_x[j]);
+        abs_normal_y[j] = simd::abs(normal_y[j]);
+        abs_normal_z[j] = simd::abs(normal_z[j]);
+    }
+
+    simd::vfloat4 zero = simd::splat(0.f);
+
+    for (; i + 4 <= count; i += 4) {
+        simd::vfloat4 box_center_x = simd::load(center_x + i);
+        simd::vfloat4 box_center_y = simd::load(center_y + i);
+        simd::vfloat4 box_center_z = simd::load(center_z + i);
+        simd::vfloat4 box_extent_x = simd::load(extent_x + i);
+        simd::vfloat4 box_extent_y = simd::load(extent_y + i);
+        simd::vfloat4 box_extent_z = simd::load(extent_z + i);
+
+        int intersect_bits = 0b1111;
+        int inside_bits = 0b1111;
+
+        for (size_t j = 0; j < 6 && intersect_bits != 0; j++) {
+            simd::vfloat4 signed_distance = simd::madd(box_center_x, normal_x[j], simd::madd(box_center_y, normal_y[j], simd::madd(box_center_z, normal_z[j], distance[j])));
+            simd::vfloat4 radius = simd::madd(box_extent_x, abs_normal_x[j], simd::madd(box_extent_y, abs_normal_y[j], simd::mul(box_extent_z, abs_normal_z[j])));
+
+            intersect_bits &= ~simd::movemask(simd::less(signed_distance, simd::sub(zero, radius)));
+            inside_bits &= ~simd::movemask(simd::less(signed_distance, radius));
+        }
+
+        intersect_mask[i / 64] |= static_cast<uint64_t>(intersect_bits) << (i % 64);
+
+        if (inside_mask != nullptr) {
+            inside_mask[i / 64] |= static_cast<uint64_t>(intersect_bits & inside_bits) << (i % 64);
+        }
+    }
+#endif // KW_SIMD
+
+    for (; i < count; i++) {
+        bool is_intersecting = true;
+        bool is_inside = true;
+
+        for (size_t j = 0; j < 6 && is_intersecting; j++) {
+            const plane& plane = frustum.data[PLANE_ORDER[j]];
+
+            float signed_distance = center_x[i] * plane.normal.x + center_y[i] * plane.normal.y + center_z[i] * plane.normal.z + plane.distance;
+            float radius = extent_x[i] * std::abs(plane.normal.x) + extent_y[i] * std::abs(plane.normal.y) + extent_z[i] * std::abs(plane.normal.z);
+
+            is_intersecting = signed_distance >= -radius;
+            is_inside = is_inside && signed_distance >= radius;
+        }
+
+        if (is_intersecting) {
+            intersect_mask[i / 64] |= 1ull << (i % 64);
+
+            if (inside_mask != nullptr && is_inside) {
+                inside_mask[i / 64] |= 1ull << (i % 64);
+            }
+        }
+    }
+}
+
+} // namespace kw
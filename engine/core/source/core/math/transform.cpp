@@ -21,4 +21,104 @@ transform::transform(const float4x4& value) {
     rotation = quaternion(without_scale);
 }
 
+void multiply(const transform* lhs, const transform& rhs, transform* result, size_t count) {
+    size_t i = 0;
+
+#ifdef KW_SIMD
+    using simd::vfloat4;
+    using simd::vfloat4x4;
+
+    static_assert(sizeof(transform) == sizeof(float) * 10, "Transform is expected to be tightly packed.");
+
+    vfloat4 rhs_translation_x = simd::splat(rhs.translation.x);
+    vfloat4 rhs_translation_y = simd::splat(rhs.translation.y);
+    vfloat4 rhs_translation_z = simd::splat(rhs.translation.z);
+    vfloat4 rhs_rotation_x = simd::splat(rhs.rotation.x);
+    vfloat4 rhs_rotation_y = simd::splat(rhs.rotation.y);
+    vfloat4 rhs_rotation_z = simd::splat(rhs.rotation.z);
+    vfloat4 rhs_rotation_w = simd::splat(rhs.rotation.w);
+    vfloat4 rhs_scale_x = simd::splat(rhs.scale.x);
+    vfloat4 rhs_scale_y = simd::splat(rhs.scale.y);
+    vfloat4 rhs_scale_z = simd::splat(rhs.scale.z);
+    vfloat4 two = simd::splat(2.f);
+
+    for (; i + 4 <= count; i += 4) {
+        // Convert four transforms to structure of arrays. Ten floats of each transform are loaded as three
+        // overlapping vectors `data[0..4]`, `data[4..8]` and `data[6..10]`.
+        vfloat4x4 a = simd::transpose(vfloat4x4{ { simd::load(lhs[i].data), simd::load(lhs[i + 1].data), simd::load(lhs[i + 2].data), simd::load(lhs[i + 3].data) } });
+        vfloat4x4 b = simd::transpose(vfloat4x4{ { simd::load(lhs[i].data + 4), simd::load(lhs[i + 1].data + 4), simd::load(lhs[i + 2].data + 4), simd::load(lhs[i + 3].data + 4) } });
+        vfloat4x4 c = simd::transpose(vfloat4x4{ { simd::load(lhs[i].data + 6), simd::load(lhs[i + 1].data + 6), simd::load(lhs[i + 2].data + 6), simd::load(lhs[i + 3].data + 6) } });
+
+        vfloat4 translation_x = a.rows[0];
+        vfloat4 translation_y = a.rows[1];
+        vfloat4 translation_z = a.rows[2];
+        vfloat4 rotation_x = a.rows[3];
+        vfloat4 rotation_y = b.rows[0];
+        vfloat4 rotation_z = b.rows[1];
+        vfloat4 rotation_w = b.rows[2];
+        vfloat4 scale_x = b.rows[3];
+        vfloat4 scale_y = c.rows[2];
+        vfloat4 scale_z = c.rows[3];
+
+        // Rotate translation by `rhs.rotation`, see `operator*(const float3&, const quaternion&)`.
+        vfloat4 cross_x = simd::nmadd(rhs_rotation_z, translation_y, simd::mul(rhs_rotation_y, translation_z));
+        vfloat4 cross_y = simd::nmadd(rhs_rotation_x, translation_z, simd::mul(rhs_rotation_z, translation_x));
+        vfloat4 cross_z = simd::nmadd(rhs_rotation_y, translation_x, simd::mul(rhs_rotation_x, translation_y));
+
+        vfloat4 double_cross_x = simd::nmadd(rhs_rotation_z, cross_y, simd::mul(rhs_rotation_y, cross_z));
+        vfloat4 double_cross_y = simd::nmadd(rhs_rotation_x, cross_z, simd::mul(rhs_rotation_z, cross_x));
+        vfloat4 double_cross_z = simd::nmadd(rhs_rotation_y, cross_x, simd::mul(rhs_rotation_x, cross_y));
+
+        translation_x = simd::madd(simd::madd(cross_x, rhs_rotation_w, double_cross_x), two, translation_x);
+        translation_y = simd::madd(simd::madd(cross_y, rhs_rotation_w, double_cross_y), two, translation_y);
+        translation_z = simd::madd(simd::madd(cross_z, rhs_rotation_w, double_cross_z), two, translation_z);
+
+        // Scale and translate.
+        translation_x = simd::madd(translation_x, rhs_scale_x, rhs_translation_x);
+        translation_y = simd::madd(translation_y, rhs_scale_y, rhs_translation_y);
+        translation_z = simd::madd(translation_z, rhs_scale_z, rhs_translation_z);
+
+        // `rhs.rotation * rotation`, see `quaternion::operator*`.
+        vfloat4 result_rotation_x = simd::mul(rhs_rotation_w, rotation_x);
+        result_rotation_x = simd::madd(rhs_rotation_x, rotation_w, result_rotation_x);
+        result_rotation_x = simd::madd(rhs_rotation_y, rotation_z, result_rotation_x);
+        result_rotation_x = simd::nmadd(rhs_rotation_z, rotation_y, result_rotation_x);
+
+        vfloat4 result_rotation_y = simd::mul(rhs_rotation_w, rotation_y);
+        result_rotation_y = simd::nmadd(rhs_rotation_x, rotation_z, result_rotation_y);
+        result_rotation_y = simd::madd(rhs_rotation_y, rotation_w, result_rotation_y);
+        result_rotation_y = simd::madd(rhs_rotation_z, rotation_x, result_rotation_y);
+
+        vfloat4 result_rotation_z = simd::mul(rhs_rotation_w, rotation_z);
+        result_rotation_z = simd::madd(rhs_rotation_x, rotation_y, result_rotation_z);
+        result_rotation_z = simd::nmadd(rhs_rotation_y, rotation_x, result_rotation_z);
+        result_rotation_z = simd::madd(rhs_rotation_z, rotation_w, result_rotation_z);
+
+        vfloat4 result_rotation_w = simd::mul(rhs_rotation_w, rotation_w);
+        result_rotation_w = simd::nmadd(rhs_rotation_x, rotation_x, result_rotation_w);
+        result_rotation_w = simd::nmadd(rhs_rotation_y, rotation_y, result_rotation_w);
+        result_rotation_w = simd::nmadd(rhs_rotation_z, rotation_z, result_rotation_w);
+
+        scale_x = simd::mul(rhs_scale_x, scale_x);
+        scale_y = simd::mul(rhs_scale_y, scale_y);
+        scale_z = simd::mul(rhs_scale_z, scale_z);
+
+        // Convert back to array of structures. Overlapping stores write the same values.
+        a = simd::transpose(vfloat4x4{ { translation_x, translation_y, translation_z, result_rotation_x } });
+        b = simd::transpose(vfloat4x4{ { result_rotation_y, result_rotation_z, result_rotation_w, scale_x } });
+        c = simd::transpose(vfloat4x4{ { result_rotation_w, scale_x, scale_y, scale_z } });
+
+        for (size_t j = 0; j < 4; j++) {
+            simd::store(result[i + j].data, a.rows[j]);
+            simd::store(result[i + j].data + 4, b.rows[j]);
+            simd::store(result[i + j].data + 6, c.rows[j]);
+        }
+    }
+#endif // KW_SIMD
+
+    for (; i < count; i++) {
+        result[i] = lhs[i] * rhs;
+    }
+}
+
 } // namespace kw
@@ -1,5 +1,6 @@
 #include "core/memory/buddy_memory_resource.h"
 #include "core/debug/assert.h"
+#include "core/math/scalar.h"
 
 #include <algorithm>
 #include <cstddef>
@@ -11,6 +12,7 @@ BuddyMemoryResource::BuddyMemoryResource(MemoryResource& memory_resource, size_t
     : m_memory_resource(memory_resource)
     , m_leaf_size_log2(static_cast<uint32_t>(leaf_size_log2))
     , m_max_depth(static_cast<uint32_t>(root_size_log2 - leaf_size_log2))
+    , m_free_mask(0)
 {
     KW_ASSERT(root_size_log2 >= leaf_size_log2, "Root size must be not less than leaf size.");
     KW_ASSERT(root_size_log2 - leaf_size_log2 < 27, "Binary tree height must be less than 27.");
@@ -20,14 +22,11 @@ BuddyMemoryResource::BuddyMemoryResource(MemoryResource& memory_resource, size_t
     m_leafs = memory_resource.allocate<Leaf>(1ull << m_max_depth);
     m_memory = memory_resource.allocate<uint8_t>(1ull << root_size_log2);
 
-    for (uint32_t i = 0; i < m_max_depth; i++) {
+    for (uint32_t i = 0; i <= m_max_depth; i++) {
         m_heads[i] = END;
     }
 
-    m_heads[m_max_depth] = 0;
-
-    m_leafs[0].depth = m_max_depth;
-    m_leafs[0].next = END;
+    push_node(0, m_max_depth);
 }
 
 BuddyMemoryResource::~BuddyMemoryResource() {
@@ -42,41 +41,34 @@ void* BuddyMemoryResource::allocate(size_t size, size_t alignment) {
     KW_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be power of two.");
     KW_ASSERT(size > 0, "Size must be greater than zero.");
 
-    uint32_t depth = 0;
-    size_t allocation_size = 1ull << m_leaf_size_log2;
-
-    // Search for the smallest available node.
-    while (depth < m_max_depth && (allocation_size < size || m_heads[depth] == END)) {
-        depth++;
-        allocation_size <<= 1;
+    uint32_t required_depth = get_depth(size);
+    if (required_depth > m_max_depth) {
+        return nullptr;
     }
 
-    // Check whether any node is found.
-    if (depth == m_max_depth && (allocation_size < size || m_heads[m_max_depth] == END)) {
+    // Search for the smallest available node.
+    uint32_t free_mask = m_free_mask & ~((1u << required_depth) - 1);
+    if (free_mask == 0) {
         return nullptr;
     }
 
+    uint32_t depth = log2(free_mask & (~free_mask + 1));
+    KW_ASSERT(depth >= required_depth && depth <= m_max_depth);
+
     // Split this node into two smaller nodes recursively.
     uint32_t local_offset = m_heads[depth];
     KW_ASSERT(m_leafs[local_offset].next != BUSY);
     KW_ASSERT(m_leafs[local_offset].depth == depth);
 
     // Remove this node from this depth's linked list.
-    m_heads[depth] = m_leafs[local_offset].next;
+    remove_node(local_offset, depth);
 
     // Split as many nodes as we can.
-    while (depth > 0 && (allocation_size >> 1) >= size) {
-        uint32_t buddy_offset = local_offset ^ (1u << (depth - 1));
-        // Buddy has undefined next and depth.
-
+    while (depth > required_depth) {
         depth--;
-        allocation_size >>= 1;
 
-        // Insert buddy node into the next depth's linked list.
-        uint32_t old_head = m_heads[depth];
-        m_heads[depth] = buddy_offset;
-        m_leafs[buddy_offset].next = old_head;
-        m_leafs[buddy_offset].depth = depth;
+        // Insert buddy node into the next depth's linked list. Buddy has undefined next and depth.
+        push_node(local_offset ^ (1u << depth), depth);
     }
 
     // Mark the node as busy, so it's buddy node doesn't merge into a parent node. Depth could've changed too.
@@ -88,23 +80,59 @@ void* BuddyMemoryResource::allocate(size_t size, size_t alignment) {
 }
 
 void* BuddyMemoryResource::reallocate(void* memory, size_t size, size_t alignment) {
-    void* result = allocate(size, alignment);
+    KW_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be power of two.");
+    KW_ASSERT(size > 0, "Size must be greater than zero.");
 
-    if (memory != nullptr && result != nullptr) {
-        KW_ASSERT(memory >= m_memory && memory < static_cast<uint8_t*>(m_memory) + (1ull << (m_leaf_size_log2 + m_max_depth)));
+    if (memory == nullptr) {
+        return allocate(size, alignment);
+    }
 
-        size_t offset = static_cast<uint8_t*>(memory) - static_cast<uint8_t*>(m_memory);
-        KW_ASSERT(((offset >> m_leaf_size_log2) << m_leaf_size_log2) == offset);
+    uint32_t local_offset = get_local_offset(memory);
+    uint32_t depth = m_leafs[local_offset].depth;
 
-        uint32_t local_offset = static_cast<uint32_t>(offset >> m_leaf_size_log2);
-        KW_ASSERT(m_leafs[local_offset].next == BUSY);
+    uint32_t required_depth = get_depth(size);
+    if (required_depth > m_max_depth) {
+        return nullptr;
+    }
 
-        uint32_t depth = m_leafs[local_offset].depth;
-        KW_ASSERT(depth <= m_max_depth);
+    if (required_depth <= depth) {
+        // Shrink in place by returning the right halves to the free lists. Their buddies are busy, so no merging.
+        while (depth > required_depth) {
+            depth--;
+            push_node(local_offset ^ (1u << depth), depth);
+        }
 
-        size_t old_size = 1ull << (m_leaf_size_log2 + depth);
+        m_leafs[local_offset].depth = depth;
 
-        std::memcpy(result, memory, std::min(size, old_size));
+        return memory;
+    }
+
+    // Check whether this node is a left child on every level up to the required depth and all its buddies are free.
+    uint32_t current_depth = depth;
+    while (current_depth < required_depth) {
+        uint32_t buddy_offset = local_offset ^ (1u << current_depth);
+        if ((local_offset & (1u << current_depth)) != 0 || m_leafs[buddy_offset].next == BUSY || m_leafs[buddy_offset].depth != current_depth) {
+            break;
+        }
+        current_depth++;
+    }
+
+    if (current_depth == required_depth) {
+        // Grow in place by taking all buddies from their free lists.
+        while (depth < required_depth) {
+            remove_node(local_offset ^ (1u << depth), depth);
+            depth++;
+        }
+
+        m_leafs[local_offset].depth = depth;
+
+        return memory;
+    }
+
+    void* result = allocate(size, alignment);
+
+    if (result != nullptr) {
+        std::memcpy(result, memory, 1ull << (m_leaf_size_log2 + depth));
 
         deallocate(memory);
     }
@@ -114,37 +142,15 @@ void* BuddyMemoryResource::reallocate(void* memory, size_t size, size_t alignmen
 
 void BuddyMemoryResource::deallocate(void* memory) {
     if (memory != nullptr) {
-        KW_ASSERT(memory >= m_memory && memory < static_cast<uint8_t*>(m_memory) + (1ull << (m_leaf_size_log2 + m_max_depth)));
-
-        size_t offset = static_cast<uint8_t*>(memory) - static_cast<uint8_t*>(m_memory);
-        KW_ASSERT(((offset >> m_leaf_size_log2) << m_leaf_size_log2) == offset);
-
-        uint32_t local_offset = static_cast<uint32_t>(offset >> m_leaf_size_log2);
-        KW_ASSERT(m_leafs[local_offset].next == BUSY);
-
+        uint32_t local_offset = get_local_offset(memory);
         uint32_t depth = m_leafs[local_offset].depth;
-        KW_ASSERT(depth <= m_max_depth);
 
         uint32_t buddy_offset = local_offset ^ (1u << depth);
 
         // Merge as many nodes as we can.
         while (depth < m_max_depth && (m_leafs[buddy_offset].next != BUSY && m_leafs[buddy_offset].depth == depth)) {
             // Buddy offset must be stored in this depth's linked list.
-            uint32_t current_offset = m_heads[depth];
-            KW_ASSERT(current_offset != END);
-
-            // Remove buddy offset from this depth's linked list.
-            if (current_offset == buddy_offset) {
-                // Buddy offset is stored in the head.
-                m_heads[depth] = m_leafs[buddy_offset].next;
-            } else {
-                // Buddy offset is stored somewhere inside linked list.
-                while (m_leafs[current_offset].next != buddy_offset) {
-                    current_offset = m_leafs[current_offset].next;
-                    KW_ASSERT(current_offset != END);
-                }
-                m_leafs[current_offset].next = m_leafs[buddy_offset].next;
-            }
+            remove_node(buddy_offset, depth);
 
             depth++;
 
@@ -155,14 +161,93 @@ void BuddyMemoryResource::deallocate(void* memory) {
             buddy_offset = local_offset ^ (1u << depth);
         }
 
-        // Depth could've changed.
-        m_leafs[local_offset].depth = depth;
-
         // Store offset in a linked list for other allocations.
-        uint32_t old_head = m_heads[depth];
-        m_heads[depth] = local_offset;
-        m_leafs[local_offset].next = old_head;
+        push_node(local_offset, depth);
+    }
+}
+
+size_t BuddyMemoryResource::get_largest_free_size() const {
+    if (m_free_mask == 0) {
+        return 0;
     }
+
+    return 1ull << (m_leaf_size_log2 + log2(m_free_mask));
+}
+
+size_t BuddyMemoryResource::get_free_size_below(size_t size) const {
+    uint32_t max_depth = std::min(get_depth(size), m_max_depth + 1);
+
+    size_t result = 0;
+
+    for (uint32_t depth = 0; depth < max_depth; depth++) {
+        for (uint32_t local_offset = m_heads[depth]; local_offset != END; local_offset = m_leafs[local_offset].next) {
+            result += 1ull << (m_leaf_size_log2 + depth);
+        }
+    }
+
+    return result;
+}
+
+uint32_t BuddyMemoryResource::get_depth(size_t size) const {
+    uint32_t depth = 0;
+    size_t allocation_size = 1ull << m_leaf_size_log2;
+
+    while (depth <= m_max_depth && allocation_size < size) {
+        depth++;
+        allocation_size <<= 1;
+    }
+
+    return depth;
+}
+
+void BuddyMemoryResource::push_node(uint32_t local_offset, uint32_t depth) {
+    uint32_t old_head = m_heads[depth];
+    if (old_head != END) {
+        m_leafs[old_head].previous = local_offset;
+    }
+
+    m_heads[depth] = local_offset;
+    m_leafs[local_offset].next = old_head;
+    m_leafs[local_offset].depth = depth;
+    m_leafs[local_offset].previous = END;
+
+    m_free_mask |= 1u << depth;
+}
+
+void BuddyMemoryResource::remove_node(uint32_t local_offset, uint32_t depth) {
+    KW_ASSERT(m_leafs[local_offset].next != BUSY);
+    KW_ASSERT(m_leafs[local_offset].depth == depth);
+
+    uint32_t next = m_leafs[local_offset].next;
+    uint32_t previous = m_leafs[local_offset].previous;
+
+    if (previous != END) {
+        m_leafs[previous].next = next;
+    } else {
+        KW_ASSERT(m_heads[depth] == local_offset);
+        m_heads[depth] = next;
+    }
+
+    if (next != END) {
+        m_leafs[next].previous = previous;
+    }
+
+    if (m_heads[depth] == END) {
+        m_free_mask &= ~(1u << depth);
+    }
+}
+
+uint32_t BuddyMemoryResource::get_local_offset(void* memory) const {
+    KW_ASSERT(memory >= m_memory && memory < static_cast<uint8_t*>(m_memory) + (1ull << (m_leaf_size_log2 + m_max_depth)));
+
+    size_t offset = static_cast<uint8_t*>(memory) - static_cast<uint8_t*>(m_memory);
+    KW_ASSERT(((offset >> m_leaf_size_log2) << m_leaf_size_log2) == offset);
+
+    uint32_t local_offset = static_cast<uint32_t>(offset >> m_leaf_size_log2);
+    KW_ASSERT(m_leafs[local_offset].next == BUSY);
+    KW_ASSERT(m_leafs[local_offset].depth <= m_max_depth);
+
+    return local_offset;
 }
 
 } // namespace kw
@@ -0,0 +1,211 @@
+#include "core/memory/concurrent_paged_pool_memory_resource.h"
+#include "core/debug/assert.h"
+
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+
+namespace kw {
+
+static_assert(sizeof(void*) == sizeof(uint64_t), "Tagged pointers require 64-bit pointers.");
+
+static constexpr uint64_t POINTER_MASK = (1ull << 48) - 1;
+static constexpr uint64_t TAG_INCREMENT = 1ull << 48;
+
+inline void* get_pointer(uint64_t tagged_pointer) {
+    return reinterpret_cast<void*>(tagged_pointer & POINTER_MASK);
+}
+
+inline uint64_t make_tagged_pointer(void* pointer, uint64_t previous_tagged_pointer) {
+    KW_ASSERT((reinterpret_cast<uint64_t>(pointer) & ~POINTER_MASK) == 0, "Pointer doesn't fit in 48 bits.");
+    return ((previous_tagged_pointer & ~POINTER_MASK) + TAG_INCREMENT) | reinterpret_cast<uint64_t>(pointer);
+}
+
+inline void* get_next_item(void* item) {
+    void* result;
+    std::memcpy(&result, item, sizeof(void*));
+    return result;
+}
+
+inline void set_next_item(void* item, void* next) {
+    std::memcpy(item, &next, sizeof(void*));
+}
+
+ConcurrentPagedPoolMemoryResource::ConcurrentPagedPoolMemoryResource(MemoryResource& memory_resource, size_t allocation_size, size_t allocations_per_page)
+    : m_memory_resource(memory_resource)
+    , m_allocation_size(allocation_size)
+    , m_allocations_per_page(allocations_per_page)
+    , m_data_head(0)
+    , m_live_count(0)
+    , m_peak_count(0)
+    , m_page_head(nullptr)
+{
+    KW_ASSERT(allocation_size >= sizeof(void*), "Allocation size must be not less than 8 bytes.");
+    KW_ASSERT((allocation_size & (allocation_size - 1)) == 0, "Allocation size must be power of two.");
+    KW_ASSERT(allocations_per_page > 0, "At least one allocation per page is required.");
+}
+
+ConcurrentPagedPoolMemoryResource::~ConcurrentPagedPoolMemoryResource() {
+    KW_ASSERT(m_live_count == 0, "Not all items are deallocated.");
+
+    while (m_page_head != nullptr) {
+        void* next_page;
+        std::memcpy(&next_page, m_page_head, sizeof(void*));
+        m_memory_resource.deallocate(m_page_head);
+        m_page_head = next_page;
+    }
+}
+
+void* ConcurrentPagedPoolMemoryResource::allocate(size_t size, size_t alignment) {
+    KW_ASSERT(size <= m_allocation_size, "Invalid size.");
+    KW_ASSERT(m_allocation_size >= alignment && m_allocation_size % alignment == 0, "Invalid alignment.");
+
+    void* result;
+
+    uint64_t data_head = m_data_head.load(std::memory_order_acquire);
+    while (true) {
+        result = get_pointer(data_head);
+        if (result == nullptr) {
+            result = allocate_new_page();
+            break;
+        }
+
+        // The item might have been popped and even overwritten by another thread already. In that case the tag has
+        // changed and the exchange fails. Pages are never freed until destruction, so the read itself is safe.
+        void* next_item = get_next_item(result);
+
+        if (m_data_head.compare_exchange_weak(data_head, make_tagged_pointer(next_item, data_head), std::memory_order_acquire, std::memory_order_acquire)) {
+            break;
+        }
+    }
+
+    size_t live_count = ++m_live_count;
+
+    size_t peak_count = m_peak_count.load(std::memory_order_relaxed);
+    while (live_count > peak_count && !m_peak_count.compare_exchange_weak(peak_count, live_count, std::memory_order_relaxed));
+
+    return result;
+}
+
+void* ConcurrentPagedPoolMemoryResource::reallocate(void* memory, size_t size, size_t alignment) {
+    KW_ASSERT(size <= m_allocation_size, "Invalid size.");
+    KW_ASSERT(m_allocation_size >= alignment && m_allocation_size % alignment == 0, "Invalid alignment.");
+
+    if (memory == nullptr) {
+        return allocate(size, alignment);
+    }
+
+    // Reallocate for a pool memory resource doesn't make any sense.
+    return memory;
+}
+
+void ConcurrentPagedPoolMemoryResource::deallocate(void* memory) {
+    if (memory != nullptr) {
+        KW_ASSERT(is_valid_item(memory), "Memory out of range.");
+
+        push_items(memory, memory);
+
+        --m_live_count;
+    }
+}
+
+void ConcurrentPagedPoolMemoryResource::deallocate(void* const* memory, size_t count) {
+    KW_ASSERT(memory != nullptr || count == 0);
+
+    void* first = nullptr;
+    void* last = nullptr;
+    size_t chain_length = 0;
+
+    // Link items into a chain first, so the whole chain is pushed at once.
+    for (size_t i = 0; i < count; i++) {
+        if (memory[i] != nullptr) {
+            KW_ASSERT(is_valid_item(memory[i]), "Memory out of range.");
+
+            if (last == nullptr) {
+                last = memory[i];
+            }
+
+            set_next_item(memory[i], first);
+            first = memory[i];
+            chain_length++;
+        }
+    }
+
+    if (first != nullptr) {
+        push_items(first, last);
+
+        m_live_count -= chain_length;
+    }
+}
+
+size_t ConcurrentPagedPoolMemoryResource::get_live_count() const {
+    return m_live_count.load(std::memory_order_relaxed);
+}
+
+size_t ConcurrentPagedPoolMemoryResource::get_peak_count() const {
+    return m_peak_count.load(std::memory_order_relaxed);
+}
+
+void ConcurrentPagedPoolMemoryResource::push_items(void* first, void* last) {
+    uint64_t data_head = m_data_head.load(std::memory_order_relaxed);
+    do {
+        set_next_item(last, get_pointer(data_head));
+    } while (!m_data_head.compare_exchange_weak(data_head, make_tagged_pointer(first, data_head), std::memory_order_release, std::memory_order_relaxed));
+}
+
+void* ConcurrentPagedPoolMemoryResource::allocate_new_page() {
+    void* first_item;
+    void* last_item;
+
+    {
+        std::lock_guard lock(m_page_spinlock);
+
+        // Allocate enough memory for page, pointer to the next page and page alignment.
+        void* page = m_memory_resource.allocate(m_allocation_size * m_allocations_per_page + sizeof(void*) + (m_allocation_size - 1), alignof(void*));
+        KW_ASSERT(page != nullptr);
+
+        // Store address of the previous page at the beginning.
+        std::memcpy(page, &m_page_head, sizeof(void*));
+        m_page_head = page;
+
+        // Offset by next page pointer and align by allocation size.
+        first_item = reinterpret_cast<void*>((reinterpret_cast<size_t>(page) + sizeof(void*) + (m_allocation_size - 1)) & ~(m_allocation_size - 1));
+        last_item = static_cast<uint8_t*>(first_item) + m_allocation_size * (m_allocations_per_page - 1);
+    }
+
+    if (m_allocations_per_page > 1) {
+        // The first item is returned to the caller, the rest is pushed to the free list.
+        void* current_item = static_cast<uint8_t*>(first_item) + m_allocation_size;
+        while (current_item != last_item) {
+            void* next_item = static_cast<uint8_t*>(current_item) + m_allocation_size;
+            set_next_item(current_item, next_item);
+            current_item = next_item;
+        }
+
+        push_items(static_cast<uint8_t*>(first_item) + m_allocation_size, last_item);
+    }
+
+    return first_item;
+}
+
+bool ConcurrentPagedPoolMemoryResource::is_valid_item(void* memory) const {
+    if (reinterpret_cast<size_t>(memory) % m_allocation_size != 0) {
+        return false;
+    }
+
+    std::lock_guard lock(m_page_spinlock);
+
+    void* current_page = m_page_head;
+    while (current_page != nullptr) {
+        void* items_start = reinterpret_cast<void*>((reinterpret_cast<size_t>(current_page) + sizeof(void*) + (m_allocation_size - 1)) & ~(m_allocation_size - 1));
+        void* items_end = static_cast<uint8_t*>(items_start) + m_allocation_size * m_allocations_per_page;
+        if (memory >= items_start && memory < items_end) {
+            return true;
+        }
+        std::memcpy(&current_page, current_page, sizeof(void*));
+    }
+
+    return false;
+}
+
+} // namespace kw
@@ -37,7 +37,7 @@ void* PagedPoolMemoryResource::allocate(size_t size, size_t alignment) {
 
     // Remove storage from the linked list and return it.
     void* result = m_data_head;
-    std::memcpy(m_data_head, m_data_head, sizeof(void*));
+    std::memcpy(&m_data_head, m_data_head, sizeof(void*));
     return result;
 }
 
@@ -59,13 +59,13 @@ void PagedPoolMemoryResource::deallocate(void* memory) {
         // Check whether address is inside some of the pages.
         void* current_page = m_page_head;
         do {
-            void* items_start = reinterpret_cast<void*>((reinterpret_cast<size_t>(m_page_head) + sizeof(void*) + (m_allocation_size - 1)) & ~(m_allocation_size - 1));
+            void* items_start = reinterpret_cast<void*>((reinterpret_cast<size_t>(current_page) + sizeof(void*) + (m_allocation_size - 1)) & ~(m_allocation_size - 1));
             void* items_end = static_cast<uint8_t*>(items_start) + m_allocation_size * m_allocations_per_page;
             if (memory >= items_start && memory < items_end) {
                 valid_range = true;
                 break;
             }
-            std::memcpy(&current_page, m_page_head, sizeof(void*));
+            std::memcpy(&current_page, current_page, sizeof(void*));
         } while (current_page != nullptr);
 
         KW_ASSERT(valid_range, "Memory out of range.");
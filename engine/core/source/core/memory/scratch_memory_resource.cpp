@@ -1,21 +1,57 @@
 #include "core/memory/scratch_memory_resource.h"
 #include "core/debug/assert.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
 namespace kw {
 
+static constexpr size_t MAX_CHUNK_SIZE = 64 * 1024;
+
+// Smaller scratch memory resources don't use thread chunks at all.
+static constexpr size_t MIN_CHUNK_SIZE = 1024;
+
+// The number of scratch memory resources a thread can allocate from without losing its chunks.
+static constexpr size_t THREAD_CHUNK_COUNT = 4;
+
+struct ThreadChunk {
+    uint64_t token;
+    uint8_t* current;
+    uint8_t* end;
+};
+
+static std::atomic<uint64_t> next_token(1);
+
+static thread_local ThreadChunk thread_chunks[THREAD_CHUNK_COUNT];
+static thread_local size_t thread_chunk_victim = 0;
+
+inline uint8_t* align_pointer(uint8_t* pointer, size_t alignment) {
+    return reinterpret_cast<uint8_t*>((reinterpret_cast<size_t>(pointer) + (alignment - 1)) & ~(alignment - 1));
+}
+
 ScratchMemoryResource::ScratchMemoryResource(MemoryResource& memory_resource, size_t capacity)
     : m_memory_resource(&memory_resource)
+    , m_begin(static_cast<uint8_t*>(memory_resource.allocate(capacity, alignof(std::max_align_t))))
+    , m_end(m_begin + capacity)
+    , m_chunk_size(std::min(capacity / 64, MAX_CHUNK_SIZE))
+    , m_token(next_token++)
+    , m_offset(0)
+    , m_overflow(0)
+    , m_high_water_mark(0)
 {
-    m_begin = memory_resource.allocate(capacity, 1);
-    m_current = m_begin;
-    m_end = static_cast<uint8_t*>(m_begin) + capacity;
+    KW_ASSERT(m_begin != nullptr);
 }
 
 ScratchMemoryResource::ScratchMemoryResource(void* data, size_t capacity)
     : m_memory_resource(nullptr)
-    , m_begin(data)
-    , m_current(data)
-    , m_end(static_cast<uint8_t*>(data) + capacity)
+    , m_begin(static_cast<uint8_t*>(data))
+    , m_end(m_begin + capacity)
+    , m_chunk_size(std::min(capacity / 64, MAX_CHUNK_SIZE))
+    , m_token(next_token++)
+    , m_offset(0)
+    , m_overflow(0)
+    , m_high_water_mark(0)
 {
 }
 
@@ -28,22 +64,22 @@ ScratchMemoryResource::~ScratchMemoryResource() {
 void* ScratchMemoryResource::allocate(size_t size, size_t alignment) {
     KW_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be power of two.");
     KW_ASSERT(size > 0, "Size must be greater than zero.");
-    
-    void* old_value = m_current.load(std::memory_order_relaxed);
-    while (true) {
-        void* result = reinterpret_cast<void*>((reinterpret_cast<size_t>(old_value) + (alignment - 1)) & ~(alignment - 1));
-        if (m_current.compare_exchange_weak(old_value, reinterpret_cast<void*>(reinterpret_cast<size_t>(result) + size), std::memory_order_release, std::memory_order_relaxed)) {
-            KW_ASSERT(reinterpret_cast<void*>(reinterpret_cast<size_t>(result) + size) <= m_end, "Linear allocator overflow. Consider increasing capacity.");
-            return result;
-        }
+
+    void* result = allocate_local(size, alignment);
+    if (result == nullptr) {
+        // Remember how much memory was needed for the high-water mark.
+        m_overflow.fetch_add(size, std::memory_order_relaxed);
     }
+
+    KW_ASSERT(result != nullptr, "Linear allocator overflow. Consider increasing capacity.");
+    return result;
 }
 
 void* ScratchMemoryResource::reallocate(void* memory, size_t size, size_t alignment) {
-    KW_ASSERT(memory == nullptr || (memory >= m_begin && memory < m_current), "Invalid reallocation.");
+    KW_ASSERT(memory == nullptr || (memory >= m_begin && memory < m_begin + m_offset.load(std::memory_order_relaxed)), "Invalid reallocation.");
 
     void* result = allocate(size, alignment);
-    if (memory != nullptr) {
+    if (memory != nullptr && result != nullptr) {
         std::memcpy(result, memory, size);
         deallocate(memory);
     }
@@ -55,7 +91,81 @@ void ScratchMemoryResource::deallocate(void* memory) {
 }
 
 void ScratchMemoryResource::reset() {
-    m_current = m_begin;
+    m_high_water_mark = get_high_water_mark();
+
+    m_offset = 0;
+    m_overflow = 0;
+
+    // Invalidate all thread chunks at once.
+    m_token = next_token++;
+}
+
+size_t ScratchMemoryResource::get_allocated_size() const {
+    return m_offset.load(std::memory_order_relaxed) + m_overflow.load(std::memory_order_relaxed);
+}
+
+size_t ScratchMemoryResource::get_high_water_mark() const {
+    return std::max(m_high_water_mark, get_allocated_size());
+}
+
+void* ScratchMemoryResource::allocate_local(size_t size, size_t alignment) {
+    if (m_chunk_size < MIN_CHUNK_SIZE || size + alignment > m_chunk_size / 4) {
+        // Large allocations would waste too much of a chunk.
+        return allocate_shared(size, alignment);
+    }
+
+    ThreadChunk* thread_chunk = nullptr;
+    for (ThreadChunk& chunk : thread_chunks) {
+        if (chunk.token == m_token) {
+            thread_chunk = &chunk;
+            break;
+        }
+    }
+
+    if (thread_chunk != nullptr) {
+        uint8_t* result = align_pointer(thread_chunk->current, alignment);
+        if (result + size <= thread_chunk->end) {
+            thread_chunk->current = result + size;
+            return result;
+        }
+    } else {
+        // Chunk of some other scratch memory resource (or a stale chunk of this one) is lost.
+        thread_chunk = &thread_chunks[thread_chunk_victim++ % THREAD_CHUNK_COUNT];
+    }
+
+    // The current chunk is exhausted, the rest of it is lost.
+    uint8_t* chunk = static_cast<uint8_t*>(allocate_shared(m_chunk_size, alignof(std::max_align_t)));
+    if (chunk == nullptr) {
+        // Chunk doesn't fit, but the allocation itself still might.
+        thread_chunk->token = 0;
+        return allocate_shared(size, alignment);
+    }
+
+    uint8_t* result = align_pointer(chunk, alignment);
+
+    thread_chunk->token = m_token;
+    thread_chunk->current = result + size;
+    thread_chunk->end = chunk + m_chunk_size;
+
+    return result;
+}
+
+void* ScratchMemoryResource::allocate_shared(size_t size, size_t alignment) {
+    size_t capacity = static_cast<size_t>(m_end - m_begin);
+
+    size_t old_offset = m_offset.load(std::memory_order_relaxed);
+    while (true) {
+        uint8_t* result = align_pointer(m_begin + old_offset, alignment);
+        size_t new_offset = static_cast<size_t>(result - m_begin) + size;
+        if (new_offset > capacity) {
+            // Don't move the offset, smaller allocations still might fit.
+            return nullptr;
+        }
+
+        if (m_offset.compare_exchange_weak(old_offset, new_offset, std::memory_order_relaxed, std::memory_order_relaxed)) {
+            return result;
+        }
+    }
 }
 
 } // namespace kw
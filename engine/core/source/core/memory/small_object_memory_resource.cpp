@@ -0,0 +1,385 @@
+#include "core/memory/small_object_memory_resource.h"
+#include "core/debug/assert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace kw {
+
+static constexpr size_t SIZE_CLASS_SIZES[SmallObjectMemoryResource::SIZE_CLASS_COUNT] = {
+    16,   32,   48,   64,   80,   96,   112,  128,
+    160,  192,  224,  256,  320,  384,  448,  512,
+    640,  768,  896,  1024, 1280, 1536, 1792, 2048,
+};
+
+// Slabs are aligned by their size, so the slab header can be found from any block address.
+static constexpr size_t SLAB_SIZE = 64 * 1024;
+static constexpr size_t SLAB_HEADER_SIZE = 64;
+static constexpr size_t SLABS_PER_SEGMENT = 64;
+static constexpr size_t SEGMENT_SIZE = SLAB_SIZE * SLABS_PER_SEGMENT;
+
+// Blocks are placed at `SLAB_HEADER_SIZE` multiples of their size, so that's the max supported alignment.
+static constexpr size_t MAX_SMALL_ALIGNMENT = SLAB_HEADER_SIZE;
+
+// The number of memory resources a thread can allocate from without losing its cached blocks.
+static constexpr size_t THREAD_CACHE_COUNT = 4;
+
+struct SlabHeader {
+    size_t size_class;
+};
+
+static_assert(sizeof(SlabHeader) <= SLAB_HEADER_SIZE);
+
+struct ThreadCache {
+    uint64_t token;
+    void* heads[SmallObjectMemoryResource::SIZE_CLASS_COUNT];
+    size_t counts[SmallObjectMemoryResource::SIZE_CLASS_COUNT];
+};
+
+static std::atomic<uint64_t> next_token(1);
+
+static thread_local ThreadCache thread_caches[THREAD_CACHE_COUNT];
+static thread_local size_t thread_cache_victim = 0;
+
+// The number of blocks moved between a thread cache and a size class at once. Smaller blocks move in larger batches.
+inline size_t get_batch_size(size_t size_class) {
+    return std::clamp(8192 / SIZE_CLASS_SIZES[size_class], size_t(4), size_t(64));
+}
+
+inline void* get_next_block(void* block) {
+    void* result;
+    std::memcpy(&result, block, sizeof(void*));
+    return result;
+}
+
+inline void set_next_block(void* block, void* next) {
+    std::memcpy(block, &next, sizeof(void*));
+}
+
+static ThreadCache& get_thread_cache(uint64_t token) {
+    for (ThreadCache& thread_cache : thread_caches) {
+        if (thread_cache.token == token) {
+            return thread_cache;
+        }
+    }
+
+    // Blocks cached for some other memory resource are lost, it might have already been destroyed.
+    ThreadCache& thread_cache = thread_caches[thread_cache_victim++ % THREAD_CACHE_COUNT];
+    thread_cache.token = token;
+    std::fill(std::begin(thread_cache.heads), std::end(thread_cache.heads), nullptr);
+    std::fill(std::begin(thread_cache.counts), std::end(thread_cache.counts), 0);
+    return thread_cache;
+}
+
+SmallObjectMemoryResource::SmallObjectMemoryResource(MemoryResource& memory_resource)
+    : m_memory_resource(memory_resource)
+    , m_token(next_token++)
+    , m_segments{}
+    , m_segment_begins{}
+    , m_segment_count(0)
+    , m_segment_sequence(0)
+    , m_current_segment_begin(nullptr)
+    , m_segment_slab_count(SLABS_PER_SEGMENT)
+{
+    for (SizeClass& size_class : m_size_classes) {
+        size_class.head = nullptr;
+        size_class.free_count = 0;
+        size_class.block_count = 0;
+        size_class.slab_count = 0;
+    }
+}
+
+SmallObjectMemoryResource::~SmallObjectMemoryResource() {
+    size_t segment_count = m_segment_count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < segment_count; i++) {
+        m_memory_resource.deallocate(m_segments[i]);
+    }
+}
+
+void* SmallObjectMemoryResource::allocate(size_t size, size_t alignment) {
+    KW_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be power of two.");
+    KW_ASSERT(size > 0, "Size must be greater than zero.");
+
+    size_t size_class = get_size_class(size, alignment);
+    if (size_class == SIZE_CLASS_COUNT) {
+        return m_memory_resource.allocate(size, alignment);
+    }
+
+    ThreadCache& thread_cache = get_thread_cache(m_token);
+
+    if (thread_cache.heads[size_class] == nullptr) {
+        thread_cache.counts[size_class] = acquire_blocks(size_class, thread_cache.heads[size_class], get_batch_size(size_class));
+        if (thread_cache.counts[size_class] == 0) {
+            // Out of segments.
+            return m_memory_resource.allocate(size, alignment);
+        }
+    }
+
+    void* result = thread_cache.heads[size_class];
+    thread_cache.heads[size_class] = get_next_block(result);
+    thread_cache.counts[size_class]--;
+
+    return result;
+}
+
+void* SmallObjectMemoryResource::reallocate(void* memory, size_t size, size_t alignment) {
+    KW_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be power of two.");
+    KW_ASSERT(size > 0, "Size must be greater than zero.");
+
+    if (memory == nullptr) {
+        return allocate(size, alignment);
+    }
+
+    size_t size_class = find_size_class(memory);
+    if (size_class == SIZE_CLASS_COUNT) {
+        // Large allocations stay in upstream memory resource even when they shrink.
+        return m_memory_resource.reallocate(memory, size, alignment);
+    }
+
+    size_t block_size = SIZE_CLASS_SIZES[size_class];
+    if (size <= block_size && alignment <= MAX_SMALL_ALIGNMENT && block_size % alignment == 0) {
+        // The block is large enough already.
+        return memory;
+    }
+
+    void* result = allocate(size, alignment);
+    if (result != nullptr) {
+        std::memcpy(result, memory, std::min(size, block_size));
+        deallocate(memory);
+    }
+    return result;
+}
+
+void SmallObjectMemoryResource::deallocate(void* memory) {
+    if (memory != nullptr) {
+        size_t size_class = find_size_class(memory);
+        if (size_class == SIZE_CLASS_COUNT) {
+            m_memory_resource.deallocate(memory);
+            return;
+        }
+
+        ThreadCache& thread_cache = get_thread_cache(m_token);
+
+        set_next_block(memory, thread_cache.heads[size_class]);
+        thread_cache.heads[size_class] = memory;
+
+        // Return half of the cached blocks when there's too many, so they can be reused by other threads.
+        size_t batch_size = get_batch_size(size_class);
+        if (++thread_cache.counts[size_class] > batch_size * 2) {
+            release_blocks(size_class, thread_cache.heads[size_class], batch_size);
+            thread_cache.counts[size_class] -= batch_size;
+        }
+    }
+}
+
+SmallObjectMemoryResource::SizeClassStatistics SmallObjectMemoryResource::get_size_class_statistics(size_t size_class) const {
+    KW_ASSERT(size_class < SIZE_CLASS_COUNT, "Invalid size class.");
+
+    const SizeClass& size_class_data = m_size_classes[size_class];
+    std::lock_guard lock(size_class_data.spinlock);
+
+    SizeClassStatistics result;
+    result.block_size = SIZE_CLASS_SIZES[size_class];
+    result.slab_count = size_class_data.slab_count;
+    result.live_bytes = (size_class_data.block_count - size_class_data.free_count) * SIZE_CLASS_SIZES[size_class];
+    result.free_bytes = size_class_data.free_count * SIZE_CLASS_SIZES[size_class];
+    return result;
+}
+
+float SmallObjectMemoryResource::get_fragmentation() const {
+    size_t live_bytes = 0;
+    size_t slab_bytes = 0;
+
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        SizeClassStatistics statistics = get_size_class_statistics(i);
+        live_bytes += statistics.live_bytes;
+        slab_bytes += statistics.slab_count * SLAB_SIZE;
+    }
+
+    if (slab_bytes == 0) {
+        return 0.f;
+    }
+
+    return 1.f - static_cast<float>(live_bytes) / slab_bytes;
+}
+
+size_t SmallObjectMemoryResource::get_size_class(size_t size, size_t alignment) {
+    if (size > MAX_SMALL_SIZE || alignment > MAX_SMALL_ALIGNMENT) {
+        return SIZE_CLASS_COUNT;
+    }
+
+    // Size classes are sorted, so the first suitable one is the tightest.
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        if (SIZE_CLASS_SIZES[i] >= size && SIZE_CLASS_SIZES[i] % alignment == 0) {
+            return i;
+        }
+    }
+
+    return SIZE_CLASS_COUNT;
+}
+
+size_t SmallObjectMemoryResource::find_size_class(void* memory) const {
+    uint8_t* address = static_cast<uint8_t*>(memory);
+
+    while (true) {
+        uint64_t sequence = m_segment_sequence.load(std::memory_order_acquire);
+        if (sequence % 2 != 0) {
+            // Segment begins are being modified.
+            continue;
+        }
+
+        // Find the last segment that begins before the given address.
+        size_t first = 0;
+        size_t last = m_segment_count.load(std::memory_order_relaxed);
+        while (first < last) {
+            size_t middle = first + (last - first) / 2;
+            if (m_segment_begins[middle].load(std::memory_order_relaxed) <= address) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+
+        uint8_t* segment_begin = first > 0 ? m_segment_begins[first - 1].load(std::memory_order_relaxed) : nullptr;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (m_segment_sequence.load(std::memory_order_relaxed) == sequence) {
+            if (segment_begin != nullptr && address < segment_begin + SEGMENT_SIZE) {
+                const SlabHeader* slab_header = reinterpret_cast<const SlabHeader*>(reinterpret_cast<size_t>(memory) & ~(SLAB_SIZE - 1));
+                return slab_header->size_class;
+            }
+
+            return SIZE_CLASS_COUNT;
+        }
+    }
+}
+
+size_t SmallObjectMemoryResource::acquire_blocks(size_t size_class, void*& head, size_t count) {
+    SizeClass& size_class_data = m_size_classes[size_class];
+
+    {
+        std::lock_guard lock(size_class_data.spinlock);
+
+        if (size_class_data.free_count > 0) {
+            return detach_blocks(size_class_data, head, count);
+        }
+    }
+
+    // New slab is allocated and linked outside of the lock, so other threads can acquire and release blocks of this
+    // size class meanwhile. If multiple threads run out of blocks at once, each of them adds a slab.
+    uint8_t* slab = static_cast<uint8_t*>(allocate_slab());
+    if (slab == nullptr) {
+        return 0;
+    }
+
+    SlabHeader* slab_header = reinterpret_cast<SlabHeader*>(slab);
+    slab_header->size_class = size_class;
+
+    size_t block_size = SIZE_CLASS_SIZES[size_class];
+    size_t block_count = (SLAB_SIZE - SLAB_HEADER_SIZE) / block_size;
+
+    // Link blocks in address order, so consecutive allocations are adjacent in memory.
+    uint8_t* block = slab + SLAB_HEADER_SIZE;
+    for (size_t i = 0; i + 1 < block_count; i++) {
+        set_next_block(block, block + block_size);
+        block += block_size;
+    }
+
+    std::lock_guard lock(size_class_data.spinlock);
+
+    set_next_block(block, size_class_data.head);
+
+    size_class_data.head = slab + SLAB_HEADER_SIZE;
+    size_class_data.free_count += block_count;
+    size_class_data.block_count += block_count;
+    size_class_data.slab_count++;
+
+    return detach_blocks(size_class_data, head, count);
+}
+
+size_t SmallObjectMemoryResource::detach_blocks(SizeClass& size_class_data, void*& head, size_t count) {
+    KW_ASSERT(size_class_data.free_count > 0);
+
+    count = std::min(count, size_class_data.free_count);
+
+    // Detach the first `count` blocks.
+    void* first = size_class_data.head;
+    void* last = first;
+    for (size_t i = 0; i + 1 < count; i++) {
+        last = get_next_block(last);
+    }
+
+    size_class_data.head = get_next_block(last);
+    size_class_data.free_count -= count;
+
+    set_next_block(last, head);
+    head = first;
+
+    return count;
+}
+
+void SmallObjectMemoryResource::release_blocks(size_t size_class, void*& head, size_t count) {
+    KW_ASSERT(count > 0);
+
+    // Detach the first `count` blocks outside of the lock.
+    void* first = head;
+    void* last = first;
+    for (size_t i = 0; i + 1 < count; i++) {
+        last = get_next_block(last);
+    }
+
+    head = get_next_block(last);
+
+    SizeClass& size_class_data = m_size_classes[size_class];
+    std::lock_guard lock(size_class_data.spinlock);
+
+    set_next_block(last, size_class_data.head);
+    size_class_data.head = first;
+    size_class_data.free_count += count;
+}
+
+void* SmallObjectMemoryResource::allocate_slab() {
+    std::lock_guard lock(m_segment_spinlock);
+
+    if (m_segment_slab_count == SLABS_PER_SEGMENT) {
+        size_t segment_count = m_segment_count.load(std::memory_order_relaxed);
+        if (segment_count == MAX_SEGMENT_COUNT) {
+            return nullptr;
+        }
+
+        // Extra slab size to align the segment by slab size.
+        uint8_t* segment = static_cast<uint8_t*>(m_memory_resource.allocate(SEGMENT_SIZE + SLAB_SIZE, alignof(void*)));
+        if (segment == nullptr) {
+            return nullptr;
+        }
+
+        uint8_t* segment_begin = reinterpret_cast<uint8_t*>((reinterpret_cast<size_t>(segment) + (SLAB_SIZE - 1)) & ~(SLAB_SIZE - 1));
+
+        m_segments[segment_count] = segment;
+
+        // Readers that see an odd sequence or a sequence that has changed since they started will retry.
+        uint64_t sequence = m_segment_sequence.load(std::memory_order_relaxed);
+        m_segment_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // Insert new segment begin in sorted order.
+        size_t index = segment_count;
+        while (index > 0 && m_segment_begins[index - 1].load(std::memory_order_relaxed) > segment_begin) {
+            m_segment_begins[index].store(m_segment_begins[index - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            index--;
+        }
+        m_segment_begins[index].store(segment_begin, std::memory_order_relaxed);
+        m_segment_count.store(segment_count + 1, std::memory_order_relaxed);
+
+        m_segment_sequence.store(sequence + 2, std::memory_order_release);
+
+        m_current_segment_begin = segment_begin;
+        m_segment_slab_count = 0;
+    }
+
+    return m_current_segment_begin + SLAB_SIZE * m_segment_slab_count++;
+}
+
+} // namespace kw
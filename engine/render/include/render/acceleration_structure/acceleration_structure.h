@@ -1,9 +1,14 @@
 #pragma once
 
+#include "render/acceleration_structure/query_views.h"
+
 #include <core/containers/vector.h>
 #include <core/math/aabbox.h>
 #include <core/math/frustum.h>
 
+#include <memory>
+#include <type_traits>
+
 namespace kw {
 
 class AccelerationStructurePrimitive;
@@ -14,10 +19,99 @@ public:
     virtual void remove(AccelerationStructurePrimitive& primitive) = 0;
     virtual void update(AccelerationStructurePrimitive& primitive) = 0;
 
-    virtual Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const aabbox& bounds) const = 0;
-    virtual Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const frustum& frustum) const = 0;
+    // Same as `update` for each primitive, but synchronization is performed once for the whole batch.
+    virtual void update(AccelerationStructurePrimitive* const* primitives, size_t count) = 0;
+
+    // Called with spans of primitives found by a query. `context` is the pointer passed to the query.
+    using QueryCallback = void (*)(void* context, AccelerationStructurePrimitive* const* primitives, size_t count);
+
+    // Query without any allocations. The callback may be called from under the acceleration structure's lock,
+    // so it must not modify this acceleration structure.
+    virtual void query(const aabbox& bounds, QueryCallback callback, void* context) const = 0;
+    virtual void query(const frustum& frustum, QueryCallback callback, void* context) const = 0;
+
+    // Same as above, but `visitor(primitives, count)` is called instead.
+    template <typename Visitor>
+    void query(const aabbox& bounds, Visitor&& visitor) const;
+
+    template <typename Visitor>
+    void query(const frustum& frustum, Visitor&& visitor) const;
+
+    Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const aabbox& bounds) const;
+    Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const frustum& frustum) const;
+
+    // Called with spans of primitives visible from at least one view and their view masks.
+    using MultiQueryCallback = void (*)(void* context, AccelerationStructurePrimitive* const* primitives, const uint64_t* masks, size_t count);
+
+    // Query all views in a single traversal. Subtrees rejected or fully accepted by a view are not tested against
+    // it again.
+    virtual void query(const QueryViews& views, MultiQueryCallback callback, void* context) const = 0;
+
+    // Same as above, but `visitor(primitives, masks, count)` is called instead.
+    template <typename Visitor>
+    void query(const QueryViews& views, Visitor&& visitor) const;
 
     virtual size_t get_count() const = 0;
+
+protected:
+    // Accumulates primitives found by a query and passes them to the callback in spans of up to 64 primitives.
+    class QueryBuffer {
+    public:
+        QueryBuffer(QueryCallback callback, void* context);
+
+        void push(AccelerationStructurePrimitive* primitive);
+
+        // Must be called when the query is done.
+        void flush();
+
+    private:
+        QueryCallback m_callback;
+        void* m_context;
+        AccelerationStructurePrimitive* m_primitives[64];
+        size_t m_count;
+    };
+
+    // Pass primitives intersecting the given frustum to the callback. Bounds are tested in batches.
+    static void cull_primitives(AccelerationStructurePrimitive* const* primitives, size_t count, const frustum& frustum,
+                                QueryCallback callback, void* context);
+
+    // Pass primitives visible from any view in `mask` to the callback. Views in `inside_mask` are known to contain
+    // all the given primitives and are not tested.
+    static void cull_primitives(AccelerationStructurePrimitive* const* primitives, size_t count, const QueryViews& views,
+                                uint64_t mask, uint64_t inside_mask, MultiQueryCallback callback, void* context);
+
+private:
+    template <typename Visitor>
+    static void visit(void* context, AccelerationStructurePrimitive* const* primitives, size_t count);
+
+    template <typename Visitor>
+    static void visit(void* context, AccelerationStructurePrimitive* const* primitives, const uint64_t* masks, size_t count);
 };
 
+template <typename Visitor>
+void AccelerationStructure::query(const aabbox& bounds, Visitor&& visitor) const {
+    query(bounds, &visit<std::remove_reference_t<Visitor>>, const_cast<void*>(static_cast<const void*>(std::addressof(visitor))));
+}
+
+template <typename Visitor>
+void AccelerationStructure::query(const frustum& frustum, Visitor&& visitor) const {
+    query(frustum, &visit<std::remove_reference_t<Visitor>>, const_cast<void*>(static_cast<const void*>(std::addressof(visitor))));
+}
+
+template <typename Visitor>
+void AccelerationStructure::query(const QueryViews& views, Visitor&& visitor) const {
+    MultiQueryCallback callback = &visit<std::remove_reference_t<Visitor>>;
+    query(views, callback, const_cast<void*>(static_cast<const void*>(std::addressof(visitor))));
+}
+
+template <typename Visitor>
+void AccelerationStructure::visit(void* context, AccelerationStructurePrimitive* const* primitives, size_t count) {
+    (*static_cast<Visitor*>(context))(primitives, count);
+}
+
+template <typename Visitor>
+void AccelerationStructure::visit(void* context, AccelerationStructurePrimitive* const* primitives, const uint64_t* masks, size_t count) {
+    (*static_cast<Visitor*>(context))(primitives, masks, count);
+}
+
 } // namespace kw
@@ -29,7 +29,11 @@ public:
     uint64_t get_counter() const;
 
 protected:
-    void global_transform_updated() override;
+    // Updates bounds, counter and acceleration structure's node. Override `update_bounds` instead.
+    void global_transform_updated() final;
+
+    // Called when global transform is updated. Children are responsible for recomputing `m_bounds` here.
+    virtual void update_bounds();
 
     // Children are responsible for setting bounds.
     aabbox m_bounds;
@@ -41,9 +45,15 @@ private:
     AccelerationStructure* m_acceleration_structure;
     void* m_node;
 
+    // Same as `global_transform_updated` for each primitive, but acceleration structures are updated once per batch.
+    // The order of primitives is changed.
+    static void global_transform_updated(AccelerationStructurePrimitive** primitives, size_t count);
+
+    friend class BvhAccelerationStructure;
+    friend class ContainerPrimitive;
     friend class LinearAccelerationStructure;
     friend class OctreeAccelerationStructure;
-    friend class QuadtreeAccelerationStructure;
+    friend class SnapshotAccelerationStructure;
 };
 
 } // namespace kw
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "render/acceleration_structure/acceleration_structure.h"
+
+#include <shared_mutex>
+
+namespace kw {
+
+class Task;
+
+struct BvhBuildBounds;
+struct BvhBuildItem;
+
+// Nodes are stored in depth-first order: left child immediately follows its parent, so any subtree occupies a
+// contiguous range of nodes and all its primitives occupy a contiguous range of primitive slots. A rebuilt subtree
+// keeps its range of nodes, nodes it doesn't need anymore become empty leaves.
+struct BvhNode {
+    aabbox bounds;
+
+    // Surface area of the bounds when this node was built. Used to detect quality degradation after refits.
+    float build_area;
+
+    uint32_t parent;
+
+    // For leaf nodes it's the index of the first primitive slot, for internal nodes it's the index of the right child.
+    uint32_t first;
+
+    // For leaf nodes it's the number of primitives, for internal nodes it's `UINT32_MAX`.
+    uint32_t count;
+
+    // Index of the node after the last node of this subtree.
+    uint32_t end;
+};
+
+// Bounding volume hierarchy built with binned surface area heuristic. O(1) `add` and `remove`, O(logN) `query`.
+// Primitives added after the last build are stored in a linear list. The whole tree is rebuilt by `rebuild_if_needed`
+// after too many primitives are added or removed, in O(logN) per added primitive amortized. Queries never modify
+// the tree.
+// `update` grows the bounds of the primitive's leaf and its parents in O(logN) and rebuilds small subtrees whose
+// quality degraded. A subtree of M primitives is rebuilt in place in O(MlogM) within its own range of nodes, the rest
+// of the tree is not touched. When a large subtree close to the root degrades, the whole tree is rebuilt instead.
+class BvhAccelerationStructure : public AccelerationStructure {
+public:
+    explicit BvhAccelerationStructure(MemoryResource& persistent_memory_resource);
+
+    void add(AccelerationStructurePrimitive& primitive) override;
+    void remove(AccelerationStructurePrimitive& primitive) override;
+    void update(AccelerationStructurePrimitive& primitive) override;
+    void update(AccelerationStructurePrimitive* const* primitives, size_t count) override;
+
+    void query(const aabbox& bounds, QueryCallback callback, void* context) const override;
+    void query(const frustum& frustum, QueryCallback callback, void* context) const override;
+    void query(const QueryViews& views, MultiQueryCallback callback, void* context) const override;
+    using AccelerationStructure::query;
+
+    size_t get_count() const override;
+
+    // Rebuild the whole tree if too many primitives were added or removed since the last build. Must be called by
+    // the writer after adding or removing primitives, otherwise they're tested linearly.
+    void rebuild_if_needed();
+
+    // The task that calls `rebuild_if_needed`. Must be placed after the tasks that add and remove the primitives and
+    // before the tasks that query them.
+    Task* create_task(MemoryResource& transient_memory_resource);
+
+private:
+    class RebuildTask;
+
+    // Must be called under exclusive lock.
+    void refit(AccelerationStructurePrimitive& primitive);
+
+    // Grow the bounds of the given node and its parents to contain the given bounds.
+    void grow(uint32_t node_index, const aabbox& bounds);
+
+    // Recompute the bounds of the given node's parents from their children.
+    void refit_parents(uint32_t node_index);
+
+    // Whether there are too many pending primitives or empty slots.
+    bool is_rebuild_needed() const;
+
+    void rebuild_degraded_nodes();
+    void rebuild();
+
+    // Rebuild the subtree in place, within its current range of nodes.
+    void rebuild(uint32_t node_index);
+
+    // Build a subtree from the given items at `node_index` using at most `node_budget` nodes and write its primitives
+    // to slots `[first, first + count)`. Items are reordered. Returns the number of used nodes.
+    uint32_t build(BvhBuildItem* items, const BvhBuildBounds& build_bounds, uint32_t node_index, uint32_t node_budget,
+                   uint32_t parent, uint32_t first, uint32_t count);
+
+    void collect_primitives(uint32_t first_node, uint32_t last_node, QueryCallback callback, void* context) const;
+
+    // Views in `mask` may intersect the node, views in `inside_mask` contain it entirely.
+    void collect_primitives(uint32_t node_index, const QueryViews& views, uint64_t mask, uint64_t inside_mask,
+                            MultiQueryCallback callback, void* context) const;
+
+    MemoryResource& m_memory_resource;
+
+    Vector<BvhNode> m_nodes;
+
+    // Primitive slots `[0, m_build_count)` are referenced by leaf nodes, some of them are empty after `remove`.
+    // Primitive slots `[m_build_count, m_primitives.size())` are added after the last build and are tested linearly.
+    Vector<AccelerationStructurePrimitive*> m_primitives;
+
+    // Nodes that need to be rebuilt after refit.
+    Vector<uint32_t> m_degraded_nodes;
+
+    uint32_t m_build_count;
+
+    // Number of empty primitive slots in `[0, m_build_count)`.
+    uint32_t m_hole_count;
+
+    // Set when a subtree too large to be rebuilt in place degrades, the whole tree is rebuilt after refit.
+    bool m_is_rebuild_scheduled;
+
+    mutable std::shared_mutex m_shared_mutex;
+};
+
+} // namespace kw
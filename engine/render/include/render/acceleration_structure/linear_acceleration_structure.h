@@ -14,9 +14,12 @@ public:
     void add(AccelerationStructurePrimitive& primitive) override;
     void remove(AccelerationStructurePrimitive& primitive) override;
     void update(AccelerationStructurePrimitive& primitive) override;
+    void update(AccelerationStructurePrimitive* const* primitives, size_t count) override;
 
-    Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const aabbox& bounds) const override;
-    Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const frustum& frustum) const override;
+    void query(const aabbox& bounds, QueryCallback callback, void* context) const override;
+    void query(const frustum& frustum, QueryCallback callback, void* context) const override;
+    void query(const QueryViews& views, MultiQueryCallback callback, void* context) const override;
+    using AccelerationStructure::query;
 
     size_t get_count() const override;
 
@@ -27,17 +27,30 @@ public:
     void add(AccelerationStructurePrimitive& primitive) override;
     void remove(AccelerationStructurePrimitive& primitive) override;
     void update(AccelerationStructurePrimitive& primitive) override;
+    void update(AccelerationStructurePrimitive* const* primitives, size_t count) override;
 
-    Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const aabbox& bounds) const override;
-    Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const frustum& frustum) const override;
+    void query(const aabbox& bounds, QueryCallback callback, void* context) const override;
+    void query(const frustum& frustum, QueryCallback callback, void* context) const override;
+    void query(const QueryViews& views, MultiQueryCallback callback, void* context) const override;
+    using AccelerationStructure::query;
 
     size_t get_count() const override;
 
 private:
+    // Must be called under exclusive lock.
+    void update_locked(AccelerationStructurePrimitive& primitive);
+
     OctreeNode& find_node(const aabbox& bounds, OctreeNode& node, uint32_t depth = 0);
 
-    template <typename Bounds>
-    void collect_primitives(const OctreeNode& node, const Bounds& bounds, Vector<AccelerationStructurePrimitive*>& output) const;
+    void collect_primitives(const OctreeNode& node, const aabbox& bounds, QueryBuffer& buffer) const;
+    void collect_primitives(const OctreeNode& node, const frustum& frustum, QueryCallback callback, void* context) const;
+
+    // Views in `mask` may intersect the node, views in `inside_mask` contain it entirely.
+    void collect_primitives(const OctreeNode& node, const QueryViews& views, uint64_t mask, uint64_t inside_mask,
+                            MultiQueryCallback callback, void* context) const;
+
+    // Collect primitives of a node that is fully inside of a query volume.
+    void collect_all_primitives(const OctreeNode& node, QueryCallback callback, void* context) const;
 
     MemoryResource& m_memory_resource;
     uint32_t m_max_depth;
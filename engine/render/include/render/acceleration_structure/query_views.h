@@ -0,0 +1,42 @@
+#pragma once
+
+#include <core/math/aabbox.h>
+#include <core/math/frustum.h>
+
+namespace kw {
+
+// Up to 64 views that are queried from an acceleration structure in a single traversal. View `i` corresponds
+// to bit `i` of view masks.
+class QueryViews {
+public:
+    // Frustums must outlive the query.
+    QueryViews(const frustum* frustums, size_t frustum_count);
+
+    // Six 90 degree cubemap faces around the given point in +X, -X, +Y, -Y, +Z, -Z order, e.g. for point light shadows.
+    // Bounds are tested against the sphere around all faces first, and then against faces analytically.
+    QueryViews(const float3& origin, float near_plane, float far_plane);
+
+    // Mask with a bit set for each view.
+    uint64_t get_mask() const;
+
+    // Return the subset of views from `mask` that intersect the given bounds. The subset of views that contain
+    // the bounds entirely is written to `inside_mask`.
+    uint64_t intersect(const aabbox& bounds, uint64_t mask, uint64_t& inside_mask) const;
+
+    // Write the subset of views from `mask` that intersect box `i` to `masks[i]`. Up to 64 boxes.
+    void intersect(const float* center_x, const float* center_y, const float* center_z,
+                   const float* extent_x, const float* extent_y, const float* extent_z,
+                   size_t count, uint64_t mask, uint64_t* masks) const;
+
+private:
+    uint64_t intersect_cubemap(const float3& min, const float3& max, uint64_t mask, uint64_t& inside_mask) const;
+
+    const frustum* m_frustums;
+    size_t m_frustum_count;
+
+    float3 m_origin;
+    float m_near_plane;
+    float m_far_plane;
+};
+
+} // namespace kw
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "render/acceleration_structure/acceleration_structure.h"
+
+#include <core/containers/shared_ptr.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace kw {
+
+class Task;
+
+struct SnapshotBuildItem;
+
+// Committed primitives are referenced through handles shared by all snapshots that contain them. `remove` clears
+// the handle, so snapshots skip removed primitives without dereferencing them.
+struct SnapshotHandle {
+    std::atomic<AccelerationStructurePrimitive*> primitive;
+};
+
+// Primitives of a snapshot are stored in chunks of up to 64, bounds are stored in structure of arrays for batch
+// culling. Chunks are immutable and shared between snapshots, `commit` copies only the chunks that have changed.
+struct SnapshotChunk {
+    float center_x[64];
+    float center_y[64];
+    float center_z[64];
+    float extent_x[64];
+    float extent_y[64];
+    float extent_z[64];
+    SharedPtr<SnapshotHandle> handles[64];
+    uint32_t count;
+};
+
+// Chunks of a snapshot are the leaves of a bounding volume hierarchy. Nodes are stored in depth-first order: left
+// child immediately follows its parent and the right child follows the left child's subtree.
+struct SnapshotNode {
+    aabbox bounds;
+
+    // For leaf nodes it's the index of the chunk, for internal nodes it's `UINT32_MAX`.
+    uint32_t chunk;
+
+    // Index of the node after the last node of this subtree.
+    uint32_t end;
+
+    // Number of primitives in this subtree. Empty subtrees are skipped by queries.
+    uint32_t count;
+};
+
+// Immutable state of `SnapshotAccelerationStructure` at some commit. Queries don't lock anything.
+class AccelerationStructureSnapshot {
+public:
+    explicit AccelerationStructureSnapshot(MemoryResource& persistent_memory_resource);
+
+    void query(const aabbox& bounds, AccelerationStructure::QueryCallback callback, void* context) const;
+    void query(const frustum& frustum, AccelerationStructure::QueryCallback callback, void* context) const;
+    void query(const QueryViews& views, AccelerationStructure::MultiQueryCallback callback, void* context) const;
+
+    Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const aabbox& bounds) const;
+    Vector<AccelerationStructurePrimitive*> query(MemoryResource& memory_resource, const frustum& frustum) const;
+
+    size_t get_count() const;
+
+private:
+    // Views in `mask` may intersect the node, views in `inside_mask` contain it entirely.
+    void query(uint32_t node_index, const QueryViews& views, uint64_t mask, uint64_t inside_mask,
+               AccelerationStructure::MultiQueryCallback callback, void* context) const;
+
+    // Chunks `[0, m_tree_chunk_count)` are the leaves of `m_nodes`. Chunks `[m_tree_chunk_count, m_chunks.size())`
+    // contain primitives added after the last build and are tested linearly.
+    Vector<SharedPtr<const SnapshotChunk>> m_chunks;
+    Vector<SnapshotNode> m_nodes;
+    size_t m_tree_chunk_count;
+
+    // Bounds of each chunk in structure of arrays.
+    Vector<float> m_center_x;
+    Vector<float> m_center_y;
+    Vector<float> m_center_z;
+    Vector<float> m_extent_x;
+    Vector<float> m_extent_y;
+    Vector<float> m_extent_z;
+
+    size_t m_count;
+
+    friend class SnapshotAccelerationStructure;
+};
+
+// O(1) `add`, `remove` and `update`, O(logN) `query` over a hierarchy of chunks. `add`, `remove` and `update` only
+// record changes to the update log, which is applied by `commit` once per frame. `commit` copies the changed chunks
+// and refits the hierarchy in O(N/64), primitives added since the last build are kept in chunks that are tested
+// linearly. The hierarchy is rebuilt in O(NlogN) when too many primitives are added or removed, or when refits make
+// it twice as large as it was built.
+//
+// Queries never lock and never see changes made after the last `commit`, so writers (animation, particle systems)
+// never stall readers (render passes) and vice versa. Snapshots returned by `get_snapshot` stay valid after
+// subsequent commits. Removed primitives are never returned by any snapshot, so a removed primitive can be
+// destroyed right away, as long as no query that could return it is running.
+class SnapshotAccelerationStructure : public AccelerationStructure {
+public:
+    explicit SnapshotAccelerationStructure(MemoryResource& persistent_memory_resource);
+
+    void add(AccelerationStructurePrimitive& primitive) override;
+    void remove(AccelerationStructurePrimitive& primitive) override;
+    void update(AccelerationStructurePrimitive& primitive) override;
+    void update(AccelerationStructurePrimitive* const* primitives, size_t count) override;
+
+    // Query the last committed snapshot.
+    void query(const aabbox& bounds, QueryCallback callback, void* context) const override;
+    void query(const frustum& frustum, QueryCallback callback, void* context) const override;
+    void query(const QueryViews& views, MultiQueryCallback callback, void* context) const override;
+    using AccelerationStructure::query;
+
+    // The number of primitives in the last committed snapshot.
+    size_t get_count() const override;
+
+    // Apply the update log and publish a new snapshot. Queries running concurrently keep using the previous one.
+    void commit();
+
+    // The task that calls `commit`. Must be placed after the tasks that update the primitives and before the tasks
+    // that query them.
+    Task* create_task(MemoryResource& transient_memory_resource);
+
+    // The last committed snapshot, e.g. for a bake that spans multiple frames.
+    SharedPtr<const AccelerationStructureSnapshot> get_snapshot() const;
+
+private:
+    class CommitTask;
+
+    struct Addition {
+        AccelerationStructurePrimitive* primitive;
+        aabbox bounds;
+    };
+
+    struct Modification {
+        uint32_t slot;
+        aabbox bounds;
+    };
+
+    // Build the hierarchy from all primitives of the given snapshot.
+    void rebuild(AccelerationStructureSnapshot& snapshot);
+
+    // Build a subtree from the given items, appending its nodes and chunks to the snapshot. Items are reordered.
+    void build(AccelerationStructureSnapshot& snapshot, SnapshotBuildItem* items, uint32_t count);
+
+    MemoryResource& m_memory_resource;
+
+    // Published with `std::atomic_store` and read with `std::atomic_load`, because queries may run during `commit`.
+    SharedPtr<const AccelerationStructureSnapshot> m_snapshot;
+
+    // Primitives added since the last commit. Primitives removed before commit have null primitive.
+    Vector<Addition> m_additions;
+
+    // Bounds of committed primitives updated since the last commit.
+    Vector<Modification> m_modifications;
+
+    // Slots of committed primitives removed since the last commit.
+    Vector<uint32_t> m_removals;
+
+    // Number of primitives and total surface area of the nodes when the hierarchy was last built.
+    uint32_t m_build_count;
+    float m_build_area;
+
+    // Protects the update log and primitives' nodes.
+    std::mutex m_mutex;
+};
+
+// Read-only acceleration structure that queries a snapshot pinned by `SnapshotAccelerationStructure::get_snapshot`.
+// Primitives must not be added to it.
+class PinnedSnapshotAccelerationStructure : public AccelerationStructure {
+public:
+    explicit PinnedSnapshotAccelerationStructure(SharedPtr<const AccelerationStructureSnapshot> snapshot);
+
+    void add(AccelerationStructurePrimitive& primitive) override;
+    void remove(AccelerationStructurePrimitive& primitive) override;
+    void update(AccelerationStructurePrimitive& primitive) override;
+    void update(AccelerationStructurePrimitive* const* primitives, size_t count) override;
+
+    void query(const aabbox& bounds, QueryCallback callback, void* context) const override;
+    void query(const frustum& frustum, QueryCallback callback, void* context) const override;
+    void query(const QueryViews& views, MultiQueryCallback callback, void* context) const override;
+    using AccelerationStructure::query;
+
+    size_t get_count() const override;
+
+private:
+    SharedPtr<const AccelerationStructureSnapshot> m_snapshot;
+};
+
+} // namespace kw
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "render/animation/animation_blend_tree.h"
 #include "render/geometry/geometry_primitive.h"
 #include "render/geometry/skeleton_pose.h"
 
@@ -31,18 +32,18 @@ public:
     const SkeletonPose& get_skeleton_pose() const;
     SkeletonPose& get_skeleton_pose();
 
+    // Layers and clips sampled by animation player.
+    const AnimationBlendTree& get_animation_blend_tree() const;
+    AnimationBlendTree& get_animation_blend_tree();
+
+    // The first clip of the base layer. Setting an animation replaces all clips of the base layer, keeping the time and
+    // speed of the first one.
     const SharedPtr<Animation>& get_animation() const;
     void set_animation(SharedPtr<Animation> animation);
 
     // The joint matrices are retrieved from skeleton pose.
     Vector<float4x4> get_model_space_joint_matrices(MemoryResource& memory_resource) override;
 
-    float get_animation_time() const;
-    void set_animation_time(float value);
-
-    float get_animation_speed() const;
-    void set_animation_speed(float value);
-
     UniquePtr<Primitive> clone(MemoryResource& memory_resource) const override;
 
 protected:
@@ -51,11 +52,14 @@ protected:
 private:
     AnimationPlayer* m_animation_player;
     SkeletonPose m_skeleton_pose;
-    SharedPtr<Animation> m_animation;
-    float m_animation_time;
-    float m_animation_speed;
+    AnimationBlendTree m_animation_blend_tree;
+
+    // Animation player's level of detail state. Elapsed time of the frames that were skipped is applied on the next
+    // update.
+    float m_skipped_time;
+    bool m_is_visible;
 
-    // Friendship is needed to access `m_animation_player`.
+    // Friendship is needed to access `m_animation_player` and level of detail state.
     friend class AnimationPlayer;
 };
 
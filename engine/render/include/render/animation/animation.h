@@ -5,6 +5,8 @@
 
 namespace kw {
 
+class AnimationCursor;
+class SkeletonPose;
 class float4x4;
 
 class Animation {
@@ -18,20 +20,69 @@ public:
         Vector<JointKeyframe> keyframes;
     };
 
+    // Compressed animations store translation, rotation and scale of each joint in separate tracks. Each keyframe is
+    // four 16-bit values: timestamp relative to animation duration and three value components. Translation and scale
+    // components are relative to the track's range. Rotations store the smallest three components, the index of the
+    // largest component is stored in the highest bits of the first two values. Constant tracks have no keyframes.
+    // Tracks that can't be quantized within tolerance (e.g. translations with a wide range) are raw: their keyframes
+    // store only timestamps, values are stored separately as four floats per keyframe.
+    struct CompressedTrack {
+        uint32_t keyframe_count;
+        bool is_raw;
+
+        // The value of a constant track. The minimum of the translation or scale track.
+        float minimum[4];
+
+        // The range of the translation or scale track.
+        float extent[3];
+    };
+
+    // The number of compressed tracks per joint: translation, rotation and scale.
+    static constexpr uint32_t COMPRESSED_TRACK_COUNT = 3;
+
     Animation();
     explicit Animation(Vector<JointAnimation>&& joint_animations);
 
+    // Tracks of the first joint go first, followed by the tracks of the second joint and so on. Keyframes and raw values
+    // of the tracks are stored in the same order.
+    Animation(float duration, Vector<CompressedTrack>&& compressed_tracks, Vector<uint16_t>&& compressed_keyframes,
+              Vector<float>&& compressed_raw_values);
+
     // Return joint transform at given timestamp.
     float4x4 get_joint_transform(uint32_t joint_index, float timestamp) const;
 
+    // Write joint space transforms of all joints at given timestamp to the given skeleton pose. When the cursor is
+    // specified, keyframes are searched starting from the ones found on the previous call with the same cursor.
+    void sample_pose(float timestamp, SkeletonPose& skeleton_pose, AnimationCursor* cursor = nullptr) const;
+
+    // Same as `sample_pose`, but writes `get_joint_count()` joint space transforms to the given array. When joint
+    // indices are specified, only these joints are sampled and the other transforms are left untouched.
+    void sample_transforms(float timestamp, transform* result, AnimationCursor* cursor = nullptr,
+                           const Vector<uint32_t>* joint_indices = nullptr) const;
+
     // Return the number of joints of target skeleton.
     size_t get_joint_count() const;
 
     bool is_loaded() const;
+    bool is_compressed() const;
 
 private:
+    float normalize_timestamp(float timestamp) const;
+
+    // Decode the keyframes to interpolate between and interpolation factors of the translation, rotation and scale
+    // tracks of the given joint. `keyframe_indices` are the lower bound keyframe indices of the tracks, which are
+    // updated.
+    void get_compressed_joint_keyframes(uint32_t joint_index, float quantized_timestamp, uint32_t* keyframe_indices,
+                                        transform& from, transform& to, float* factors) const;
+
     float m_duration;
     Vector<JointAnimation> m_joint_animations;
+
+    Vector<CompressedTrack> m_compressed_tracks;
+    Vector<uint32_t> m_compressed_track_offsets;
+    Vector<uint16_t> m_compressed_keyframes;
+    Vector<uint32_t> m_compressed_raw_offsets;
+    Vector<float> m_compressed_raw_values;
 };
 
 } // namespace kw
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "render/animation/animation_cursor.h"
+
+#include <core/containers/shared_ptr.h>
+#include <core/containers/vector.h>
+#include <core/math/transform.h>
+
+namespace kw {
+
+class Animation;
+class SkeletonPose;
+
+// Blends multiple animation clips of one skeleton. Clips are grouped in layers, layers are applied in order. Clips of
+// an override layer are blended by their normalized weights and the result replaces the pose of the previous layers
+// by the layer weight. Clips of an additive layer add their difference from their first frame to the pose of the
+// previous layers. Each layer may have per-joint weights to affect only some joints, for example upper body. Blending
+// is done on joint space translation, rotation and scale, matrices are built only once from the final pose.
+class AnimationBlendTree {
+public:
+    enum class LayerMode {
+        OVERRIDE,
+        ADDITIVE,
+    };
+
+    // The base layer with index 0 is created on construction. It's an override layer that always has full weight.
+    explicit AnimationBlendTree(MemoryResource& memory_resource);
+
+    // Return the index of the new layer.
+    uint32_t add_layer(LayerMode layer_mode, float weight = 1.f);
+    size_t get_layer_count() const;
+
+    LayerMode get_layer_mode(uint32_t layer_index) const;
+
+    float get_layer_weight(uint32_t layer_index) const;
+    void set_layer_weight(uint32_t layer_index, float value);
+
+    // Layer weight is multiplied by the weight of each joint. Empty joint weights apply the layer to all joints.
+    const Vector<float>& get_layer_joint_weights(uint32_t layer_index) const;
+    void set_layer_joint_weights(uint32_t layer_index, const Vector<float>& joint_weights);
+
+    // Return the index of the new clip. Clip indices of a layer change when its clips are removed.
+    uint32_t add_clip(uint32_t layer_index, SharedPtr<Animation> animation, float weight = 1.f, float speed = 1.f);
+    void remove_clip(uint32_t layer_index, uint32_t clip_index);
+    void clear_clips(uint32_t layer_index);
+    size_t get_clip_count(uint32_t layer_index) const;
+
+    const SharedPtr<Animation>& get_clip_animation(uint32_t layer_index, uint32_t clip_index) const;
+
+    float get_clip_time(uint32_t layer_index, uint32_t clip_index) const;
+    void set_clip_time(uint32_t layer_index, uint32_t clip_index, float value);
+
+    float get_clip_speed(uint32_t layer_index, uint32_t clip_index) const;
+    void set_clip_speed(uint32_t layer_index, uint32_t clip_index, float value);
+
+    // Setting clip weight cancels its fade.
+    float get_clip_weight(uint32_t layer_index, uint32_t clip_index) const;
+    void set_clip_weight(uint32_t layer_index, uint32_t clip_index, float value);
+
+    // Add a clip that fades in over `duration` seconds while other clips of the layer fade out. Clips that are faded
+    // out and clips of zero weight are removed. When `duration` is not positive, all clips of the layer are removed
+    // right away and the new clip has full weight. Return the index the new clip has until some clip is removed.
+    uint32_t crossfade(uint32_t layer_index, SharedPtr<Animation> animation, float duration, float speed = 1.f);
+
+    // Advance clip times and fades.
+    void update(float elapsed_time);
+
+    // Whether any clip of the base layer is loaded. Clips that are not loaded yet are ignored by `sample_pose`.
+    bool is_loaded() const;
+
+    // Write the joint space transforms of the blended pose to the given skeleton pose. The joint count of all clip
+    // animations must match the skeleton pose's joint count. When joint indices are specified, only these joints are
+    // sampled and blended, the other joint space transforms are left untouched.
+    void sample_pose(SkeletonPose& skeleton_pose, const Vector<uint32_t>* joint_indices = nullptr);
+
+private:
+    struct Clip {
+        explicit Clip(MemoryResource& memory_resource);
+
+        SharedPtr<Animation> animation;
+        AnimationCursor cursor;
+
+        // The first frame of a clip on an additive layer. Sampled when the animation is loaded.
+        Vector<transform> reference_transforms;
+
+        float time;
+        float speed;
+        float weight;
+        float target_weight;
+
+        // Weight change per second towards `target_weight`. Zero when the clip is not fading.
+        float fade_speed;
+    };
+
+    struct Layer {
+        explicit Layer(MemoryResource& memory_resource);
+
+        Vector<Clip> clips;
+        Vector<float> joint_weights;
+        LayerMode layer_mode;
+        float weight;
+    };
+
+    Vector<Layer> m_layers;
+
+    // Sampled clip and blended layer poses.
+    Vector<transform> m_clip_transforms;
+    Vector<transform> m_layer_transforms;
+};
+
+} // namespace kw
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <core/containers/vector.h>
+
+namespace kw {
+
+class Animation;
+
+// Sampling state of one animation instance. Stores the last keyframe of each joint, so when the animation time moves
+// forward, keyframes are found by advancing from the previous ones instead of a binary search. Seeks backwards, loops
+// and animation changes are detected automatically and fall back to the binary search.
+class AnimationCursor {
+public:
+    explicit AnimationCursor(MemoryResource& memory_resource);
+
+    // The next sample searches keyframes from scratch.
+    void reset();
+
+private:
+    const Animation* m_animation;
+    Vector<uint32_t> m_keyframe_indices;
+    float m_timestamp;
+
+    friend class Animation;
+};
+
+} // namespace kw
@@ -1,13 +1,13 @@
 #pragma once
 
+#include <core/concurrency/task_shared_mutex.h>
 #include <core/containers/pair.h>
 #include <core/containers/vector.h>
 
-#include <shared_mutex>
-
 namespace kw {
 
 class AnimatedGeometryPrimitive;
+class CameraManager;
 class Task;
 class TaskScheduler;
 class Timer;
@@ -15,6 +15,19 @@ class Timer;
 struct AnimationPlayerDescriptor {
     Timer* timer;
     TaskScheduler* task_scheduler;
+
+    // Primitives outside of the occlusion camera's frustum are invisible.
+    CameraManager* camera_manager;
+
+    // Primitives whose bounding sphere takes less than this fraction of the screen height are distant. Distant
+    // primitives animate only the skeleton's LOD joints. Zero disables distant level of detail.
+    float lod_screen_size;
+
+    // Distant and invisible primitives are updated once per this number of frames, spread evenly across frames.
+    // Zero and one update every frame, `UINT32_MAX` freezes them. Primitives that become visible are updated at once.
+    uint32_t lod_update_interval;
+    uint32_t invisible_update_interval;
+
     MemoryResource* persistent_memory_resource;
     MemoryResource* transient_memory_resource;
 };
@@ -34,11 +47,19 @@ private:
 
     Timer& m_timer;
     TaskScheduler& m_task_scheduler;
+    CameraManager& m_camera_manager;
+    float m_lod_screen_size;
+    uint32_t m_lod_update_interval;
+    uint32_t m_invisible_update_interval;
     MemoryResource& m_persistent_memory_resource;
     MemoryResource& m_transient_memory_resource;
 
     Vector<AnimatedGeometryPrimitive*> m_primitives;
-    std::shared_mutex m_primitives_mutex;
+    // Worker tasks park instead of blocking while `add` or `remove` is running.
+    TaskSharedMutex m_primitives_mutex;
+
+    // Incremented on each `create_tasks` call. Used for visibility and staggered updates.
+    uint64_t m_frame_index;
 };
 
 } // namespace kw
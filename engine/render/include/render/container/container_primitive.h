@@ -8,6 +8,7 @@
 
 namespace kw {
 
+class AccelerationStructurePrimitive;
 class ContainerPrototype;
 struct PrimitiveReflectionDescriptor;
 
@@ -46,15 +47,24 @@ public:
     UniquePtr<Primitive> clone(MemoryResource& memory_resource) const override;
 
 protected:
-    void global_transform_updated() override;
+    // Propagates global transform to the whole subtree in batches, so containers must not override it.
+    void global_transform_updated() final;
     void container_prototype_loaded() override;
 
     virtual void child_added(Primitive& primitive);
     virtual void child_removed(Primitive& primitive);
     
 private:
+    // Detach and destroy all children at once.
+    void detach_children();
+
     Vector<UniquePtr<Primitive>> m_children;
     SharedPtr<ContainerPrototype> m_container_prototype;
+
+    // Used in `global_transform_updated` to avoid allocations on every transform change.
+    Vector<ContainerPrimitive*> m_scratch_containers;
+    Vector<AccelerationStructurePrimitive*> m_scratch_acceleration_structure_primitives;
+    Vector<transform> m_scratch_transforms;
 };
 
 } // namespace kw
@@ -4,9 +4,11 @@ namespace kw {
 
 class ImguiManager;
 class MemoryResource;
+class TaskScheduler;
 
 struct CpuProfilerOverlayDescriptor {
     ImguiManager* imgui_manager;
+    TaskScheduler* task_scheduler;
     MemoryResource* transient_memory_resource;
 };
 
@@ -19,6 +21,7 @@ public:
 
 private:
     ImguiManager& m_imgui_manager;
+    TaskScheduler& m_task_scheduler;
     MemoryResource& m_transient_memory_resource;
 
     int m_offset;
@@ -9,6 +9,7 @@ namespace kw {
 class GeometryListener;
 class GeometryNotifier;
 class IndexBuffer;
+class Occluder;
 class Skeleton;
 class VertexBuffer;
 
@@ -28,7 +29,8 @@ public:
 
     explicit Geometry(GeometryNotifier& geometry_notifier);
     Geometry(GeometryNotifier& geometry_notifier, VertexBuffer* vertex_buffer, VertexBuffer* skinned_vertex_buffer,
-             IndexBuffer* index_buffer, uint32_t index_count, const aabbox& bounds, UniquePtr<Skeleton>&& skeleton);
+             IndexBuffer* index_buffer, uint32_t index_count, const aabbox& bounds, UniquePtr<Skeleton>&& skeleton,
+             UniquePtr<Occluder>&& occluder);
     Geometry(Geometry&& other);
     ~Geometry();
     Geometry& operator=(Geometry&& other);
@@ -45,6 +47,9 @@ public:
     const aabbox& get_bounds() const;
     const Skeleton* get_skeleton() const;
 
+    // Returns nullptr if this geometry is not used for occlusion culling.
+    const Occluder* get_occluder() const;
+
     bool is_loaded() const;
 
 private:
@@ -53,6 +58,7 @@ private:
     // Geometry data is initialized in reverse order with thread fences.
     // When `m_vertex_buffer` is set, other fields are guaranteed to be set too.
     UniquePtr<Skeleton> m_skeleton;
+    UniquePtr<Occluder> m_occluder;
     aabbox m_bounds;
     uint32_t m_index_count;
     IndexBuffer* m_index_buffer;
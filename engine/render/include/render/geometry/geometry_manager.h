@@ -23,6 +23,9 @@ struct GeometryManagerDescriptor {
 
     MemoryResource* persistent_memory_resource;
     MemoryResource* transient_memory_resource;
+
+    // Static geometry with at most this many triangles keeps a CPU copy of its triangles for occlusion culling.
+    uint32_t max_occluder_triangle_count;
 };
 
 class GeometryManager {
@@ -52,6 +55,8 @@ private:
     MemoryResource& m_persistent_memory_resource;
     MemoryResource& m_transient_memory_resource;
 
+    uint32_t m_max_occluder_triangle_count;
+
     UnorderedMap<String, SharedPtr<Geometry>> m_geometry;
     Vector<Pair<const String&, SharedPtr<Geometry>>> m_pending_geometry;
     mutable std::shared_mutex m_geometry_mutex;
@@ -42,7 +42,7 @@ public:
     UniquePtr<Primitive> clone(MemoryResource& memory_resource) const override;
 
 protected:
-    void global_transform_updated() override;
+    void update_bounds() override;
     void geometry_loaded() override;
 
 private:
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <core/containers/vector.h>
+#include <core/math/float3.h>
+
+namespace kw {
+
+// CPU copy of geometry's triangles in model space that is rasterized by `OcclusionCuller`.
+class Occluder {
+public:
+    Occluder(Vector<float3>&& vertices, Vector<uint32_t>&& indices);
+
+    const Vector<float3>& get_vertices() const;
+    const Vector<uint32_t>& get_indices() const;
+
+    size_t get_triangle_count() const;
+
+private:
+    Vector<float3> m_vertices;
+    Vector<uint32_t> m_indices;
+};
+
+} // namespace kw
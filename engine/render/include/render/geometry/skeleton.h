@@ -20,6 +20,13 @@ public:
     const float4x4& get_bind_matrix(uint32_t joint_index) const;
     const String& get_joint_name(uint32_t joint_index) const;
 
+    // Joint indices in breadth-first order, every parent joint goes before its children.
+    const Vector<uint32_t>& get_hierarchy_order() const;
+
+    // Joint indices in ascending order that are animated on distant levels of detail. Joints close to the leaves of
+    // the hierarchy, like fingers or facial joints, are excluded, root joints are always included.
+    const Vector<uint32_t>& get_lod_joints() const;
+
     // Returns UINT32_MAX on failure.
     uint32_t get_joint_index(const String& name) const;
 
@@ -28,6 +35,8 @@ private:
     Vector<float4x4> m_inverse_bind_matrices;
     Vector<float4x4> m_bind_matrices;
     UnorderedMap<String, uint32_t> m_joint_mapping;
+    Vector<uint32_t> m_hierarchy_order;
+    Vector<uint32_t> m_lod_joints;
 };
 
 } // namespace kw
@@ -2,6 +2,7 @@
 
 #include <core/containers/vector.h>
 #include <core/math/float4x4.h>
+#include <core/math/transform.h>
 
 namespace kw {
 
@@ -11,20 +12,31 @@ class SkeletonPose {
 public:
     explicit SkeletonPose(MemoryResource& memory_resource);
     
-    const Vector<float4x4>& get_joint_space_matrices() const;
+    // Joint space transforms are blended as translation, rotation and scale and converted to matrices only once when
+    // model space matrices are built.
+    const Vector<transform>& get_joint_space_transforms() const;
+    Vector<transform>& get_joint_space_transforms();
 
-    void set_joint_space_matrix(uint32_t joint_index, const float4x4& matrix);
+    void set_joint_space_transform(uint32_t joint_index, const transform& value);
+
+    // Set joint space transforms to the skeleton's bind pose. Memory is allocated only when the joint count changes.
+    void set_bind_pose(const Skeleton& skeleton);
 
     const Vector<float4x4>& get_model_space_matrices() const;
 
-    // Uses joint space matrices and skeleton hierarchy to build model space matrices.
+    // Uses joint space transforms and skeleton hierarchy to build model space matrices. Joints are composed in
+    // skeleton's hierarchy order, so joint indices don't have to be sorted.
     void build_model_space_matrices(const Skeleton& skeleton);
 
-    // The number of joint space matrices.
+    // The number of joint space transforms.
     size_t get_joint_count() const;
 
 private:
-    Vector<float4x4> m_joint_space_matrices;
+    Vector<transform> m_joint_space_transforms;
+
+    // Joint space matrices that are turned into model space matrices without inverse bind matrices in hierarchy order.
+    Vector<float4x4> m_hierarchy_matrices;
+
     Vector<float4x4> m_model_space_matrices;
 };
 
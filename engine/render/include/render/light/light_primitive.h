@@ -17,7 +17,7 @@ public:
     void set_power(float value);
 
 protected:
-    void global_transform_updated() override;
+    void update_bounds() override;
 
 private:
     float3 m_color;
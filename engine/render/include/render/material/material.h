@@ -65,7 +65,7 @@ public:
 
     Material();
     Material(SharedPtr<GraphicsPipeline*> graphics_pipeline, Vector<SharedPtr<Texture*>>&& textures,
-             bool is_shadow, bool is_skinned, bool is_particle);
+             bool is_shadow, bool is_skinned, bool is_particle, bool is_occluder);
 
     const SharedPtr<GraphicsPipeline*>& get_graphics_pipeline() const;
     const Vector<SharedPtr<Texture*>>& get_textures() const;
@@ -74,6 +74,10 @@ public:
     bool is_skinned() const;
     bool is_particle() const;
 
+    // Whether occlusion culler may rasterize geometry with this material. Must be false for materials with alpha
+    // tested holes (foliage, curtains, chains), otherwise everything behind the holes would be culled.
+    bool is_occluder() const;
+
     bool is_loaded() const;
 
 private:
@@ -82,6 +86,7 @@ private:
     bool m_is_shadow;
     bool m_is_skinned;
     bool m_is_particle;
+    bool m_is_occluder;
 };
 
 } // namespace kw
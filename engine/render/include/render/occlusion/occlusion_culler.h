@@ -0,0 +1,152 @@
+#pragma once
+
+#include "render/acceleration_structure/acceleration_structure_primitive.h"
+
+#include <core/containers/pair.h>
+#include <core/containers/vector.h>
+#include <core/math/float4x4.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace kw {
+
+class CameraManager;
+class MemoryResource;
+class Occluder;
+class Scene;
+class Task;
+class TaskScheduler;
+
+struct OcclusionCullerDescriptor {
+    Scene* scene;
+    CameraManager* camera_manager;
+    TaskScheduler* task_scheduler;
+
+    // Depth buffer dimensions, must be multiples of 32.
+    uint32_t width;
+    uint32_t height;
+
+    // The number of occluders with the largest screen size that are rasterized each frame.
+    uint32_t max_occluder_count;
+
+    MemoryResource* persistent_memory_resource;
+    MemoryResource* transient_memory_resource;
+};
+
+// Rasterizes occluders of geometry visible from the occlusion camera into a low resolution depth buffer on CPU and
+// tests bounding boxes against its hierarchical depth pyramid. Depth buffer is split in 32x32 tiles, which are
+// rasterized concurrently.
+class OcclusionCuller {
+public:
+    explicit OcclusionCuller(const OcclusionCullerDescriptor& descriptor);
+
+    // Return whether the given bounds are entirely hidden behind the occluders. Must be called after the second task.
+    bool is_occluded(const aabbox& bounds) const;
+
+    // Remove occluded primitives from the given array. Must be called after the second task.
+    template <typename T>
+    void cull(Vector<T*>& primitives) const;
+
+    // Disabled occlusion culler doesn't rasterize occluders and doesn't cull anything, which allows to measure its
+    // benefit. Must not be called while its tasks are running.
+    void set_enabled(bool is_enabled);
+    bool is_enabled() const;
+
+    // Statistics of the last frame.
+    uint32_t get_occluder_count() const;
+    uint32_t get_triangle_count() const;
+    uint32_t get_tested_primitive_count() const;
+    uint32_t get_culled_primitive_count() const;
+
+    // The first task selects occluders and creates rasterization tasks. The second task builds the depth pyramid.
+    // The first task must run after primitive bounds are updated on this frame. Primitives must be culled after the
+    // second task.
+    Pair<Task*, Task*> create_tasks();
+
+private:
+    class BeginTask;
+    class WorkerTask;
+    class EndTask;
+
+    // Edge functions and depth plane of a screen space triangle. Depth is the inverse of clip space w, which is linear
+    // in screen space. Greater depth is closer to the camera, zero is infinitely far.
+    struct Triangle {
+        float edge_a[3];
+        float edge_b[3];
+        float edge_c[3];
+        float depth_a;
+        float depth_b;
+        float depth_c;
+        float max_depth;
+        uint32_t min_x;
+        uint32_t min_y;
+        uint32_t max_x;
+        uint32_t max_y;
+    };
+
+    void add_occluder(const AccelerationStructurePrimitive& primitive, const Occluder& occluder);
+
+    // Vertices are in clip space.
+    void add_triangle(const float4& a, const float4& b, const float4& c);
+    void add_screen_triangle(const float3& a, const float3& b, const float3& c);
+
+    void rasterize_tile(uint32_t tile_index);
+    void build_depth_pyramid();
+
+    float* get_level(uint32_t level);
+    const float* get_level(uint32_t level) const;
+    uint32_t get_level_width(uint32_t level) const;
+    uint32_t get_level_height(uint32_t level) const;
+
+    void update_statistics(size_t tested_primitive_count, size_t culled_primitive_count) const;
+
+    Scene& m_scene;
+    CameraManager& m_camera_manager;
+    TaskScheduler& m_task_scheduler;
+    MemoryResource& m_persistent_memory_resource;
+    MemoryResource& m_transient_memory_resource;
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_tile_count_x;
+    uint32_t m_tile_count_y;
+    uint32_t m_max_occluder_count;
+    bool m_is_enabled;
+
+    // All levels of the depth pyramid one after another. Each texel contains the farthest depth of its children.
+    Vector<float> m_depth_pyramid;
+    Vector<size_t> m_level_offsets;
+
+    // Triangles of this frame's occluders and the indices of triangles that overlap each tile.
+    Vector<Triangle> m_triangles;
+    Vector<Vector<uint32_t>> m_tiles;
+
+    // Reused between occluders to avoid allocations.
+    Vector<float4> m_clip_vertices;
+
+    // Occlusion camera's view projection matrix and near plane of this frame.
+    float4x4 m_view_projection;
+    float m_z_near;
+
+    uint32_t m_occluder_count;
+    mutable std::atomic<uint32_t> m_tested_primitive_count;
+    mutable std::atomic<uint32_t> m_culled_primitive_count;
+};
+
+template <typename T>
+void OcclusionCuller::cull(Vector<T*>& primitives) const {
+    if (!m_is_enabled) {
+        return;
+    }
+
+    auto it = std::remove_if(primitives.begin(), primitives.end(), [this](const T* primitive) {
+        return is_occluded(primitive->get_bounds());
+    });
+
+    update_statistics(primitives.size(), primitives.end() - it);
+
+    primitives.erase(it, primitives.end());
+}
+
+} // namespace kw
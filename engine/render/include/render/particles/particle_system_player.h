@@ -1,10 +1,9 @@
 #pragma once
 
+#include <core/concurrency/task_shared_mutex.h>
 #include <core/containers/pair.h>
 #include <core/containers/vector.h>
 
-#include <shared_mutex>
-
 namespace kw {
 
 class ParticleSystemPrimitive;
@@ -38,7 +37,8 @@ private:
     MemoryResource& m_transient_memory_resource;
 
     Vector<ParticleSystemPrimitive*> m_primitives;
-    std::shared_mutex m_primitives_mutex;
+    // Worker tasks park instead of blocking while `add` or `remove` is running.
+    TaskSharedMutex m_primitives_mutex;
 };
 
 } // namespace kw
@@ -39,7 +39,7 @@ public:
     UniquePtr<Primitive> clone(MemoryResource& memory_resource) const override;
 
 protected:
-    void global_transform_updated() override;
+    void update_bounds() override;
 
 private:
     ReflectionProbeManager* m_reflection_probe_manager;
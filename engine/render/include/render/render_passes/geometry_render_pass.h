@@ -5,11 +5,17 @@
 namespace kw {
 
 class CameraManager;
+class OcclusionCuller;
 class Scene;
 
 struct GeometryRenderPassDescriptor {
     Scene* scene;
     CameraManager* camera_manager;
+
+    // Optional. When set, primitives hidden behind occluders are not drawn and the task must be placed after
+    // the occlusion culler's second task.
+    OcclusionCuller* occlusion_culler;
+
     MemoryResource* transient_memory_resource;
 };
 
@@ -31,6 +37,7 @@ private:
 
     Scene& m_scene;
     CameraManager& m_camera_manager;
+    OcclusionCuller* m_occlusion_culler;
     MemoryResource& m_transient_memory_resource;
 };
 
@@ -32,6 +32,7 @@ public:
 
 private:
     class BeginTask;
+    class CullTask;
     class WorkerTask;
 
     Scene& m_scene;
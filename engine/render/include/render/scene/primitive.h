@@ -46,9 +46,18 @@ public:
     virtual UniquePtr<Primitive> clone(MemoryResource& memory_resource) const = 0;
 
 protected:
+    enum class PrimitiveType : uint8_t {
+        GENERIC,
+        ACCELERATION_STRUCTURE,
+        CONTAINER,
+    };
+
     // Acceleration structure primitives must update their bounds, container primitives must propagate global transform.
     virtual void global_transform_updated();
-    
+
+    // Set by derived constructors. Allows containers to propagate global transform without `dynamic_cast`.
+    PrimitiveType m_primitive_type;
+
 private:
     ContainerPrimitive* m_parent;
 
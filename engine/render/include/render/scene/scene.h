@@ -15,6 +15,7 @@ class GeometryPrimitive;
 class LightPrimitive;
 class ParticleSystemPlayer;
 class ParticleSystemPrimitive;
+class QueryViews;
 class ReflectionProbeManager;
 class ReflectionProbePrimitive;
 
@@ -34,6 +35,11 @@ class Scene : public ContainerPrimitive {
 public:
     explicit Scene(const SceneDescriptor& scene_descriptor);
 
+    // Scene without children that queries the acceleration structures of the given scene, except geometry queries
+    // go to the given acceleration structure. Primitives must not be added to it.
+    Scene(const Scene& scene, AccelerationStructure& geometry_acceleration_structure, MemoryResource& persistent_memory_resource);
+
+    // Results are allocated from the transient memory resource.
     Vector<GeometryPrimitive*> query_geometry(const aabbox& bounds) const;
     Vector<GeometryPrimitive*> query_geometry(const frustum& frustum) const;
     
@@ -46,6 +52,27 @@ public:
     Vector<ReflectionProbePrimitive*> query_reflection_probes(const aabbox& bounds) const;
     Vector<ReflectionProbePrimitive*> query_reflection_probes(const frustum& frustum) const;
 
+    // Append results to the given vector. Nothing is allocated if the vector has enough capacity.
+    void query_geometry(const aabbox& bounds, Vector<GeometryPrimitive*>& output) const;
+    void query_geometry(const frustum& frustum, Vector<GeometryPrimitive*>& output) const;
+
+    void query_lights(const aabbox& bounds, Vector<LightPrimitive*>& output) const;
+    void query_lights(const frustum& frustum, Vector<LightPrimitive*>& output) const;
+
+    void query_particle_systems(const aabbox& bounds, Vector<ParticleSystemPrimitive*>& output) const;
+    void query_particle_systems(const frustum& frustum, Vector<ParticleSystemPrimitive*>& output) const;
+
+    void query_reflection_probes(const aabbox& bounds, Vector<ReflectionProbePrimitive*>& output) const;
+    void query_reflection_probes(const frustum& frustum, Vector<ReflectionProbePrimitive*>& output) const;
+
+    // Query multiple views in a single traversal. Results of view `i` are appended to `outputs[i]`.
+    void query_geometry(const QueryViews& views, Vector<GeometryPrimitive*>* outputs) const;
+    void query_lights(const QueryViews& views, Vector<LightPrimitive*>* outputs) const;
+    void query_particle_systems(const QueryViews& views, Vector<ParticleSystemPrimitive*>* outputs) const;
+    void query_reflection_probes(const QueryViews& views, Vector<ReflectionProbePrimitive*>* outputs) const;
+
+    AccelerationStructure& get_geometry_acceleration_structure() const;
+
 protected:
     void child_added(Primitive& primitive) override;
     void child_removed(Primitive& primitive) override;
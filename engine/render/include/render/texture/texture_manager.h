@@ -1,5 +1,6 @@
 #pragma once
 
+#include <core/concurrency/task_scheduler.h>
 #include <core/containers/pair.h>
 #include <core/containers/shared_ptr.h>
 #include <core/containers/string.h>
@@ -13,12 +14,13 @@ namespace kw {
 
 class Render;
 class Task;
-class TaskScheduler;
 class Texture;
 class TextureLoader;
 
 struct TextureManagerDescriptor {
     Render* render;
+
+    // Texture files are opened on background threads, so task scheduler must have at least one.
     TaskScheduler* task_scheduler;
 
     MemoryResource* persistent_memory_resource;
@@ -48,9 +50,18 @@ public:
 
 private:
     class BeginTask;
+    class OpeningTask;
     class PendingTask;
     class LoadingTask;
 
+    struct OpeningTexture {
+        UniquePtr<TextureLoader> texture_loader;
+        SharedPtr<Texture*> texture;
+        const char* relative_path;
+        UniquePtr<OpeningTask> opening_task;
+        BackgroundTaskHandle handle;
+    };
+
     Render& m_render;
     TaskScheduler& m_task_scheduler;
 
@@ -65,6 +76,9 @@ private:
     // Textures that are not even opened yet.
     Vector<Pair<const String&, SharedPtr<Texture*>>> m_pending_textures;
 
+    // Textures that are being opened on a background thread.
+    Vector<OpeningTexture> m_opening_textures;
+
     // Opened textures with some not yet loaded mip levels.
     Vector<Pair<UniquePtr<TextureLoader>, SharedPtr<Texture*>>> m_loading_textures;
 
@@ -0,0 +1,166 @@
+#include "render/acceleration_structure/acceleration_structure.h"
+#include "render/acceleration_structure/acceleration_structure_primitive.h"
+
+#include <core/debug/assert.h>
+#include <core/math/scalar.h>
+
+#include <algorithm>
+
+namespace kw {
+
+AccelerationStructure::QueryBuffer::QueryBuffer(QueryCallback callback, void* context)
+    : m_callback(callback)
+    , m_context(context)
+    , m_count(0)
+{
+    KW_ASSERT(callback != nullptr);
+}
+
+void AccelerationStructure::QueryBuffer::push(AccelerationStructurePrimitive* primitive) {
+    m_primitives[m_count++] = primitive;
+
+    if (m_count == 64) {
+        flush();
+    }
+}
+
+void AccelerationStructure::QueryBuffer::flush() {
+    if (m_count > 0) {
+        m_callback(m_context, m_primitives, m_count);
+        m_count = 0;
+    }
+}
+
+Vector<AccelerationStructurePrimitive*> AccelerationStructure::query(MemoryResource& memory_resource, const aabbox& bounds) const {
+    Vector<AccelerationStructurePrimitive*> result(memory_resource);
+    result.reserve(64);
+
+    query(bounds, [&](AccelerationStructurePrimitive* const* primitives, size_t count) {
+        result.insert(result.end(), primitives, primitives + count);
+    });
+
+    return result;
+}
+
+Vector<AccelerationStructurePrimitive*> AccelerationStructure::query(MemoryResource& memory_resource, const frustum& frustum) const {
+    Vector<AccelerationStructurePrimitive*> result(memory_resource);
+    result.reserve(64);
+
+    query(frustum, [&](AccelerationStructurePrimitive* const* primitives, size_t count) {
+        result.insert(result.end(), primitives, primitives + count);
+    });
+
+    return result;
+}
+
+void AccelerationStructure::cull_primitives(AccelerationStructurePrimitive* const* primitives, size_t count, const frustum& frustum,
+                                            QueryCallback callback, void* context)
+{
+    KW_ASSERT(primitives != nullptr || count == 0);
+
+    // Bounds are stored in primitives, so they must be gathered into structure of arrays first.
+    float center_x[64];
+    float center_y[64];
+    float center_z[64];
+    float extent_x[64];
+    float extent_y[64];
+    float extent_z[64];
+
+    for (size_t offset = 0; offset < count; offset += 64) {
+        size_t batch_size = std::min(count - offset, static_cast<size_t>(64));
+
+        for (size_t i = 0; i < batch_size; i++) {
+            const aabbox& bounds = primitives[offset + i]->get_bounds();
+
+            center_x[i] = bounds.center.x;
+            center_y[i] = bounds.center.y;
+            center_z[i] = bounds.center.z;
+            extent_x[i] = bounds.extent.x;
+            extent_y[i] = bounds.extent.y;
+            extent_z[i] = bounds.extent.z;
+        }
+
+        uint64_t intersect_mask;
+        intersect(center_x, center_y, center_z, extent_x, extent_y, extent_z, batch_size, frustum, &intersect_mask);
+
+        if (intersect_mask == (~0ull >> (64 - batch_size))) {
+            // The whole batch is visible, no need to copy it.
+            callback(context, primitives + offset, batch_size);
+        } else if (intersect_mask != 0) {
+            AccelerationStructurePrimitive* visible_primitives[64];
+            size_t visible_count = 0;
+
+            while (intersect_mask != 0) {
+                uint64_t index = log2(intersect_mask & (~intersect_mask + 1));
+                visible_primitives[visible_count++] = primitives[offset + index];
+                intersect_mask &= intersect_mask - 1;
+            }
+
+            callback(context, visible_primitives, visible_count);
+        }
+    }
+}
+
+void AccelerationStructure::cull_primitives(AccelerationStructurePrimitive* const* primitives, size_t count, const QueryViews& views,
+                                            uint64_t mask, uint64_t inside_mask, MultiQueryCallback callback, void* context)
+{
+    KW_ASSERT(primitives != nullptr || count == 0);
+    KW_ASSERT((inside_mask & ~mask) == 0);
+
+    uint64_t masks[64];
+
+    if (mask == inside_mask) {
+        // All views contain all primitives, no need to test anything.
+        std::fill(std::begin(masks), std::end(masks), mask);
+
+        for (size_t offset = 0; offset < count; offset += 64) {
+            callback(context, primitives + offset, masks, std::min(count - offset, static_cast<size_t>(64)));
+        }
+
+        return;
+    }
+
+    float center_x[64];
+    float center_y[64];
+    float center_z[64];
+    float extent_x[64];
+    float extent_y[64];
+    float extent_z[64];
+
+    AccelerationStructurePrimitive* visible_primitives[64];
+
+    for (size_t offset = 0; offset < count; offset += 64) {
+        size_t batch_size = std::min(count - offset, static_cast<size_t>(64));
+
+        for (size_t i = 0; i < batch_size; i++) {
+            const aabbox& bounds = primitives[offset + i]->get_bounds();
+
+            center_x[i] = bounds.center.x;
+            center_y[i] = bounds.center.y;
+            center_z[i] = bounds.center.z;
+            extent_x[i] = bounds.extent.x;
+            extent_y[i] = bounds.extent.y;
+            extent_z[i] = bounds.extent.z;
+        }
+
+        views.intersect(center_x, center_y, center_z, extent_x, extent_y, extent_z, batch_size, mask & ~inside_mask, masks);
+
+        // Compact visible primitives in place, masks are never read ahead of writes.
+        size_t visible_count = 0;
+
+        for (size_t i = 0; i < batch_size; i++) {
+            uint64_t primitive_mask = masks[i] | inside_mask;
+            if (primitive_mask != 0) {
+                visible_primitives[visible_count] = primitives[offset + i];
+                masks[visible_count] = primitive_mask;
+                visible_count++;
+            }
+        }
+
+        if (visible_count > 0) {
+            callback(context, visible_primitives, masks, visible_count);
+        }
+    }
+}
+
+} // namespace kw
@@ -3,7 +3,9 @@
 
 #include <core/debug/assert.h>
 
+#include <algorithm>
 #include <atomic>
+#include <functional>
 
 namespace kw {
 
@@ -16,6 +18,7 @@ AccelerationStructurePrimitive::AccelerationStructurePrimitive(const transform&
     , m_acceleration_structure(nullptr)
     , m_node(nullptr)
 {
+    m_primitive_type = PrimitiveType::ACCELERATION_STRUCTURE;
 }
 
 AccelerationStructurePrimitive::AccelerationStructurePrimitive(const AccelerationStructurePrimitive& other)
@@ -25,6 +28,8 @@ AccelerationStructurePrimitive::AccelerationStructurePrimitive(const Acceleratio
     , m_acceleration_structure(nullptr)
     , m_node(nullptr)
 {
+    m_primitive_type = PrimitiveType::ACCELERATION_STRUCTURE;
+
     KW_ASSERT(
         other.m_acceleration_structure == nullptr,
         "Copying acceleration structure primitives assigned to some acceleration structure is not allowed."
@@ -70,6 +75,8 @@ uint64_t AccelerationStructurePrimitive::get_counter() const {
 }
 
 void AccelerationStructurePrimitive::global_transform_updated() {
+    update_bounds();
+
     m_counter = ++acceleration_structure_counter;
 
     if (m_acceleration_structure != nullptr) {
@@ -77,4 +84,41 @@ void AccelerationStructurePrimitive::global_transform_updated() {
     }
 }
 
+void AccelerationStructurePrimitive::update_bounds() {
+    // No-op.
+}
+
+void AccelerationStructurePrimitive::global_transform_updated(AccelerationStructurePrimitive** primitives, size_t count) {
+    KW_ASSERT(primitives != nullptr || count == 0);
+
+    // Reserve a range of counter values at once rather than incrementing atomic counter for each primitive.
+    uint64_t counter = acceleration_structure_counter.fetch_add(count);
+
+    for (size_t i = 0; i < count; i++) {
+        primitives[i]->update_bounds();
+        primitives[i]->m_counter = counter + i + 1;
+    }
+
+    // Group primitives by acceleration structure to update each acceleration structure once.
+    std::sort(primitives, primitives + count, [](const AccelerationStructurePrimitive* lhs, const AccelerationStructurePrimitive* rhs) {
+        return std::less<AccelerationStructure*>()(lhs->m_acceleration_structure, rhs->m_acceleration_structure);
+    });
+
+    size_t first = 0;
+    while (first < count) {
+        AccelerationStructure* acceleration_structure = primitives[first]->m_acceleration_structure;
+
+        size_t last = first + 1;
+        while (last < count && primitives[last]->m_acceleration_structure == acceleration_structure) {
+            last++;
+        }
+
+        if (acceleration_structure != nullptr) {
+            acceleration_structure->update(primitives + first, last - first);
+        }
+
+        first = last;
+    }
+}
+
 } // namespace kw
@@ -0,0 +1,707 @@
+#include "render/acceleration_structure/bvh_acceleration_structure.h"
+#include "render/acceleration_structure/acceleration_structure_primitive.h"
+
+#include <core/concurrency/task.h>
+#include <core/debug/assert.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+namespace kw {
+
+constexpr uint32_t BVH_INTERNAL_NODE = UINT32_MAX;
+constexpr uint32_t BVH_INVALID_INDEX = UINT32_MAX;
+
+constexpr uint32_t BVH_BIN_COUNT = 16;
+
+// Nodes with this many primitives or less are never split.
+constexpr uint32_t BVH_MIN_LEAF_SIZE = 4;
+
+// Nodes with more primitives than this are always split, even if surface area heuristic suggests otherwise.
+constexpr uint32_t BVH_MAX_LEAF_SIZE = 8;
+
+// Cost of visiting a node relative to the cost of testing a primitive.
+constexpr float BVH_TRAVERSAL_COST = 1.f;
+
+// Subtree is rebuilt when its surface area grows this many times after refits.
+constexpr float BVH_DEGRADATION_FACTOR = 2.f;
+
+// Subtrees with more nodes than this are never rebuilt in place, because rebuilding most of the tree in place is not
+// cheaper than rebuilding the whole tree. When such subtree degrades, the whole tree is rebuilt instead.
+constexpr uint32_t BVH_MAX_DEGRADED_NODE_COUNT = 1024;
+
+// The whole tree is rebuilt by `rebuild_if_needed` when the number of primitives added since the last build exceeds
+// this number and a quarter of the primitives in the tree, or when the number of empty slots exceeds this number
+// and a half of the primitives in the tree.
+constexpr uint32_t BVH_MIN_PENDING_COUNT = 64;
+
+// `m_node` of a primitive stores the index of its leaf node or its slot with this flag for pending primitives.
+constexpr uint32_t BVH_PENDING_FLAG = 0x80000000;
+
+// Zero `m_node` is reserved for primitives that are not in any acceleration structure.
+static uint32_t get_index(void* node) {
+    KW_ASSERT(node != nullptr);
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(node) - 1);
+}
+
+static void* make_node(uint32_t index) {
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(index) + 1);
+}
+
+// Unlike `min` and `max` from "core/math/float3.h" these don't handle NaNs, which makes the build much faster.
+static float3 min_fast(const float3& lhs, const float3& rhs) {
+    return float3(lhs.x < rhs.x ? lhs.x : rhs.x, lhs.y < rhs.y ? lhs.y : rhs.y, lhs.z < rhs.z ? lhs.z : rhs.z);
+}
+
+static float3 max_fast(const float3& lhs, const float3& rhs) {
+    return float3(lhs.x > rhs.x ? lhs.x : rhs.x, lhs.y > rhs.y ? lhs.y : rhs.y, lhs.z > rhs.z ? lhs.z : rhs.z);
+}
+
+struct BvhBuildItem {
+    float3 min;
+    float3 max;
+    float3 center;
+    AccelerationStructurePrimitive* primitive;
+};
+
+// Bounds of the items of a subtree and bounds of their centers.
+struct BvhBuildBounds {
+    float3 min = float3(FLT_MAX);
+    float3 max = float3(-FLT_MAX);
+    float3 centroid_min = float3(FLT_MAX);
+    float3 centroid_max = float3(-FLT_MAX);
+};
+
+static BvhBuildItem make_build_item(AccelerationStructurePrimitive* primitive) {
+    const aabbox& bounds = primitive->get_bounds();
+    return BvhBuildItem{ bounds.center - bounds.extent, bounds.center + bounds.extent, bounds.center, primitive };
+}
+
+static BvhBuildBounds get_build_bounds(const BvhBuildItem* items, uint32_t count) {
+    BvhBuildBounds result;
+
+    for (uint32_t i = 0; i < count; i++) {
+        result.min = min_fast(result.min, items[i].min);
+        result.max = max_fast(result.max, items[i].max);
+        result.centroid_min = min_fast(result.centroid_min, items[i].center);
+        result.centroid_max = max_fast(result.centroid_max, items[i].center);
+    }
+
+    return result;
+}
+
+static void merge_build_bounds(BvhBuildBounds& lhs, const BvhBuildBounds& rhs) {
+    lhs.min = min_fast(lhs.min, rhs.min);
+    lhs.max = max_fast(lhs.max, rhs.max);
+    lhs.centroid_min = min_fast(lhs.centroid_min, rhs.centroid_min);
+    lhs.centroid_max = max_fast(lhs.centroid_max, rhs.centroid_max);
+}
+
+static float get_area(const aabbox& bounds) {
+    return bounds.extent.x * bounds.extent.y + bounds.extent.y * bounds.extent.z + bounds.extent.z * bounds.extent.x;
+}
+
+static float get_area(const float3& min, const float3& max) {
+    float3 size = max - min;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+static bool contains(const aabbox& outer, const aabbox& inner) {
+    return std::abs(outer.center.x - inner.center.x) + inner.extent.x <= outer.extent.x &&
+           std::abs(outer.center.y - inner.center.y) + inner.extent.y <= outer.extent.y &&
+           std::abs(outer.center.z - inner.center.z) + inner.extent.z <= outer.extent.z;
+}
+
+// Same as `intersect` and `inside` from "core/math/frustum.h" in one pass. Returns 0 when the box is outside of
+// the frustum, 1 when the box intersects the frustum and 2 when the box is inside of the frustum.
+static uint32_t classify(const aabbox& box, const frustum& frustum) {
+    uint32_t result = 2;
+
+    for (const plane& plane : frustum.data) {
+        float distance = dot(box.center, plane.normal) + plane.distance;
+        float radius = dot(box.extent, abs(plane.normal));
+
+        if (distance < -radius) {
+            return 0;
+        }
+
+        if (distance < radius) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+BvhAccelerationStructure::BvhAccelerationStructure(MemoryResource& persistent_memory_resource)
+    : m_memory_resource(persistent_memory_resource)
+    , m_nodes(persistent_memory_resource)
+    , m_primitives(persistent_memory_resource)
+    , m_degraded_nodes(persistent_memory_resource)
+    , m_build_count(0)
+    , m_hole_count(0)
+    , m_is_rebuild_scheduled(false)
+{
+    // Avoid first 8 reallocations.
+    m_primitives.reserve(128);
+}
+
+void BvhAccelerationStructure::add(AccelerationStructurePrimitive& primitive) {
+    std::lock_guard lock_guard(m_shared_mutex);
+
+    KW_ASSERT(primitive.m_acceleration_structure == nullptr, "Primitive is already is in this acceleration structure.");
+    primitive.m_acceleration_structure = this;
+
+    // The tree is rebuilt by `rebuild_if_needed`, so adding many primitives in a row doesn't rebuild it many times.
+    primitive.m_node = make_node(static_cast<uint32_t>(m_primitives.size()) | BVH_PENDING_FLAG);
+    m_primitives.push_back(&primitive);
+}
+
+void BvhAccelerationStructure::remove(AccelerationStructurePrimitive& primitive) {
+    std::lock_guard lock_guard(m_shared_mutex);
+
+    KW_ASSERT(primitive.m_acceleration_structure == this, "Primitive is not in this acceleration structure.");
+    primitive.m_acceleration_structure = nullptr;
+
+    uint32_t index = get_index(primitive.m_node);
+
+    if ((index & BVH_PENDING_FLAG) != 0) {
+        uint32_t slot = index & ~BVH_PENDING_FLAG;
+        KW_ASSERT(slot >= m_build_count && slot < m_primitives.size() && m_primitives[slot] == &primitive);
+
+        // Pending primitives are not referenced by leaves, so any of them can be moved.
+        AccelerationStructurePrimitive* last_primitive = m_primitives.back();
+        m_primitives[slot] = last_primitive;
+        last_primitive->m_node = make_node(slot | BVH_PENDING_FLAG);
+        m_primitives.pop_back();
+    } else {
+        BvhNode& leaf = m_nodes[index];
+        KW_ASSERT(leaf.count != BVH_INTERNAL_NODE && leaf.count > 0);
+
+        uint32_t last_slot = leaf.first + leaf.count - 1;
+
+        uint32_t slot = leaf.first;
+        while (m_primitives[slot] != &primitive) {
+            KW_ASSERT(slot < last_slot);
+            slot++;
+        }
+
+        // Move the last primitive of the leaf to the removed primitive's slot and leave an empty slot at the end.
+        // Leaf bounds are not shrunk, too many empty slots make `rebuild_if_needed` rebuild the tree.
+        m_primitives[slot] = m_primitives[last_slot];
+        m_primitives[last_slot] = nullptr;
+
+        leaf.count--;
+
+        m_hole_count++;
+    }
+
+    primitive.m_node = nullptr;
+}
+
+void BvhAccelerationStructure::update(AccelerationStructurePrimitive& primitive) {
+    std::lock_guard lock_guard(m_shared_mutex);
+
+    refit(primitive);
+
+    rebuild_degraded_nodes();
+}
+
+void BvhAccelerationStructure::update(AccelerationStructurePrimitive* const* primitives, size_t count) {
+    KW_ASSERT(primitives != nullptr || count == 0);
+
+    std::lock_guard lock_guard(m_shared_mutex);
+
+    for (size_t i = 0; i < count; i++) {
+        refit(*primitives[i]);
+    }
+
+    // Each degraded subtree is rebuilt once for the whole batch.
+    rebuild_degraded_nodes();
+}
+
+void BvhAccelerationStructure::query(const aabbox& bounds, QueryCallback callback, void* context) const {
+    std::shared_lock shared_lock(m_shared_mutex);
+
+    QueryBuffer buffer(callback, context);
+
+    // Nodes are stored in depth-first order, so the traversal is a linear scan that skips rejected subtrees.
+    uint32_t node_index = 0;
+    while (node_index < m_nodes.size()) {
+        const BvhNode& node = m_nodes[node_index];
+
+        if (node.count == 0 || !intersect(node.bounds, bounds)) {
+            node_index = node.end;
+        } else if (node.count != BVH_INTERNAL_NODE) {
+            for (uint32_t slot = node.first; slot < node.first + node.count; slot++) {
+                if (intersect(m_primitives[slot]->get_bounds(), bounds)) {
+                    buffer.push(m_primitives[slot]);
+                }
+            }
+
+            node_index = node.end;
+        } else {
+            node_index++;
+        }
+    }
+
+    for (size_t slot = m_build_count; slot < m_primitives.size(); slot++) {
+        if (intersect(m_primitives[slot]->get_bounds(), bounds)) {
+            buffer.push(m_primitives[slot]);
+        }
+    }
+
+    buffer.flush();
+}
+
+void BvhAccelerationStructure::query(const frustum& frustum, QueryCallback callback, void* context) const {
+    std::shared_lock shared_lock(m_shared_mutex);
+
+    // Nodes are stored in depth-first order, so the traversal is a linear scan that skips rejected subtrees.
+    uint32_t node_index = 0;
+    while (node_index < m_nodes.size()) {
+        const BvhNode& node = m_nodes[node_index];
+
+        uint32_t classification = node.count != 0 ? classify(node.bounds, frustum) : 0;
+
+        if (classification == 0) {
+            node_index = node.end;
+        } else if (classification == 2) {
+            // Subtree is stored contiguously, so all its leaves are collected without any tests.
+            collect_primitives(node_index, node.end, callback, context);
+            node_index = node.end;
+        } else if (node.count != BVH_INTERNAL_NODE) {
+            cull_primitives(m_primitives.data() + node.first, node.count, frustum, callback, context);
+            node_index = node.end;
+        } else {
+            node_index++;
+        }
+    }
+
+    cull_primitives(m_primitives.data() + m_build_count, m_primitives.size() - m_build_count, frustum, callback, context);
+}
+
+void BvhAccelerationStructure::query(const QueryViews& views, MultiQueryCallback callback, void* context) const {
+    std::shared_lock shared_lock(m_shared_mutex);
+
+    if (!m_nodes.empty()) {
+        uint64_t inside_mask;
+        uint64_t mask = views.intersect(m_nodes[0].bounds, views.get_mask(), inside_mask);
+
+        if (mask != 0) {
+            collect_primitives(0, views, mask, inside_mask, callback, context);
+        }
+    }
+
+    cull_primitives(m_primitives.data() + m_build_count, m_primitives.size() - m_build_count, views, views.get_mask(), 0, callback, context);
+}
+
+size_t BvhAccelerationStructure::get_count() const {
+    std::shared_lock shared_lock(m_shared_mutex);
+
+    return m_primitives.size() - m_hole_count;
+}
+
+void BvhAccelerationStructure::refit(AccelerationStructurePrimitive& primitive) {
+    KW_ASSERT(primitive.m_acceleration_structure == this, "Primitive is not in this acceleration structure.");
+
+    uint32_t index = get_index(primitive.m_node);
+
+    if ((index & BVH_PENDING_FLAG) != 0) {
+        // Pending primitives are tested linearly.
+        return;
+    }
+
+    grow(index, primitive.get_bounds());
+}
+
+void BvhAccelerationStructure::grow(uint32_t node_index, const aabbox& bounds) {
+    // Nodes are only grown, never shrunk, so only the updated primitive's bounds are accessed. When most primitives
+    // move in the same direction, parents quickly contain all the new bounds and refits stop after a few nodes.
+    // Degraded subtrees are rebuilt with exact bounds.
+    while (node_index != BVH_INVALID_INDEX) {
+        BvhNode& node = m_nodes[node_index];
+
+        if (contains(node.bounds, bounds)) {
+            break;
+        }
+
+        aabbox node_bounds = node.bounds + bounds;
+        if (node_bounds == node.bounds) {
+            // Rounding errors make `contains` fail for boxes touching the node's bounds.
+            break;
+        }
+
+        node.bounds = node_bounds;
+
+        if (get_area(node_bounds) > node.build_area * BVH_DEGRADATION_FACTOR) {
+            // Rebuilding a leaf alone would not change anything, but rebuilding its parent moves its primitives
+            // between the leaves.
+            uint32_t degraded_index = node.count != BVH_INTERNAL_NODE ? node.parent : node_index;
+            if (degraded_index != BVH_INVALID_INDEX) {
+                if (m_nodes[degraded_index].end - degraded_index <= BVH_MAX_DEGRADED_NODE_COUNT) {
+                    m_degraded_nodes.push_back(degraded_index);
+                } else {
+                    // Bounds of the nodes close to the root are never shrunk otherwise.
+                    m_is_rebuild_scheduled = true;
+                }
+            }
+        }
+
+        node_index = node.parent;
+    }
+}
+
+void BvhAccelerationStructure::refit_parents(uint32_t node_index) {
+    uint32_t parent_index = m_nodes[node_index].parent;
+    while (parent_index != BVH_INVALID_INDEX) {
+        BvhNode& parent = m_nodes[parent_index];
+
+        aabbox bounds = m_nodes[parent_index + 1].bounds + m_nodes[parent.first].bounds;
+        if (parent.bounds == bounds) {
+            // Bounds of the parent nodes are not affected.
+            break;
+        }
+
+        parent.bounds = bounds;
+        parent_index = parent.parent;
+    }
+}
+
+void BvhAccelerationStructure::rebuild_if_needed() {
+    std::lock_guard lock_guard(m_shared_mutex);
+
+    if (is_rebuild_needed()) {
+        rebuild();
+    }
+}
+
+class BvhAccelerationStructure::RebuildTask : public Task {
+public:
+    explicit RebuildTask(BvhAccelerationStructure& acceleration_structure)
+        : m_acceleration_structure(acceleration_structure)
+    {
+    }
+
+    void run() override {
+        m_acceleration_structure.rebuild_if_needed();
+    }
+
+    const char* get_name() const override {
+        return "Bvh Acceleration Structure Rebuild";
+    }
+
+private:
+    BvhAccelerationStructure& m_acceleration_structure;
+};
+
+Task* BvhAccelerationStructure::create_task(MemoryResource& transient_memory_resource) {
+    return transient_memory_resource.construct<RebuildTask>(*this);
+}
+
+bool BvhAccelerationStructure::is_rebuild_needed() const {
+    // Rebuilding when the number of pending primitives grows proportionally to the tree size makes `add` O(logN)
+    // amortized and keeps the linearly tested list short.
+    uint32_t pending_count = static_cast<uint32_t>(m_primitives.size()) - m_build_count;
+    return pending_count > std::max(BVH_MIN_PENDING_COUNT, m_build_count / 4) ||
+           m_hole_count > std::max(BVH_MIN_PENDING_COUNT, m_build_count / 2);
+}
+
+void BvhAccelerationStructure::rebuild_degraded_nodes() {
+    if (m_is_rebuild_scheduled) {
+        // Rebuilds degraded subtrees too.
+        rebuild();
+        return;
+    }
+
+    if (m_degraded_nodes.empty()) {
+        return;
+    }
+
+    std::sort(m_degraded_nodes.begin(), m_degraded_nodes.end());
+
+    // Skip degraded nodes inside of the subtrees of other degraded nodes. Subtrees are rebuilt within their own
+    // ranges of nodes, so the order doesn't matter.
+    uint32_t subtree_end = 0;
+
+    for (uint32_t node_index : m_degraded_nodes) {
+        if (node_index >= subtree_end) {
+            subtree_end = m_nodes[node_index].end;
+            rebuild(node_index);
+        }
+    }
+
+    m_degraded_nodes.clear();
+}
+
+void BvhAccelerationStructure::rebuild() {
+    // Remove empty slots. Pending primitives join the tree.
+    auto it = std::remove(m_primitives.begin(), m_primitives.end(), nullptr);
+    m_primitives.erase(it, m_primitives.end());
+
+    m_build_count = static_cast<uint32_t>(m_primitives.size());
+    m_hole_count = 0;
+    m_is_rebuild_scheduled = false;
+
+    m_nodes.clear();
+    m_degraded_nodes.clear();
+
+    if (m_build_count > 0) {
+        Vector<BvhBuildItem> items(m_memory_resource);
+        items.reserve(m_build_count);
+
+        for (AccelerationStructurePrimitive* primitive : m_primitives) {
+            items.push_back(make_build_item(primitive));
+        }
+
+        // A binary tree with N leaves has 2N-1 nodes and each leaf has at least one primitive.
+        m_nodes.resize(2 * m_build_count - 1);
+
+        uint32_t node_count = build(items.data(), get_build_bounds(items.data(), m_build_count), 0, 2 * m_build_count - 1, BVH_INVALID_INDEX, 0, m_build_count);
+
+        m_nodes.resize(node_count);
+    }
+}
+
+void BvhAccelerationStructure::rebuild(uint32_t node_index) {
+    KW_ASSERT(node_index < m_nodes.size());
+
+    uint32_t subtree_end = m_nodes[node_index].end;
+
+    // Leaves store their primitives in depth-first order too, so the subtree's primitives are compacted towards
+    // the first leaf's slot.
+    uint32_t first_slot = UINT32_MAX;
+    uint32_t last_slot = 0;
+
+    Vector<BvhBuildItem> items(m_memory_resource);
+
+    for (uint32_t i = node_index; i < subtree_end; i++) {
+        const BvhNode& node = m_nodes[i];
+        if (node.count != BVH_INTERNAL_NODE && node.count > 0) {
+            first_slot = std::min(first_slot, node.first);
+            last_slot = std::max(last_slot, node.first + node.count);
+
+            for (uint32_t slot = node.first; slot < node.first + node.count; slot++) {
+                items.push_back(make_build_item(m_primitives[slot]));
+            }
+        }
+    }
+
+    KW_ASSERT(first_slot != UINT32_MAX);
+
+    uint32_t count = static_cast<uint32_t>(items.size());
+
+    for (uint32_t slot = first_slot + count; slot < last_slot; slot++) {
+        m_primitives[slot] = nullptr;
+    }
+
+    // The subtree must fit in its current range of nodes, so the rest of the tree stays intact.
+    uint32_t node_budget = subtree_end - node_index;
+    uint32_t node_count = build(items.data(), get_build_bounds(items.data(), count), node_index, node_budget, m_nodes[node_index].parent, first_slot, count);
+
+    // Unused nodes become empty leaves, which are skipped by queries.
+    for (uint32_t i = node_index + node_count; i < subtree_end; i++) {
+        BvhNode& node = m_nodes[i];
+        node.bounds = aabbox();
+        node.build_area = 0.f;
+        node.parent = BVH_INVALID_INDEX;
+        node.first = 0;
+        node.count = 0;
+        node.end = i + 1;
+    }
+
+    m_nodes[node_index].end = subtree_end;
+
+    // Primitives could have changed their bounds before they were refitted, so propagate new bounds to the parents.
+    refit_parents(node_index);
+}
+
+uint32_t BvhAccelerationStructure::build(BvhBuildItem* items, const BvhBuildBounds& build_bounds, uint32_t node_index, uint32_t node_budget,
+                                         uint32_t parent, uint32_t first, uint32_t count)
+{
+    KW_ASSERT(node_budget > 0);
+
+    BvhNode& node = m_nodes[node_index];
+    node.bounds = count > 0 ? aabbox::from_min_max(build_bounds.min, build_bounds.max) : aabbox();
+    node.build_area = get_area(node.bounds);
+    node.parent = parent;
+    node.first = first;
+    node.count = count;
+    node.end = node_index + 1;
+
+    float3 centroid_size = build_bounds.centroid_max - build_bounds.centroid_min;
+
+    uint32_t axis = 0;
+    if (centroid_size.y > centroid_size[axis]) {
+        axis = 1;
+    }
+    if (centroid_size.z > centroid_size[axis]) {
+        axis = 2;
+    }
+
+    // A node needs at least three nodes to be split: itself and two leaves.
+    bool is_leaf = count <= BVH_MIN_LEAF_SIZE || node_budget < 3;
+    uint32_t split = UINT32_MAX;
+
+    BvhBuildBounds left_bounds;
+    BvhBuildBounds right_bounds;
+
+    if (!is_leaf && centroid_size[axis] > 0.f) {
+        struct Bin {
+            BvhBuildBounds bounds;
+            uint32_t count = 0;
+        } bins[BVH_BIN_COUNT];
+
+        float centroid_min = build_bounds.centroid_min[axis];
+        float scale = BVH_BIN_COUNT / centroid_size[axis];
+
+        auto get_bin = [&](const BvhBuildItem& item) {
+            return std::min(static_cast<uint32_t>((item.center[axis] - centroid_min) * scale), BVH_BIN_COUNT - 1);
+        };
+
+        for (uint32_t i = 0; i < count; i++) {
+            const BvhBuildItem& item = items[i];
+
+            Bin& bin = bins[get_bin(item)];
+            bin.bounds.min = min_fast(bin.bounds.min, item.min);
+            bin.bounds.max = max_fast(bin.bounds.max, item.max);
+            bin.bounds.centroid_min = min_fast(bin.bounds.centroid_min, item.center);
+            bin.bounds.centroid_max = max_fast(bin.bounds.centroid_max, item.center);
+            bin.count++;
+        }
+
+        // Sweep from the right to compute the cost of the right side of each split.
+        float right_costs[BVH_BIN_COUNT];
+        float3 right_min(FLT_MAX);
+        float3 right_max(-FLT_MAX);
+        uint32_t right_count = 0;
+
+        for (uint32_t i = BVH_BIN_COUNT - 1; i > 0; i--) {
+            right_min = min_fast(right_min, bins[i].bounds.min);
+            right_max = max_fast(right_max, bins[i].bounds.max);
+            right_count += bins[i].count;
+            right_costs[i - 1] = right_count > 0 ? right_count * get_area(right_min, right_max) : 0.f;
+        }
+
+        // Sweep from the left to find the cheapest split. Bins `[0, i]` go to the left child.
+        float best_cost = FLT_MAX;
+        uint32_t best_bin = BVH_BIN_COUNT;
+        float3 left_min(FLT_MAX);
+        float3 left_max(-FLT_MAX);
+        uint32_t left_count = 0;
+
+        for (uint32_t i = 0; i < BVH_BIN_COUNT - 1; i++) {
+            left_min = min_fast(left_min, bins[i].bounds.min);
+            left_max = max_fast(left_max, bins[i].bounds.max);
+            left_count += bins[i].count;
+
+            if (left_count > 0 && left_count < count) {
+                float cost = left_count * get_area(left_min, left_max) + right_costs[i];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_bin = i;
+                }
+            }
+        }
+
+        float area = get_area(build_bounds.min, build_bounds.max);
+
+        // Split even when the surface area heuristic prefers a leaf, if the leaf would be too large.
+        is_leaf = BVH_TRAVERSAL_COST * area + best_cost >= count * area && count <= BVH_MAX_LEAF_SIZE;
+
+        if (!is_leaf && best_bin != BVH_BIN_COUNT) {
+            BvhBuildItem* it = std::partition(items, items + count, [&](const BvhBuildItem& item) {
+                return get_bin(item) <= best_bin;
+            });
+
+            split = static_cast<uint32_t>(it - items);
+
+            // Children's bounds are known from the bins, so they don't need another pass over their items.
+            for (uint32_t i = 0; i < BVH_BIN_COUNT; i++) {
+                merge_build_bounds(i <= best_bin ? left_bounds : right_bounds, bins[i].bounds);
+            }
+        }
+    } else if (!is_leaf) {
+        // All centroids are equal, splitting won't help.
+        is_leaf = count <= BVH_MAX_LEAF_SIZE;
+    }
+
+    if (is_leaf) {
+        for (uint32_t i = 0; i < count; i++) {
+            m_primitives[first + i] = items[i].primitive;
+            m_primitives[first + i]->m_node = make_node(node_index);
+        }
+
+        return 1;
+    }
+
+    if (split == UINT32_MAX) {
+        // All centroids ended up in a single bin, split by the median.
+        split = count / 2;
+
+        std::nth_element(items, items + split, items + count, [&](const BvhBuildItem& lhs, const BvhBuildItem& rhs) {
+            return lhs.center[axis] < rhs.center[axis];
+        });
+
+        left_bounds = get_build_bounds(items, split);
+        right_bounds = get_build_bounds(items + split, count - split);
+    }
+
+    KW_ASSERT(split > 0 && split < count);
+
+    node.count = BVH_INTERNAL_NODE;
+
+    // Children get as many nodes as they could possibly need. When the budget is not enough for that, it's shared
+    // proportionally to the number of primitives and the children end up with larger leaves.
+    uint32_t available_count = node_budget - 1;
+    uint32_t left_budget = 2 * split - 1;
+
+    if (left_budget + 2 * (count - split) - 1 > available_count) {
+        left_budget = static_cast<uint32_t>(static_cast<uint64_t>(available_count) * split / count);
+        left_budget = std::min(std::max(left_budget, 1U), available_count - 1);
+    }
+
+    uint32_t left_node_count = build(items, left_bounds, node_index + 1, left_budget, node_index, first, split);
+
+    uint32_t right_index = node_index + 1 + left_node_count;
+    uint32_t right_node_count = build(items + split, right_bounds, right_index, available_count - left_node_count, node_index, first + split, count - split);
+
+    m_nodes[node_index].first = right_index;
+    m_nodes[node_index].end = right_index + right_node_count;
+
+    return 1 + left_node_count + right_node_count;
+}
+
+void BvhAccelerationStructure::collect_primitives(uint32_t first_node, uint32_t last_node, QueryCallback callback, void* context) const {
+    for (uint32_t node_index = first_node; node_index < last_node; node_index++) {
+        const BvhNode& node = m_nodes[node_index];
+        if (node.count != BVH_INTERNAL_NODE && node.count > 0) {
+            callback(context, m_primitives.data() + node.first, node.count);
+        }
+    }
+}
+
+void BvhAccelerationStructure::collect_primitives(uint32_t node_index, const QueryViews& views, uint64_t mask, uint64_t inside_mask,
+                                                  MultiQueryCallback callback, void* context) const
+{
+    const BvhNode& node = m_nodes[node_index];
+
+    if (node.count != BVH_INTERNAL_NODE) {
+        cull_primitives(m_primitives.data() + node.first, node.count, views, mask, inside_mask, callback, context);
+    } else {
+        uint32_t children[2] = { node_index + 1, node.first };
+
+        for (uint32_t child_index : children) {
+            // Views that contain this node contain its children too.
+            uint64_t child_inside_mask;
+            uint64_t child_mask = views.intersect(m_nodes[child_index].bounds, mask & ~inside_mask, child_inside_mask) | inside_mask;
+
+            if (child_mask != 0) {
+                collect_primitives(child_index, views, child_mask, child_inside_mask | inside_mask, callback, context);
+            }
+        }
+    }
+}
+
+} // namespace kw
@@ -40,34 +40,34 @@ void LinearAccelerationStructure::update(AccelerationStructurePrimitive& primiti
     // No-op.
 }
 
-Vector<AccelerationStructurePrimitive*> LinearAccelerationStructure::query(MemoryResource& memory_resource, const aabbox& bounds) const {
+void LinearAccelerationStructure::update(AccelerationStructurePrimitive* const* primitives, size_t count) {
+    // No-op.
+}
+
+void LinearAccelerationStructure::query(const aabbox& bounds, QueryCallback callback, void* context) const {
     std::shared_lock shared_lock(m_shared_mutex);
 
-    Vector<AccelerationStructurePrimitive*> result(memory_resource);
-    result.reserve(64);
+    QueryBuffer buffer(callback, context);
 
     for (AccelerationStructurePrimitive* primitive : m_primitives) {
         if (intersect(primitive->get_bounds(), bounds)) {
-            result.push_back(primitive);
+            buffer.push(primitive);
         }
     }
-    
-    return result;
+
+    buffer.flush();
 }
 
-Vector<AccelerationStructurePrimitive*> LinearAccelerationStructure::query(MemoryResource& memory_resource, const frustum& frustum) const {
+void LinearAccelerationStructure::query(const frustum& frustum, QueryCallback callback, void* context) const {
     std::shared_lock shared_lock(m_shared_mutex);
 
-    Vector<AccelerationStructurePrimitive*> result(memory_resource);
-    result.reserve(64);
-    
-    for (AccelerationStructurePrimitive* primitive : m_primitives) {
-        if (intersect(primitive->get_bounds(), frustum)) {
-            result.push_back(primitive);
-        }
-    }
-    
-    return result;
+    cull_primitives(m_primitives.data(), m_primitives.size(), frustum, callback, context);
+}
+
+void LinearAccelerationStructure::query(const QueryViews& views, MultiQueryCallback callback, void* context) const {
+    std::shared_lock shared_lock(m_shared_mutex);
+
+    cull_primitives(m_primitives.data(), m_primitives.size(), views, views.get_mask(), 0, callback, context);
 }
 
 size_t LinearAccelerationStructure::get_count() const {
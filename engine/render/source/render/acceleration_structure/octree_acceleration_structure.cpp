@@ -84,6 +84,20 @@ void OctreeAccelerationStructure::remove(AccelerationStructurePrimitive& primiti
 void OctreeAccelerationStructure::update(AccelerationStructurePrimitive& primitive) {
     std::lock_guard lock_guard(m_shared_mutex);
 
+    update_locked(primitive);
+}
+
+void OctreeAccelerationStructure::update(AccelerationStructurePrimitive* const* primitives, size_t count) {
+    KW_ASSERT(primitives != nullptr || count == 0);
+
+    std::lock_guard lock_guard(m_shared_mutex);
+
+    for (size_t i = 0; i < count; i++) {
+        update_locked(*primitives[i]);
+    }
+}
+
+void OctreeAccelerationStructure::update_locked(AccelerationStructurePrimitive& primitive) {
     KW_ASSERT(primitive.m_acceleration_structure == this, "Primitive is not in this acceleration structure.");
 
     OctreeNode* node = static_cast<OctreeNode*>(primitive.m_node);
@@ -111,41 +125,109 @@ void OctreeAccelerationStructure::update(AccelerationStructurePrimitive& primiti
     }
 }
 
-template <typename Bounds>
-void OctreeAccelerationStructure::collect_primitives(const OctreeNode& node, const Bounds& bounds, Vector<AccelerationStructurePrimitive*>& output) const {
+void OctreeAccelerationStructure::collect_primitives(const OctreeNode& node, const aabbox& bounds, QueryBuffer& buffer) const {
     for (AccelerationStructurePrimitive* primitive : node.primitives) {
         if (intersect(primitive->get_bounds(), bounds)) {
-            output.push_back(primitive);
+            buffer.push(primitive);
         }
     }
 
     for (const UniquePtr<OctreeNode>& child : node.children) {
         if (child && intersect(child->bounds, bounds)) {
-            collect_primitives(*child, bounds, output);
+            collect_primitives(*child, bounds, buffer);
+        }
+    }
+}
+
+void OctreeAccelerationStructure::collect_primitives(const OctreeNode& node, const frustum& frustum, QueryCallback callback, void* context) const {
+    cull_primitives(node.primitives.data(), node.primitives.size(), frustum, callback, context);
+
+    const OctreeNode* children[8];
+    float center_x[8];
+    float center_y[8];
+    float center_z[8];
+    float extent_x[8];
+    float extent_y[8];
+    float extent_z[8];
+    size_t child_count = 0;
+
+    for (const UniquePtr<OctreeNode>& child : node.children) {
+        if (child) {
+            children[child_count] = child.get();
+            center_x[child_count] = child->bounds.center.x;
+            center_y[child_count] = child->bounds.center.y;
+            center_z[child_count] = child->bounds.center.z;
+            extent_x[child_count] = child->bounds.extent.x;
+            extent_y[child_count] = child->bounds.extent.y;
+            extent_z[child_count] = child->bounds.extent.z;
+            child_count++;
+        }
+    }
+
+    if (child_count > 0) {
+        // Test all children at once. Children that are fully inside the frustum skip per-primitive tests.
+        uint64_t intersect_mask;
+        uint64_t inside_mask;
+        intersect(center_x, center_y, center_z, extent_x, extent_y, extent_z, child_count, frustum, &intersect_mask, &inside_mask);
+
+        for (size_t i = 0; i < child_count; i++) {
+            if ((inside_mask & (1ull << i)) != 0) {
+                collect_all_primitives(*children[i], callback, context);
+            } else if ((intersect_mask & (1ull << i)) != 0) {
+                collect_primitives(*children[i], frustum, callback, context);
+            }
         }
     }
 }
 
-Vector<AccelerationStructurePrimitive*> OctreeAccelerationStructure::query(MemoryResource& memory_resource, const aabbox& bounds) const {
+void OctreeAccelerationStructure::collect_primitives(const OctreeNode& node, const QueryViews& views, uint64_t mask, uint64_t inside_mask,
+                                                     MultiQueryCallback callback, void* context) const
+{
+    cull_primitives(node.primitives.data(), node.primitives.size(), views, mask, inside_mask, callback, context);
+
+    for (const UniquePtr<OctreeNode>& child : node.children) {
+        if (child) {
+            // Views that contain this node contain its children too.
+            uint64_t child_inside_mask;
+            uint64_t child_mask = views.intersect(child->bounds, mask & ~inside_mask, child_inside_mask) | inside_mask;
+
+            if (child_mask != 0) {
+                collect_primitives(*child, views, child_mask, child_inside_mask | inside_mask, callback, context);
+            }
+        }
+    }
+}
+
+void OctreeAccelerationStructure::collect_all_primitives(const OctreeNode& node, QueryCallback callback, void* context) const {
+    if (!node.primitives.empty()) {
+        callback(context, node.primitives.data(), node.primitives.size());
+    }
+
+    for (const UniquePtr<OctreeNode>& child : node.children) {
+        if (child) {
+            collect_all_primitives(*child, callback, context);
+        }
+    }
+}
+
+void OctreeAccelerationStructure::query(const aabbox& bounds, QueryCallback callback, void* context) const {
     std::shared_lock shared_lock(m_shared_mutex);
 
-    Vector<AccelerationStructurePrimitive*> result(memory_resource);
-    result.reserve(64);
+    QueryBuffer buffer(callback, context);
+    collect_primitives(*this, bounds, buffer);
+    buffer.flush();
+}
+
+void OctreeAccelerationStructure::query(const frustum& frustum, QueryCallback callback, void* context) const {
+    std::shared_lock shared_lock(m_shared_mutex);
 
-    collect_primitives(*this, bounds, result);
-    
-    return result;
+    collect_primitives(*this, frustum, callback, context);
 }
 
-Vector<AccelerationStructurePrimitive*> OctreeAccelerationStructure::query(MemoryResource& memory_resource, const frustum& frustum) const {
+void OctreeAccelerationStructure::query(const QueryViews& views, MultiQueryCallback callback, void* context) const {
     std::shared_lock shared_lock(m_shared_mutex);
 
-    Vector<AccelerationStructurePrimitive*> result(memory_resource);
-    result.reserve(64);
-    
-    collect_primitives(*this, frustum, result);
-    
-    return result;
+    collect_primitives(*this, views, views.get_mask(), 0, callback, context);
 }
 
 size_t OctreeAccelerationStructure::get_count() const {
@@ -159,6 +241,18 @@ OctreeNode& OctreeAccelerationStructure::find_node(const aabbox& bounds, OctreeN
         return node;
     }
 
+    // Primitives that don't fit in the root node are stored in the root node, otherwise node's bounds contain all of
+    // its primitives entirely. The same condition is used in `update_locked`.
+    if (bounds.center.x - bounds.extent.x <  node.bounds.center.x - node.bounds.extent.x ||
+        bounds.center.y - bounds.extent.y <  node.bounds.center.y - node.bounds.extent.y ||
+        bounds.center.z - bounds.extent.z <  node.bounds.center.z - node.bounds.extent.z ||
+        bounds.center.x + bounds.extent.x >= node.bounds.center.x + node.bounds.extent.x ||
+        bounds.center.y + bounds.extent.y >= node.bounds.center.y + node.bounds.extent.y ||
+        bounds.center.z + bounds.extent.z >= node.bounds.center.z + node.bounds.extent.z)
+    {
+        return node;
+    }
+
     uint32_t index = 0;
 
     if (bounds.center.x - bounds.extent.x >= node.bounds.center.x) {
@@ -0,0 +1,152 @@
+#include "render/acceleration_structure/query_views.h"
+
+#include <core/debug/assert.h>
+#include <core/math/scalar.h>
+
+#include <algorithm>
+
+namespace kw {
+
+// Distance from zero to the closest point of the range.
+static float get_distance(float min, float max) {
+    return std::max(std::max(min, -max), 0.f);
+}
+
+// Distance from zero to the farthest point of the range.
+static float get_max_distance(float min, float max) {
+    return std::max(-min, max);
+}
+
+QueryViews::QueryViews(const frustum* frustums, size_t frustum_count)
+    : m_frustums(frustums)
+    , m_frustum_count(frustum_count)
+    , m_near_plane(0.f)
+    , m_far_plane(0.f)
+{
+    KW_ASSERT(frustums != nullptr || frustum_count == 0);
+    KW_ASSERT(frustum_count <= 64, "At most 64 views are supported.");
+}
+
+QueryViews::QueryViews(const float3& origin, float near_plane, float far_plane)
+    : m_frustums(nullptr)
+    , m_frustum_count(6)
+    , m_origin(origin)
+    , m_near_plane(near_plane)
+    , m_far_plane(far_plane)
+{
+    KW_ASSERT(near_plane >= 0.f && near_plane < far_plane);
+}
+
+uint64_t QueryViews::get_mask() const {
+    return m_frustum_count < 64 ? (1ull << m_frustum_count) - 1 : ~0ull;
+}
+
+uint64_t QueryViews::intersect(const aabbox& bounds, uint64_t mask, uint64_t& inside_mask) const {
+    inside_mask = 0;
+
+    if (m_frustums == nullptr) {
+        return intersect_cubemap(bounds.center - bounds.extent, bounds.center + bounds.extent, mask, inside_mask);
+    }
+
+    uint64_t result = 0;
+
+    while (mask != 0) {
+        uint64_t bit = mask & (~mask + 1);
+        const frustum& frustum = m_frustums[log2(bit)];
+
+        if (kw::intersect(bounds, frustum)) {
+            result |= bit;
+
+            if (inside(bounds, frustum)) {
+                inside_mask |= bit;
+            }
+        }
+
+        mask &= mask - 1;
+    }
+
+    return result;
+}
+
+void QueryViews::intersect(const float* center_x, const float* center_y, const float* center_z,
+                           const float* extent_x, const float* extent_y, const float* extent_z,
+                           size_t count, uint64_t mask, uint64_t* masks) const
+{
+    KW_ASSERT(count <= 64);
+
+    if (m_frustums == nullptr) {
+        for (size_t i = 0; i < count; i++) {
+            float3 min(center_x[i] - extent_x[i], center_y[i] - extent_y[i], center_z[i] - extent_z[i]);
+            float3 max(center_x[i] + extent_x[i], center_y[i] + extent_y[i], center_z[i] + extent_z[i]);
+
+            uint64_t inside_mask;
+            masks[i] = intersect_cubemap(min, max, mask, inside_mask);
+        }
+
+        return;
+    }
+
+    std::fill(masks, masks + count, 0ull);
+
+    // Each view tests the whole batch at once, the result is transposed into per-box masks.
+    while (mask != 0) {
+        uint64_t bit = mask & (~mask + 1);
+
+        uint64_t intersect_mask;
+        kw::intersect(center_x, center_y, center_z, extent_x, extent_y, extent_z, count, m_frustums[log2(bit)], &intersect_mask);
+
+        while (intersect_mask != 0) {
+            masks[log2(intersect_mask & (~intersect_mask + 1))] |= bit;
+            intersect_mask &= intersect_mask - 1;
+        }
+
+        mask &= mask - 1;
+    }
+}
+
+uint64_t QueryViews::intersect_cubemap(const float3& min, const float3& max, uint64_t mask, uint64_t& inside_mask) const {
+    float3 relative_min = min - m_origin;
+    float3 relative_max = max - m_origin;
+
+    float distance_x = get_distance(relative_min.x, relative_max.x);
+    float distance_y = get_distance(relative_min.y, relative_max.y);
+    float distance_z = get_distance(relative_min.z, relative_max.z);
+
+    // The sphere around all faces. Most boxes are rejected here.
+    if (distance_x * distance_x + distance_y * distance_y + distance_z * distance_z > 3.f * m_far_plane * m_far_plane) {
+        inside_mask = 0;
+        return 0;
+    }
+
+    float max_distance_x = get_max_distance(relative_min.x, relative_max.x);
+    float max_distance_y = get_max_distance(relative_min.y, relative_max.y);
+    float max_distance_z = get_max_distance(relative_min.z, relative_max.z);
+
+    // Face +X contains points where `near <= x <= far`, `|y| <= x` and `|z| <= x`. The box intersects it when
+    // such `x` exists within the box, the rest of the faces are symmetric.
+    float face_min[6] = { relative_min.x, -relative_max.x, relative_min.y, -relative_max.y, relative_min.z, -relative_max.z };
+    float face_max[6] = { relative_max.x, -relative_min.x, relative_max.y, -relative_min.y, relative_max.z, -relative_min.z };
+    float side_distance[3] = { std::max(distance_y, distance_z), std::max(distance_x, distance_z), std::max(distance_x, distance_y) };
+    float side_max_distance[3] = { std::max(max_distance_y, max_distance_z), std::max(max_distance_x, max_distance_z), std::max(max_distance_x, max_distance_y) };
+
+    uint64_t result = 0;
+    inside_mask = 0;
+
+    for (uint32_t face = 0; face < 6; face++) {
+        uint64_t bit = 1ull << face;
+        if ((mask & bit) != 0) {
+            float farthest = std::min(face_max[face], m_far_plane);
+            if (farthest >= std::max(face_min[face], m_near_plane) && farthest >= side_distance[face / 2]) {
+                result |= bit;
+
+                if (face_min[face] >= m_near_plane && face_max[face] <= m_far_plane && face_min[face] >= side_max_distance[face / 2]) {
+                    inside_mask |= bit;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace kw
@@ -0,0 +1,808 @@
+#include "render/acceleration_structure/snapshot_acceleration_structure.h"
+#include "render/acceleration_structure/acceleration_structure_primitive.h"
+
+#include <core/concurrency/task.h>
+#include <core/debug/assert.h>
+#include <core/math/scalar.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+namespace kw {
+
+constexpr uint32_t SNAPSHOT_INTERNAL_NODE = UINT32_MAX;
+
+// The hierarchy is rebuilt by `commit` when the number of primitives added since the last build exceeds this number
+// and a quarter of the primitives in the hierarchy, or when the number of removed primitives exceeds this number and
+// a half of the primitives in the hierarchy.
+constexpr uint32_t SNAPSHOT_MIN_PENDING_COUNT = 64;
+
+// The hierarchy is rebuilt by `commit` when refits make the total surface area of its nodes grow this many times.
+constexpr float SNAPSHOT_DEGRADATION_FACTOR = 2.f;
+
+// `m_node` of a committed primitive stores its slot plus one, where slot is chunk index times 64 plus the index in
+// the chunk. `m_node` of a primitive added after the last commit stores its index in the additions log with this
+// bit set.
+constexpr uintptr_t SNAPSHOT_PENDING_BIT = static_cast<uintptr_t>(1) << (sizeof(uintptr_t) * 8 - 1);
+
+static bool is_pending(void* node) {
+    return (reinterpret_cast<uintptr_t>(node) & SNAPSHOT_PENDING_BIT) != 0;
+}
+
+static uint32_t get_index(void* node) {
+    KW_ASSERT(node != nullptr);
+    uintptr_t value = reinterpret_cast<uintptr_t>(node);
+    return static_cast<uint32_t>(is_pending(node) ? value & ~SNAPSHOT_PENDING_BIT : value - 1);
+}
+
+static void* make_node(uint32_t slot) {
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(slot) + 1);
+}
+
+static void* make_pending_node(uint32_t index) {
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(index) | SNAPSHOT_PENDING_BIT);
+}
+
+static void write_bounds(SnapshotChunk& chunk, uint32_t index, const aabbox& bounds) {
+    chunk.center_x[index] = bounds.center.x;
+    chunk.center_y[index] = bounds.center.y;
+    chunk.center_z[index] = bounds.center.z;
+    chunk.extent_x[index] = bounds.extent.x;
+    chunk.extent_y[index] = bounds.extent.y;
+    chunk.extent_z[index] = bounds.extent.z;
+}
+
+static aabbox read_bounds(const SnapshotChunk& chunk, uint32_t index) {
+    return aabbox(
+        float3(chunk.center_x[index], chunk.center_y[index], chunk.center_z[index]),
+        float3(chunk.extent_x[index], chunk.extent_y[index], chunk.extent_z[index])
+    );
+}
+
+static uint64_t get_chunk_mask(const SnapshotChunk& chunk) {
+    return chunk.count < 64 ? (static_cast<uint64_t>(1) << chunk.count) - 1 : UINT64_MAX;
+}
+
+static float get_area(const aabbox& bounds) {
+    return bounds.extent.x * bounds.extent.y + bounds.extent.y * bounds.extent.z + bounds.extent.z * bounds.extent.x;
+}
+
+// Same as `classify` in "bvh_acceleration_structure.cpp": 0 when the box is outside of the frustum, 1 when the box
+// intersects the frustum and 2 when the box is inside of the frustum.
+static uint32_t classify(const aabbox& box, const frustum& frustum) {
+    uint32_t result = 2;
+
+    for (const plane& plane : frustum.data) {
+        float distance = dot(box.center, plane.normal) + plane.distance;
+        float radius = dot(box.extent, abs(plane.normal));
+
+        if (distance < -radius) {
+            return 0;
+        }
+
+        if (distance < radius) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+// Write the primitives of the masked handles to `primitives`, skipping removed ones. Returns the number of written
+// primitives.
+static size_t resolve_handles(const SnapshotChunk& chunk, uint64_t mask, AccelerationStructurePrimitive** primitives) {
+    size_t count = 0;
+
+    while (mask != 0) {
+        AccelerationStructurePrimitive* primitive = chunk.handles[log2(mask & (~mask + 1))]->primitive.load(std::memory_order_acquire);
+        if (primitive != nullptr) {
+            primitives[count++] = primitive;
+        }
+
+        mask &= mask - 1;
+    }
+
+    return count;
+}
+
+static void collect_chunk(const SnapshotChunk& chunk, uint64_t mask, AccelerationStructure::QueryCallback callback, void* context) {
+    AccelerationStructurePrimitive* primitives[64];
+
+    size_t count = resolve_handles(chunk, mask, primitives);
+    if (count > 0) {
+        callback(context, primitives, count);
+    }
+}
+
+static void cull_chunk(const SnapshotChunk& chunk, const aabbox& bounds, AccelerationStructure::QueryCallback callback, void* context) {
+    uint64_t mask = 0;
+
+    for (uint32_t i = 0; i < chunk.count; i++) {
+        if (intersect(read_bounds(chunk, i), bounds)) {
+            mask |= static_cast<uint64_t>(1) << i;
+        }
+    }
+
+    collect_chunk(chunk, mask, callback, context);
+}
+
+static void cull_chunk(const SnapshotChunk& chunk, const frustum& frustum, AccelerationStructure::QueryCallback callback, void* context) {
+    uint64_t mask;
+    intersect(
+        chunk.center_x, chunk.center_y, chunk.center_z,
+        chunk.extent_x, chunk.extent_y, chunk.extent_z,
+        chunk.count, frustum, &mask
+    );
+
+    collect_chunk(chunk, mask, callback, context);
+}
+
+// Views in `mask` may intersect the chunk, views in `inside_mask` contain it entirely.
+static void cull_chunk(const SnapshotChunk& chunk, const QueryViews& views, uint64_t mask, uint64_t inside_mask,
+                       AccelerationStructure::MultiQueryCallback callback, void* context)
+{
+    uint64_t masks[64];
+
+    if (mask == inside_mask) {
+        std::fill(masks, masks + chunk.count, mask);
+    } else {
+        views.intersect(
+            chunk.center_x, chunk.center_y, chunk.center_z,
+            chunk.extent_x, chunk.extent_y, chunk.extent_z,
+            chunk.count, mask & ~inside_mask, masks
+        );
+    }
+
+    AccelerationStructurePrimitive* primitives[64];
+    size_t count = 0;
+
+    for (uint32_t i = 0; i < chunk.count; i++) {
+        uint64_t primitive_mask = masks[i] | inside_mask;
+        if (primitive_mask != 0) {
+            AccelerationStructurePrimitive* primitive = chunk.handles[i]->primitive.load(std::memory_order_acquire);
+            if (primitive != nullptr) {
+                primitives[count] = primitive;
+                masks[count] = primitive_mask;
+                count++;
+            }
+        }
+    }
+
+    if (count > 0) {
+        callback(context, primitives, masks, count);
+    }
+}
+
+struct SnapshotBuildItem {
+    float3 min;
+    float3 max;
+    float3 center;
+    const SharedPtr<SnapshotHandle>* handle;
+};
+
+AccelerationStructureSnapshot::AccelerationStructureSnapshot(MemoryResource& persistent_memory_resource)
+    : m_chunks(persistent_memory_resource)
+    , m_nodes(persistent_memory_resource)
+    , m_tree_chunk_count(0)
+    , m_center_x(persistent_memory_resource)
+    , m_center_y(persistent_memory_resource)
+    , m_center_z(persistent_memory_resource)
+    , m_extent_x(persistent_memory_resource)
+    , m_extent_y(persistent_memory_resource)
+    , m_extent_z(persistent_memory_resource)
+    , m_count(0)
+{
+}
+
+void AccelerationStructureSnapshot::query(const aabbox& bounds, AccelerationStructure::QueryCallback callback, void* context) const {
+    // Nodes are stored in depth-first order, so the traversal is a linear scan that skips rejected subtrees.
+    uint32_t node_index = 0;
+    while (node_index < m_nodes.size()) {
+        const SnapshotNode& node = m_nodes[node_index];
+
+        if (node.count == 0 || !intersect(node.bounds, bounds)) {
+            node_index = node.end;
+        } else if (node.chunk != SNAPSHOT_INTERNAL_NODE) {
+            cull_chunk(*m_chunks[node.chunk], bounds, callback, context);
+            node_index = node.end;
+        } else {
+            node_index++;
+        }
+    }
+
+    for (size_t chunk_index = m_tree_chunk_count; chunk_index < m_chunks.size(); chunk_index++) {
+        aabbox chunk_bounds(
+            float3(m_center_x[chunk_index], m_center_y[chunk_index], m_center_z[chunk_index]),
+            float3(m_extent_x[chunk_index], m_extent_y[chunk_index], m_extent_z[chunk_index])
+        );
+
+        if (intersect(chunk_bounds, bounds)) {
+            cull_chunk(*m_chunks[chunk_index], bounds, callback, context);
+        }
+    }
+}
+
+void AccelerationStructureSnapshot::query(const frustum& frustum, AccelerationStructure::QueryCallback callback, void* context) const {
+    uint32_t node_index = 0;
+    while (node_index < m_nodes.size()) {
+        const SnapshotNode& node = m_nodes[node_index];
+
+        uint32_t classification = node.count != 0 ? classify(node.bounds, frustum) : 0;
+
+        if (classification == 0) {
+            node_index = node.end;
+        } else if (classification == 2) {
+            // The whole subtree is inside the frustum, its chunks are collected without any tests.
+            for (uint32_t i = node_index; i < node.end; i++) {
+                if (m_nodes[i].chunk != SNAPSHOT_INTERNAL_NODE) {
+                    const SnapshotChunk& chunk = *m_chunks[m_nodes[i].chunk];
+                    collect_chunk(chunk, get_chunk_mask(chunk), callback, context);
+                }
+            }
+
+            node_index = node.end;
+        } else if (node.chunk != SNAPSHOT_INTERNAL_NODE) {
+            cull_chunk(*m_chunks[node.chunk], frustum, callback, context);
+            node_index = node.end;
+        } else {
+            node_index++;
+        }
+    }
+
+    for (size_t offset = m_tree_chunk_count; offset < m_chunks.size(); offset += 64) {
+        size_t batch_size = std::min(m_chunks.size() - offset, static_cast<size_t>(64));
+
+        uint64_t intersect_mask;
+        uint64_t inside_mask;
+        intersect(
+            m_center_x.data() + offset, m_center_y.data() + offset, m_center_z.data() + offset,
+            m_extent_x.data() + offset, m_extent_y.data() + offset, m_extent_z.data() + offset,
+            batch_size, frustum, &intersect_mask, &inside_mask
+        );
+
+        while (intersect_mask != 0) {
+            uint64_t bit = intersect_mask & (~intersect_mask + 1);
+            const SnapshotChunk& chunk = *m_chunks[offset + log2(bit)];
+
+            if ((inside_mask & bit) != 0) {
+                // The whole chunk is inside the frustum.
+                collect_chunk(chunk, get_chunk_mask(chunk), callback, context);
+            } else {
+                cull_chunk(chunk, frustum, callback, context);
+            }
+
+            intersect_mask &= intersect_mask - 1;
+        }
+    }
+}
+
+void AccelerationStructureSnapshot::query(const QueryViews& views, AccelerationStructure::MultiQueryCallback callback, void* context) const {
+    if (!m_nodes.empty() && m_nodes[0].count > 0) {
+        uint64_t inside_mask;
+        uint64_t mask = views.intersect(m_nodes[0].bounds, views.get_mask(), inside_mask);
+
+        if (mask != 0) {
+            query(0, views, mask, inside_mask, callback, context);
+        }
+    }
+
+    for (size_t chunk_index = m_tree_chunk_count; chunk_index < m_chunks.size(); chunk_index++) {
+        aabbox chunk_bounds(
+            float3(m_center_x[chunk_index], m_center_y[chunk_index], m_center_z[chunk_index]),
+            float3(m_extent_x[chunk_index], m_extent_y[chunk_index], m_extent_z[chunk_index])
+        );
+
+        uint64_t inside_mask;
+        uint64_t mask = views.intersect(chunk_bounds, views.get_mask(), inside_mask);
+
+        if (mask != 0) {
+            cull_chunk(*m_chunks[chunk_index], views, mask, inside_mask, callback, context);
+        }
+    }
+}
+
+Vector<AccelerationStructurePrimitive*> AccelerationStructureSnapshot::query(MemoryResource& memory_resource, const aabbox& bounds) const {
+    Vector<AccelerationStructurePrimitive*> result(memory_resource);
+    result.reserve(64);
+
+    query(bounds, [](void* context, AccelerationStructurePrimitive* const* primitives, size_t count) {
+        Vector<AccelerationStructurePrimitive*>& result = *static_cast<Vector<AccelerationStructurePrimitive*>*>(context);
+        result.insert(result.end(), primitives, primitives + count);
+    }, &result);
+
+    return result;
+}
+
+Vector<AccelerationStructurePrimitive*> AccelerationStructureSnapshot::query(MemoryResource& memory_resource, const frustum& frustum) const {
+    Vector<AccelerationStructurePrimitive*> result(memory_resource);
+    result.reserve(64);
+
+    query(frustum, [](void* context, AccelerationStructurePrimitive* const* primitives, size_t count) {
+        Vector<AccelerationStructurePrimitive*>& result = *static_cast<Vector<AccelerationStructurePrimitive*>*>(context);
+        result.insert(result.end(), primitives, primitives + count);
+    }, &result);
+
+    return result;
+}
+
+size_t AccelerationStructureSnapshot::get_count() const {
+    return m_count;
+}
+
+void AccelerationStructureSnapshot::query(uint32_t node_index, const QueryViews& views, uint64_t mask, uint64_t inside_mask,
+                                          AccelerationStructure::MultiQueryCallback callback, void* context) const
+{
+    const SnapshotNode& node = m_nodes[node_index];
+
+    if (node.chunk != SNAPSHOT_INTERNAL_NODE) {
+        cull_chunk(*m_chunks[node.chunk], views, mask, inside_mask, callback, context);
+    } else {
+        uint32_t children[2] = { node_index + 1, m_nodes[node_index + 1].end };
+
+        for (uint32_t child_index : children) {
+            const SnapshotNode& child = m_nodes[child_index];
+
+            if (child.count > 0) {
+                // Views that contain this node contain its children too.
+                uint64_t child_inside_mask;
+                uint64_t child_mask = views.intersect(child.bounds, mask & ~inside_mask, child_inside_mask) | inside_mask;
+
+                if (child_mask != 0) {
+                    query(child_index, views, child_mask, child_inside_mask | inside_mask, callback, context);
+                }
+            }
+        }
+    }
+}
+
+SnapshotAccelerationStructure::SnapshotAccelerationStructure(MemoryResource& persistent_memory_resource)
+    : m_memory_resource(persistent_memory_resource)
+    , m_snapshot(allocate_shared<AccelerationStructureSnapshot>(persistent_memory_resource, persistent_memory_resource))
+    , m_additions(persistent_memory_resource)
+    , m_modifications(persistent_memory_resource)
+    , m_removals(persistent_memory_resource)
+    , m_build_count(0)
+    , m_build_area(0.f)
+{
+}
+
+void SnapshotAccelerationStructure::add(AccelerationStructurePrimitive& primitive) {
+    std::lock_guard lock_guard(m_mutex);
+
+    KW_ASSERT(primitive.m_acceleration_structure == nullptr);
+    primitive.m_acceleration_structure = this;
+
+    KW_ASSERT(primitive.m_node == nullptr);
+    primitive.m_node = make_pending_node(static_cast<uint32_t>(m_additions.size()));
+
+    m_additions.push_back(Addition{ &primitive, primitive.get_bounds() });
+}
+
+void SnapshotAccelerationStructure::remove(AccelerationStructurePrimitive& primitive) {
+    std::lock_guard lock_guard(m_mutex);
+
+    KW_ASSERT(primitive.m_acceleration_structure == static_cast<AccelerationStructure*>(this));
+    primitive.m_acceleration_structure = nullptr;
+
+    if (is_pending(primitive.m_node)) {
+        // The primitive was never committed, just cancel the addition.
+        uint32_t index = get_index(primitive.m_node);
+        KW_ASSERT(index < m_additions.size() && m_additions[index].primitive == &primitive);
+
+        m_additions[index].primitive = nullptr;
+    } else {
+        // `m_snapshot` is only replaced by `commit`, which holds the same lock.
+        const AccelerationStructureSnapshot& snapshot = *m_snapshot;
+
+        uint32_t slot = get_index(primitive.m_node);
+        KW_ASSERT(slot / 64 < snapshot.m_chunks.size() && slot % 64 < snapshot.m_chunks[slot / 64]->count);
+
+        SnapshotHandle& handle = *snapshot.m_chunks[slot / 64]->handles[slot % 64];
+        KW_ASSERT(handle.primitive.load(std::memory_order_relaxed) == &primitive);
+
+        // Committed chunks are shared with running queries and pinned snapshots, which skip cleared handles.
+        // The slot itself is freed on commit.
+        handle.primitive.store(nullptr, std::memory_order_release);
+
+        m_removals.push_back(slot);
+    }
+
+    primitive.m_node = nullptr;
+}
+
+void SnapshotAccelerationStructure::update(AccelerationStructurePrimitive& primitive) {
+    AccelerationStructurePrimitive* primitives = &primitive;
+    update(&primitives, 1);
+}
+
+void SnapshotAccelerationStructure::update(AccelerationStructurePrimitive* const* primitives, size_t count) {
+    KW_ASSERT(primitives != nullptr || count == 0);
+
+    std::lock_guard lock_guard(m_mutex);
+
+    for (size_t i = 0; i < count; i++) {
+        AccelerationStructurePrimitive& primitive = *primitives[i];
+        KW_ASSERT(primitive.m_acceleration_structure == static_cast<AccelerationStructure*>(this));
+
+        uint32_t index = get_index(primitive.m_node);
+
+        if (is_pending(primitive.m_node)) {
+            KW_ASSERT(index < m_additions.size() && m_additions[index].primitive == &primitive);
+            m_additions[index].bounds = primitive.get_bounds();
+        } else {
+            m_modifications.push_back(Modification{ index, primitive.get_bounds() });
+        }
+    }
+}
+
+void SnapshotAccelerationStructure::query(const aabbox& bounds, QueryCallback callback, void* context) const {
+    std::atomic_load(&m_snapshot)->query(bounds, callback, context);
+}
+
+void SnapshotAccelerationStructure::query(const frustum& frustum, QueryCallback callback, void* context) const {
+    std::atomic_load(&m_snapshot)->query(frustum, callback, context);
+}
+
+void SnapshotAccelerationStructure::query(const QueryViews& views, MultiQueryCallback callback, void* context) const {
+    std::atomic_load(&m_snapshot)->query(views, callback, context);
+}
+
+size_t SnapshotAccelerationStructure::get_count() const {
+    return std::atomic_load(&m_snapshot)->get_count();
+}
+
+class SnapshotAccelerationStructure::CommitTask : public Task {
+public:
+    explicit CommitTask(SnapshotAccelerationStructure& acceleration_structure)
+        : m_acceleration_structure(acceleration_structure)
+    {
+    }
+
+    void run() override {
+        m_acceleration_structure.commit();
+    }
+
+    const char* get_name() const override {
+        return "Snapshot Acceleration Structure Commit";
+    }
+
+private:
+    SnapshotAccelerationStructure& m_acceleration_structure;
+};
+
+Task* SnapshotAccelerationStructure::create_task(MemoryResource& transient_memory_resource) {
+    return transient_memory_resource.construct<CommitTask>(*this);
+}
+
+SharedPtr<const AccelerationStructureSnapshot> SnapshotAccelerationStructure::get_snapshot() const {
+    return std::atomic_load(&m_snapshot);
+}
+
+void SnapshotAccelerationStructure::commit() {
+    std::lock_guard lock_guard(m_mutex);
+
+    if (m_additions.empty() && m_modifications.empty() && m_removals.empty()) {
+        return;
+    }
+
+    // Chunk pointers, chunk bounds and nodes are copied, chunks themselves are copied only when they're modified.
+    SharedPtr<AccelerationStructureSnapshot> snapshot = allocate_shared<AccelerationStructureSnapshot>(m_memory_resource, *m_snapshot);
+
+    Vector<SharedPtr<SnapshotChunk>> modified_chunks(snapshot->m_chunks.size(), m_memory_resource);
+
+    auto get_chunk = [&](size_t chunk_index) -> SnapshotChunk& {
+        if (!modified_chunks[chunk_index]) {
+            modified_chunks[chunk_index] = allocate_shared<SnapshotChunk>(m_memory_resource, *snapshot->m_chunks[chunk_index]);
+            snapshot->m_chunks[chunk_index] = modified_chunks[chunk_index];
+        }
+
+        return *modified_chunks[chunk_index];
+    };
+
+    // Modifications must be applied first, because their slots are valid only until removed slots are compacted.
+    for (const Modification& modification : m_modifications) {
+        KW_ASSERT(modification.slot / 64 < snapshot->m_chunks.size());
+        write_bounds(get_chunk(modification.slot / 64), modification.slot % 64, modification.bounds);
+    }
+
+    size_t count = snapshot->m_count - m_removals.size();
+
+    if (!m_removals.empty()) {
+        for (uint32_t slot : m_removals) {
+            get_chunk(slot / 64).handles[slot % 64] = nullptr;
+        }
+
+        // Compact the chunks with removed primitives. Primitives never leave their chunk, so the hierarchy stays valid.
+        for (size_t chunk_index = 0; chunk_index < modified_chunks.size(); chunk_index++) {
+            if (modified_chunks[chunk_index]) {
+                SnapshotChunk& chunk = *modified_chunks[chunk_index];
+                uint32_t chunk_count = 0;
+
+                for (uint32_t i = 0; i < chunk.count; i++) {
+                    if (chunk.handles[i]) {
+                        if (chunk_count != i) {
+                            chunk.handles[chunk_count] = std::move(chunk.handles[i]);
+                            write_bounds(chunk, chunk_count, read_bounds(chunk, i));
+
+                            AccelerationStructurePrimitive* primitive = chunk.handles[chunk_count]->primitive.load(std::memory_order_relaxed);
+                            primitive->m_node = make_node(static_cast<uint32_t>(chunk_index * 64 + chunk_count));
+                        }
+
+                        chunk_count++;
+                    }
+                }
+
+                chunk.count = chunk_count;
+            }
+        }
+    }
+
+    // Added primitives are appended to the chunks after the hierarchy's chunks, which are tested linearly until
+    // the next build.
+    for (const Addition& addition : m_additions) {
+        if (addition.primitive != nullptr) {
+            if (snapshot->m_chunks.size() == snapshot->m_tree_chunk_count || snapshot->m_chunks.back()->count == 64) {
+                modified_chunks.push_back(allocate_shared<SnapshotChunk>(m_memory_resource));
+                snapshot->m_chunks.push_back(modified_chunks.back());
+            }
+
+            size_t chunk_index = snapshot->m_chunks.size() - 1;
+            SnapshotChunk& chunk = get_chunk(chunk_index);
+
+            uint32_t index = chunk.count++;
+
+            chunk.handles[index] = allocate_shared<SnapshotHandle>(m_memory_resource);
+            chunk.handles[index]->primitive.store(addition.primitive, std::memory_order_relaxed);
+            write_bounds(chunk, index, addition.bounds);
+
+            addition.primitive->m_node = make_node(static_cast<uint32_t>(chunk_index * 64 + index));
+            count++;
+        }
+    }
+
+    size_t chunk_count = snapshot->m_chunks.size();
+
+    snapshot->m_center_x.resize(chunk_count);
+    snapshot->m_center_y.resize(chunk_count);
+    snapshot->m_center_z.resize(chunk_count);
+    snapshot->m_extent_x.resize(chunk_count);
+    snapshot->m_extent_y.resize(chunk_count);
+    snapshot->m_extent_z.resize(chunk_count);
+    snapshot->m_count = count;
+
+    // Only modified chunks can change their bounds.
+    bool is_tree_modified = false;
+
+    for (size_t chunk_index = 0; chunk_index < chunk_count; chunk_index++) {
+        if (modified_chunks[chunk_index]) {
+            const SnapshotChunk& chunk = *modified_chunks[chunk_index];
+
+            aabbox chunk_bounds;
+
+            if (chunk.count > 0) {
+                float3 bounds_min(FLT_MAX);
+                float3 bounds_max(-FLT_MAX);
+
+                for (uint32_t i = 0; i < chunk.count; i++) {
+                    aabbox bounds = read_bounds(chunk, i);
+                    bounds_min = min(bounds_min, bounds.center - bounds.extent);
+                    bounds_max = max(bounds_max, bounds.center + bounds.extent);
+                }
+
+                chunk_bounds = aabbox::from_min_max(bounds_min, bounds_max);
+            }
+
+            snapshot->m_center_x[chunk_index] = chunk_bounds.center.x;
+            snapshot->m_center_y[chunk_index] = chunk_bounds.center.y;
+            snapshot->m_center_z[chunk_index] = chunk_bounds.center.z;
+            snapshot->m_extent_x[chunk_index] = chunk_bounds.extent.x;
+            snapshot->m_extent_y[chunk_index] = chunk_bounds.extent.y;
+            snapshot->m_extent_z[chunk_index] = chunk_bounds.extent.z;
+
+            if (chunk_index < snapshot->m_tree_chunk_count) {
+                is_tree_modified = true;
+            }
+        }
+    }
+
+    float area = 0.f;
+
+    if (is_tree_modified) {
+        // Children follow their parents, so refitting in reverse order computes exact bounds, which also shrink.
+        for (size_t node_index = snapshot->m_nodes.size(); node_index-- > 0;) {
+            SnapshotNode& node = snapshot->m_nodes[node_index];
+
+            if (node.chunk != SNAPSHOT_INTERNAL_NODE) {
+                node.bounds = aabbox(
+                    float3(snapshot->m_center_x[node.chunk], snapshot->m_center_y[node.chunk], snapshot->m_center_z[node.chunk]),
+                    float3(snapshot->m_extent_x[node.chunk], snapshot->m_extent_y[node.chunk], snapshot->m_extent_z[node.chunk])
+                );
+                node.count = snapshot->m_chunks[node.chunk]->count;
+            } else {
+                const SnapshotNode& left = snapshot->m_nodes[node_index + 1];
+                const SnapshotNode& right = snapshot->m_nodes[left.end];
+
+                if (left.count == 0) {
+                    node.bounds = right.bounds;
+                } else if (right.count == 0) {
+                    node.bounds = left.bounds;
+                } else {
+                    node.bounds = left.bounds + right.bounds;
+                }
+
+                node.count = left.count + right.count;
+            }
+
+            area += get_area(node.bounds);
+        }
+    }
+
+    uint32_t tree_count = snapshot->m_nodes.empty() ? 0 : snapshot->m_nodes[0].count;
+    uint32_t pending_count = static_cast<uint32_t>(count) - tree_count;
+    uint32_t removed_count = m_build_count - tree_count;
+
+    // Rebuilding when the number of pending primitives grows proportionally to the hierarchy size makes `add`
+    // O(logN) amortized and keeps the linearly tested chunks few.
+    if (pending_count > std::max(SNAPSHOT_MIN_PENDING_COUNT, m_build_count / 4) ||
+        removed_count > std::max(SNAPSHOT_MIN_PENDING_COUNT, m_build_count / 2) ||
+        area > m_build_area * SNAPSHOT_DEGRADATION_FACTOR)
+    {
+        rebuild(*snapshot);
+    }
+
+    std::atomic_store(&m_snapshot, SharedPtr<const AccelerationStructureSnapshot>(std::move(snapshot)));
+
+    m_additions.clear();
+    m_modifications.clear();
+    m_removals.clear();
+}
+
+void SnapshotAccelerationStructure::rebuild(AccelerationStructureSnapshot& snapshot) {
+    // Chunks are kept alive until the build is done, because build items reference their handles.
+    Vector<SharedPtr<const SnapshotChunk>> chunks(std::move(snapshot.m_chunks), m_memory_resource);
+
+    Vector<SnapshotBuildItem> items(m_memory_resource);
+    items.reserve(snapshot.m_count);
+
+    for (const SharedPtr<const SnapshotChunk>& chunk : chunks) {
+        for (uint32_t i = 0; i < chunk->count; i++) {
+            aabbox bounds = read_bounds(*chunk, i);
+            items.push_back(SnapshotBuildItem{ bounds.center - bounds.extent, bounds.center + bounds.extent, bounds.center, &chunk->handles[i] });
+        }
+    }
+
+    KW_ASSERT(items.size() == snapshot.m_count);
+
+    snapshot.m_chunks.clear();
+    snapshot.m_nodes.clear();
+    snapshot.m_center_x.clear();
+    snapshot.m_center_y.clear();
+    snapshot.m_center_z.clear();
+    snapshot.m_extent_x.clear();
+    snapshot.m_extent_y.clear();
+    snapshot.m_extent_z.clear();
+
+    if (!items.empty()) {
+        build(snapshot, items.data(), static_cast<uint32_t>(items.size()));
+    }
+
+    snapshot.m_tree_chunk_count = snapshot.m_chunks.size();
+
+    m_build_count = static_cast<uint32_t>(items.size());
+    m_build_area = 0.f;
+
+    for (const SnapshotNode& node : snapshot.m_nodes) {
+        m_build_area += get_area(node.bounds);
+    }
+}
+
+void SnapshotAccelerationStructure::build(AccelerationStructureSnapshot& snapshot, SnapshotBuildItem* items, uint32_t count) {
+    KW_ASSERT(count > 0);
+
+    float3 bounds_min(FLT_MAX);
+    float3 bounds_max(-FLT_MAX);
+    float3 centroid_min(FLT_MAX);
+    float3 centroid_max(-FLT_MAX);
+
+    for (uint32_t i = 0; i < count; i++) {
+        bounds_min = min(bounds_min, items[i].min);
+        bounds_max = max(bounds_max, items[i].max);
+        centroid_min = min(centroid_min, items[i].center);
+        centroid_max = max(centroid_max, items[i].center);
+    }
+
+    uint32_t node_index = static_cast<uint32_t>(snapshot.m_nodes.size());
+    snapshot.m_nodes.push_back(SnapshotNode{ aabbox::from_min_max(bounds_min, bounds_max), SNAPSHOT_INTERNAL_NODE, node_index + 1, count });
+
+    if (count <= 64) {
+        uint32_t chunk_index = static_cast<uint32_t>(snapshot.m_chunks.size());
+
+        SharedPtr<SnapshotChunk> chunk = allocate_shared<SnapshotChunk>(m_memory_resource);
+        chunk->count = count;
+
+        for (uint32_t i = 0; i < count; i++) {
+            chunk->handles[i] = *items[i].handle;
+            write_bounds(*chunk, i, aabbox::from_min_max(items[i].min, items[i].max));
+
+            AccelerationStructurePrimitive* primitive = chunk->handles[i]->primitive.load(std::memory_order_relaxed);
+            primitive->m_node = make_node(chunk_index * 64 + i);
+        }
+
+        const aabbox& chunk_bounds = snapshot.m_nodes[node_index].bounds;
+
+        snapshot.m_center_x.push_back(chunk_bounds.center.x);
+        snapshot.m_center_y.push_back(chunk_bounds.center.y);
+        snapshot.m_center_z.push_back(chunk_bounds.center.z);
+        snapshot.m_extent_x.push_back(chunk_bounds.extent.x);
+        snapshot.m_extent_y.push_back(chunk_bounds.extent.y);
+        snapshot.m_extent_z.push_back(chunk_bounds.extent.z);
+
+        snapshot.m_chunks.push_back(std::move(chunk));
+        snapshot.m_nodes[node_index].chunk = chunk_index;
+
+        return;
+    }
+
+    float3 centroid_size = centroid_max - centroid_min;
+
+    uint32_t axis = 0;
+    if (centroid_size.y > centroid_size[axis]) {
+        axis = 1;
+    }
+    if (centroid_size.z > centroid_size[axis]) {
+        axis = 2;
+    }
+
+    // Split by the median along the longest axis, rounded to whole chunks so all chunks but the last one are full.
+    uint32_t split = (count + 63) / 64 / 2 * 64;
+
+    std::nth_element(items, items + split, items + count, [&](const SnapshotBuildItem& lhs, const SnapshotBuildItem& rhs) {
+        return lhs.center[axis] < rhs.center[axis];
+    });
+
+    build(snapshot, items, split);
+    build(snapshot, items + split, count - split);
+
+    snapshot.m_nodes[node_index].end = static_cast<uint32_t>(snapshot.m_nodes.size());
+}
+
+PinnedSnapshotAccelerationStructure::PinnedSnapshotAccelerationStructure(SharedPtr<const AccelerationStructureSnapshot> snapshot)
+    : m_snapshot(std::move(snapshot))
+{
+    KW_ASSERT(m_snapshot);
+}
+
+void PinnedSnapshotAccelerationStructure::add(AccelerationStructurePrimitive& primitive) {
+    KW_ASSERT(false, "Pinned snapshots are read-only.");
+}
+
+void PinnedSnapshotAccelerationStructure::remove(AccelerationStructurePrimitive& primitive) {
+    KW_ASSERT(false, "Pinned snapshots are read-only.");
+}
+
+void PinnedSnapshotAccelerationStructure::update(AccelerationStructurePrimitive& primitive) {
+    KW_ASSERT(false, "Pinned snapshots are read-only.");
+}
+
+void PinnedSnapshotAccelerationStructure::update(AccelerationStructurePrimitive* const* primitives, size_t count) {
+    KW_ASSERT(false, "Pinned snapshots are read-only.");
+}
+
+void PinnedSnapshotAccelerationStructure::query(const aabbox& bounds, QueryCallback callback, void* context) const {
+    m_snapshot->query(bounds, callback, context);
+}
+
+void PinnedSnapshotAccelerationStructure::query(const frustum& frustum, QueryCallback callback, void* context) const {
+    m_snapshot->query(frustum, callback, context);
+}
+
+void PinnedSnapshotAccelerationStructure::query(const QueryViews& views, MultiQueryCallback callback, void* context) const {
+    m_snapshot->query(views, callback, context);
+}
+
+size_t PinnedSnapshotAccelerationStructure::get_count() const {
+    return m_snapshot->get_count();
+}
+
+} // namespace kw
@@ -49,19 +49,22 @@ AnimatedGeometryPrimitive::AnimatedGeometryPrimitive(MemoryResource& memory_reso
     : GeometryPrimitive(geometry, material, shadow_material, local_transform)
     , m_animation_player(nullptr)
     , m_skeleton_pose(memory_resource)
-    , m_animation(std::move(animation))
-    , m_animation_time(0.f)
-    , m_animation_speed(1.f)
+    , m_animation_blend_tree(memory_resource)
+    , m_skipped_time(0.f)
+    , m_is_visible(false)
 {
+    if (animation) {
+        m_animation_blend_tree.add_clip(0, std::move(animation));
+    }
 }
 
 AnimatedGeometryPrimitive::AnimatedGeometryPrimitive(const AnimatedGeometryPrimitive& other)
     : GeometryPrimitive(other)
     , m_animation_player(nullptr)
     , m_skeleton_pose(other.m_skeleton_pose)
-    , m_animation(other.m_animation)
-    , m_animation_time(other.m_animation_time)
-    , m_animation_speed(other.m_animation_speed)
+    , m_animation_blend_tree(other.m_animation_blend_tree)
+    , m_skipped_time(0.f)
+    , m_is_visible(false)
 {
     KW_ASSERT(
         other.m_animation_player == nullptr,
@@ -73,9 +76,9 @@ AnimatedGeometryPrimitive::AnimatedGeometryPrimitive(AnimatedGeometryPrimitive&&
     : GeometryPrimitive(std::move(other))
     , m_animation_player(nullptr)
     , m_skeleton_pose(std::move(other.m_skeleton_pose))
-    , m_animation(std::move(other.m_animation))
-    , m_animation_time(other.m_animation_time)
-    , m_animation_speed(other.m_animation_speed)
+    , m_animation_blend_tree(std::move(other.m_animation_blend_tree))
+    , m_skipped_time(0.f)
+    , m_is_visible(false)
 {
     KW_ASSERT(
         other.m_animation_player == nullptr,
@@ -97,9 +100,7 @@ AnimatedGeometryPrimitive& AnimatedGeometryPrimitive::operator=(const AnimatedGe
     }
 
     m_skeleton_pose = other.m_skeleton_pose;
-    m_animation = other.m_animation;
-    m_animation_time = other.m_animation_time;
-    m_animation_speed = other.m_animation_speed;
+    m_animation_blend_tree = other.m_animation_blend_tree;
 
     KW_ASSERT(
         other.m_animation_player == nullptr,
@@ -117,9 +118,7 @@ AnimatedGeometryPrimitive& AnimatedGeometryPrimitive::operator=(AnimatedGeometry
     }
 
     m_skeleton_pose = std::move(other.m_skeleton_pose);
-    m_animation = std::move(other.m_animation);
-    m_animation_time = other.m_animation_time;
-    m_animation_speed = other.m_animation_speed;
+    m_animation_blend_tree = std::move(other.m_animation_blend_tree);
 
     KW_ASSERT(
         other.m_animation_player == nullptr,
@@ -143,32 +142,42 @@ SkeletonPose& AnimatedGeometryPrimitive::get_skeleton_pose() {
     return m_skeleton_pose;
 }
 
-const SharedPtr<Animation>& AnimatedGeometryPrimitive::get_animation() const {
-    return m_animation;
+const AnimationBlendTree& AnimatedGeometryPrimitive::get_animation_blend_tree() const {
+    return m_animation_blend_tree;
 }
 
-void AnimatedGeometryPrimitive::set_animation(SharedPtr<Animation> animation) {
-    m_animation = std::move(animation);
+AnimationBlendTree& AnimatedGeometryPrimitive::get_animation_blend_tree() {
+    return m_animation_blend_tree;
 }
 
-Vector<float4x4> AnimatedGeometryPrimitive::get_model_space_joint_matrices(MemoryResource& memory_resource) {
-    return Vector<float4x4>(m_skeleton_pose.get_model_space_matrices(), memory_resource);
-}
+const SharedPtr<Animation>& AnimatedGeometryPrimitive::get_animation() const {
+    static const SharedPtr<Animation> EMPTY_ANIMATION;
 
-float AnimatedGeometryPrimitive::get_animation_time() const {
-    return m_animation_time;
+    if (m_animation_blend_tree.get_clip_count(0) > 0) {
+        return m_animation_blend_tree.get_clip_animation(0, 0);
+    }
+    return EMPTY_ANIMATION;
 }
 
-void AnimatedGeometryPrimitive::set_animation_time(float value) {
-    m_animation_time = value;
-}
+void AnimatedGeometryPrimitive::set_animation(SharedPtr<Animation> animation) {
+    float time = 0.f;
+    float speed = 1.f;
+
+    if (m_animation_blend_tree.get_clip_count(0) > 0) {
+        time = m_animation_blend_tree.get_clip_time(0, 0);
+        speed = m_animation_blend_tree.get_clip_speed(0, 0);
+    }
 
-float AnimatedGeometryPrimitive::get_animation_speed() const {
-    return m_animation_speed;
+    m_animation_blend_tree.clear_clips(0);
+
+    if (animation) {
+        uint32_t clip_index = m_animation_blend_tree.add_clip(0, std::move(animation), 1.f, speed);
+        m_animation_blend_tree.set_clip_time(0, clip_index, time);
+    }
 }
 
-void AnimatedGeometryPrimitive::set_animation_speed(float value) {
-    m_animation_speed = value;
+Vector<float4x4> AnimatedGeometryPrimitive::get_model_space_joint_matrices(MemoryResource& memory_resource) {
+    return Vector<float4x4>(m_skeleton_pose.get_model_space_matrices(), memory_resource);
 }
 
 UniquePtr<Primitive> AnimatedGeometryPrimitive::clone(MemoryResource& memory_resource) const {
@@ -180,9 +189,7 @@ void AnimatedGeometryPrimitive::geometry_loaded() {
 
     const Skeleton* skeleton = get_geometry()->get_skeleton();
     if (skeleton != nullptr) {
-        for (uint32_t i = 0; i < skeleton->get_joint_count(); i++) {
-            m_skeleton_pose.set_joint_space_matrix(i, skeleton->get_bind_matrix(i));
-        }
+        m_skeleton_pose.set_bind_pose(*skeleton);
         m_skeleton_pose.build_model_space_matrices(*skeleton);
     }
 
@@ -1,7 +1,10 @@
 #include "render/animation/animation.h"
+#include "render/animation/animation_cursor.h"
+#include "render/geometry/skeleton_pose.h"
 
 #include <core/debug/assert.h>
 #include <core/math/float4x4.h>
+#include <core/math/simd.h>
 #include <core/math/transform.h>
 #include <core/memory/malloc_memory_resource.h>
 
@@ -20,12 +23,22 @@ static bool operator<(const Animation::JointKeyframe& lhs, float rhs) {
 Animation::Animation()
     : m_duration(NAN)
     , m_joint_animations(MallocMemoryResource::instance())
+    , m_compressed_tracks(MallocMemoryResource::instance())
+    , m_compressed_track_offsets(MallocMemoryResource::instance())
+    , m_compressed_keyframes(MallocMemoryResource::instance())
+    , m_compressed_raw_offsets(MallocMemoryResource::instance())
+    , m_compressed_raw_values(MallocMemoryResource::instance())
 {
 }
 
 Animation::Animation(Vector<JointAnimation>&& joint_animations)
     : m_duration(NAN)
     , m_joint_animations(std::move(joint_animations))
+    , m_compressed_tracks(MallocMemoryResource::instance())
+    , m_compressed_track_offsets(MallocMemoryResource::instance())
+    , m_compressed_keyframes(MallocMemoryResource::instance())
+    , m_compressed_raw_offsets(MallocMemoryResource::instance())
+    , m_compressed_raw_values(MallocMemoryResource::instance())
 {
     float duration = 0.f;
     for (JointAnimation& joint_animation : m_joint_animations) {
@@ -35,37 +48,464 @@ Animation::Animation(Vector<JointAnimation>&& joint_animations)
     m_duration = duration;
 }
 
+Animation::Animation(float duration, Vector<CompressedTrack>&& compressed_tracks, Vector<uint16_t>&& compressed_keyframes,
+                     Vector<float>&& compressed_raw_values)
+    : m_duration(NAN)
+    , m_joint_animations(MallocMemoryResource::instance())
+    , m_compressed_tracks(std::move(compressed_tracks))
+    , m_compressed_track_offsets(*m_compressed_tracks.get_allocator().memory_resource)
+    , m_compressed_keyframes(std::move(compressed_keyframes))
+    , m_compressed_raw_offsets(*m_compressed_tracks.get_allocator().memory_resource)
+    , m_compressed_raw_values(std::move(compressed_raw_values))
+{
+    KW_ASSERT(duration >= 0.f, "Invalid animation duration.");
+    KW_ASSERT(m_compressed_tracks.size() % COMPRESSED_TRACK_COUNT == 0, "Invalid compressed track count.");
+
+    m_compressed_track_offsets.reserve(m_compressed_tracks.size());
+    m_compressed_raw_offsets.reserve(m_compressed_tracks.size());
+
+    // Offsets allow to access keyframes of any track in constant time.
+    uint32_t offset = 0;
+    uint32_t raw_offset = 0;
+    for (const CompressedTrack& compressed_track : m_compressed_tracks) {
+        m_compressed_track_offsets.push_back(offset);
+        offset += compressed_track.keyframe_count * 4;
+
+        m_compressed_raw_offsets.push_back(raw_offset);
+        if (compressed_track.is_raw) {
+            raw_offset += compressed_track.keyframe_count * 4;
+        }
+    }
+
+    KW_ASSERT(offset == m_compressed_keyframes.size(), "Mismatching compressed keyframe count.");
+    KW_ASSERT(raw_offset == m_compressed_raw_values.size(), "Mismatching compressed raw value count.");
+
+    m_duration = duration;
+}
+
+// Return the index of the first keyframe not less than the timestamp, given that it's not less than `index`. When time
+// moves forward, the keyframe is usually the same or the next one, so a few keyframes are checked linearly first.
+static uint32_t find_keyframe(const Vector<Animation::JointKeyframe>& keyframes, uint32_t index, float timestamp) {
+    uint32_t keyframe_count = static_cast<uint32_t>(keyframes.size());
+
+    for (uint32_t step = 0; step < 4; step++) {
+        if (index == keyframe_count || !(keyframes[index].timestamp < timestamp)) {
+            return index;
+        }
+        index++;
+    }
+
+    return static_cast<uint32_t>(std::lower_bound(keyframes.begin() + index, keyframes.end(), timestamp) - keyframes.begin());
+}
+
+// Find the keyframes to interpolate between given the index returned from `find_keyframe`.
+static void get_keyframes(const Vector<Animation::JointKeyframe>& keyframes, uint32_t index, float timestamp,
+                          const Animation::JointKeyframe*& from, const Animation::JointKeyframe*& to, float& factor) {
+    if (index < keyframes.size()) {
+        if (index > 0) {
+            const Animation::JointKeyframe& prev = keyframes[index - 1];
+            const Animation::JointKeyframe& next = keyframes[index];
+
+            from = &prev;
+            to = &next;
+            factor = (timestamp - prev.timestamp) / (next.timestamp - prev.timestamp);
+        } else {
+            const Animation::JointKeyframe& next = keyframes.front();
+
+            from = &keyframes.back();
+            to = &next;
+            factor = next.timestamp > EPSILON ? timestamp / next.timestamp : 1.f;
+        }
+    } else {
+        from = &keyframes.back();
+        to = &keyframes.back();
+        factor = 0.f;
+    }
+}
+
+// Timestamps of compressed keyframes are relative to animation duration.
+static constexpr float QUANTIZED_TIMESTAMP_MAX = 65535.f;
+
+// Translation and scale components are relative to track range.
+static constexpr float QUANTIZED_VALUE_MAX = 65535.f;
+
+// The smallest three quaternion components are in range [-1/sqrt(2), 1/sqrt(2)] and take 15 bits each.
+static constexpr float QUANTIZED_ROTATION_MAX = 32767.f;
+static constexpr float ROTATION_COMPONENT_MAX = 0.70710678f;
+
+// Same as `find_keyframe` for compressed keyframes, which are stored in groups of four starting with timestamp.
+static uint32_t find_compressed_keyframe(const uint16_t* keyframes, uint32_t keyframe_count, uint32_t index, float quantized_timestamp) {
+    for (uint32_t step = 0; step < 4; step++) {
+        if (index == keyframe_count || !(keyframes[index * 4] < quantized_timestamp)) {
+            return index;
+        }
+        index++;
+    }
+
+    uint32_t count = keyframe_count - index;
+    while (count > 0) {
+        uint32_t half = count / 2;
+        if (keyframes[(index + half) * 4] < quantized_timestamp) {
+            index += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+
+    return index;
+}
+
+// Same as `get_keyframes` for compressed tracks. Constant tracks have no keyframes and must be handled separately.
+static void get_compressed_keyframes(const uint16_t* keyframes, uint32_t keyframe_count, uint32_t index, float quantized_timestamp,
+                                     const uint16_t*& from, const uint16_t*& to, float& factor) {
+    if (index < keyframe_count) {
+        if (index > 0) {
+            from = keyframes + (index - 1) * 4;
+            to = keyframes + index * 4;
+            factor = (quantized_timestamp - from[0]) / (to[0] - from[0]);
+        } else {
+            from = keyframes + (keyframe_count - 1) * 4;
+            to = keyframes;
+            factor = to[0] > 0 ? quantized_timestamp / to[0] : 1.f;
+        }
+    } else {
+        from = keyframes + (keyframe_count - 1) * 4;
+        to = from;
+        factor = 0.f;
+    }
+}
+
+static float3 decode_compressed_vector(const Animation::CompressedTrack& track, const uint16_t* keyframe) {
+    return float3(track.minimum[0] + keyframe[1] * (track.extent[0] / QUANTIZED_VALUE_MAX),
+                  track.minimum[1] + keyframe[2] * (track.extent[1] / QUANTIZED_VALUE_MAX),
+                  track.minimum[2] + keyframe[3] * (track.extent[2] / QUANTIZED_VALUE_MAX));
+}
+
+static quaternion decode_compressed_rotation(const uint16_t* keyframe) {
+    float a = (keyframe[1] & 0x7FFF) * (2.f * ROTATION_COMPONENT_MAX / QUANTIZED_ROTATION_MAX) - ROTATION_COMPONENT_MAX;
+    float b = (keyframe[2] & 0x7FFF) * (2.f * ROTATION_COMPONENT_MAX / QUANTIZED_ROTATION_MAX) - ROTATION_COMPONENT_MAX;
+    float c = (keyframe[3] & 0x7FFF) * (2.f * ROTATION_COMPONENT_MAX / QUANTIZED_ROTATION_MAX) - ROTATION_COMPONENT_MAX;
+
+    // The largest component is always stored positive.
+    float largest = std::sqrt(std::max(1.f - a * a - b * b - c * c, 0.f));
+
+    switch (((keyframe[1] >> 15) << 1) | (keyframe[2] >> 15)) {
+    case 0:
+        return quaternion(largest, a, b, c);
+    case 1:
+        return quaternion(a, largest, b, c);
+    case 2:
+        return quaternion(a, b, largest, c);
+    default:
+        return quaternion(a, b, c, largest);
+    }
+}
+
+// Interpolate the keyframes returned from `get_compressed_joint_keyframes`. Unlike uncompressed animations, rotations
+// are always interpolated with normalized linear interpolation, geometry converter accounts for its error.
+static transform interpolate_compressed_joint(const transform& from, const transform& to, const float* factors) {
+    float4 from_rotation(from.rotation);
+    float4 to_rotation(to.rotation);
+
+    if (dot(from_rotation, to_rotation) < 0.f) {
+        to_rotation = -to_rotation;
+    }
+
+    return transform(
+        lerp(from.translation, to.translation, factors[0]),
+        quaternion(normalize(lerp(from_rotation, to_rotation, factors[1]))),
+        lerp(from.scale, to.scale, factors[2])
+    );
+}
+
+#ifdef KW_SIMD
+// Interpolate four pairs of transforms in structure of arrays form. Transforms are passed as pointers to their ten
+// floats. Translation, rotation and scale have separate interpolation factors. Rotations that are too far apart for
+// normalized linear interpolation fall back to scalar `slerp` when `is_slerp_allowed` is set. Only the first `count`
+// transforms are stored to `result`, the rest of the lanes must still be valid.
+static void interpolate_transforms(const float* const* from, const float* const* to, const float* translation_factors,
+                                   const float* rotation_factors, const float* scale_factors, bool is_slerp_allowed,
+                                   transform* const* result, size_t count) {
+    using simd::vfloat4;
+    using simd::vfloat4x4;
+
+    static_assert(sizeof(transform) == sizeof(float) * 10, "Transform is expected to be tightly packed.");
+
+    // Ten floats of each transform are loaded as three overlapping vectors `data[0..4]`, `data[4..8]` and
+    // `data[6..10]`.
+    vfloat4x4 from_a = simd::transpose(vfloat4x4{ { simd::load(from[0]), simd::load(from[1]), simd::load(from[2]), simd::load(from[3]) } });
+    vfloat4x4 from_b = simd::transpose(vfloat4x4{ { simd::load(from[0] + 4), simd::load(from[1] + 4), simd::load(from[2] + 4), simd::load(from[3] + 4) } });
+    vfloat4x4 from_c = simd::transpose(vfloat4x4{ { simd::load(from[0] + 6), simd::load(from[1] + 6), simd::load(from[2] + 6), simd::load(from[3] + 6) } });
+    vfloat4x4 to_a = simd::transpose(vfloat4x4{ { simd::load(to[0]), simd::load(to[1]), simd::load(to[2]), simd::load(to[3]) } });
+    vfloat4x4 to_b = simd::transpose(vfloat4x4{ { simd::load(to[0] + 4), simd::load(to[1] + 4), simd::load(to[2] + 4), simd::load(to[3] + 4) } });
+    vfloat4x4 to_c = simd::transpose(vfloat4x4{ { simd::load(to[0] + 6), simd::load(to[1] + 6), simd::load(to[2] + 6), simd::load(to[3] + 6) } });
+
+    vfloat4 translation_factor = simd::load(translation_factors);
+    vfloat4 rotation_factor = simd::load(rotation_factors);
+    vfloat4 scale_factor = simd::load(scale_factors);
+    vfloat4 zero = simd::splat(0.f);
+
+    vfloat4 translation_x = simd::madd(simd::sub(to_a.rows[0], from_a.rows[0]), translation_factor, from_a.rows[0]);
+    vfloat4 translation_y = simd::madd(simd::sub(to_a.rows[1], from_a.rows[1]), translation_factor, from_a.rows[1]);
+    vfloat4 translation_z = simd::madd(simd::sub(to_a.rows[2], from_a.rows[2]), translation_factor, from_a.rows[2]);
+    vfloat4 scale_x = simd::madd(simd::sub(to_b.rows[3], from_b.rows[3]), scale_factor, from_b.rows[3]);
+    vfloat4 scale_y = simd::madd(simd::sub(to_c.rows[2], from_c.rows[2]), scale_factor, from_c.rows[2]);
+    vfloat4 scale_z = simd::madd(simd::sub(to_c.rows[3], from_c.rows[3]), scale_factor, from_c.rows[3]);
+
+    vfloat4 from_rotation_x = from_a.rows[3];
+    vfloat4 from_rotation_y = from_b.rows[0];
+    vfloat4 from_rotation_z = from_b.rows[1];
+    vfloat4 from_rotation_w = from_b.rows[2];
+    vfloat4 to_rotation_x = to_a.rows[3];
+    vfloat4 to_rotation_y = to_b.rows[0];
+    vfloat4 to_rotation_z = to_b.rows[1];
+    vfloat4 to_rotation_w = to_b.rows[2];
+
+    // Take the shortest path, see `slerp`.
+    vfloat4 cos_a = simd::mul(from_rotation_x, to_rotation_x);
+    cos_a = simd::madd(from_rotation_y, to_rotation_y, cos_a);
+    cos_a = simd::madd(from_rotation_z, to_rotation_z, cos_a);
+    cos_a = simd::madd(from_rotation_w, to_rotation_w, cos_a);
+
+    vfloat4 negative = simd::less(cos_a, zero);
+    to_rotation_x = simd::select(negative, simd::sub(zero, to_rotation_x), to_rotation_x);
+    to_rotation_y = simd::select(negative, simd::sub(zero, to_rotation_y), to_rotation_y);
+    to_rotation_z = simd::select(negative, simd::sub(zero, to_rotation_z), to_rotation_z);
+    to_rotation_w = simd::select(negative, simd::sub(zero, to_rotation_w), to_rotation_w);
+
+    vfloat4 rotation_x = simd::madd(simd::sub(to_rotation_x, from_rotation_x), rotation_factor, from_rotation_x);
+    vfloat4 rotation_y = simd::madd(simd::sub(to_rotation_y, from_rotation_y), rotation_factor, from_rotation_y);
+    vfloat4 rotation_z = simd::madd(simd::sub(to_rotation_z, from_rotation_z), rotation_factor, from_rotation_z);
+    vfloat4 rotation_w = simd::madd(simd::sub(to_rotation_w, from_rotation_w), rotation_factor, from_rotation_w);
+
+    vfloat4 length = simd::mul(rotation_x, rotation_x);
+    length = simd::madd(rotation_y, rotation_y, length);
+    length = simd::madd(rotation_z, rotation_z, length);
+    length = simd::madd(rotation_w, rotation_w, length);
+    length = simd::sqrt(length);
+
+    rotation_x = simd::div(rotation_x, length);
+    rotation_y = simd::div(rotation_y, length);
+    rotation_z = simd::div(rotation_z, length);
+    rotation_w = simd::div(rotation_w, length);
+
+    // Normalized linear interpolation is accurate only for close rotations, the rest fall back to scalar `slerp`.
+    int nlerp_mask = is_slerp_allowed ? simd::movemask(simd::less(simd::splat(0.995f), simd::abs(cos_a))) : 0xF;
+    if ((nlerp_mask & 0xF) != 0xF) {
+        float rotations[4][4];
+        simd::store(rotations[0], rotation_x);
+        simd::store(rotations[1], rotation_y);
+        simd::store(rotations[2], rotation_z);
+        simd::store(rotations[3], rotation_w);
+
+        for (size_t i = 0; i < 4; i++) {
+            if ((nlerp_mask & (1 << i)) == 0) {
+                quaternion from_rotation(from[i][3], from[i][4], from[i][5], from[i][6]);
+                quaternion to_rotation(to[i][3], to[i][4], to[i][5], to[i][6]);
+                quaternion rotation = slerp(from_rotation, to_rotation, rotation_factors[i]);
+                rotations[0][i] = rotation.x;
+                rotations[1][i] = rotation.y;
+                rotations[2][i] = rotation.z;
+                rotations[3][i] = rotation.w;
+            }
+        }
+
+        rotation_x = simd::load(rotations[0]);
+        rotation_y = simd::load(rotations[1]);
+        rotation_z = simd::load(rotations[2]);
+        rotation_w = simd::load(rotations[3]);
+    }
+
+    // Convert back to array of structures. Overlapping stores write the same values.
+    vfloat4x4 a = simd::transpose(vfloat4x4{ { translation_x, translation_y, translation_z, rotation_x } });
+    vfloat4x4 b = simd::transpose(vfloat4x4{ { rotation_y, rotation_z, rotation_w, scale_x } });
+    vfloat4x4 c = simd::transpose(vfloat4x4{ { rotation_w, scale_x, scale_y, scale_z } });
+
+    for (size_t i = 0; i < count; i++) {
+        float* data = reinterpret_cast<float*>(result[i]);
+        simd::store(data, a.rows[i]);
+        simd::store(data + 4, b.rows[i]);
+        simd::store(data + 6, c.rows[i]);
+    }
+}
+#endif // KW_SIMD
+
 float4x4 Animation::get_joint_transform(uint32_t joint_index, float timestamp) const {
     KW_ASSERT(is_loaded(), "Animation is not loaded yet.");
+    KW_ASSERT(joint_index < get_joint_count(), "Invalid joint index.");
+
+    float normalized_timestamp = normalize_timestamp(timestamp);
+
+    if (is_compressed()) {
+        uint32_t keyframe_indices[COMPRESSED_TRACK_COUNT] = {};
+
+        transform from;
+        transform to;
+        float factors[COMPRESSED_TRACK_COUNT];
+
+        get_compressed_joint_keyframes(joint_index, normalized_timestamp * (QUANTIZED_TIMESTAMP_MAX / m_duration), keyframe_indices, from, to, factors);
+
+        return float4x4(interpolate_compressed_joint(from, to, factors));
+    }
 
-    KW_ASSERT(joint_index < m_joint_animations.size(), "Invalid joint index.");
     const JointAnimation& joint_animation = m_joint_animations[joint_index];
 
-    float normalized_timestamp = m_duration > 0.f ? std::fmodf(timestamp, m_duration) : 0.f;
-    KW_ASSERT(normalized_timestamp < m_duration);
+    const JointKeyframe* from;
+    const JointKeyframe* to;
+    float factor;
 
-    auto it = std::lower_bound(joint_animation.keyframes.begin(), joint_animation.keyframes.end(), normalized_timestamp);
-    if (it != joint_animation.keyframes.end()) {
-        if (it != joint_animation.keyframes.begin()) {
-            auto prev_it = std::prev(it);
+    uint32_t index = find_keyframe(joint_animation.keyframes, 0, normalized_timestamp);
+    get_keyframes(joint_animation.keyframes, index, normalized_timestamp, from, to, factor);
 
-            float factor = (normalized_timestamp - prev_it->timestamp) / (it->timestamp - prev_it->timestamp);
+    return float4x4(lerp(from->transform, to->transform, factor));
+}
 
-            return float4x4(lerp(prev_it->transform, it->transform, factor));
-        } else {
-            auto prev_it = joint_animation.keyframes.rbegin();
+void Animation::sample_pose(float timestamp, SkeletonPose& skeleton_pose, AnimationCursor* cursor) const {
+    Vector<transform>& transforms = skeleton_pose.get_joint_space_transforms();
+    transforms.resize(get_joint_count());
+
+    sample_transforms(timestamp, transforms.data(), cursor);
+}
+
+void Animation::sample_transforms(float timestamp, transform* result, AnimationCursor* cursor, const Vector<uint32_t>* joint_indices) const {
+    KW_ASSERT(is_loaded(), "Animation is not loaded yet.");
+    KW_ASSERT(result != nullptr);
 
-            float factor = it->timestamp > EPSILON ? normalized_timestamp / it->timestamp : 1.f;
+    float normalized_timestamp = normalize_timestamp(timestamp);
+    uint32_t joint_count = static_cast<uint32_t>(get_joint_count());
+    uint32_t sample_count = joint_indices != nullptr ? static_cast<uint32_t>(joint_indices->size()) : joint_count;
 
-            return float4x4(lerp(prev_it->transform, it->transform, factor));
+    // Transforms are sampled in groups of four, these are the outputs of a group.
+    transform* results[4];
+
+    // Compressed animations have a keyframe index per track rather than per joint.
+    size_t keyframe_index_count = is_compressed() ? joint_count * COMPRESSED_TRACK_COUNT : joint_count;
+
+    // Keyframes found with the cursor are valid lower bounds only while time moves forward. Seeks backwards and loops
+    // search from the first keyframe. Keyframes of the joints that are not sampled stay valid lower bounds too.
+    if (cursor != nullptr) {
+        bool is_cursor_valid = cursor->m_animation == this &&
+                               cursor->m_keyframe_indices.size() == keyframe_index_count &&
+                               cursor->m_timestamp <= normalized_timestamp;
+
+        if (!is_cursor_valid) {
+            cursor->m_animation = this;
+            cursor->m_keyframe_indices.assign(keyframe_index_count, 0);
         }
-    } else {
-        const JointKeyframe& joint_keyframe = joint_animation.keyframes.back();
-        return float4x4(transform(joint_keyframe.transform.translation, joint_keyframe.transform.rotation, joint_keyframe.transform.scale));
+
+        cursor->m_timestamp = normalized_timestamp;
+    }
+
+    if (is_compressed()) {
+        float quantized_timestamp = normalized_timestamp * (QUANTIZED_TIMESTAMP_MAX / m_duration);
+
+        transform from[4];
+        transform to[4];
+        float factors[COMPRESSED_TRACK_COUNT][4];
+
+        for (uint32_t i = 0; i < sample_count; i += 4) {
+            uint32_t count = std::min(sample_count - i, 4U);
+
+            for (uint32_t j = 0; j < count; j++) {
+                uint32_t joint_index = joint_indices != nullptr ? (*joint_indices)[i + j] : i + j;
+                KW_ASSERT(joint_index < joint_count, "Invalid joint index.");
+
+                results[j] = result + joint_index;
+
+                uint32_t keyframe_indices[COMPRESSED_TRACK_COUNT] = {};
+
+                uint32_t* joint_keyframe_indices = keyframe_indices;
+                if (cursor != nullptr) {
+                    joint_keyframe_indices = cursor->m_keyframe_indices.data() + joint_index * COMPRESSED_TRACK_COUNT;
+                }
+
+                float joint_factors[COMPRESSED_TRACK_COUNT];
+                get_compressed_joint_keyframes(joint_index, quantized_timestamp, joint_keyframe_indices, from[j], to[j], joint_factors);
+
+                for (uint32_t k = 0; k < COMPRESSED_TRACK_COUNT; k++) {
+                    factors[k][j] = joint_factors[k];
+                }
+            }
+
+#ifdef KW_SIMD
+            // Lanes past the last joint repeat it, their results are not stored.
+            for (uint32_t j = count; j < 4; j++) {
+                from[j] = from[count - 1];
+                to[j] = to[count - 1];
+
+                for (uint32_t k = 0; k < COMPRESSED_TRACK_COUNT; k++) {
+                    factors[k][j] = factors[k][count - 1];
+                }
+            }
+
+            const float* from_data[4] = { from[0].data, from[1].data, from[2].data, from[3].data };
+            const float* to_data[4] = { to[0].data, to[1].data, to[2].data, to[3].data };
+
+            interpolate_transforms(from_data, to_data, factors[0], factors[1], factors[2], false, results, count);
+#else
+            for (uint32_t j = 0; j < count; j++) {
+                float joint_factors[COMPRESSED_TRACK_COUNT] = { factors[0][j], factors[1][j], factors[2][j] };
+                *results[j] = interpolate_compressed_joint(from[j], to[j], joint_factors);
+            }
+#endif // KW_SIMD
+        }
+
+        return;
+    }
+
+    const JointKeyframe* from[4];
+    const JointKeyframe* to[4];
+    float factors[4];
+
+    for (uint32_t i = 0; i < sample_count; i += 4) {
+        uint32_t count = std::min(sample_count - i, 4U);
+
+        for (uint32_t j = 0; j < count; j++) {
+            uint32_t joint_index = joint_indices != nullptr ? (*joint_indices)[i + j] : i + j;
+            KW_ASSERT(joint_index < joint_count, "Invalid joint index.");
+
+            results[j] = result + joint_index;
+
+            const Vector<JointKeyframe>& keyframes = m_joint_animations[joint_index].keyframes;
+
+            uint32_t index = 0;
+            if (cursor != nullptr) {
+                index = std::min(cursor->m_keyframe_indices[joint_index], static_cast<uint32_t>(keyframes.size()));
+            }
+
+            index = find_keyframe(keyframes, index, normalized_timestamp);
+            get_keyframes(keyframes, index, normalized_timestamp, from[j], to[j], factors[j]);
+
+            if (cursor != nullptr) {
+                cursor->m_keyframe_indices[joint_index] = index;
+            }
+        }
+
+#ifdef KW_SIMD
+        // Lanes past the last joint repeat it, their results are not stored.
+        for (uint32_t j = count; j < 4; j++) {
+            from[j] = from[count - 1];
+            to[j] = to[count - 1];
+            factors[j] = factors[count - 1];
+        }
+
+        const float* from_data[4] = { from[0]->transform.data, from[1]->transform.data, from[2]->transform.data, from[3]->transform.data };
+        const float* to_data[4] = { to[0]->transform.data, to[1]->transform.data, to[2]->transform.data, to[3]->transform.data };
+
+        interpolate_transforms(from_data, to_data, factors, factors, factors, true, results, count);
+#else
+        for (uint32_t j = 0; j < count; j++) {
+            *results[j] = lerp(from[j]->transform, to[j]->transform, factors[j]);
+        }
+#endif // KW_SIMD
     }
 }
 
 size_t Animation::get_joint_count() const {
+    if (is_compressed()) {
+        return m_compressed_tracks.size() / COMPRESSED_TRACK_COUNT;
+    }
     return m_joint_animations.size();
 }
 
@@ -73,4 +513,76 @@ bool Animation::is_loaded() const {
     return m_duration == m_duration;
 }
 
+bool Animation::is_compressed() const {
+    return !m_compressed_tracks.empty();
+}
+
+float Animation::normalize_timestamp(float timestamp) const {
+    float normalized_timestamp = m_duration > 0.f ? std::fmodf(timestamp, m_duration) : 0.f;
+    KW_ASSERT(normalized_timestamp < m_duration);
+    return normalized_timestamp;
+}
+
+void Animation::get_compressed_joint_keyframes(uint32_t joint_index, float quantized_timestamp, uint32_t* keyframe_indices,
+                                               transform& from, transform& to, float* factors) const {
+    for (uint32_t i = 0; i < COMPRESSED_TRACK_COUNT; i++) {
+        uint32_t track_index = joint_index * COMPRESSED_TRACK_COUNT + i;
+
+        const CompressedTrack& compressed_track = m_compressed_tracks[track_index];
+        const uint16_t* keyframes = m_compressed_keyframes.data() + m_compressed_track_offsets[track_index];
+
+        if (compressed_track.keyframe_count == 0) {
+            if (i == 1) {
+                from.rotation = quaternion(compressed_track.minimum[0], compressed_track.minimum[1], compressed_track.minimum[2], compressed_track.minimum[3]);
+                to.rotation = from.rotation;
+            } else {
+                float3& from_value = i == 0 ? from.translation : from.scale;
+                float3& to_value = i == 0 ? to.translation : to.scale;
+
+                from_value = float3(compressed_track.minimum[0], compressed_track.minimum[1], compressed_track.minimum[2]);
+                to_value = from_value;
+            }
+
+            factors[i] = 0.f;
+            continue;
+        }
+
+        uint32_t index = std::min(keyframe_indices[i], compressed_track.keyframe_count);
+        index = find_compressed_keyframe(keyframes, compressed_track.keyframe_count, index, quantized_timestamp);
+
+        const uint16_t* from_keyframe;
+        const uint16_t* to_keyframe;
+        get_compressed_keyframes(keyframes, compressed_track.keyframe_count, index, quantized_timestamp, from_keyframe, to_keyframe, factors[i]);
+
+        if (compressed_track.is_raw) {
+            // Raw values are stored in the same order as keyframes, four floats per keyframe.
+            const float* raw_values = m_compressed_raw_values.data() + m_compressed_raw_offsets[track_index];
+            const float* from_raw_value = raw_values + (from_keyframe - keyframes);
+            const float* to_raw_value = raw_values + (to_keyframe - keyframes);
+
+            if (i == 1) {
+                from.rotation = quaternion(from_raw_value[0], from_raw_value[1], from_raw_value[2], from_raw_value[3]);
+                to.rotation = quaternion(to_raw_value[0], to_raw_value[1], to_raw_value[2], to_raw_value[3]);
+            } else {
+                float3& from_value = i == 0 ? from.translation : from.scale;
+                float3& to_value = i == 0 ? to.translation : to.scale;
+
+                from_value = float3(from_raw_value[0], from_raw_value[1], from_raw_value[2]);
+                to_value = float3(to_raw_value[0], to_raw_value[1], to_raw_value[2]);
+            }
+        } else if (i == 1) {
+            from.rotation = decode_compressed_rotation(from_keyframe);
+            to.rotation = decode_compressed_rotation(to_keyframe);
+        } else {
+            float3& from_value = i == 0 ? from.translation : from.scale;
+            float3& to_value = i == 0 ? to.translation : to.scale;
+
+            from_value = decode_compressed_vector(compressed_track, from_keyframe);
+            to_value = decode_compressed_vector(compressed_track, to_keyframe);
+        }
+
+        keyframe_indices[i] = index;
+    }
+}
+
 } // namespace kw
@@ -0,0 +1,354 @@
+#include "render/animation/animation_blend_tree.h"
+#include "render/animation/animation.h"
+#include "render/geometry/skeleton_pose.h"
+
+#include <core/debug/assert.h>
+#include <core/math/float4.h>
+
+#include <algorithm>
+
+namespace kw {
+
+// Blend `source` into `destination` by the given factor. Rotations are blended with normalized linear interpolation,
+// which is accurate enough for the poses of the same skeleton and keeps blending of multiple clips commutative. Only
+// the given joints are blended when `joint_indices` is not null.
+static void blend_override(transform* destination, const transform* source, float factor, const float* joint_weights,
+                           const uint32_t* joint_indices, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        size_t i = joint_indices != nullptr ? joint_indices[k] : k;
+
+        float joint_factor = joint_weights != nullptr ? factor * joint_weights[i] : factor;
+        if (joint_factor <= 0.f) {
+            continue;
+        }
+
+        float4 from_rotation(destination[i].rotation);
+        float4 to_rotation(source[i].rotation);
+
+        // Take the shortest path.
+        if (dot(from_rotation, to_rotation) < 0.f) {
+            to_rotation = -to_rotation;
+        }
+
+        destination[i].translation = lerp(destination[i].translation, source[i].translation, joint_factor);
+        destination[i].rotation = quaternion(normalize(lerp(from_rotation, to_rotation, joint_factor)));
+        destination[i].scale = lerp(destination[i].scale, source[i].scale, joint_factor);
+    }
+}
+
+// Add the difference between `source` and `reference` to `destination` by the given factor.
+static void blend_additive(transform* destination, const transform* source, const transform* reference, float factor,
+                           const float* joint_weights, const uint32_t* joint_indices, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        size_t i = joint_indices != nullptr ? joint_indices[k] : k;
+
+        float joint_factor = joint_weights != nullptr ? factor * joint_weights[i] : factor;
+        if (joint_factor <= 0.f) {
+            continue;
+        }
+
+        float4 difference(source[i].rotation * inverse(reference[i].rotation));
+
+        // Take the shortest path from identity.
+        if (difference.w < 0.f) {
+            difference = -difference;
+        }
+
+        quaternion rotation(normalize(lerp(float4(0.f, 0.f, 0.f, 1.f), difference, joint_factor)));
+
+        destination[i].translation += (source[i].translation - reference[i].translation) * joint_factor;
+        destination[i].rotation = normalize(rotation * destination[i].rotation);
+        destination[i].scale *= lerp(float3(1.f), source[i].scale / reference[i].scale, joint_factor);
+    }
+}
+
+AnimationBlendTree::Clip::Clip(MemoryResource& memory_resource)
+    : cursor(memory_resource)
+    , reference_transforms(memory_resource)
+    , time(0.f)
+    , speed(1.f)
+    , weight(1.f)
+    , target_weight(1.f)
+    , fade_speed(0.f)
+{
+}
+
+AnimationBlendTree::Layer::Layer(MemoryResource& memory_resource)
+    : clips(memory_resource)
+    , joint_weights(memory_resource)
+    , layer_mode(LayerMode::OVERRIDE)
+    , weight(1.f)
+{
+}
+
+AnimationBlendTree::AnimationBlendTree(MemoryResource& memory_resource)
+    : m_layers(memory_resource)
+    , m_clip_transforms(memory_resource)
+    , m_layer_transforms(memory_resource)
+{
+    m_layers.emplace_back(memory_resource);
+}
+
+uint32_t AnimationBlendTree::add_layer(LayerMode layer_mode, float weight) {
+    Layer& layer = m_layers.emplace_back(*m_layers.get_allocator().memory_resource);
+    layer.layer_mode = layer_mode;
+    layer.weight = weight;
+
+    return static_cast<uint32_t>(m_layers.size() - 1);
+}
+
+size_t AnimationBlendTree::get_layer_count() const {
+    return m_layers.size();
+}
+
+AnimationBlendTree::LayerMode AnimationBlendTree::get_layer_mode(uint32_t layer_index) const {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    return m_layers[layer_index].layer_mode;
+}
+
+float AnimationBlendTree::get_layer_weight(uint32_t layer_index) const {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    return m_layers[layer_index].weight;
+}
+
+void AnimationBlendTree::set_layer_weight(uint32_t layer_index, float value) {
+    KW_ASSERT(layer_index > 0 && layer_index < m_layers.size(), "Invalid layer index.");
+    m_layers[layer_index].weight = value;
+}
+
+const Vector<float>& AnimationBlendTree::get_layer_joint_weights(uint32_t layer_index) const {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    return m_layers[layer_index].joint_weights;
+}
+
+void AnimationBlendTree::set_layer_joint_weights(uint32_t layer_index, const Vector<float>& joint_weights) {
+    KW_ASSERT(layer_index > 0 && layer_index < m_layers.size(), "Invalid layer index.");
+    m_layers[layer_index].joint_weights.assign(joint_weights.begin(), joint_weights.end());
+}
+
+uint32_t AnimationBlendTree::add_clip(uint32_t layer_index, SharedPtr<Animation> animation, float weight, float speed) {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(animation, "Invalid animation.");
+
+    Clip& clip = m_layers[layer_index].clips.emplace_back(*m_layers.get_allocator().memory_resource);
+    clip.animation = std::move(animation);
+    clip.speed = speed;
+    clip.weight = weight;
+    clip.target_weight = weight;
+
+    return static_cast<uint32_t>(m_layers[layer_index].clips.size() - 1);
+}
+
+void AnimationBlendTree::remove_clip(uint32_t layer_index, uint32_t clip_index) {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(clip_index < m_layers[layer_index].clips.size(), "Invalid clip index.");
+
+    Vector<Clip>& clips = m_layers[layer_index].clips;
+    clips.erase(clips.begin() + clip_index);
+}
+
+void AnimationBlendTree::clear_clips(uint32_t layer_index) {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    m_layers[layer_index].clips.clear();
+}
+
+size_t AnimationBlendTree::get_clip_count(uint32_t layer_index) const {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    return m_layers[layer_index].clips.size();
+}
+
+const SharedPtr<Animation>& AnimationBlendTree::get_clip_animation(uint32_t layer_index, uint32_t clip_index) const {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(clip_index < m_layers[layer_index].clips.size(), "Invalid clip index.");
+    return m_layers[layer_index].clips[clip_index].animation;
+}
+
+float AnimationBlendTree::get_clip_time(uint32_t layer_index, uint32_t clip_index) const {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(clip_index < m_layers[layer_index].clips.size(), "Invalid clip index.");
+    return m_layers[layer_index].clips[clip_index].time;
+}
+
+void AnimationBlendTree::set_clip_time(uint32_t layer_index, uint32_t clip_index, float value) {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(clip_index < m_layers[layer_index].clips.size(), "Invalid clip index.");
+    m_layers[layer_index].clips[clip_index].time = value;
+}
+
+float AnimationBlendTree::get_clip_speed(uint32_t layer_index, uint32_t clip_index) const {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(clip_index < m_layers[layer_index].clips.size(), "Invalid clip index.");
+    return m_layers[layer_index].clips[clip_index].speed;
+}
+
+void AnimationBlendTree::set_clip_speed(uint32_t layer_index, uint32_t clip_index, float value) {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(clip_index < m_layers[layer_index].clips.size(), "Invalid clip index.");
+    m_layers[layer_index].clips[clip_index].speed = value;
+}
+
+float AnimationBlendTree::get_clip_weight(uint32_t layer_index, uint32_t clip_index) const {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(clip_index < m_layers[layer_index].clips.size(), "Invalid clip index.");
+    return m_layers[layer_index].clips[clip_index].weight;
+}
+
+void AnimationBlendTree::set_clip_weight(uint32_t layer_index, uint32_t clip_index, float value) {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+    KW_ASSERT(clip_index < m_layers[layer_index].clips.size(), "Invalid clip index.");
+
+    Clip& clip = m_layers[layer_index].clips[clip_index];
+    clip.weight = value;
+    clip.target_weight = value;
+    clip.fade_speed = 0.f;
+}
+
+uint32_t AnimationBlendTree::crossfade(uint32_t layer_index, SharedPtr<Animation> animation, float duration, float speed) {
+    KW_ASSERT(layer_index < m_layers.size(), "Invalid layer index.");
+
+    if (duration <= 0.f) {
+        clear_clips(layer_index);
+        return add_clip(layer_index, std::move(animation), 1.f, speed);
+    }
+
+    Vector<Clip>& clips = m_layers[layer_index].clips;
+
+    // Clips of zero weight have nothing to fade, so `update` would never remove them.
+    clips.erase(std::remove_if(clips.begin(), clips.end(), [](const Clip& clip) {
+        return clip.weight <= 0.f;
+    }), clips.end());
+
+    // Clips that are already fading out keep fading at the new rate, so all of them end at the same time.
+    for (Clip& clip : clips) {
+        clip.target_weight = 0.f;
+        clip.fade_speed = clip.weight / duration;
+    }
+
+    uint32_t clip_index = add_clip(layer_index, std::move(animation), 0.f, speed);
+
+    Clip& clip = clips[clip_index];
+    clip.target_weight = 1.f;
+    clip.fade_speed = 1.f / duration;
+
+    return clip_index;
+}
+
+void AnimationBlendTree::update(float elapsed_time) {
+    for (Layer& layer : m_layers) {
+        for (Clip& clip : layer.clips) {
+            clip.time += elapsed_time * clip.speed;
+
+            if (clip.fade_speed > 0.f) {
+                float step = clip.fade_speed * elapsed_time;
+                if (clip.weight < clip.target_weight) {
+                    clip.weight = std::min(clip.weight + step, clip.target_weight);
+                } else {
+                    clip.weight = std::max(clip.weight - step, clip.target_weight);
+                }
+            }
+        }
+
+        // Remove the clips that are faded out, the clips whose weight is set to zero explicitly are kept.
+        layer.clips.erase(std::remove_if(layer.clips.begin(), layer.clips.end(), [](const Clip& clip) {
+            return clip.fade_speed > 0.f && clip.target_weight == 0.f && clip.weight == 0.f;
+        }), layer.clips.end());
+    }
+}
+
+bool AnimationBlendTree::is_loaded() const {
+    for (const Clip& clip : m_layers[0].clips) {
+        if (clip.animation->is_loaded()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AnimationBlendTree::sample_pose(SkeletonPose& skeleton_pose, const Vector<uint32_t>* joint_indices) {
+    KW_ASSERT(is_loaded(), "Animation blend tree is not loaded yet.");
+
+    Vector<transform>& pose_transforms = skeleton_pose.get_joint_space_transforms();
+    size_t joint_count = pose_transforms.size();
+
+    const uint32_t* blend_indices = joint_indices != nullptr ? joint_indices->data() : nullptr;
+    size_t blend_count = joint_indices != nullptr ? joint_indices->size() : joint_count;
+
+    m_clip_transforms.resize(joint_count);
+
+    for (size_t layer_index = 0; layer_index < m_layers.size(); layer_index++) {
+        Layer& layer = m_layers[layer_index];
+
+        KW_ASSERT(
+            layer.joint_weights.empty() || layer.joint_weights.size() == joint_count,
+            "Mismatching layer joint weights and skeleton."
+        );
+
+        const float* joint_weights = layer.joint_weights.empty() ? nullptr : layer.joint_weights.data();
+
+        if (layer.layer_mode == LayerMode::ADDITIVE) {
+            for (Clip& clip : layer.clips) {
+                const Animation& animation = *clip.animation;
+
+                float factor = layer.weight * clip.weight;
+                if (!animation.is_loaded() || factor <= 0.f) {
+                    continue;
+                }
+
+                KW_ASSERT(animation.get_joint_count() == joint_count, "Mismatching animation and skeleton.");
+
+                if (clip.reference_transforms.size() != joint_count) {
+                    clip.reference_transforms.resize(joint_count);
+                    animation.sample_transforms(0.f, clip.reference_transforms.data());
+                }
+
+                animation.sample_transforms(clip.time, m_clip_transforms.data(), &clip.cursor, joint_indices);
+
+                blend_additive(pose_transforms.data(), m_clip_transforms.data(), clip.reference_transforms.data(),
+                               factor, joint_weights, blend_indices, blend_count);
+            }
+        } else {
+            // The base layer is sampled directly into the skeleton pose, other override layers are blended into their
+            // own pose first and then blended into the skeleton pose by layer weight.
+            transform* layer_transforms = pose_transforms.data();
+            if (layer_index > 0) {
+                m_layer_transforms.resize(joint_count);
+                layer_transforms = m_layer_transforms.data();
+            }
+
+            // Blending each next clip by its share of the total weight so far is the same as blending all clips by
+            // their normalized weights, but doesn't need a separate accumulation pass.
+            float total_weight = 0.f;
+            bool is_first_clip = true;
+
+            for (Clip& clip : layer.clips) {
+                const Animation& animation = *clip.animation;
+
+                // The first loaded clip of the base layer is sampled even if its weight is zero, so the pose is valid.
+                if (!animation.is_loaded() || (clip.weight <= 0.f && (layer_index > 0 || !is_first_clip))) {
+                    continue;
+                }
+
+                KW_ASSERT(animation.get_joint_count() == joint_count, "Mismatching animation and skeleton.");
+
+                if (is_first_clip) {
+                    animation.sample_transforms(clip.time, layer_transforms, &clip.cursor, joint_indices);
+                    is_first_clip = false;
+                } else {
+                    animation.sample_transforms(clip.time, m_clip_transforms.data(), &clip.cursor, joint_indices);
+                    blend_override(layer_transforms, m_clip_transforms.data(), clip.weight / (total_weight + clip.weight),
+                                   nullptr, blend_indices, blend_count);
+                }
+
+                total_weight += std::max(clip.weight, 0.f);
+            }
+
+            // When the weights of all clips add up to less than one, the layer fades out.
+            if (layer_index > 0 && !is_first_clip) {
+                blend_override(pose_transforms.data(), layer_transforms, layer.weight * std::min(total_weight, 1.f),
+                               joint_weights, blend_indices, blend_count);
+            }
+        }
+    }
+}
+
+} // namespace kw
@@ -0,0 +1,18 @@
+#include "render/animation/animation_cursor.h"
+
+namespace kw {
+
+AnimationCursor::AnimationCursor(MemoryResource& memory_resource)
+    : m_animation(nullptr)
+    , m_keyframe_indices(memory_resource)
+    , m_timestamp(0.f)
+{
+}
+
+void AnimationCursor::reset() {
+    m_animation = nullptr;
+    m_keyframe_indices.clear();
+    m_timestamp = 0.f;
+}
+
+} // namespace kw
@@ -8,6 +8,8 @@
 #include <core/io/binary_reader.h>
 #include <core/memory/malloc_memory_resource.h>
 
+#include <cmath>
+
 namespace kw {
 
 namespace EndianUtils {
@@ -43,6 +45,7 @@ static Animation::JointKeyframe swap_le(Animation::JointKeyframe keyframe) {
 } // namespace EndianUtils
 
 constexpr uint32_t KWA_SIGNATURE = ' AWK';
+constexpr uint32_t KWA_COMPRESSED_SIGNATURE = 'CAWK';
 
 class AnimationManager::PendingTask final : public Task {
 public:
@@ -56,7 +59,14 @@ public:
     void run() override {
         BinaryReader reader(m_relative_path);
         KW_ERROR(reader, "Failed to open animation \"%s\".", m_relative_path);
-        KW_ERROR(read_next(reader) == KWA_SIGNATURE, "Invalid animation \"%s\" signature.", m_relative_path);
+
+        uint32_t signature = read_next(reader);
+        if (signature == KWA_COMPRESSED_SIGNATURE) {
+            load_compressed(reader);
+            return;
+        }
+
+        KW_ERROR(signature == KWA_SIGNATURE, "Invalid animation \"%s\" signature.", m_relative_path);
 
         uint32_t joint_count = read_next(reader);
 
@@ -88,6 +98,53 @@ public:
     }
 
 private:
+    void load_compressed(BinaryReader& reader) {
+        uint32_t joint_count = read_next(reader);
+        uint32_t keyframe_count = read_next(reader);
+
+        std::optional<float> duration = reader.read_le<float>();
+        KW_ERROR(duration, "Failed to read animation header.");
+
+        // Compressed timestamps are relative to the duration.
+        KW_ERROR(std::isfinite(*duration) && *duration > 0.f, "Invalid animation \"%s\" duration.", m_relative_path);
+
+        Vector<Animation::CompressedTrack> compressed_tracks(joint_count * Animation::COMPRESSED_TRACK_COUNT, m_manager.m_persistent_memory_resource);
+
+        uint32_t total_keyframe_count = 0;
+        uint32_t raw_keyframe_count = 0;
+
+        for (Animation::CompressedTrack& compressed_track : compressed_tracks) {
+            compressed_track.keyframe_count = read_next(reader);
+            compressed_track.is_raw = read_next(reader) != 0;
+            KW_ERROR(reader.read_le<float>(compressed_track.minimum, std::size(compressed_track.minimum)), "Failed to read compressed track range.");
+            KW_ERROR(reader.read_le<float>(compressed_track.extent, std::size(compressed_track.extent)), "Failed to read compressed track range.");
+
+            total_keyframe_count += compressed_track.keyframe_count;
+            if (compressed_track.is_raw) {
+                raw_keyframe_count += compressed_track.keyframe_count;
+            }
+        }
+
+        KW_ERROR(total_keyframe_count == keyframe_count, "Mismatching animation \"%s\" keyframe count.", m_relative_path);
+
+        Vector<uint16_t> compressed_keyframes(keyframe_count * 4, m_manager.m_persistent_memory_resource);
+        KW_ERROR(reader.read_le<uint16_t>(compressed_keyframes.data(), compressed_keyframes.size()), "Failed to read compressed keyframes.");
+
+        Vector<float> compressed_raw_values(raw_keyframe_count * 4, m_manager.m_persistent_memory_resource);
+        KW_ERROR(reader.read_le<float>(compressed_raw_values.data(), compressed_raw_values.size()), "Failed to read compressed raw values.");
+
+        // Interpolation divides by the difference of adjacent timestamps.
+        const uint16_t* track_keyframes = compressed_keyframes.data();
+        for (const Animation::CompressedTrack& compressed_track : compressed_tracks) {
+            for (uint32_t i = 1; i < compressed_track.keyframe_count; i++) {
+                KW_ERROR(track_keyframes[i * 4] > track_keyframes[(i - 1) * 4], "Invalid animation \"%s\" keyframe order.", m_relative_path);
+            }
+            track_keyframes += compressed_track.keyframe_count * 4;
+        }
+
+        m_animation = Animation(*duration, std::move(compressed_tracks), std::move(compressed_keyframes), std::move(compressed_raw_values));
+    }
+
     uint32_t read_next(BinaryReader& reader) {
         std::optional<uint32_t> value = reader.read_le<uint32_t>();
         KW_ERROR(value, "Failed to read animation header.");
@@ -1,54 +1,106 @@
 #include "render/animation/animation_player.h"
 #include "render/animation/animated_geometry_primitive.h"
-#include "render/animation/animation.h"
+#include "render/camera/camera_manager.h"
 #include "render/geometry/geometry.h"
+#include "render/geometry/skeleton.h"
 
 #include <system/timer.h>
 
-#include <core/concurrency/task.h>
+#include <core/concurrency/parallel_for_task.h>
 #include <core/concurrency/task_scheduler.h>
 #include <core/debug/assert.h>
+#include <core/debug/cpu_profiler.h>
 
 #include <algorithm>
+#include <cmath>
 
 namespace kw {
 
-class AnimationPlayer::WorkerTask : public Task {
+// Primitives with the same update interval are updated on different frames depending on their index.
+static bool is_update_frame(uint64_t frame_index, size_t primitive_index, uint32_t update_interval) {
+    if (update_interval <= 1) {
+        return true;
+    }
+
+    if (update_interval == UINT32_MAX) {
+        return false;
+    }
+
+    return (frame_index + primitive_index) % update_interval == 0;
+}
+
+class AnimationPlayer::WorkerTask : public ParallelForTask {
 public:
-    WorkerTask(AnimationPlayer& animation_player, size_t primitive_index, float elapsed_time)
-        : m_animation_player(animation_player)
-        , m_primitive_index(primitive_index)
+    WorkerTask(AnimationPlayer& animation_player, Task* end_task, size_t primitive_count, float elapsed_time,
+               uint64_t frame_index, const frustum& frustum, const float3& camera_translation, float lod_distance_factor)
+        : ParallelForTask(animation_player.m_task_scheduler, animation_player.m_transient_memory_resource, end_task, primitive_count)
+        , m_animation_player(animation_player)
         , m_elapsed_time(elapsed_time)
+        , m_frame_index(frame_index)
+        , m_frustum(frustum)
+        , m_camera_translation(camera_translation)
+        , m_lod_distance_factor(lod_distance_factor)
     {
     }
 
-    void run() override {
-        std::shared_lock lock(m_animation_player.m_primitives_mutex);
+    void run(size_t begin, size_t end) override {
+        if (Task* unlock_task = m_animation_player.m_primitives_mutex.try_lock_shared(m_animation_player.m_transient_memory_resource)) {
+            // Some primitive is being added or removed. Let this worker thread run other tasks in the meantime.
+            suspend(m_animation_player.m_transient_memory_resource, { unlock_task });
+            return;
+        }
 
-        AnimatedGeometryPrimitive* animated_geometry_primitive = m_animation_player.m_primitives[m_primitive_index];
-        if (animated_geometry_primitive != nullptr) {
-            const SharedPtr<Geometry>& geometry = animated_geometry_primitive->get_geometry();
-            const SharedPtr<Animation>& animation = animated_geometry_primitive->get_animation();
+        std::shared_lock lock(m_animation_player.m_primitives_mutex, std::adopt_lock);
 
-            if (geometry && geometry->is_loaded() && animation && animation->is_loaded()) {
-                SkeletonPose& skeleton_pose = animated_geometry_primitive->get_skeleton_pose();
+        size_t sampled_primitive_count = 0;
+        size_t evaluated_joint_count = 0;
 
-                KW_ASSERT(
-                    skeleton_pose.get_joint_count() == animation->get_joint_count(),
-                    "Mismatching animation and skeleton."
-                );
+        for (size_t i = begin; i < end; i++) {
+            AnimatedGeometryPrimitive* animated_geometry_primitive = m_animation_player.m_primitives[i];
+            if (animated_geometry_primitive != nullptr) {
+                const SharedPtr<Geometry>& geometry = animated_geometry_primitive->get_geometry();
+                AnimationBlendTree& animation_blend_tree = animated_geometry_primitive->get_animation_blend_tree();
 
-                float old_time = animated_geometry_primitive->get_animation_time();
-                float new_time = old_time + m_elapsed_time * animated_geometry_primitive->get_animation_speed();
-                animated_geometry_primitive->set_animation_time(new_time);
+                if (geometry && geometry->is_loaded() && animation_blend_tree.is_loaded()) {
+                    const Skeleton& skeleton = *geometry->get_skeleton();
 
-                for (uint32_t i = 0; i < animation->get_joint_count(); i++) {
-                    skeleton_pose.set_joint_space_matrix(i, animation->get_joint_transform(i, new_time));
-                }
+                    bool was_visible = animated_geometry_primitive->m_is_visible;
+                    bool is_visible = intersect(animated_geometry_primitive->get_bounds(), m_frustum);
+                    bool is_distant = is_distant_primitive(*animated_geometry_primitive);
+
+                    uint32_t update_interval = 1;
+                    if (!is_visible) {
+                        update_interval = m_animation_player.m_invisible_update_interval;
+                    } else if (is_distant) {
+                        update_interval = m_animation_player.m_lod_update_interval;
+                    }
+
+                    animated_geometry_primitive->m_is_visible = is_visible;
+                    animated_geometry_primitive->m_skipped_time += m_elapsed_time;
+
+                    // The pose of a primitive that just became visible may be many frames old.
+                    if ((is_visible && !was_visible) || is_update_frame(m_frame_index, i, update_interval)) {
+                        SkeletonPose& skeleton_pose = animated_geometry_primitive->get_skeleton_pose();
+
+                        // The joints that are not animated keep their last pose.
+                        const Vector<uint32_t>* joint_indices = is_distant ? &skeleton.get_lod_joints() : nullptr;
 
-                skeleton_pose.build_model_space_matrices(*geometry->get_skeleton());
+                        animation_blend_tree.update(animated_geometry_primitive->m_skipped_time);
+                        animation_blend_tree.sample_pose(skeleton_pose, joint_indices);
+
+                        skeleton_pose.build_model_space_matrices(skeleton);
+
+                        animated_geometry_primitive->m_skipped_time = 0.f;
+
+                        sampled_primitive_count++;
+                        evaluated_joint_count += joint_indices != nullptr ? joint_indices->size() : skeleton.get_joint_count();
+                    }
+                }
             }
         }
+
+        KW_CPU_PROFILER_COUNTER("Animated Primitives", sampled_primitive_count);
+        KW_CPU_PROFILER_COUNTER("Animated Joints", evaluated_joint_count);
     }
 
     const char* get_name() const override {
@@ -56,31 +108,58 @@ public:
     }
 
 private:
+    // Compare the bounding sphere's radius to the camera distance rather than computing the screen size directly.
+    bool is_distant_primitive(const AnimatedGeometryPrimitive& animated_geometry_primitive) const {
+        const aabbox& bounds = animated_geometry_primitive.get_bounds();
+
+        float square_radius = square_length(bounds.extent);
+        float square_distance = square_length(bounds.center - m_camera_translation);
+
+        return square_radius < square_distance * m_lod_distance_factor * m_lod_distance_factor;
+    }
+
     AnimationPlayer& m_animation_player;
-    size_t m_primitive_index;
     float m_elapsed_time;
+    uint64_t m_frame_index;
+    frustum m_frustum;
+    float3 m_camera_translation;
+    float m_lod_distance_factor;
 };
 
 class AnimationPlayer::BeginTask : public Task {
 public:
-    BeginTask(AnimationPlayer& animation_player, Task* end_task, float elapsed_time)
+    BeginTask(AnimationPlayer& animation_player, Task* end_task, float elapsed_time, uint64_t frame_index)
         : m_animation_player(animation_player)
         , m_end_task(end_task)
         , m_elapsed_time(elapsed_time)
+        , m_frame_index(frame_index)
     {
     }
 
     void run() override {
-        std::lock_guard lock(m_animation_player.m_primitives_mutex);
+        if (Task* unlock_task = m_animation_player.m_primitives_mutex.try_lock_shared(m_animation_player.m_transient_memory_resource)) {
+            // Some primitive is being added or removed. Let this worker thread run other tasks in the meantime.
+            suspend(m_animation_player.m_transient_memory_resource, { unlock_task });
+            return;
+        }
 
-        for (size_t i = 0; i < m_animation_player.m_primitives.size(); i++) {
-            WorkerTask* worker_task = m_animation_player.m_transient_memory_resource.construct<WorkerTask>(m_animation_player, i, m_elapsed_time);
-            KW_ASSERT(worker_task != nullptr);
+        std::shared_lock lock(m_animation_player.m_primitives_mutex, std::adopt_lock);
 
-            worker_task->add_output_dependencies(m_animation_player.m_transient_memory_resource, { m_end_task });
+        const Camera& camera = m_animation_player.m_camera_manager.get_occlusion_camera();
 
-            m_animation_player.m_task_scheduler.enqueue_task(m_animation_player.m_transient_memory_resource, worker_task);
-        }
+        size_t primitive_count = m_animation_player.m_primitives.size();
+
+        // A primitive is distant when its bounding sphere radius is less than camera distance times this factor.
+        float lod_distance_factor = std::tan(camera.get_fov() / 2.f) * m_animation_player.m_lod_screen_size;
+
+        // A single parallel for task instead of a task per primitive. Primitives added after this point are updated
+        // on the next frame.
+        WorkerTask* worker_task = m_animation_player.m_transient_memory_resource.construct<WorkerTask>(
+            m_animation_player, m_end_task, primitive_count, m_elapsed_time, m_frame_index, camera.get_frustum(), camera.get_translation(), lod_distance_factor
+        );
+        KW_ASSERT(worker_task != nullptr);
+
+        m_animation_player.m_task_scheduler.enqueue_task(m_animation_player.m_transient_memory_resource, worker_task);
     }
 
     const char* get_name() const override {
@@ -91,17 +170,26 @@ private:
     AnimationPlayer& m_animation_player;
     Task* m_end_task;
     float m_elapsed_time;
+    uint64_t m_frame_index;
 };
 
 AnimationPlayer::AnimationPlayer(const AnimationPlayerDescriptor& descriptor)
     : m_timer(*descriptor.timer)
     , m_task_scheduler(*descriptor.task_scheduler)
+    , m_camera_manager(*descriptor.camera_manager)
+    , m_lod_screen_size(descriptor.lod_screen_size)
+    , m_lod_update_interval(descriptor.lod_update_interval)
+    , m_invisible_update_interval(descriptor.invisible_update_interval)
     , m_persistent_memory_resource(*descriptor.persistent_memory_resource)
     , m_transient_memory_resource(*descriptor.transient_memory_resource)
     , m_primitives(*descriptor.persistent_memory_resource)
+    , m_primitives_mutex(*descriptor.task_scheduler)
+    , m_frame_index(0)
 {
     KW_ASSERT(descriptor.timer != nullptr);
     KW_ASSERT(descriptor.task_scheduler != nullptr);
+    KW_ASSERT(descriptor.camera_manager != nullptr);
+    KW_ASSERT(descriptor.lod_screen_size >= 0.f, "Invalid LOD screen size.");
     KW_ASSERT(descriptor.persistent_memory_resource != nullptr);
     KW_ASSERT(descriptor.transient_memory_resource != nullptr);
 
@@ -138,7 +226,7 @@ void AnimationPlayer::remove(AnimatedGeometryPrimitive& primitive) {
 
 Pair<Task*, Task*> AnimationPlayer::create_tasks() {
     Task* end_task = m_transient_memory_resource.construct<NoopTask>("Animation Player End");
-    Task* begin_task = m_transient_memory_resource.construct<BeginTask>(*this, end_task, m_timer.get_elapsed_time());
+    Task* begin_task = m_transient_memory_resource.construct<BeginTask>(*this, end_task, m_timer.get_elapsed_time(), ++m_frame_index);
 
     return { begin_task, end_task };
 }
@@ -1,6 +1,7 @@
 #include "render/buddy_allocator.h"
 
 #include <core/debug/assert.h>
+#include <core/math/scalar.h>
 #include <core/memory/memory_resource.h>
 
 #include <cstddef>
@@ -11,6 +12,7 @@ RenderBuddyAllocator::RenderBuddyAllocator(MemoryResource& memory_resource, uint
     : m_memory_resource(memory_resource)
     , m_leaf_size_log2(leaf_size_log2)
     , m_max_depth(root_size_log2 - leaf_size_log2)
+    , m_free_mask(0)
 {
     KW_ASSERT(root_size_log2 >= leaf_size_log2, "Root size must be not less than leaf size.");
     KW_ASSERT(root_size_log2 - leaf_size_log2 < 27, "Binary tree height must be less than 27.");
@@ -19,23 +21,22 @@ RenderBuddyAllocator::RenderBuddyAllocator(MemoryResource& memory_resource, uint
     m_heads = memory_resource.allocate<uint32_t>(m_max_depth + 1ull);
     m_leafs = memory_resource.allocate<Leaf>(1ull << m_max_depth);
 
-    for (uint32_t i = 0; i < m_max_depth; i++) {
+    for (uint32_t i = 0; i <= m_max_depth; i++) {
         m_heads[i] = END;
     }
 
-    m_heads[m_max_depth] = 0;
-
-    m_leafs[0].depth = m_max_depth;
-    m_leafs[0].next = END;
+    push_node(0, static_cast<uint32_t>(m_max_depth));
 }
 
 RenderBuddyAllocator::RenderBuddyAllocator(RenderBuddyAllocator&& other)
     : m_memory_resource(other.m_memory_resource)
     , m_leaf_size_log2(other.m_leaf_size_log2)
     , m_max_depth(other.m_max_depth)
+    , m_free_mask(other.m_free_mask)
     , m_heads(other.m_heads)
     , m_leafs(other.m_leafs)
 {
+    other.m_free_mask = 0;
     other.m_heads = nullptr;
     other.m_leafs = nullptr;
 }
@@ -51,41 +52,34 @@ uint64_t RenderBuddyAllocator::allocate(uint64_t size, uint64_t alignment) {
     KW_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be power of two.");
     KW_ASSERT(size > 0, "Size must be greater than zero.");
 
-    uint32_t depth = 0;
-    uint64_t allocation_size = 1ull << m_leaf_size_log2;
-
-    // Search for the smallest available node.
-    while (depth < m_max_depth && (allocation_size < size || m_heads[depth] == END)) {
-        depth++;
-        allocation_size <<= 1;
+    uint32_t required_depth = get_depth(size);
+    if (required_depth > m_max_depth) {
+        return INVALID_ALLOCATION;
     }
 
-    // Check whether any node is found.
-    if (depth == m_max_depth && (allocation_size < size || m_heads[m_max_depth] == END)) {
+    // Search for the smallest available node.
+    uint32_t free_mask = m_free_mask & ~((1u << required_depth) - 1);
+    if (free_mask == 0) {
         return INVALID_ALLOCATION;
     }
 
+    uint32_t depth = log2(free_mask & (~free_mask + 1));
+    KW_ASSERT(depth >= required_depth && depth <= m_max_depth);
+
     // Split this node into two smaller nodes recursively.
     uint32_t local_offset = m_heads[depth];
     KW_ASSERT(m_leafs[local_offset].next != BUSY);
     KW_ASSERT(m_leafs[local_offset].depth == depth);
 
     // Remove this node from this depth's linked list.
-    m_heads[depth] = m_leafs[local_offset].next;
+    remove_node(local_offset, depth);
 
     // Split as many nodes as we can.
-    while (depth > 0 && (allocation_size >> 1) >= size) {
-        uint32_t buddy_offset = local_offset ^ (1u << (depth - 1));
-        // Buddy has undefined next and depth.
-
+    while (depth > required_depth) {
         depth--;
-        allocation_size >>= 1;
 
-        // Insert buddy node into the next depth's linked list.
-        uint32_t old_head = m_heads[depth];
-        m_heads[depth] = buddy_offset;
-        m_leafs[buddy_offset].next = old_head;
-        m_leafs[buddy_offset].depth = depth;
+        // Insert buddy node into the next depth's linked list. Buddy has undefined next and depth.
+        push_node(local_offset ^ (1u << depth), depth);
     }
 
     // Mark the node as busy, so it's buddy node doesn't merge into a parent node. Depth could've changed too.
@@ -98,34 +92,15 @@ uint64_t RenderBuddyAllocator::allocate(uint64_t size, uint64_t alignment) {
 
 void RenderBuddyAllocator::deallocate(uint64_t offset) {
     if (offset != INVALID_ALLOCATION) {
-        KW_ASSERT(((offset >> m_leaf_size_log2) << m_leaf_size_log2) == offset);
-
-        uint32_t local_offset = static_cast<uint32_t>(offset >> m_leaf_size_log2);
-        KW_ASSERT(m_leafs[local_offset].next == BUSY);
-
+        uint32_t local_offset = get_local_offset(offset);
         uint32_t depth = m_leafs[local_offset].depth;
-        KW_ASSERT(depth <= m_max_depth);
 
         uint32_t buddy_offset = local_offset ^ (1u << depth);
 
         // Merge as many nodes as we can.
         while (depth < m_max_depth && (m_leafs[buddy_offset].next != BUSY && m_leafs[buddy_offset].depth == depth)) {
             // Buddy offset must be stored in this depth's linked list.
-            uint32_t current_offset = m_heads[depth];
-            KW_ASSERT(current_offset != END);
-
-            // Remove buddy offset from this depth's linked list.
-            if (current_offset == buddy_offset) {
-                // Buddy offset is stored in the head.
-                m_heads[depth] = m_leafs[buddy_offset].next;
-            } else {
-                // Buddy offset is stored somewhere inside linked list.
-                while (m_leafs[current_offset].next != buddy_offset) {
-                    current_offset = m_leafs[current_offset].next;
-                    KW_ASSERT(current_offset != END);
-                }
-                m_leafs[current_offset].next = m_leafs[buddy_offset].next;
-            }
+            remove_node(buddy_offset, depth);
 
             depth++;
 
@@ -136,14 +111,111 @@ void RenderBuddyAllocator::deallocate(uint64_t offset) {
             buddy_offset = local_offset ^ (1u << depth);
         }
 
-        // Depth could've changed.
+        // Store offset in a linked list for other allocations.
+        push_node(local_offset, depth);
+    }
+}
+
+bool RenderBuddyAllocator::reallocate(uint64_t offset, uint64_t size) {
+    KW_ASSERT(size > 0, "Size must be greater than zero.");
+
+    uint32_t local_offset = get_local_offset(offset);
+    uint32_t depth = m_leafs[local_offset].depth;
+
+    uint32_t required_depth = get_depth(size);
+    if (required_depth > m_max_depth) {
+        return false;
+    }
+
+    if (required_depth <= depth) {
+        // Shrink in place by returning the right halves to the free lists. Their buddies are busy, so no merging.
+        while (depth > required_depth) {
+            depth--;
+            push_node(local_offset ^ (1u << depth), depth);
+        }
+
         m_leafs[local_offset].depth = depth;
 
-        // Store offset in a linked list for other allocations.
-        uint32_t old_head = m_heads[depth];
-        m_heads[depth] = local_offset;
-        m_leafs[local_offset].next = old_head;
+        return true;
+    }
+
+    // Check whether this node is a left child on every level up to the required depth and all its buddies are free.
+    for (uint32_t current_depth = depth; current_depth < required_depth; current_depth++) {
+        uint32_t buddy_offset = local_offset ^ (1u << current_depth);
+        if ((local_offset & (1u << current_depth)) != 0 || m_leafs[buddy_offset].next == BUSY || m_leafs[buddy_offset].depth != current_depth) {
+            return false;
+        }
+    }
+
+    // Grow in place by taking all buddies from their free lists.
+    while (depth < required_depth) {
+        remove_node(local_offset ^ (1u << depth), depth);
+        depth++;
+    }
+
+    m_leafs[local_offset].depth = depth;
+
+    return true;
+}
+
+uint32_t RenderBuddyAllocator::get_depth(uint64_t size) const {
+    uint32_t depth = 0;
+    uint64_t allocation_size = 1ull << m_leaf_size_log2;
+
+    while (depth <= m_max_depth && allocation_size < size) {
+        depth++;
+        allocation_size <<= 1;
+    }
+
+    return depth;
+}
+
+void RenderBuddyAllocator::push_node(uint32_t local_offset, uint32_t depth) {
+    uint32_t old_head = m_heads[depth];
+    if (old_head != END) {
+        m_leafs[old_head].previous = local_offset;
+    }
+
+    m_heads[depth] = local_offset;
+    m_leafs[local_offset].next = old_head;
+    m_leafs[local_offset].depth = depth;
+    m_leafs[local_offset].previous = END;
+
+    m_free_mask |= 1u << depth;
+}
+
+void RenderBuddyAllocator::remove_node(uint32_t local_offset, uint32_t depth) {
+    KW_ASSERT(m_leafs[local_offset].next != BUSY);
+    KW_ASSERT(m_leafs[local_offset].depth == depth);
+
+    uint32_t next = m_leafs[local_offset].next;
+    uint32_t previous = m_leafs[local_offset].previous;
+
+    if (previous != END) {
+        m_leafs[previous].next = next;
+    } else {
+        KW_ASSERT(m_heads[depth] == local_offset);
+        m_heads[depth] = next;
     }
+
+    if (next != END) {
+        m_leafs[next].previous = previous;
+    }
+
+    if (m_heads[depth] == END) {
+        m_free_mask &= ~(1u << depth);
+    }
+}
+
+uint32_t RenderBuddyAllocator::get_local_offset(uint64_t offset) const {
+    KW_ASSERT(offset < (1ull << (m_leaf_size_log2 + m_max_depth)));
+    KW_ASSERT(((offset >> m_leaf_size_log2) << m_leaf_size_log2) == offset);
+
+    uint32_t local_offset = static_cast<uint32_t>(offset >> m_leaf_size_log2);
+    KW_ASSERT(m_leafs[local_offset].next == BUSY);
+    KW_ASSERT(m_leafs[local_offset].depth <= m_max_depth);
+
+    return local_offset;
 }
 
 } // namespace kw
@@ -2,6 +2,7 @@
 
 namespace kw {
 
+// Buddy allocator of device memory offsets. See `BuddyMemoryResource` for details.
 class RenderBuddyAllocator {
 public:
     static constexpr uint64_t INVALID_ALLOCATION = UINT64_MAX;
@@ -16,6 +17,10 @@ public:
     uint64_t allocate(uint64_t size, uint64_t alignment);
     void deallocate(uint64_t offset);
 
+    // Resize the given allocation in place. Shrinking always succeeds, growing succeeds only when the buddy nodes are
+    // free. On failure the allocation remains untouched and the caller must allocate new memory and copy the data.
+    bool reallocate(uint64_t offset, uint64_t size);
+
 private:
     static constexpr uint32_t END = 0x07FFFFFF;
     static constexpr uint32_t BUSY = 0x07FFFFFE;
@@ -23,13 +28,29 @@ private:
     struct Leaf {
         uint32_t next : 27;
         uint32_t depth : 5;
+        uint32_t previous;
     };
 
+    // Return the smallest depth that fits the given size or `m_max_depth + 1` if the size is too large.
+    uint32_t get_depth(uint64_t size) const;
+
+    // Insert the given node into the given depth's linked list.
+    void push_node(uint32_t local_offset, uint32_t depth);
+
+    // Remove the given node from the given depth's linked list.
+    void remove_node(uint32_t local_offset, uint32_t depth);
+
+    // Return the local offset of the given allocation.
+    uint32_t get_local_offset(uint64_t offset) const;
+
     MemoryResource& m_memory_resource;
 
     uint64_t m_leaf_size_log2;
     uint64_t m_max_depth;
 
+    // Bit `i` is set when depth `i` has at least one free node.
+    uint32_t m_free_mask;
+
     uint32_t* m_heads;
     Leaf* m_leafs;
 };
@@ -1,4 +1,5 @@
 #include "render/container/container_primitive.h"
+#include "render/acceleration_structure/acceleration_structure_primitive.h"
 #include "render/container/container_manager.h"
 #include "render/container/container_prototype.h"
 #include "render/scene/primitive_reflection.h"
@@ -32,7 +33,12 @@ ContainerPrimitive::ContainerPrimitive(MemoryResource& persistent_memory_resourc
     : Primitive(local_transform)
     , m_children(persistent_memory_resource)
     , m_container_prototype(std::move(container_prototype))
+    , m_scratch_containers(persistent_memory_resource)
+    , m_scratch_acceleration_structure_primitives(persistent_memory_resource)
+    , m_scratch_transforms(persistent_memory_resource)
 {
+    m_primitive_type = PrimitiveType::CONTAINER;
+
     if (m_container_prototype) {
         // If container primitive is already loaded, `container_prototype_loaded` will be called immediately.
         m_container_prototype->subscribe(*this);
@@ -43,7 +49,12 @@ ContainerPrimitive::ContainerPrimitive(const ContainerPrimitive& other)
     : Primitive(other)
     , m_children(*other.m_children.get_allocator().memory_resource)
     , m_container_prototype(other.m_container_prototype)
+    , m_scratch_containers(*other.m_children.get_allocator().memory_resource)
+    , m_scratch_acceleration_structure_primitives(*other.m_children.get_allocator().memory_resource)
+    , m_scratch_transforms(*other.m_children.get_allocator().memory_resource)
 {
+    m_primitive_type = PrimitiveType::CONTAINER;
+
     KW_ASSERT(
         other.m_children.empty(),
         "Copying non-empty containers is not allowed."
@@ -56,10 +67,7 @@ ContainerPrimitive::ContainerPrimitive(const ContainerPrimitive& other)
 }
 
 ContainerPrimitive::~ContainerPrimitive() {
-    // Primitive removes itself from container in destructor.
-    while (!m_children.empty()) {
-        m_children.front().reset();
-    }
+    detach_children();
 
     if (m_container_prototype) {
         // No effect if `container_prototype_loaded` for this primitive was already called.
@@ -173,13 +181,55 @@ UniquePtr<Primitive> ContainerPrimitive::clone(MemoryResource& memory_resource)
 void ContainerPrimitive::global_transform_updated() {
     // Global transform had been updated outside.
 
-    for (UniquePtr<Primitive>& child : m_children) {
-        // Update child's global transform too.
-        child->m_global_transform = child->m_local_transform * m_global_transform;
+    if (m_children.empty()) {
+        return;
+    }
+
+    // Containers are traversed in breadth-first order, so parent's global transform is always computed before its
+    // children's global transforms. Nested containers don't call this method, so scratch vectors are not reentered.
+    Vector<ContainerPrimitive*>& containers = m_scratch_containers;
+    containers.clear();
+    containers.push_back(this);
+
+    Vector<AccelerationStructurePrimitive*>& acceleration_structure_primitives = m_scratch_acceleration_structure_primitives;
+    acceleration_structure_primitives.clear();
+
+    Vector<transform>& transforms = m_scratch_transforms;
+
+    for (size_t i = 0; i < containers.size(); i++) {
+        ContainerPrimitive& container = *containers[i];
+
+        // Compute global transforms of all children at once.
+        transforms.resize(container.m_children.size());
+
+        for (size_t j = 0; j < container.m_children.size(); j++) {
+            transforms[j] = container.m_children[j]->m_local_transform;
+        }
 
-        // Render primitives must update their bounds, container primitives must propagate global transform.
-        child->global_transform_updated();
+        multiply(transforms.data(), container.m_global_transform, transforms.data(), transforms.size());
+
+        for (size_t j = 0; j < container.m_children.size(); j++) {
+            Primitive& child = *container.m_children[j];
+
+            child.m_global_transform = transforms[j];
+
+            // Render primitives must update their bounds, container primitives must propagate global transform.
+            switch (child.m_primitive_type) {
+            case PrimitiveType::ACCELERATION_STRUCTURE:
+                acceleration_structure_primitives.push_back(static_cast<AccelerationStructurePrimitive*>(&child));
+                break;
+            case PrimitiveType::CONTAINER:
+                containers.push_back(static_cast<ContainerPrimitive*>(&child));
+                break;
+            default:
+                child.global_transform_updated();
+                break;
+            }
+        }
     }
+
+    // Update bounds and acceleration structures of all render primitives at once.
+    AccelerationStructurePrimitive::global_transform_updated(acceleration_structure_primitives.data(), acceleration_structure_primitives.size());
 }
 
 void ContainerPrimitive::container_prototype_loaded() {
@@ -188,10 +238,7 @@ void ContainerPrimitive::container_prototype_loaded() {
         "Container prototype is exprected to be loaded."
     );
 
-    // Primitive removes itself from container in destructor.
-    while (!m_children.empty()) {
-        m_children.front().reset();
-    }
+    detach_children();
 
     const Vector<UniquePtr<Primitive>>& primitives = m_container_prototype->get_primitives();
 
@@ -202,6 +249,19 @@ void ContainerPrimitive::container_prototype_loaded() {
     }
 }
 
+void ContainerPrimitive::detach_children() {
+    for (UniquePtr<Primitive>& child : m_children) {
+        // Notify all parents about removed child before it's removed.
+        child_removed(*child);
+
+        // Children are destroyed right away, so unlike `remove_child` their global transforms are not updated.
+        child->m_parent = nullptr;
+    }
+
+    // Children without parent don't call `remove_child` from their destructors.
+    m_children.clear();
+}
+
 void ContainerPrimitive::child_added(Primitive& primitive) {
     if (m_parent != nullptr) {
         m_parent->child_added(primitive);
@@ -1,10 +1,13 @@
 #include "render/debug/cpu_profiler_overlay.h"
 #include "render/debug/imgui_manager.h"
 
+#include <core/concurrency/task_scheduler.h>
 #include <core/containers/set.h>
 #include <core/debug/assert.h>
 #include <core/debug/cpu_profiler.h>
 
+#include <cstdio>
+
 namespace kw {
 
 static const uint32_t CIEDE2000_COLORS[] = {
@@ -44,10 +47,12 @@ static const uint32_t CIEDE2000_COLORS[] = {
 
 CpuProfilerOverlay::CpuProfilerOverlay(const CpuProfilerOverlayDescriptor& descriptor)
     : m_imgui_manager(*descriptor.imgui_manager)
+    , m_task_scheduler(*descriptor.task_scheduler)
     , m_transient_memory_resource(*descriptor.transient_memory_resource)
     , m_offset(0)
 {
     KW_ASSERT(descriptor.imgui_manager != nullptr);
+    KW_ASSERT(descriptor.task_scheduler != nullptr);
     KW_ASSERT(descriptor.transient_memory_resource != nullptr);
 }
 
@@ -137,6 +142,100 @@ void CpuProfilerOverlay::update() {
                 imgui.Dummy(ImVec2(size.x, max_y * 24.f));
             }
         }
+
+        //
+        // Counter history of all frames, the value of the selected frame is shown on top.
+        //
+
+        size_t counter_count = cpu_profiler.get_counter_count();
+        if (counter_count > 0) {
+            imgui.Separator();
+
+            Vector<float> values(cpu_profiler.get_frame_count(), m_transient_memory_resource);
+
+            for (uint32_t counter_id = 0; counter_id < counter_count; counter_id++) {
+                for (size_t i = 0; i < values.size(); i++) {
+                    values[i] = static_cast<float>(cpu_profiler.get_counter_value(counter_id, values.size() - i - 1));
+                }
+
+                char overlay_text[32];
+                std::snprintf(overlay_text, sizeof(overlay_text), "%lld", static_cast<long long>(cpu_profiler.get_counter_value(counter_id, size_t(m_offset))));
+
+                imgui.PlotLines(cpu_profiler.get_counter_name(counter_id), values.data(), static_cast<int>(values.size()), 0, overlay_text, FLT_MAX, FLT_MAX, ImVec2(0.f, 48.f));
+            }
+        }
+
+        //
+        // Task scheduler statistics are only available for the last frame, regardless of offset.
+        //
+
+        const TaskScheduler::Statistics& statistics = m_task_scheduler.get_statistics();
+        if (statistics.frame_duration > 0) {
+            imgui.Separator();
+
+            imgui.Text(
+                "Task scheduler: %llu tasks, average latency %f ms, max latency %f ms, max pending tasks %zu",
+                statistics.task_count,
+                statistics.task_count > 0 ? statistics.total_task_latency / statistics.task_count / 1e6f : 0.f,
+                statistics.max_task_latency / 1e6f,
+                statistics.max_pending_task_count
+            );
+
+            for (size_t i = 0; i < statistics.threads.size(); i++) {
+                const TaskScheduler::ThreadStatistics& thread_statistics = statistics.threads[i];
+
+                if (i + 1 < statistics.threads.size()) {
+                    imgui.Text("Worker Thread %zu:", i);
+                } else {
+                    imgui.Text("Joining Thread:");
+                }
+
+                ImVec2 position = imgui.GetCursorScreenPos();
+
+                struct Lane {
+                    const char* name;
+                    uint64_t duration;
+                    uint32_t color;
+                };
+
+                Lane lanes[] = {
+                    { "Busy", thread_statistics.busy_time, 0xFF3BB300 },
+                    { "Idle", thread_statistics.idle_time, 0xFF00C2E6 },
+                    { "Sleep", thread_statistics.sleep_time, 0xFF808080 },
+                };
+
+                float left = position.x;
+
+                for (const Lane& lane : lanes) {
+                    float width = static_cast<float>(lane.duration) / statistics.frame_duration * size.x;
+
+                    ImVec2 left_top(left, position.y);
+                    ImVec2 right_bottom(left + width, position.y + 24.f);
+
+                    ImVec2 text_size = imgui.CalcTextSize(lane.name);
+
+                    float text_left = left_top.x + std::max((width - text_size.x) / 2.f, 0.f);
+                    float text_top = (left_top.y + right_bottom.y - text_size.y) / 2.f;
+                    ImVec4 text_bounds(left_top.x, left_top.y, right_bottom.x, right_bottom.y);
+
+                    draw_list->AddRectFilled(left_top, right_bottom, lane.color);
+                    draw_list->AddText(nullptr, 0.f, ImVec2(text_left, text_top), 0xFF000000, lane.name, nullptr, 0.f, &text_bounds);
+
+                    if (mouse_position.x >= left_top.x && mouse_position.y >= left_top.y &&
+                        mouse_position.x < right_bottom.x && mouse_position.y < right_bottom.y) {
+                        imgui.SetTooltip(
+                            "%s (%f ms)\n%llu tasks, %llu steals, %llu wake-ups",
+                            lane.name, lane.duration / 1e6f,
+                            thread_statistics.task_count, thread_statistics.steal_count, thread_statistics.wake_up_count
+                        );
+                    }
+
+                    left += width;
+                }
+
+                imgui.Dummy(ImVec2(size.x, 24.f));
+            }
+        }
     }
     imgui.End();
 }
@@ -1,6 +1,7 @@
 #include "render/geometry/geometry.h"
 #include "render/geometry/geometry_listener.h"
 #include "render/geometry/geometry_notifier.h"
+#include "render/geometry/occluder.h"
 #include "render/geometry/skeleton.h"
 
 #include <core/debug/assert.h>
@@ -19,9 +20,11 @@ Geometry::Geometry(GeometryNotifier& geometry_notifier)
 }
     
 Geometry::Geometry(GeometryNotifier& geometry_notifier, VertexBuffer* vertex_buffer, VertexBuffer* skinned_vertex_buffer,
-                   IndexBuffer* index_buffer, uint32_t index_count, const aabbox& bounds, UniquePtr<Skeleton>&& skeleton)
+                   IndexBuffer* index_buffer, uint32_t index_count, const aabbox& bounds, UniquePtr<Skeleton>&& skeleton,
+                   UniquePtr<Occluder>&& occluder)
     : m_geometry_notifier(geometry_notifier)
     , m_skeleton(std::move(skeleton))
+    , m_occluder(std::move(occluder))
     , m_bounds(bounds)
     , m_index_count(index_count)
     , m_index_buffer(index_buffer)
@@ -36,6 +39,7 @@ Geometry::Geometry(GeometryNotifier& geometry_notifier, VertexBuffer* vertex_buf
 Geometry::Geometry(Geometry&& other)
     : m_geometry_notifier(other.m_geometry_notifier)
     , m_skeleton(std::move(other.m_skeleton))
+    , m_occluder(std::move(other.m_occluder))
     , m_bounds(other.m_bounds)
     , m_index_count(other.m_index_count)
     , m_index_buffer(other.m_index_buffer)
@@ -48,8 +52,8 @@ Geometry::Geometry(Geometry&& other)
 
     other.m_vertex_buffer = nullptr;
 
-    // Make `m_vertex_buffer` visible to other threads before any other properties. The `m_skeleton` have been changed
-    // before though (via `std::move`). If that becomes a problem, consider copy constructor instead.
+    // Make `m_vertex_buffer` visible to other threads before any other properties. The `m_skeleton` and `m_occluder`
+    // have been changed before though (via `std::move`). If that becomes a problem, consider copy constructor instead.
     std::atomic_thread_fence(std::memory_order_release);
 
     other.m_skinned_vertex_buffer = nullptr;
@@ -64,6 +68,7 @@ Geometry& Geometry::operator=(Geometry&& other) {
     KW_ASSERT(!is_loaded(), "Move assignemt is allowed only for unloaded geometry.");
 
     m_skeleton = std::move(other.m_skeleton);
+    m_occluder = std::move(other.m_occluder);
     m_bounds = other.m_bounds;
     m_index_count = other.m_index_count;
     m_index_buffer = other.m_index_buffer;
@@ -76,8 +81,8 @@ Geometry& Geometry::operator=(Geometry&& other) {
 
     other.m_vertex_buffer = nullptr;
 
-    // Make `m_vertex_buffer` visible to other threads before any other properties. The `m_skeleton` have been changed
-    // before though (via `std::move`). If that becomes a problem, consider copy constructor instead.
+    // Make `m_vertex_buffer` visible to other threads before any other properties. The `m_skeleton` and `m_occluder`
+    // have been changed before though (via `std::move`). If that becomes a problem, consider copy constructor instead.
     std::atomic_thread_fence(std::memory_order_release);
 
     other.m_skinned_vertex_buffer = nullptr;
@@ -126,6 +131,10 @@ const Skeleton* Geometry::get_skeleton() const {
     return m_skeleton.get();
 }
 
+const Occluder* Geometry::get_occluder() const {
+    return m_occluder.get();
+}
+
 bool Geometry::is_loaded() const {
     return m_vertex_buffer != nullptr;
 }
@@ -1,5 +1,6 @@
 #include "render/geometry/geometry_manager.h"
 #include "render/geometry/geometry.h"
+#include "render/geometry/occluder.h"
 #include "render/geometry/skeleton.h"
 #include "render/render.h"
 
@@ -100,6 +101,12 @@ public:
             m_manager.m_render.upload_vertex_buffer(skinned_vertex_buffer, skinned_vertices.data(), sizeof(Geometry::SkinnedVertex) * skinned_vertices.size());
         }
 
+        // Skinned geometry is never an occluder, because its triangles are moved by animation. Geometry doesn't know its
+        // material, so occlusion culler also checks `Material::is_occluder` of the primitive before rasterizing this.
+        bool is_occluder = skinned_vertex_count == 0 && index_count / 3 <= m_manager.m_max_occluder_triangle_count;
+
+        Vector<uint32_t> occluder_indices(m_manager.m_persistent_memory_resource);
+
         IndexBuffer* index_buffer;
 
         if (vertex_count < UINT16_MAX) {
@@ -110,6 +117,10 @@ public:
             KW_ASSERT(index_buffer != nullptr);
 
             m_manager.m_render.upload_index_buffer(index_buffer, indices.data(), sizeof(uint16_t) * indices.size());
+
+            if (is_occluder) {
+                occluder_indices.assign(indices.begin(), indices.end());
+            }
         } else {
             Vector<uint32_t> indices(index_count, m_manager.m_transient_memory_resource);
             KW_ERROR(reader.read_le<uint32_t>(indices.data(), indices.size()), "Failed to read geometry indices.");
@@ -118,6 +129,27 @@ public:
             KW_ASSERT(index_buffer != nullptr);
 
             m_manager.m_render.upload_index_buffer(index_buffer, indices.data(), sizeof(uint32_t) * indices.size());
+
+            if (is_occluder) {
+                occluder_indices.assign(indices.begin(), indices.end());
+            }
+        }
+
+        UniquePtr<Occluder> occluder;
+
+        if (is_occluder && index_count > 0) {
+            Vector<float3> occluder_vertices(m_manager.m_persistent_memory_resource);
+            occluder_vertices.reserve(vertices.size());
+
+            for (const Geometry::Vertex& vertex : vertices) {
+                occluder_vertices.push_back(vertex.position);
+            }
+
+            for (uint32_t index : occluder_indices) {
+                KW_ERROR(index < vertex_count, "Invalid geometry index.");
+            }
+
+            occluder = allocate_unique<Occluder>(m_manager.m_persistent_memory_resource, std::move(occluder_vertices), std::move(occluder_indices));
         }
 
         UniquePtr<Skeleton> skeleton;
@@ -151,7 +183,7 @@ public:
             );
         }
 
-        m_geometry = Geometry(m_manager.m_geometry_notifier, vertex_buffer, skinned_vertex_buffer, index_buffer, index_count, bounds, std::move(skeleton));
+        m_geometry = Geometry(m_manager.m_geometry_notifier, vertex_buffer, skinned_vertex_buffer, index_buffer, index_count, bounds, std::move(skeleton), std::move(occluder));
 
         m_manager.m_geometry_notifier.notify(m_geometry);
     }
@@ -230,6 +262,7 @@ GeometryManager::GeometryManager(const GeometryManagerDescriptor& descriptor)
     , m_task_scheduler(*descriptor.task_scheduler)
     , m_persistent_memory_resource(*descriptor.persistent_memory_resource)
     , m_transient_memory_resource(*descriptor.transient_memory_resource)
+    , m_max_occluder_triangle_count(descriptor.max_occluder_triangle_count)
     , m_geometry(*descriptor.persistent_memory_resource)
     , m_pending_geometry(*descriptor.persistent_memory_resource)
     , m_geometry_notifier(*descriptor.persistent_memory_resource)
@@ -209,22 +209,18 @@ UniquePtr<Primitive> GeometryPrimitive::clone(MemoryResource& memory_resource) c
     return static_pointer_cast<Primitive>(allocate_unique<GeometryPrimitive>(memory_resource, *this));
 }
 
-void GeometryPrimitive::global_transform_updated() {
+void GeometryPrimitive::update_bounds() {
     if (m_geometry && m_geometry->is_loaded()) {
         m_bounds = m_geometry->get_bounds() * get_global_transform();
     }
-
-    AccelerationStructurePrimitive::global_transform_updated();
 }
 
 void GeometryPrimitive::geometry_loaded() {
     // This method must be called from geometry manager, which knows for sure that geometry is loaded.
     KW_ASSERT(m_geometry && m_geometry->is_loaded(), "Geometry must be loaded.");
 
-    m_bounds = m_geometry->get_bounds() * get_global_transform();
-
-    // Update acceleration structure's node.
-    AccelerationStructurePrimitive::global_transform_updated();
+    // Update bounds and acceleration structure's node.
+    global_transform_updated();
 }
 
 } // namespace kw
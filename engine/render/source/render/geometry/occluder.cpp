@@ -0,0 +1,26 @@
+#include "render/geometry/occluder.h"
+
+#include <core/debug/assert.h>
+
+namespace kw {
+
+Occluder::Occluder(Vector<float3>&& vertices, Vector<uint32_t>&& indices)
+    : m_vertices(std::move(vertices))
+    , m_indices(std::move(indices))
+{
+    KW_ASSERT(m_indices.size() % 3 == 0, "Invalid occluder index count.");
+}
+
+const Vector<float3>& Occluder::get_vertices() const {
+    return m_vertices;
+}
+
+const Vector<uint32_t>& Occluder::get_indices() const {
+    return m_indices;
+}
+
+size_t Occluder::get_triangle_count() const {
+    return m_indices.size() / 3;
+}
+
+} // namespace kw
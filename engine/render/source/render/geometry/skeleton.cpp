@@ -3,8 +3,15 @@
 #include <core/debug/assert.h>
 #include <core/memory/malloc_memory_resource.h>
 
+#include <algorithm>
+#include <numeric>
+
 namespace kw {
 
+// Joints with fewer levels of descendants are not animated on distant levels of detail. Leaves and their parents are
+// usually finger tips, toes and facial joints, which are too small to notice from distance.
+static constexpr uint32_t LOD_JOINT_MIN_HEIGHT = 2;
+
 // `MallocMemoryResource` is required here because of MSVC's STL debug iterators.
 // It allocates some stuff in constructor (only in debug though).
 Skeleton::Skeleton()
@@ -12,6 +19,8 @@ Skeleton::Skeleton()
     , m_inverse_bind_matrices(MallocMemoryResource::instance())
     , m_bind_matrices(MallocMemoryResource::instance())
     , m_joint_mapping(MallocMemoryResource::instance())
+    , m_hierarchy_order(MallocMemoryResource::instance())
+    , m_lod_joints(MallocMemoryResource::instance())
 {
 }
 
@@ -21,10 +30,46 @@ Skeleton::Skeleton(Vector<uint32_t>&& parent_joints, Vector<float4x4>&& inverse_
     , m_inverse_bind_matrices(std::move(inverse_bind_matrices))
     , m_bind_matrices(std::move(bind_matrices))
     , m_joint_mapping(std::move(joint_mapping))
+    , m_hierarchy_order(*m_parent_joints.get_allocator().memory_resource)
+    , m_lod_joints(*m_parent_joints.get_allocator().memory_resource)
 {
     KW_ASSERT(m_parent_joints.size() == m_inverse_bind_matrices.size(), "Mismatching skeleton data.");
     KW_ASSERT(m_parent_joints.size() == m_bind_matrices.size(), "Mismatching skeleton data.");
     KW_ASSERT(m_parent_joints.size() == m_joint_mapping.size(), "Mismatching skeleton data.");
+
+    uint32_t joint_count = static_cast<uint32_t>(m_parent_joints.size());
+
+    Vector<uint32_t> depths(joint_count, 0, *m_parent_joints.get_allocator().memory_resource);
+    for (uint32_t i = 0; i < joint_count; i++) {
+        for (uint32_t parent_joint = m_parent_joints[i]; parent_joint != UINT32_MAX; parent_joint = m_parent_joints[parent_joint]) {
+            KW_ASSERT(parent_joint < joint_count, "Invalid parent joint.");
+            KW_ASSERT(depths[i] < joint_count, "Skeleton hierarchy must not have cycles.");
+            depths[i]++;
+        }
+    }
+
+    // Joint indices don't have to be sorted by hierarchy, so the order is computed once here rather than on every
+    // skeleton pose update. Joints of the same depth keep their relative order.
+    m_hierarchy_order.resize(joint_count);
+    std::iota(m_hierarchy_order.begin(), m_hierarchy_order.end(), 0U);
+    std::stable_sort(m_hierarchy_order.begin(), m_hierarchy_order.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return depths[lhs] < depths[rhs];
+    });
+
+    // Children go after their parents in hierarchy order, so the reverse order visits children first.
+    Vector<uint32_t> heights(joint_count, 0, *m_parent_joints.get_allocator().memory_resource);
+    for (auto it = m_hierarchy_order.rbegin(); it != m_hierarchy_order.rend(); ++it) {
+        uint32_t parent_joint = m_parent_joints[*it];
+        if (parent_joint != UINT32_MAX) {
+            heights[parent_joint] = std::max(heights[parent_joint], heights[*it] + 1);
+        }
+    }
+
+    for (uint32_t i = 0; i < joint_count; i++) {
+        if (m_parent_joints[i] == UINT32_MAX || heights[i] >= LOD_JOINT_MIN_HEIGHT) {
+            m_lod_joints.push_back(i);
+        }
+    }
 }
 
 size_t Skeleton::get_joint_count() const {
@@ -60,6 +105,14 @@ const String& Skeleton::get_joint_name(uint32_t joint_index) const {
     return EMPTY_STRING;
 }
 
+const Vector<uint32_t>& Skeleton::get_hierarchy_order() const {
+    return m_hierarchy_order;
+}
+
+const Vector<uint32_t>& Skeleton::get_lod_joints() const {
+    return m_lod_joints;
+}
+
 uint32_t Skeleton::get_joint_index(const String& name) const {
     auto it = m_joint_mapping.find(name);
     if (it != m_joint_mapping.end()) {
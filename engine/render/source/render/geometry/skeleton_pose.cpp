@@ -1,21 +1,135 @@
 #include "render/geometry/skeleton_pose.h"
 #include "render/geometry/skeleton.h"
 
+#include <core/debug/assert.h>
+#include <core/math/simd.h>
+
 namespace kw {
 
+#ifdef KW_SIMD
+// Same as `result[i] = float4x4(transforms[i])` for four transforms.
+static void convert_transforms(const transform* transforms, float4x4* result) {
+    using simd::vfloat4;
+    using simd::vfloat4x4;
+
+    static_assert(sizeof(transform) == sizeof(float) * 10, "Transform is expected to be tightly packed.");
+
+    // Ten floats of each transform are loaded as three overlapping vectors `data[0..4]`, `data[4..8]` and
+    // `data[6..10]`.
+    const float* data = reinterpret_cast<const float*>(transforms);
+    vfloat4x4 a = simd::transpose(vfloat4x4{ { simd::load(data), simd::load(data + 10), simd::load(data + 20), simd::load(data + 30) } });
+    vfloat4x4 b = simd::transpose(vfloat4x4{ { simd::load(data + 4), simd::load(data + 14), simd::load(data + 24), simd::load(data + 34) } });
+    vfloat4x4 c = simd::transpose(vfloat4x4{ { simd::load(data + 6), simd::load(data + 16), simd::load(data + 26), simd::load(data + 36) } });
+
+    vfloat4 translation_x = a.rows[0];
+    vfloat4 translation_y = a.rows[1];
+    vfloat4 translation_z = a.rows[2];
+    vfloat4 rotation_x = a.rows[3];
+    vfloat4 rotation_y = b.rows[0];
+    vfloat4 rotation_z = b.rows[1];
+    vfloat4 rotation_w = b.rows[2];
+    vfloat4 scale_x = b.rows[3];
+    vfloat4 scale_y = c.rows[2];
+    vfloat4 scale_z = c.rows[3];
+
+    vfloat4 zero = simd::splat(0.f);
+    vfloat4 one = simd::splat(1.f);
+    vfloat4 two = simd::splat(2.f);
+
+    // See `float4x4(const transform&)`.
+    vfloat4 xx = simd::mul(rotation_x, rotation_x);
+    vfloat4 xy = simd::mul(rotation_x, rotation_y);
+    vfloat4 xz = simd::mul(rotation_x, rotation_z);
+    vfloat4 xw = simd::mul(rotation_x, rotation_w);
+    vfloat4 yy = simd::mul(rotation_y, rotation_y);
+    vfloat4 yz = simd::mul(rotation_y, rotation_z);
+    vfloat4 yw = simd::mul(rotation_y, rotation_w);
+    vfloat4 zz = simd::mul(rotation_z, rotation_z);
+    vfloat4 zw = simd::mul(rotation_z, rotation_w);
+
+    vfloat4 scale_x2 = simd::mul(two, scale_x);
+    vfloat4 scale_y2 = simd::mul(two, scale_y);
+    vfloat4 scale_z2 = simd::mul(two, scale_z);
+
+    vfloat4 m00 = simd::mul(scale_x, simd::nmadd(two, simd::add(yy, zz), one));
+    vfloat4 m01 = simd::mul(scale_x2, simd::add(xy, zw));
+    vfloat4 m02 = simd::mul(scale_x2, simd::sub(xz, yw));
+    vfloat4 m10 = simd::mul(scale_y2, simd::sub(xy, zw));
+    vfloat4 m11 = simd::mul(scale_y, simd::nmadd(two, simd::add(xx, zz), one));
+    vfloat4 m12 = simd::mul(scale_y2, simd::add(yz, xw));
+    vfloat4 m20 = simd::mul(scale_z2, simd::add(xz, yw));
+    vfloat4 m21 = simd::mul(scale_z2, simd::sub(yz, xw));
+    vfloat4 m22 = simd::mul(scale_z, simd::nmadd(two, simd::add(xx, yy), one));
+
+    // Back to array of structures, `row_i.rows[j]` is the i-th row of the j-th matrix.
+    vfloat4x4 row_0 = simd::transpose(vfloat4x4{ { m00, m01, m02, zero } });
+    vfloat4x4 row_1 = simd::transpose(vfloat4x4{ { m10, m11, m12, zero } });
+    vfloat4x4 row_2 = simd::transpose(vfloat4x4{ { m20, m21, m22, zero } });
+    vfloat4x4 row_3 = simd::transpose(vfloat4x4{ { translation_x, translation_y, translation_z, one } });
+
+    for (size_t i = 0; i < 4; i++) {
+        simd::store4x4(result[i].begin(), vfloat4x4{ { row_0.rows[i], row_1.rows[i], row_2.rows[i], row_3.rows[i] } });
+    }
+}
+
+// Same as `lhs * rhs` for an affine row of `lhs`, whose last component is zero.
+static simd::vfloat4 multiply_affine(simd::vfloat4 lhs, const simd::vfloat4x4& rhs) {
+    simd::vfloat4 result = simd::mul(simd::broadcast<0>(lhs), rhs.rows[0]);
+    result = simd::madd(simd::broadcast<1>(lhs), rhs.rows[1], result);
+    return simd::madd(simd::broadcast<2>(lhs), rhs.rows[2], result);
+}
+
+// Same as `lhs * rhs` for affine matrices, whose last column is `(0, 0, 0, 1)`. The last column of `lhs` is ignored.
+// Not inlining it passes the result matrix through memory, which is slower than a full matrix multiplication.
+static inline simd::vfloat4x4 multiply_affine(const simd::vfloat4x4& lhs, const simd::vfloat4x4& rhs) {
+    return simd::vfloat4x4{ {
+        multiply_affine(lhs.rows[0], rhs),
+        multiply_affine(lhs.rows[1], rhs),
+        multiply_affine(lhs.rows[2], rhs),
+        simd::add(multiply_affine(lhs.rows[3], rhs), rhs.rows[3]),
+    } };
+}
+#else
+// Same as `lhs * rhs` for affine matrices, whose last column is `(0, 0, 0, 1)`. The last column of `lhs` is ignored.
+static float4x4 multiply_affine(const float4x4& lhs, const float4x4& rhs) {
+    float4x4 result;
+
+    for (size_t i = 0; i < 3; i++) {
+        result[i] = lhs[i][0] * rhs[0] + lhs[i][1] * rhs[1] + lhs[i][2] * rhs[2];
+    }
+
+    result[3] = lhs[3][0] * rhs[0] + lhs[3][1] * rhs[1] + lhs[3][2] * rhs[2] + rhs[3];
+
+    return result;
+}
+#endif // KW_SIMD
+
 SkeletonPose::SkeletonPose(MemoryResource& memory_resource)
-    : m_joint_space_matrices(memory_resource)
+    : m_joint_space_transforms(memory_resource)
+    , m_hierarchy_matrices(memory_resource)
     , m_model_space_matrices(memory_resource)
 {
 }
 
-const Vector<float4x4>& SkeletonPose::get_joint_space_matrices() const {
-    return m_joint_space_matrices;
+const Vector<transform>& SkeletonPose::get_joint_space_transforms() const {
+    return m_joint_space_transforms;
+}
+
+Vector<transform>& SkeletonPose::get_joint_space_transforms() {
+    return m_joint_space_transforms;
 }
 
-void SkeletonPose::set_joint_space_matrix(uint32_t joint_index, const float4x4& matrix) {
-    m_joint_space_matrices.resize(std::max(m_joint_space_matrices.size(), joint_index + 1ull));
-    m_joint_space_matrices[joint_index] = matrix;
+void SkeletonPose::set_joint_space_transform(uint32_t joint_index, const transform& value) {
+    KW_ASSERT(joint_index < m_joint_space_transforms.size(), "Invalid joint index.");
+    m_joint_space_transforms[joint_index] = value;
+}
+
+void SkeletonPose::set_bind_pose(const Skeleton& skeleton) {
+    m_joint_space_transforms.resize(skeleton.get_joint_count());
+
+    for (uint32_t i = 0; i < m_joint_space_transforms.size(); i++) {
+        m_joint_space_transforms[i] = transform(skeleton.get_bind_matrix(i));
+    }
 }
 
 const Vector<float4x4>& SkeletonPose::get_model_space_matrices() const {
@@ -23,23 +137,55 @@ const Vector<float4x4>& SkeletonPose::get_model_space_matrices() const {
 }
 
 void SkeletonPose::build_model_space_matrices(const Skeleton& skeleton) {
-    m_model_space_matrices.clear();
-    m_model_space_matrices.insert(m_model_space_matrices.end(), m_joint_space_matrices.begin(), m_joint_space_matrices.end());
+    KW_ASSERT(m_joint_space_transforms.size() == skeleton.get_joint_count(), "Mismatching skeleton pose and skeleton.");
+
+    size_t joint_count = m_joint_space_transforms.size();
+
+    // Both are no-op unless the skeleton changes.
+    m_hierarchy_matrices.resize(joint_count);
+    m_model_space_matrices.resize(joint_count);
+
+    size_t converted_count = 0;
+
+#ifdef KW_SIMD
+    for (; converted_count + 4 <= joint_count; converted_count += 4) {
+        convert_transforms(m_joint_space_transforms.data() + converted_count, m_hierarchy_matrices.data() + converted_count);
+    }
+#endif // KW_SIMD
+
+    for (; converted_count < joint_count; converted_count++) {
+        m_hierarchy_matrices[converted_count] = float4x4(m_joint_space_transforms[converted_count]);
+    }
+
+    // Parents are always processed before their children, so their matrices are already in model space. Inverse bind
+    // matrix is applied in the same pass while the model space matrix is still in cache.
+    for (uint32_t joint_index : skeleton.get_hierarchy_order()) {
+        uint32_t parent_joint = skeleton.get_parent_joint(joint_index);
+
+#ifdef KW_SIMD
+        simd::vfloat4x4 hierarchy_matrix = simd::load4x4(m_hierarchy_matrices[joint_index].begin());
 
-    for (uint32_t i = 0; i < m_model_space_matrices.size(); i++) {
-        uint32_t parent_joint = skeleton.get_parent_joint(i);
         if (parent_joint != UINT32_MAX) {
-            m_model_space_matrices[i] *= m_model_space_matrices[parent_joint];
+            hierarchy_matrix = multiply_affine(hierarchy_matrix, simd::load4x4(m_hierarchy_matrices[parent_joint].begin()));
+            simd::store4x4(m_hierarchy_matrices[joint_index].begin(), hierarchy_matrix);
+        }
+
+        simd::vfloat4x4 inverse_bind_matrix = simd::load4x4(skeleton.get_inverse_bind_matrix(joint_index).begin());
+        simd::store4x4(m_model_space_matrices[joint_index].begin(), multiply_affine(inverse_bind_matrix, hierarchy_matrix));
+#else
+        float4x4& hierarchy_matrix = m_hierarchy_matrices[joint_index];
+
+        if (parent_joint != UINT32_MAX) {
+            hierarchy_matrix = multiply_affine(hierarchy_matrix, m_hierarchy_matrices[parent_joint]);
         }
-    }
 
-    for (uint32_t i = 0; i < m_model_space_matrices.size(); i++) {
-        m_model_space_matrices[i] = skeleton.get_inverse_bind_matrix(i) * m_model_space_matrices[i];
+        m_model_space_matrices[joint_index] = multiply_affine(skeleton.get_inverse_bind_matrix(joint_index), hierarchy_matrix);
+#endif // KW_SIMD
     }
 }
 
 size_t SkeletonPose::get_joint_count() const {
-    return m_joint_space_matrices.size();
+    return m_joint_space_transforms.size();
 }
 
 } // namespace kw
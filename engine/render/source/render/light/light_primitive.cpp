@@ -42,10 +42,8 @@ void LightPrimitive::set_power(float value) {
     }
 }
 
-void LightPrimitive::global_transform_updated() {
+void LightPrimitive::update_bounds() {
     m_bounds = aabbox(get_global_translation(), float3(std::sqrt(m_power * 50.f)));
-
-    AccelerationStructurePrimitive::global_transform_updated();
 }
 
 } // namespace kw
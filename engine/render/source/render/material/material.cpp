@@ -13,19 +13,22 @@ Material::Material()
     , m_is_shadow(false)
     , m_is_skinned(false)
     , m_is_particle(false)
+    , m_is_occluder(false)
 {
 }
 
 Material::Material(SharedPtr<GraphicsPipeline*> graphics_pipeline, Vector<SharedPtr<Texture*>>&& textures,
-                   bool is_shadow, bool is_skinned, bool is_particle)
+                   bool is_shadow, bool is_skinned, bool is_particle, bool is_occluder)
     : m_graphics_pipeline(std::move(graphics_pipeline))
     , m_textures(std::move(textures))
     , m_is_shadow(is_shadow)
     , m_is_skinned(is_skinned)
     , m_is_particle(is_particle)
+    , m_is_occluder(is_occluder)
 {
     KW_ASSERT(m_graphics_pipeline, "Invalid graphics pipeline.");
     KW_ASSERT(!m_is_skinned || !is_particle, "Skinned particle is not allowed.");
+    KW_ASSERT(!m_is_occluder || (!is_shadow && !is_skinned && !is_particle), "Only solid geometry materials can be occluders.");
 }
 
 const SharedPtr<GraphicsPipeline*>& Material::get_graphics_pipeline() const {
@@ -52,6 +55,10 @@ bool Material::is_particle() const {
     return m_is_particle;
 }
 
+bool Material::is_occluder() const {
+    return m_is_occluder;
+}
+
 bool Material::is_loaded() const {
     return m_graphics_pipeline && *m_graphics_pipeline != nullptr;
 }
@@ -347,6 +347,7 @@ public:
         BooleanNode& is_shadow = material_descriptor["is_shadow"].as<BooleanNode>();
         BooleanNode& is_skinned = material_descriptor["is_skinned"].as<BooleanNode>();
         BooleanNode& is_particle = material_descriptor["is_particle"].as<BooleanNode>();
+        BooleanNode& is_occluder = material_descriptor["is_occluder"].as<BooleanNode>();
 
         //
         // Load material graphics pipeline.
@@ -380,7 +381,7 @@ public:
         //
 
         m_material = Material(graphics_pipeline_context, std::move(material_textures),
-                              is_shadow.get_value(), is_skinned.get_value(), is_particle.get_value());
+                              is_shadow.get_value(), is_skinned.get_value(), is_particle.get_value(), is_occluder.get_value());
     }
 
     const char* get_name() const override {
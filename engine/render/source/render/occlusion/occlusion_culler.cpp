@@ -0,0 +1,551 @@
+#include "render/occlusion/occlusion_culler.h"
+#include "render/camera/camera_manager.h"
+#include "render/geometry/geometry.h"
+#include "render/geometry/geometry_primitive.h"
+#include "render/geometry/occluder.h"
+#include "render/material/material.h"
+#include "render/scene/scene.h"
+
+#include <core/concurrency/parallel_for_task.h>
+#include <core/concurrency/task.h>
+#include <core/concurrency/task_scheduler.h>
+#include <core/debug/assert.h>
+#include <core/debug/cpu_profiler.h>
+#include <core/math/simd.h>
+#include <core/memory/memory_resource.h>
+
+#include <cmath>
+#include <limits>
+
+namespace kw {
+
+constexpr uint32_t TILE_SIZE = 32;
+
+// Levels of the depth pyramid that are built by tile workers, the rest is built by the end task.
+constexpr uint32_t TILE_LEVEL_COUNT = 6;
+
+// Triangles with smaller doubled screen space area are not rasterized.
+constexpr float MIN_TRIANGLE_AREA = 1e-6f;
+
+class OcclusionCuller::WorkerTask : public ParallelForTask {
+public:
+    WorkerTask(OcclusionCuller& occlusion_culler, Task* end_task)
+        : ParallelForTask(occlusion_culler.m_task_scheduler, occlusion_culler.m_transient_memory_resource, end_task,
+                          occlusion_culler.m_tiles.size(), 1)
+        , m_occlusion_culler(occlusion_culler)
+    {
+    }
+
+    void run(size_t begin, size_t end) override {
+        KW_CPU_PROFILER("Occluder Rasterization");
+
+        for (size_t i = begin; i < end; i++) {
+            m_occlusion_culler.rasterize_tile(static_cast<uint32_t>(i));
+        }
+    }
+
+    const char* get_name() const override {
+        return "Occlusion Culler Worker";
+    }
+
+private:
+    OcclusionCuller& m_occlusion_culler;
+};
+
+class OcclusionCuller::BeginTask : public Task {
+public:
+    BeginTask(OcclusionCuller& occlusion_culler, Task* end_task)
+        : m_occlusion_culler(occlusion_culler)
+        , m_end_task(end_task)
+    {
+    }
+
+    void run() override {
+        const Camera& camera = m_occlusion_culler.m_camera_manager.get_occlusion_camera();
+
+        m_occlusion_culler.m_view_projection = camera.get_view_projection_matrix();
+        m_occlusion_culler.m_z_near = camera.get_z_near();
+        m_occlusion_culler.m_occluder_count = 0;
+        m_occlusion_culler.m_tested_primitive_count = 0;
+        m_occlusion_culler.m_culled_primitive_count = 0;
+        m_occlusion_culler.m_triangles.clear();
+
+        for (Vector<uint32_t>& tile : m_occlusion_culler.m_tiles) {
+            tile.clear();
+        }
+
+        if (!m_occlusion_culler.m_is_enabled) {
+            return;
+        }
+
+        {
+            KW_CPU_PROFILER("Occluder Setup");
+
+            Vector<GeometryPrimitive*> primitives(m_occlusion_culler.m_transient_memory_resource);
+            m_occlusion_culler.m_scene.query_geometry(camera.get_frustum(), primitives);
+
+            // Score is the square of the approximate screen size.
+            Vector<Pair<float, GeometryPrimitive*>> occluders(m_occlusion_culler.m_transient_memory_resource);
+            occluders.reserve(primitives.size());
+
+            for (GeometryPrimitive* primitive : primitives) {
+                const SharedPtr<Geometry>& geometry = primitive->get_geometry();
+                const SharedPtr<Material>& material = primitive->get_material();
+                if (geometry && geometry->is_loaded() && geometry->get_occluder() != nullptr &&
+                    material && material->is_loaded() && material->is_occluder()) {
+                    const aabbox& bounds = primitive->get_bounds();
+                    float distance = std::max(length(bounds.center - camera.get_translation()), camera.get_z_near());
+                    occluders.emplace_back(square_length(bounds.extent) / (distance * distance), primitive);
+                }
+            }
+
+            if (occluders.size() > m_occlusion_culler.m_max_occluder_count) {
+                auto comparator = [](const Pair<float, GeometryPrimitive*>& lhs, const Pair<float, GeometryPrimitive*>& rhs) {
+                    return lhs.first > rhs.first;
+                };
+
+                std::nth_element(occluders.begin(), occluders.begin() + m_occlusion_culler.m_max_occluder_count, occluders.end(), comparator);
+                occluders.resize(m_occlusion_culler.m_max_occluder_count);
+            }
+
+            for (const Pair<float, GeometryPrimitive*>& occluder : occluders) {
+                m_occlusion_culler.add_occluder(*occluder.second, *occluder.second->get_geometry()->get_occluder());
+            }
+
+            m_occlusion_culler.m_occluder_count = static_cast<uint32_t>(occluders.size());
+
+            KW_CPU_PROFILER_COUNTER("Occluders", occluders.size());
+        }
+
+        WorkerTask* worker_task = m_occlusion_culler.m_transient_memory_resource.construct<WorkerTask>(m_occlusion_culler, m_end_task);
+        KW_ASSERT(worker_task != nullptr);
+
+        m_occlusion_culler.m_task_scheduler.enqueue_task(m_occlusion_culler.m_transient_memory_resource, worker_task);
+    }
+
+    const char* get_name() const override {
+        return "Occlusion Culler Begin";
+    }
+
+private:
+    OcclusionCuller& m_occlusion_culler;
+    Task* m_end_task;
+};
+
+class OcclusionCuller::EndTask : public Task {
+public:
+    EndTask(OcclusionCuller& occlusion_culler)
+        : m_occlusion_culler(occlusion_culler)
+    {
+    }
+
+    void run() override {
+        if (m_occlusion_culler.m_is_enabled) {
+            KW_CPU_PROFILER("Depth Pyramid");
+
+            m_occlusion_culler.build_depth_pyramid();
+        }
+    }
+
+    const char* get_name() const override {
+        return "Occlusion Culler End";
+    }
+
+private:
+    OcclusionCuller& m_occlusion_culler;
+};
+
+OcclusionCuller::OcclusionCuller(const OcclusionCullerDescriptor& descriptor)
+    : m_scene(*descriptor.scene)
+    , m_camera_manager(*descriptor.camera_manager)
+    , m_task_scheduler(*descriptor.task_scheduler)
+    , m_persistent_memory_resource(*descriptor.persistent_memory_resource)
+    , m_transient_memory_resource(*descriptor.transient_memory_resource)
+    , m_width(descriptor.width)
+    , m_height(descriptor.height)
+    , m_tile_count_x(descriptor.width / TILE_SIZE)
+    , m_tile_count_y(descriptor.height / TILE_SIZE)
+    , m_max_occluder_count(descriptor.max_occluder_count)
+    , m_is_enabled(true)
+    , m_depth_pyramid(*descriptor.persistent_memory_resource)
+    , m_level_offsets(*descriptor.persistent_memory_resource)
+    , m_triangles(*descriptor.persistent_memory_resource)
+    , m_tiles(*descriptor.persistent_memory_resource)
+    , m_clip_vertices(*descriptor.persistent_memory_resource)
+    , m_z_near(0.f)
+    , m_occluder_count(0)
+    , m_tested_primitive_count(0)
+    , m_culled_primitive_count(0)
+{
+    KW_ASSERT(descriptor.scene != nullptr);
+    KW_ASSERT(descriptor.camera_manager != nullptr);
+    KW_ASSERT(descriptor.task_scheduler != nullptr);
+    KW_ASSERT(descriptor.width > 0 && descriptor.width % TILE_SIZE == 0, "Depth buffer width must be a multiple of %u.", TILE_SIZE);
+    KW_ASSERT(descriptor.height > 0 && descriptor.height % TILE_SIZE == 0, "Depth buffer height must be a multiple of %u.", TILE_SIZE);
+    KW_ASSERT(descriptor.persistent_memory_resource != nullptr);
+    KW_ASSERT(descriptor.transient_memory_resource != nullptr);
+
+    size_t offset = 0;
+
+    for (uint32_t level = 0; level == 0 || get_level_width(level - 1) > 1 || get_level_height(level - 1) > 1; level++) {
+        m_level_offsets.push_back(offset);
+        offset += static_cast<size_t>(get_level_width(level)) * get_level_height(level);
+    }
+
+    // Nothing is occluded until the first frame is rasterized.
+    m_depth_pyramid.resize(offset, 0.f);
+
+    m_tiles.resize(static_cast<size_t>(m_tile_count_x) * m_tile_count_y, Vector<uint32_t>(*descriptor.persistent_memory_resource));
+}
+
+bool OcclusionCuller::is_occluded(const aabbox& bounds) const {
+    if (!m_is_enabled) {
+        return false;
+    }
+
+    // Corners of the box in clip space are `center ± extent_x ± extent_y ± extent_z`.
+    float4 center = float4(bounds.center, 1.f) * m_view_projection;
+    float4 extent_x = m_view_projection[0] * bounds.extent.x;
+    float4 extent_y = m_view_projection[1] * bounds.extent.y;
+    float4 extent_z = m_view_projection[2] * bounds.extent.z;
+
+    float min_x = std::numeric_limits<float>::infinity();
+    float min_y = std::numeric_limits<float>::infinity();
+    float max_x = -std::numeric_limits<float>::infinity();
+    float max_y = -std::numeric_limits<float>::infinity();
+    float max_depth = 0.f;
+
+    for (uint32_t i = 0; i < 8; i++) {
+        float4 corner = center;
+        corner += (i & 1) ? extent_x : -extent_x;
+        corner += (i & 2) ? extent_y : -extent_y;
+        corner += (i & 4) ? extent_z : -extent_z;
+
+        // Boxes intersecting the near plane are never occluded.
+        if (corner.w < m_z_near) {
+            return false;
+        }
+
+        float depth = 1.f / corner.w;
+        float x = (corner.x * depth * 0.5f + 0.5f) * m_width;
+        float y = (0.5f - corner.y * depth * 0.5f) * m_height;
+
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+        max_depth = std::max(max_depth, depth);
+    }
+
+    if (max_x < 0.f || max_y < 0.f || min_x >= m_width || min_y >= m_height) {
+        // Entirely outside of the screen.
+        return false;
+    }
+
+    // Only pixel centers are rasterized, so an occluder covering a pixel's center may not cover the entire pixel.
+    // Neighbouring pixels are tested too, so boxes behind silhouettes are not culled. Gaps between occluders that
+    // are smaller than a pixel are considered closed though.
+    uint32_t x0 = static_cast<uint32_t>(std::max(min_x - 1.f, 0.f));
+    uint32_t y0 = static_cast<uint32_t>(std::max(min_y - 1.f, 0.f));
+    uint32_t x1 = static_cast<uint32_t>(std::min(max_x + 1.f, m_width - 1.f));
+    uint32_t y1 = static_cast<uint32_t>(std::min(max_y + 1.f, m_height - 1.f));
+
+    // The smallest level where the box covers at most 2x2 texels.
+    uint32_t level = 0;
+    while ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1) {
+        level++;
+    }
+
+    KW_ASSERT(level < m_level_offsets.size());
+
+    const float* depth = get_level(level);
+    uint32_t level_width = get_level_width(level);
+
+    float min_depth = std::numeric_limits<float>::infinity();
+    for (uint32_t y = y0 >> level; y <= y1 >> level; y++) {
+        for (uint32_t x = x0 >> level; x <= x1 >> level; x++) {
+            min_depth = std::min(min_depth, depth[y * level_width + x]);
+        }
+    }
+
+    // The closest point of the box is behind the farthest point of the occluders.
+    return max_depth < min_depth;
+}
+
+void OcclusionCuller::set_enabled(bool is_enabled) {
+    m_is_enabled = is_enabled;
+}
+
+bool OcclusionCuller::is_enabled() const {
+    return m_is_enabled;
+}
+
+uint32_t OcclusionCuller::get_occluder_count() const {
+    return m_occluder_count;
+}
+
+uint32_t OcclusionCuller::get_triangle_count() const {
+    return static_cast<uint32_t>(m_triangles.size());
+}
+
+uint32_t OcclusionCuller::get_tested_primitive_count() const {
+    return m_tested_primitive_count.load(std::memory_order_relaxed);
+}
+
+uint32_t OcclusionCuller::get_culled_primitive_count() const {
+    return m_culled_primitive_count.load(std::memory_order_relaxed);
+}
+
+Pair<Task*, Task*> OcclusionCuller::create_tasks() {
+    Task* end_task = m_transient_memory_resource.construct<EndTask>(*this);
+    Task* begin_task = m_transient_memory_resource.construct<BeginTask>(*this, end_task);
+
+    return { begin_task, end_task };
+}
+
+void OcclusionCuller::add_occluder(const AccelerationStructurePrimitive& primitive, const Occluder& occluder) {
+    float4x4 model_view_projection = float4x4(primitive.get_global_transform()) * m_view_projection;
+
+    const Vector<float3>& vertices = occluder.get_vertices();
+    const Vector<uint32_t>& indices = occluder.get_indices();
+
+    m_clip_vertices.resize(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        m_clip_vertices[i] = float4(vertices[i], 1.f) * model_view_projection;
+    }
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        add_triangle(m_clip_vertices[indices[i]], m_clip_vertices[indices[i + 1]], m_clip_vertices[indices[i + 2]]);
+    }
+}
+
+void OcclusionCuller::add_triangle(const float4& a, const float4& b, const float4& c) {
+    if (a.w < m_z_near && b.w < m_z_near && c.w < m_z_near) {
+        return;
+    }
+
+    // Clip the triangle against the near plane, which results in a polygon of up to 4 vertices.
+    float4 triangle[3] = { a, b, c };
+    float4 polygon[4];
+    size_t vertex_count = 0;
+
+    for (size_t i = 0; i < 3; i++) {
+        const float4& from = triangle[i];
+        const float4& to = triangle[(i + 1) % 3];
+
+        if (from.w >= m_z_near) {
+            polygon[vertex_count++] = from;
+        }
+
+        if ((from.w >= m_z_near) != (to.w >= m_z_near)) {
+            float factor = (m_z_near - from.w) / (to.w - from.w);
+            polygon[vertex_count++] = from + (to - from) * factor;
+        }
+    }
+
+    float3 screen[4];
+
+    for (size_t i = 0; i < vertex_count; i++) {
+        float depth = 1.f / std::max(polygon[i].w, m_z_near);
+        screen[i] = float3(
+            (polygon[i].x * depth * 0.5f + 0.5f) * m_width,
+            (0.5f - polygon[i].y * depth * 0.5f) * m_height,
+            depth
+        );
+    }
+
+    for (size_t i = 2; i < vertex_count; i++) {
+        add_screen_triangle(screen[0], screen[i - 1], screen[i]);
+    }
+}
+
+void OcclusionCuller::add_screen_triangle(const float3& a, const float3& b, const float3& c) {
+    float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+    if (std::abs(area) < MIN_TRIANGLE_AREA) {
+        return;
+    }
+
+    // Pixels whose centers are inside of the triangle's bounds.
+    float min_x = std::ceil(std::min(std::min(a.x, b.x), c.x) - 0.5f);
+    float min_y = std::ceil(std::min(std::min(a.y, b.y), c.y) - 0.5f);
+    float max_x = std::floor(std::max(std::max(a.x, b.x), c.x) - 0.5f);
+    float max_y = std::floor(std::max(std::max(a.y, b.y), c.y) - 0.5f);
+
+    if (max_x < 0.f || max_y < 0.f || min_x >= m_width || min_y >= m_height || min_x > max_x || min_y > max_y) {
+        return;
+    }
+
+    Triangle triangle;
+
+    // Edge function `a * x + b * y + c` is non-negative inside of the triangle for both windings.
+    float3 vertices[3] = { a, b, c };
+    float sign = area > 0.f ? 1.f : -1.f;
+
+    for (size_t i = 0; i < 3; i++) {
+        const float3& from = vertices[i];
+        const float3& to = vertices[(i + 1) % 3];
+
+        triangle.edge_a[i] = (from.y - to.y) * sign;
+        triangle.edge_b[i] = (to.x - from.x) * sign;
+        triangle.edge_c[i] = -(triangle.edge_a[i] * from.x + triangle.edge_b[i] * from.y);
+    }
+
+    // Depth at a pixel center is offset to the farthest depth within the pixel.
+    triangle.depth_a = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+    triangle.depth_b = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / area;
+    triangle.depth_c = a.z - triangle.depth_a * a.x - triangle.depth_b * a.y - 0.5f * (std::abs(triangle.depth_a) + std::abs(triangle.depth_b));
+    triangle.max_depth = std::max(std::max(a.z, b.z), c.z);
+
+    triangle.min_x = static_cast<uint32_t>(std::max(min_x, 0.f));
+    triangle.min_y = static_cast<uint32_t>(std::max(min_y, 0.f));
+    triangle.max_x = static_cast<uint32_t>(std::min(max_x, m_width - 1.f));
+    triangle.max_y = static_cast<uint32_t>(std::min(max_y, m_height - 1.f));
+
+    uint32_t triangle_index = static_cast<uint32_t>(m_triangles.size());
+    m_triangles.push_back(triangle);
+
+    for (uint32_t tile_y = triangle.min_y / TILE_SIZE; tile_y <= triangle.max_y / TILE_SIZE; tile_y++) {
+        for (uint32_t tile_x = triangle.min_x / TILE_SIZE; tile_x <= triangle.max_x / TILE_SIZE; tile_x++) {
+            m_tiles[tile_y * m_tile_count_x + tile_x].push_back(triangle_index);
+        }
+    }
+}
+
+void OcclusionCuller::rasterize_tile(uint32_t tile_index) {
+    uint32_t tile_min_x = tile_index % m_tile_count_x * TILE_SIZE;
+    uint32_t tile_min_y = tile_index / m_tile_count_x * TILE_SIZE;
+    uint32_t tile_max_x = tile_min_x + TILE_SIZE - 1;
+    uint32_t tile_max_y = tile_min_y + TILE_SIZE - 1;
+
+    float* depth = get_level(0);
+
+    for (uint32_t y = tile_min_y; y <= tile_max_y; y++) {
+        std::fill(depth + y * m_width + tile_min_x, depth + y * m_width + tile_max_x + 1, 0.f);
+    }
+
+    for (uint32_t triangle_index : m_tiles[tile_index]) {
+        const Triangle& triangle = m_triangles[triangle_index];
+
+        // Rasterize 4 pixels at once, so the first pixel of a row is aligned to 4.
+        uint32_t min_x = std::max(triangle.min_x, tile_min_x) & ~3u;
+        uint32_t min_y = std::max(triangle.min_y, tile_min_y);
+        uint32_t max_x = std::min(triangle.max_x, tile_max_x);
+        uint32_t max_y = std::min(triangle.max_y, tile_max_y);
+
+#ifdef KW_SIMD
+        simd::vfloat4 zero = simd::splat(0.f);
+        simd::vfloat4 max_depth = simd::splat(triangle.max_depth);
+        simd::vfloat4 offsets = simd::set(0.5f, 1.5f, 2.5f, 3.5f);
+
+        for (uint32_t y = min_y; y <= max_y; y++) {
+            simd::vfloat4 pixel_y = simd::splat(y + 0.5f);
+
+            for (uint32_t x = min_x; x <= max_x; x += 4) {
+                simd::vfloat4 pixel_x = simd::add(simd::splat(static_cast<float>(x)), offsets);
+
+                simd::vfloat4 edge = simd::madd(simd::splat(triangle.edge_a[0]), pixel_x, simd::madd(simd::splat(triangle.edge_b[0]), pixel_y, simd::splat(triangle.edge_c[0])));
+                for (size_t i = 1; i < 3; i++) {
+                    edge = simd::min(edge, simd::madd(simd::splat(triangle.edge_a[i]), pixel_x, simd::madd(simd::splat(triangle.edge_b[i]), pixel_y, simd::splat(triangle.edge_c[i]))));
+                }
+
+                if (simd::movemask(simd::less(edge, zero)) != 0xF) {
+                    simd::vfloat4 triangle_depth = simd::madd(simd::splat(triangle.depth_a), pixel_x, simd::madd(simd::splat(triangle.depth_b), pixel_y, simd::splat(triangle.depth_c)));
+                    triangle_depth = simd::select(simd::less(edge, zero), zero, simd::min(triangle_depth, max_depth));
+
+                    float* pixels = depth + y * m_width + x;
+                    simd::store(pixels, simd::max(simd::load(pixels), triangle_depth));
+                }
+            }
+        }
+#else
+        for (uint32_t y = min_y; y <= max_y; y++) {
+            float pixel_y = y + 0.5f;
+
+            for (uint32_t x = min_x; x <= max_x; x++) {
+                float pixel_x = x + 0.5f;
+
+                bool is_inside = true;
+                for (size_t i = 0; i < 3; i++) {
+                    is_inside &= triangle.edge_a[i] * pixel_x + triangle.edge_b[i] * pixel_y + triangle.edge_c[i] >= 0.f;
+                }
+
+                if (is_inside) {
+                    float triangle_depth = triangle.depth_a * pixel_x + triangle.depth_b * pixel_y + triangle.depth_c;
+                    float& pixel = depth[y * m_width + x];
+                    pixel = std::max(pixel, std::min(triangle_depth, triangle.max_depth));
+                }
+            }
+        }
+#endif
+    }
+
+    // Tiles are aligned to the texels of the first levels, so these levels are built without synchronization.
+    for (uint32_t level = 1; level < TILE_LEVEL_COUNT; level++) {
+        const float* source = get_level(level - 1);
+        float* destination = get_level(level);
+        uint32_t source_width = get_level_width(level - 1);
+        uint32_t destination_width = get_level_width(level);
+
+        for (uint32_t y = tile_min_y >> level; y <= tile_max_y >> level; y++) {
+            for (uint32_t x = tile_min_x >> level; x <= tile_max_x >> level; x++) {
+                const float* row0 = source + 2 * y * source_width + 2 * x;
+                const float* row1 = row0 + source_width;
+
+                destination[y * destination_width + x] = std::min(std::min(row0[0], row0[1]), std::min(row1[0], row1[1]));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::build_depth_pyramid() {
+    for (uint32_t level = TILE_LEVEL_COUNT; level < m_level_offsets.size(); level++) {
+        const float* source = get_level(level - 1);
+        float* destination = get_level(level);
+        uint32_t source_width = get_level_width(level - 1);
+        uint32_t source_height = get_level_height(level - 1);
+        uint32_t destination_width = get_level_width(level);
+        uint32_t destination_height = get_level_height(level);
+
+        for (uint32_t y = 0; y < destination_height; y++) {
+            for (uint32_t x = 0; x < destination_width; x++) {
+                // Level dimensions are rounded up, so the last row and column may have only one child.
+                uint32_t x0 = 2 * x;
+                uint32_t y0 = 2 * y;
+                uint32_t x1 = std::min(x0 + 1, source_width - 1);
+                uint32_t y1 = std::min(y0 + 1, source_height - 1);
+
+                destination[y * destination_width + x] = std::min(
+                    std::min(source[y0 * source_width + x0], source[y0 * source_width + x1]),
+                    std::min(source[y1 * source_width + x0], source[y1 * source_width + x1])
+                );
+            }
+        }
+    }
+}
+
+float* OcclusionCuller::get_level(uint32_t level) {
+    return m_depth_pyramid.data() + m_level_offsets[level];
+}
+
+const float* OcclusionCuller::get_level(uint32_t level) const {
+    return m_depth_pyramid.data() + m_level_offsets[level];
+}
+
+uint32_t OcclusionCuller::get_level_width(uint32_t level) const {
+    return (m_width + (1u << level) - 1) >> level;
+}
+
+uint32_t OcclusionCuller::get_level_height(uint32_t level) const {
+    return (m_height + (1u << level) - 1) >> level;
+}
+
+void OcclusionCuller::update_statistics(size_t tested_primitive_count, size_t culled_primitive_count) const {
+    m_tested_primitive_count.fetch_add(static_cast<uint32_t>(tested_primitive_count), std::memory_order_relaxed);
+    m_culled_primitive_count.fetch_add(static_cast<uint32_t>(culled_primitive_count), std::memory_order_relaxed);
+
+    KW_CPU_PROFILER_COUNTER("Occlusion Tested Primitives", tested_primitive_count);
+    KW_CPU_PROFILER_COUNTER("Occlusion Culled Primitives", culled_primitive_count);
+}
+
+} // namespace kw
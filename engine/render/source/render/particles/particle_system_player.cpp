@@ -7,7 +7,7 @@
 
 #include <system/timer.h>
 
-#include <core/concurrency/task.h>
+#include <core/concurrency/parallel_for_task.h>
 #include <core/concurrency/task_scheduler.h>
 #include <core/debug/assert.h>
 
@@ -15,24 +15,32 @@
 
 namespace kw {
 
-class ParticleSystemPlayer::WorkerTask : public Task {
+class ParticleSystemPlayer::WorkerTask : public ParallelForTask {
 public:
-    WorkerTask(ParticleSystemPlayer& particle_system_player, size_t primitive_index)
-        : m_particle_system_player(particle_system_player)
-        , m_primitive_index(primitive_index)
+    WorkerTask(ParticleSystemPlayer& particle_system_player, Task* end_task, size_t primitive_count)
+        : ParallelForTask(particle_system_player.m_task_scheduler, particle_system_player.m_transient_memory_resource, end_task, primitive_count)
+        , m_particle_system_player(particle_system_player)
     {
     }
 
-    void run() override {
-        std::shared_lock lock(m_particle_system_player.m_primitives_mutex);
-
-        ParticleSystemPrimitive* particle_system_primitive = m_particle_system_player.m_primitives[m_primitive_index];
-        if (particle_system_primitive != nullptr) {
-            SharedPtr<ParticleSystem> particle_system = particle_system_primitive->get_particle_system();
-            if (particle_system && particle_system->is_loaded()) {
-                kill(*particle_system_primitive);
-                emit(*particle_system_primitive, *particle_system, m_particle_system_player.m_timer.get_elapsed_time());
-                update(*particle_system_primitive, *particle_system, m_particle_system_player.m_timer.get_elapsed_time());
+    void run(size_t begin, size_t end) override {
+        if (Task* unlock_task = m_particle_system_player.m_primitives_mutex.try_lock_shared(m_particle_system_player.m_transient_memory_resource)) {
+            // Some primitive is being added or removed. Let this worker thread run other tasks in the meantime.
+            suspend(m_particle_system_player.m_transient_memory_resource, { unlock_task });
+            return;
+        }
+
+        std::shared_lock lock(m_particle_system_player.m_primitives_mutex, std::adopt_lock);
+
+        for (size_t i = begin; i < end; i++) {
+            ParticleSystemPrimitive* particle_system_primitive = m_particle_system_player.m_primitives[i];
+            if (particle_system_primitive != nullptr) {
+                SharedPtr<ParticleSystem> particle_system = particle_system_primitive->get_particle_system();
+                if (particle_system && particle_system->is_loaded()) {
+                    kill(*particle_system_primitive);
+                    emit(*particle_system_primitive, *particle_system, m_particle_system_player.m_timer.get_elapsed_time());
+                    update(*particle_system_primitive, *particle_system, m_particle_system_player.m_timer.get_elapsed_time());
+                }
             }
         }
     }
@@ -100,7 +108,6 @@ private:
     }
 
     ParticleSystemPlayer& m_particle_system_player;
-    size_t m_primitive_index;
 };
 
 class ParticleSystemPlayer::BeginTask : public Task {
@@ -112,16 +119,24 @@ public:
     }
 
     void run() override {
-        std::lock_guard lock(m_particle_system_player.m_primitives_mutex);
+        if (Task* unlock_task = m_particle_system_player.m_primitives_mutex.try_lock_shared(m_particle_system_player.m_transient_memory_resource)) {
+            // Some primitive is being added or removed. Let this worker thread run other tasks in the meantime.
+            suspend(m_particle_system_player.m_transient_memory_resource, { unlock_task });
+            return;
+        }
 
-        for (size_t i = 0; i < m_particle_system_player.m_primitives.size(); i++) {
-            WorkerTask* worker_task = m_particle_system_player.m_transient_memory_resource.construct<WorkerTask>(m_particle_system_player, i);
-            KW_ASSERT(worker_task != nullptr);
+        std::shared_lock lock(m_particle_system_player.m_primitives_mutex, std::adopt_lock);
 
-            worker_task->add_output_dependencies(m_particle_system_player.m_transient_memory_resource, { m_end_task });
+        size_t primitive_count = m_particle_system_player.m_primitives.size();
 
-            m_particle_system_player.m_task_scheduler.enqueue_task(m_particle_system_player.m_transient_memory_resource, worker_task);
-        }
+        // A single parallel for task instead of a task per primitive. Primitives added after this point are updated
+        // on the next frame.
+        WorkerTask* worker_task = m_particle_system_player.m_transient_memory_resource.construct<WorkerTask>(
+            m_particle_system_player, m_end_task, primitive_count
+        );
+        KW_ASSERT(worker_task != nullptr);
+
+        m_particle_system_player.m_task_scheduler.enqueue_task(m_particle_system_player.m_transient_memory_resource, worker_task);
     }
 
     const char* get_name() const override {
@@ -139,6 +154,7 @@ ParticleSystemPlayer::ParticleSystemPlayer(const ParticleSystemPlayerDescriptor&
     , m_persistent_memory_resource(*descriptor.persistent_memory_resource)
     , m_transient_memory_resource(*descriptor.transient_memory_resource)
     , m_primitives(*descriptor.persistent_memory_resource)
+    , m_primitives_mutex(*descriptor.task_scheduler)
 {
     KW_ASSERT(descriptor.timer != nullptr);
     KW_ASSERT(descriptor.task_scheduler != nullptr);
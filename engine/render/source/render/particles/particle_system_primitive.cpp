@@ -154,12 +154,10 @@ UniquePtr<Primitive> ParticleSystemPrimitive::clone(MemoryResource& memory_resou
     return static_pointer_cast<Primitive>(allocate_unique<ParticleSystemPrimitive>(memory_resource, *this));
 }
 
-void ParticleSystemPrimitive::global_transform_updated() {
+void ParticleSystemPrimitive::update_bounds() {
     if (m_particle_system && m_particle_system->is_loaded()) {
         m_bounds = m_particle_system->get_max_bounds() * get_global_transform();
     }
-
-    AccelerationStructurePrimitive::global_transform_updated();
 }
 
 void ParticleSystemPrimitive::particle_system_loaded() {
@@ -178,10 +176,8 @@ void ParticleSystemPrimitive::particle_system_loaded() {
         }
     }
 
-    m_bounds = m_particle_system->get_max_bounds() * get_global_transform();
-
-    // Update acceleration structure's node.
-    AccelerationStructurePrimitive::global_transform_updated();
+    // Update bounds and acceleration structure's node.
+    global_transform_updated();
 }
 
 } // namespace kw
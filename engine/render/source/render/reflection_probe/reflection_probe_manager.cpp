@@ -1,4 +1,5 @@
 #include "render/reflection_probe/reflection_probe_manager.h"
+#include "render/acceleration_structure/snapshot_acceleration_structure.h"
 #include "render/camera/camera_manager.h"
 #include "render/frame_graph.h"
 #include "render/reflection_probe/reflection_probe_primitive.h"
@@ -9,6 +10,7 @@
 #include "render/render_passes/opaque_shadow_render_pass.h"
 #include "render/render_passes/prefilter_render_pass.h"
 #include "render/render_passes/reflection_probe_render_pass.h"
+#include "render/scene/scene.h"
 #include "render/shadow/shadow_manager.h"
 
 #include <core/concurrency/task.h>
@@ -18,6 +20,10 @@
 namespace kw {
 
 struct ReflectionProbeManager::CubemapFrameGraphContext {
+    // Null when the scene's geometry acceleration structure doesn't support snapshots.
+    UniquePtr<PinnedSnapshotAccelerationStructure> geometry_acceleration_structure;
+    UniquePtr<Scene> scene;
+
     UniquePtr<CameraManager> camera_manager;
     UniquePtr<ShadowManager> shadow_manager;
     UniquePtr<OpaqueShadowRenderPass> opaque_shadow_render_pass;
@@ -496,6 +502,19 @@ void ReflectionProbeManager::create_bake_contexts() {
 void ReflectionProbeManager::create_cubemap_frame_graph() {
     UniquePtr<CubemapFrameGraphContext> context = allocate_unique<CubemapFrameGraphContext>(m_persistent_memory_resource);
 
+    // The bake spans multiple frames and its tasks are not ordered with the geometry acceleration structure's commit,
+    // so all cubemaps are rendered from the geometry snapshot pinned when the bake starts. Primitives removed after
+    // that are skipped by the snapshot.
+    Scene* scene = m_scene;
+
+    if (SnapshotAccelerationStructure* geometry_acceleration_structure = dynamic_cast<SnapshotAccelerationStructure*>(&m_scene->get_geometry_acceleration_structure())) {
+        context->geometry_acceleration_structure = allocate_unique<PinnedSnapshotAccelerationStructure>(
+            m_persistent_memory_resource, geometry_acceleration_structure->get_snapshot()
+        );
+        context->scene = allocate_unique<Scene>(m_persistent_memory_resource, *m_scene, *context->geometry_acceleration_structure, m_persistent_memory_resource);
+        scene = context->scene.get();
+    }
+
     context->camera_manager = allocate_unique<CameraManager>(m_persistent_memory_resource);
 
     Camera& camera = context->camera_manager->get_camera();
@@ -506,7 +525,7 @@ void ReflectionProbeManager::create_cubemap_frame_graph() {
 
     ShadowManagerDescriptor shadow_manager_descriptor{};
     shadow_manager_descriptor.render = m_render;
-    shadow_manager_descriptor.scene = m_scene;
+    shadow_manager_descriptor.scene = scene;
     shadow_manager_descriptor.camera_manager = context->camera_manager.get();
     shadow_manager_descriptor.shadow_map_count = 3;
     shadow_manager_descriptor.shadow_map_dimension = 512;
@@ -517,7 +536,7 @@ void ReflectionProbeManager::create_cubemap_frame_graph() {
     context->shadow_manager = allocate_unique<ShadowManager>(m_persistent_memory_resource, shadow_manager_descriptor);
 
     OpaqueShadowRenderPassDescriptor opaque_shadow_render_pass_descriptor{};
-    opaque_shadow_render_pass_descriptor.scene = m_scene;
+    opaque_shadow_render_pass_descriptor.scene = scene;
     opaque_shadow_render_pass_descriptor.shadow_manager = context->shadow_manager.get();
     opaque_shadow_render_pass_descriptor.task_scheduler = &m_task_scheduler;
     opaque_shadow_render_pass_descriptor.transient_memory_resource = &m_transient_memory_resource;
@@ -525,7 +544,7 @@ void ReflectionProbeManager::create_cubemap_frame_graph() {
     context->opaque_shadow_render_pass = allocate_unique<OpaqueShadowRenderPass>(m_persistent_memory_resource, opaque_shadow_render_pass_descriptor);
     
     GeometryRenderPassDescriptor geometry_render_pass_descriptor{};
-    geometry_render_pass_descriptor.scene = m_scene;
+    geometry_render_pass_descriptor.scene = scene;
     geometry_render_pass_descriptor.camera_manager = context->camera_manager.get();
     geometry_render_pass_descriptor.transient_memory_resource = &m_transient_memory_resource;
 
@@ -533,7 +552,7 @@ void ReflectionProbeManager::create_cubemap_frame_graph() {
 
     LightingRenderPassDescriptor lighting_render_pass_descriptor{};
     lighting_render_pass_descriptor.render = m_render;
-    lighting_render_pass_descriptor.scene = m_scene;
+    lighting_render_pass_descriptor.scene = scene;
     lighting_render_pass_descriptor.camera_manager = context->camera_manager.get();
     lighting_render_pass_descriptor.shadow_manager = context->shadow_manager.get();
     lighting_render_pass_descriptor.transient_memory_resource = &m_transient_memory_resource;
@@ -543,7 +562,7 @@ void ReflectionProbeManager::create_cubemap_frame_graph() {
     ReflectionProbeRenderPassDescriptor reflection_probe_render_pass_descriptor{};
     reflection_probe_render_pass_descriptor.render = m_render;
     reflection_probe_render_pass_descriptor.texture_manager = &m_texture_manager;
-    reflection_probe_render_pass_descriptor.scene = m_scene;
+    reflection_probe_render_pass_descriptor.scene = scene;
     reflection_probe_render_pass_descriptor.camera_manager = context->camera_manager.get();
     reflection_probe_render_pass_descriptor.transient_memory_resource = &m_transient_memory_resource;
 
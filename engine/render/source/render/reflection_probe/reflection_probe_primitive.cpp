@@ -83,10 +83,8 @@ UniquePtr<Primitive> ReflectionProbePrimitive::clone(MemoryResource& memory_reso
     return static_pointer_cast<Primitive>(allocate_unique<ReflectionProbePrimitive>(memory_resource, *this));
 }
 
-void ReflectionProbePrimitive::global_transform_updated() {
+void ReflectionProbePrimitive::update_bounds() {
     m_bounds = aabbox(get_global_translation(), float3(m_falloff_radius));
-
-    AccelerationStructurePrimitive::global_transform_updated();
 }
 
 } // namespace kw
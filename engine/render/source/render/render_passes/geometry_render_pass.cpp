@@ -3,6 +3,7 @@
 #include "render/geometry/geometry.h"
 #include "render/geometry/geometry_primitive.h"
 #include "render/material/material.h"
+#include "render/occlusion/occlusion_culler.h"
 #include "render/scene/scene.h"
 
 #include <core/concurrency/task.h>
@@ -28,7 +29,11 @@ public:
             {
                 KW_CPU_PROFILER("Occlusion Culling");
 
-                primitives = m_render_pass.m_scene.query_geometry(m_render_pass.m_camera_manager.get_occlusion_camera().get_frustum());
+                m_render_pass.m_scene.query_geometry(m_render_pass.m_camera_manager.get_occlusion_camera().get_frustum(), primitives);
+
+                if (m_render_pass.m_occlusion_culler != nullptr) {
+                    m_render_pass.m_occlusion_culler->cull(primitives);
+                }
             }
 
             // Sort primitives by graphics pipeline (to avoid graphics pipeline switches),
@@ -136,6 +141,7 @@ public:
 
                         {
                             KW_CPU_PROFILER("Draw Call");
+                            KW_CPU_PROFILER_COUNTER("Draw Calls", 1);
 
                             context->draw(draw_call_descriptor);
                         }
@@ -176,6 +182,7 @@ private:
 GeometryRenderPass::GeometryRenderPass(const GeometryRenderPassDescriptor& descriptor)
     : m_scene(*descriptor.scene)
     , m_camera_manager(*descriptor.camera_manager)
+    , m_occlusion_culler(descriptor.occlusion_culler)
     , m_transient_memory_resource(*descriptor.transient_memory_resource)
 {
     KW_ASSERT(descriptor.scene != nullptr);
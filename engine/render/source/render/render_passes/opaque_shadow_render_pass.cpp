@@ -1,4 +1,5 @@
 #include "render/render_passes/opaque_shadow_render_pass.h"
+#include "render/acceleration_structure/query_views.h"
 #include "render/geometry/geometry.h"
 #include "render/geometry/geometry_primitive.h"
 #include "render/light/light_primitive.h"
@@ -13,7 +14,6 @@
 #include <core/debug/cpu_profiler.h>
 #include <core/math/aabbox.h>
 #include <core/math/float4x4.h>
-#include <core/math/frustum.h>
 #include <core/memory/memory_resource.h>
 
 #include <algorithm>
@@ -37,10 +37,11 @@ static CubemapVectors CUBEMAP_VECTORS[] = {
 
 class OpaqueShadowRenderPass::WorkerTask : public Task {
 public:
-    WorkerTask(OpaqueShadowRenderPass& render_pass, uint32_t shadow_map_index, uint32_t face_index)
+    WorkerTask(OpaqueShadowRenderPass& render_pass, uint32_t shadow_map_index, uint32_t face_index, Vector<GeometryPrimitive*>& primitives)
         : m_render_pass(render_pass)
         , m_shadow_map_index(shadow_map_index)
         , m_face_index(face_index)
+        , m_primitives(primitives)
     {
     }
 
@@ -52,13 +53,7 @@ public:
         float4x4 projection = float4x4::perspective_lh(PI / 2.f, 1.f, 0.1f, 20.f);
         float4x4 view_projection = view * projection;
 
-        Vector<GeometryPrimitive*> primitives(m_render_pass.m_transient_memory_resource);
-
-        {
-            KW_CPU_PROFILER("Occlusion Culling");
-
-            primitives = m_render_pass.m_scene.query_geometry(frustum(view_projection));
-        }
+        Vector<GeometryPrimitive*>& primitives = m_primitives;
 
         // Sort primitives by geometry for instancing.
         {
@@ -178,6 +173,7 @@ public:
 
                             {
                                 KW_CPU_PROFILER("Draw Call");
+                                KW_CPU_PROFILER_COUNTER("Draw Calls", 1);
 
                                 context->draw(draw_call_descriptor);
                             }
@@ -221,6 +217,58 @@ private:
     OpaqueShadowRenderPass& m_render_pass;
     uint32_t m_shadow_map_index;
     uint32_t m_face_index;
+    Vector<GeometryPrimitive*>& m_primitives;
+};
+
+// All six faces of a shadow map are culled in a single acceleration structure traversal.
+class OpaqueShadowRenderPass::CullTask : public Task {
+public:
+    CullTask(OpaqueShadowRenderPass& render_pass, uint32_t shadow_map_index, Task* end_task)
+        : m_render_pass(render_pass)
+        , m_shadow_map_index(shadow_map_index)
+        , m_end_task(end_task)
+        , m_primitives{
+            Vector<GeometryPrimitive*>(render_pass.m_transient_memory_resource),
+            Vector<GeometryPrimitive*>(render_pass.m_transient_memory_resource),
+            Vector<GeometryPrimitive*>(render_pass.m_transient_memory_resource),
+            Vector<GeometryPrimitive*>(render_pass.m_transient_memory_resource),
+            Vector<GeometryPrimitive*>(render_pass.m_transient_memory_resource),
+            Vector<GeometryPrimitive*>(render_pass.m_transient_memory_resource)
+        }
+    {
+    }
+
+    void run() override {
+        const ShadowMap& shadow_map = m_render_pass.m_shadow_manager.get_shadow_maps()[m_shadow_map_index];
+
+        {
+            KW_CPU_PROFILER("Occlusion Culling");
+
+            // Cubemap faces are ordered the same way as `CUBEMAP_VECTORS`.
+            m_render_pass.m_scene.query_geometry(QueryViews(shadow_map.light_primitive->get_global_translation(), 0.1f, 20.f), m_primitives);
+        }
+
+        for (uint32_t face_index = 0; face_index < 6; face_index++) {
+            WorkerTask* worker_task = m_render_pass.m_transient_memory_resource.construct<WorkerTask>(m_render_pass, m_shadow_map_index, face_index, m_primitives[face_index]);
+            KW_ASSERT(worker_task != nullptr);
+
+            worker_task->add_output_dependencies(m_render_pass.m_transient_memory_resource, { m_end_task });
+
+            m_render_pass.m_task_scheduler.enqueue_task(m_render_pass.m_transient_memory_resource, worker_task);
+        }
+    }
+
+    const char* get_name() const override {
+        return "Opaque Shadow Render Pass Cull";
+    }
+
+private:
+    OpaqueShadowRenderPass& m_render_pass;
+    uint32_t m_shadow_map_index;
+    Task* m_end_task;
+
+    // Worker tasks reference these, so they must not be destroyed until the end of the frame.
+    Vector<GeometryPrimitive*> m_primitives[6];
 };
 
 class OpaqueShadowRenderPass::BeginTask : public Task {
@@ -235,14 +283,12 @@ public:
         const Vector<ShadowMap>& shadow_maps = m_render_pass.m_shadow_manager.get_shadow_maps();
         for (uint32_t shadow_map_index = 0; shadow_map_index < shadow_maps.size(); shadow_map_index++) {
             if (shadow_maps[shadow_map_index].light_primitive != nullptr) {
-                for (uint32_t face_index = 0; face_index < 6; face_index++) {
-                    WorkerTask* worker_task = m_render_pass.m_transient_memory_resource.construct<WorkerTask>(m_render_pass, shadow_map_index, face_index);
-                    KW_ASSERT(worker_task != nullptr);
+                CullTask* cull_task = m_render_pass.m_transient_memory_resource.construct<CullTask>(m_render_pass, shadow_map_index, m_end_task);
+                KW_ASSERT(cull_task != nullptr);
 
-                    worker_task->add_output_dependencies(m_render_pass.m_transient_memory_resource, { m_end_task });
+                cull_task->add_output_dependencies(m_render_pass.m_transient_memory_resource, { m_end_task });
 
-                    m_render_pass.m_task_scheduler.enqueue_task(m_render_pass.m_transient_memory_resource, worker_task);
-                }
+                m_render_pass.m_task_scheduler.enqueue_task(m_render_pass.m_transient_memory_resource, cull_task);
             }
         }
     }
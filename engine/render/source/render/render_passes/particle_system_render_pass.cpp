@@ -2,6 +2,7 @@
 #include "render/camera/camera_manager.h"
 #include "render/geometry/geometry.h"
 #include "render/material/material.h"
+#include "render/occlusion/occlusion_culler.h"
 #include "render/particles/particle_system.h"
 #include "render/particles/particle_system_primitive.h"
 #include "render/scene/scene.h"
@@ -29,7 +30,11 @@ public:
             {
                 KW_CPU_PROFILER("Occlusion Culling");
 
-                primitives = m_render_pass.m_scene.query_particle_systems(m_render_pass.m_camera_manager.get_occlusion_camera().get_frustum());
+                m_render_pass.m_scene.query_particle_systems(m_render_pass.m_camera_manager.get_occlusion_camera().get_frustum(), primitives);
+
+                if (m_render_pass.m_occlusion_culler != nullptr) {
+                    m_render_pass.m_occlusion_culler->cull(primitives);
+                }
             }
 
             Camera& camera = m_render_pass.m_camera_manager.get_camera();
@@ -209,6 +214,7 @@ public:
 
                         {
                             KW_CPU_PROFILER("Draw Call");
+                            KW_CPU_PROFILER_COUNTER("Draw Calls", 1);
 
                             context->draw(draw_call_descriptor);
                         }
@@ -244,6 +250,7 @@ private:
 ParticleSystemRenderPass::ParticleSystemRenderPass(const ParticleSystemRenderPassDescriptor& descriptor)
     : m_scene(*descriptor.scene)
     , m_camera_manager(*descriptor.camera_manager)
+    , m_occlusion_culler(descriptor.occlusion_culler)
     , m_transient_memory_resource(*descriptor.transient_memory_resource)
 {
     KW_ASSERT(descriptor.scene != nullptr);
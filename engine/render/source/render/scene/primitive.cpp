@@ -6,14 +6,16 @@
 namespace kw {
 
 Primitive::Primitive(const transform& local_transform)
-    : m_parent(nullptr)
+    : m_primitive_type(PrimitiveType::GENERIC)
+    , m_parent(nullptr)
     , m_local_transform(local_transform)
     , m_global_transform(local_transform)
 {
 }
 
 Primitive::Primitive(const Primitive& other)
-    : m_parent(nullptr)
+    : m_primitive_type(PrimitiveType::GENERIC)
+    , m_parent(nullptr)
     , m_local_transform(other.m_local_transform)
     , m_global_transform(other.m_local_transform)
 {
@@ -10,9 +10,34 @@
 #include "render/reflection_probe/reflection_probe_primitive.h"
 
 #include <core/debug/assert.h>
+#include <core/math/scalar.h>
 
 namespace kw {
 
+// Acceleration structure of each primitive type contains only primitives of that type, so they're downcast
+// right into the output without any intermediate vectors.
+template <typename Query, typename T>
+static void query_acceleration_structure(const AccelerationStructure& acceleration_structure, const Query& query, Vector<T*>& output) {
+    acceleration_structure.query(query, [&output](AccelerationStructurePrimitive* const* primitives, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            output.push_back(static_cast<T*>(primitives[i]));
+        }
+    });
+}
+
+template <typename T>
+static void query_acceleration_structure(const AccelerationStructure& acceleration_structure, const QueryViews& views, Vector<T*>* outputs) {
+    acceleration_structure.query(views, [outputs](AccelerationStructurePrimitive* const* primitives, const uint64_t* masks, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            uint64_t mask = masks[i];
+            while (mask != 0) {
+                outputs[log2(mask & (~mask + 1))].push_back(static_cast<T*>(primitives[i]));
+                mask &= mask - 1;
+            }
+        }
+    });
+}
+
 Scene::Scene(const SceneDescriptor& descriptor)
     : ContainerPrimitive(*descriptor.persistent_memory_resource)
     , m_animation_player(*descriptor.animation_player)
@@ -35,78 +60,127 @@ Scene::Scene(const SceneDescriptor& descriptor)
     KW_ASSERT(descriptor.transient_memory_resource != nullptr);
 }
 
+Scene::Scene(const Scene& scene, AccelerationStructure& geometry_acceleration_structure, MemoryResource& persistent_memory_resource)
+    : ContainerPrimitive(persistent_memory_resource)
+    , m_animation_player(scene.m_animation_player)
+    , m_particle_system_player(scene.m_particle_system_player)
+    , m_reflection_probe_manager(scene.m_reflection_probe_manager)
+    , m_geometry_acceleration_structure(geometry_acceleration_structure)
+    , m_light_acceleration_structure(scene.m_light_acceleration_structure)
+    , m_particle_system_acceleration_structure(scene.m_particle_system_acceleration_structure)
+    , m_reflection_probe_acceleration_structure(scene.m_reflection_probe_acceleration_structure)
+    , m_transient_memory_resource(scene.m_transient_memory_resource)
+{
+}
+
 Vector<GeometryPrimitive*> Scene::query_geometry(const aabbox& bounds) const {
-    Vector<AccelerationStructurePrimitive*> acceleration_structure_primitives = m_geometry_acceleration_structure.query(m_transient_memory_resource, bounds);
-    Vector<GeometryPrimitive*> result(acceleration_structure_primitives.size(), m_transient_memory_resource);
-    for (size_t i = 0; i < acceleration_structure_primitives.size(); i++) {
-        result[i] = static_cast<GeometryPrimitive*>(acceleration_structure_primitives[i]);
-    }
+    Vector<GeometryPrimitive*> result(m_transient_memory_resource);
+    result.reserve(64);
+    query_geometry(bounds, result);
     return result;
 }
 
 Vector<GeometryPrimitive*> Scene::query_geometry(const frustum& frustum) const {
-    Vector<AccelerationStructurePrimitive*> acceleration_structure_primitives = m_geometry_acceleration_structure.query(m_transient_memory_resource, frustum);
-    Vector<GeometryPrimitive*> result(acceleration_structure_primitives.size(), m_transient_memory_resource);
-    for (size_t i = 0; i < acceleration_structure_primitives.size(); i++) {
-        result[i] = static_cast<GeometryPrimitive*>(acceleration_structure_primitives[i]);
-    }
+    Vector<GeometryPrimitive*> result(m_transient_memory_resource);
+    result.reserve(64);
+    query_geometry(frustum, result);
     return result;
 }
 
 Vector<LightPrimitive*> Scene::query_lights(const aabbox& bounds) const {
-    Vector<AccelerationStructurePrimitive*> acceleration_structure_primitives = m_light_acceleration_structure.query(m_transient_memory_resource, bounds);
-    Vector<LightPrimitive*> result(acceleration_structure_primitives.size(), m_transient_memory_resource);
-    for (size_t i = 0; i < acceleration_structure_primitives.size(); i++) {
-        result[i] = static_cast<LightPrimitive*>(acceleration_structure_primitives[i]);
-    }
+    Vector<LightPrimitive*> result(m_transient_memory_resource);
+    result.reserve(64);
+    query_lights(bounds, result);
     return result;
 }
 
 Vector<LightPrimitive*> Scene::query_lights(const frustum& frustum) const {
-    Vector<AccelerationStructurePrimitive*> acceleration_structure_primitives = m_light_acceleration_structure.query(m_transient_memory_resource, frustum);
-    Vector<LightPrimitive*> result(acceleration_structure_primitives.size(), m_transient_memory_resource);
-    for (size_t i = 0; i < acceleration_structure_primitives.size(); i++) {
-        result[i] = static_cast<LightPrimitive*>(acceleration_structure_primitives[i]);
-    }
+    Vector<LightPrimitive*> result(m_transient_memory_resource);
+    result.reserve(64);
+    query_lights(frustum, result);
     return result;
 }
 
 Vector<ParticleSystemPrimitive*> Scene::query_particle_systems(const aabbox& bounds) const {
-    Vector<AccelerationStructurePrimitive*> acceleration_structure_primitives = m_particle_system_acceleration_structure.query(m_transient_memory_resource, bounds);
-    Vector<ParticleSystemPrimitive*> result(acceleration_structure_primitives.size(), m_transient_memory_resource);
-    for (size_t i = 0; i < acceleration_structure_primitives.size(); i++) {
-        result[i] = static_cast<ParticleSystemPrimitive*>(acceleration_structure_primitives[i]);
-    }
+    Vector<ParticleSystemPrimitive*> result(m_transient_memory_resource);
+    result.reserve(64);
+    query_particle_systems(bounds, result);
     return result;
 }
 
 Vector<ParticleSystemPrimitive*> Scene::query_particle_systems(const frustum& frustum) const {
-    Vector<AccelerationStructurePrimitive*> acceleration_structure_primitives = m_particle_system_acceleration_structure.query(m_transient_memory_resource, frustum);
-    Vector<ParticleSystemPrimitive*> result(acceleration_structure_primitives.size(), m_transient_memory_resource);
-    for (size_t i = 0; i < acceleration_structure_primitives.size(); i++) {
-        result[i] = static_cast<ParticleSystemPrimitive*>(acceleration_structure_primitives[i]);
-    }
+    Vector<ParticleSystemPrimitive*> result(m_transient_memory_resource);
+    result.reserve(64);
+    query_particle_systems(frustum, result);
     return result;
 }
 
 Vector<ReflectionProbePrimitive*> Scene::query_reflection_probes(const aabbox& bounds) const {
-    Vector<AccelerationStructurePrimitive*> acceleration_structure_primitives = m_reflection_probe_acceleration_structure.query(m_transient_memory_resource, bounds);
-    Vector<ReflectionProbePrimitive*> result(acceleration_structure_primitives.size(), m_transient_memory_resource);
-    for (size_t i = 0; i < acceleration_structure_primitives.size(); i++) {
-        result[i] = static_cast<ReflectionProbePrimitive*>(acceleration_structure_primitives[i]);
-    }
+    Vector<ReflectionProbePrimitive*> result(m_transient_memory_resource);
+    result.reserve(64);
+    query_reflection_probes(bounds, result);
     return result;
 }
 
 Vector<ReflectionProbePrimitive*> Scene::query_reflection_probes(const frustum& frustum) const {
-    Vector<AccelerationStructurePrimitive*> acceleration_structure_primitives = m_reflection_probe_acceleration_structure.query(m_transient_memory_resource, frustum);
-    Vector<ReflectionProbePrimitive*> result(acceleration_structure_primitives.size(), m_transient_memory_resource);
-    for (size_t i = 0; i < acceleration_structure_primitives.size(); i++) {
-        result[i] = static_cast<ReflectionProbePrimitive*>(acceleration_structure_primitives[i]);
-    }
+    Vector<ReflectionProbePrimitive*> result(m_transient_memory_resource);
+    result.reserve(64);
+    query_reflection_probes(frustum, result);
     return result;
 }
 
+void Scene::query_geometry(const aabbox& bounds, Vector<GeometryPrimitive*>& output) const {
+    query_acceleration_structure(m_geometry_acceleration_structure, bounds, output);
+}
+
+void Scene::query_geometry(const frustum& frustum, Vector<GeometryPrimitive*>& output) const {
+    query_acceleration_structure(m_geometry_acceleration_structure, frustum, output);
+}
+
+void Scene::query_lights(const aabbox& bounds, Vector<LightPrimitive*>& output) const {
+    query_acceleration_structure(m_light_acceleration_structure, bounds, output);
+}
+
+void Scene::query_lights(const frustum& frustum, Vector<LightPrimitive*>& output) const {
+    query_acceleration_structure(m_light_acceleration_structure, frustum, output);
+}
+
+void Scene::query_particle_systems(const aabbox& bounds, Vector<ParticleSystemPrimitive*>& output) const {
+    query_acceleration_structure(m_particle_system_acceleration_structure, bounds, output);
+}
+
+void Scene::query_particle_systems(const frustum& frustum, Vector<ParticleSystemPrimitive*>& output) const {
+    query_acceleration_structure(m_particle_system_acceleration_structure, frustum, output);
+}
+
+void Scene::query_reflection_probes(const aabbox& bounds, Vector<ReflectionProbePrimitive*>& output) const {
+    query_acceleration_structure(m_reflection_probe_acceleration_structure, bounds, output);
+}
+
+void Scene::query_reflection_probes(const frustum& frustum, Vector<ReflectionProbePrimitive*>& output) const {
+    query_acceleration_structure(m_reflection_probe_acceleration_structure, frustum, output);
+}
+
+void Scene::query_geometry(const QueryViews& views, Vector<GeometryPrimitive*>* outputs) const {
+    query_acceleration_structure(m_geometry_acceleration_structure, views, outputs);
+}
+
+void Scene::query_lights(const QueryViews& views, Vector<LightPrimitive*>* outputs) const {
+    query_acceleration_structure(m_light_acceleration_structure, views, outputs);
+}
+
+void Scene::query_particle_systems(const QueryViews& views, Vector<ParticleSystemPrimitive*>* outputs) const {
+    query_acceleration_structure(m_particle_system_acceleration_structure, views, outputs);
+}
+
+void Scene::query_reflection_probes(const QueryViews& views, Vector<ReflectionProbePrimitive*>* outputs) const {
+    query_acceleration_structure(m_reflection_probe_acceleration_structure, views, outputs);
+}
+
+AccelerationStructure& Scene::get_geometry_acceleration_structure() const {
+    return m_geometry_acceleration_structure;
+}
+
 void Scene::child_added(Primitive& primitive) {
     if (GeometryPrimitive* geometry_primitive = dynamic_cast<GeometryPrimitive*>(&primitive)) {
         if (AnimatedGeometryPrimitive* animated_geometry_primitive = dynamic_cast<AnimatedGeometryPrimitive*>(geometry_primitive)) {
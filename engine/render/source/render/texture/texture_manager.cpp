@@ -16,6 +16,8 @@ public:
         , m_texture(texture)
         , m_bytes_per_texture(bytes_per_texture)
     {
+        // Texture streaming must not delay frame-critical work.
+        set_priority(TaskPriority::BACKGROUND);
     }
 
     void run() override {
@@ -38,6 +40,28 @@ private:
     size_t m_bytes_per_texture;
 };
 
+class TextureManager::OpeningTask final : public Task {
+public:
+    OpeningTask(TextureLoader& texture_loader, const char* relative_path)
+        : m_texture_loader(texture_loader)
+        , m_relative_path(relative_path)
+    {
+    }
+
+    void run() override {
+        // Opening a file and reading its header may take a while, so this runs on a background thread.
+        m_texture_loader = TextureLoader(m_relative_path);
+    }
+
+    const char* get_name() const override {
+        return "Texture Manager Opening";
+    }
+
+private:
+    TextureLoader& m_texture_loader;
+    const char* m_relative_path;
+};
+
 class TextureManager::PendingTask final : public Task {
 public:
     PendingTask(TextureManager& manager, TextureLoader& texture_loader, Texture*& texture, const char* relative_path, size_t bytes_per_texture, Task* end_task)
@@ -51,7 +75,6 @@ public:
     }
 
     void run() override {
-        m_texture_loader = TextureLoader(m_relative_path);
         KW_ASSERT(!m_texture_loader.is_loaded());
 
         CreateTextureDescriptor create_texture_descriptor = m_texture_loader.get_create_texture_descriptor();
@@ -103,8 +126,34 @@ public:
             }
         }
 
-        if (!m_manager.m_pending_textures.empty() || !m_manager.m_loading_textures.empty()) {
-            size_t total_textures = m_manager.m_pending_textures.size() + m_manager.m_loading_textures.size();
+        //
+        // Start opening brand new textures on background threads.
+        //
+
+        m_manager.m_opening_textures.reserve(m_manager.m_opening_textures.size() + m_manager.m_pending_textures.size());
+
+        for (auto& [relative_path, texture] : m_manager.m_pending_textures) {
+            OpeningTexture& opening_texture = m_manager.m_opening_textures.emplace_back(OpeningTexture{
+                allocate_unique<TextureLoader>(m_manager.m_persistent_memory_resource),
+                std::move(texture),
+                relative_path.c_str(),
+            });
+
+            opening_texture.opening_task = allocate_unique<OpeningTask>(m_manager.m_persistent_memory_resource, *opening_texture.texture_loader, opening_texture.relative_path);
+            opening_texture.handle = m_manager.m_task_scheduler.enqueue_background_task(opening_texture.opening_task.get());
+        }
+
+        m_manager.m_pending_textures.clear();
+
+        size_t opened_textures = 0;
+        for (const OpeningTexture& opening_texture : m_manager.m_opening_textures) {
+            if (opening_texture.handle.is_completed()) {
+                opened_textures++;
+            }
+        }
+
+        if (opened_textures > 0 || !m_manager.m_loading_textures.empty()) {
+            size_t total_textures = opened_textures + m_manager.m_loading_textures.size();
 
             // 32 bytes is enough to load one texel of any texture format.
             size_t bytes_per_texture = std::max(m_manager.m_transient_memory_allocation / total_textures, 32ull);
@@ -131,23 +180,29 @@ public:
             }
 
             //
-            // Start loading brand new textures.
+            // Create textures that have been opened and start loading them.
             //
 
-            m_manager.m_loading_textures.reserve(m_manager.m_loading_textures.size() + m_manager.m_pending_textures.size());
+            m_manager.m_loading_textures.reserve(m_manager.m_loading_textures.size() + opened_textures);
 
-            for (auto& [relative_path, texture] : m_manager.m_pending_textures) {
-                auto& [texture_loader_, texture_] = m_manager.m_loading_textures.emplace_back(allocate_unique<TextureLoader>(m_manager.m_persistent_memory_resource), std::move(texture));
+            for (size_t i = 0; i < m_manager.m_opening_textures.size(); ) {
+                OpeningTexture& opening_texture = m_manager.m_opening_textures[i];
+                if (opening_texture.handle.is_completed()) {
+                    auto& [texture_loader_, texture_] = m_manager.m_loading_textures.emplace_back(std::move(opening_texture.texture_loader), std::move(opening_texture.texture));
 
-                PendingTask* pending_task = m_manager.m_transient_memory_resource.construct<PendingTask>(m_manager, *texture_loader_, *texture_, relative_path.c_str(), bytes_per_texture, m_end_task);
-                KW_ASSERT(pending_task != nullptr);
+                    PendingTask* pending_task = m_manager.m_transient_memory_resource.construct<PendingTask>(m_manager, *texture_loader_, *texture_, opening_texture.relative_path, bytes_per_texture, m_end_task);
+                    KW_ASSERT(pending_task != nullptr);
 
-                pending_task->add_output_dependencies(m_manager.m_transient_memory_resource, { m_end_task });
+                    pending_task->add_output_dependencies(m_manager.m_transient_memory_resource, { m_end_task });
 
-                m_manager.m_task_scheduler.enqueue_task(m_manager.m_transient_memory_resource, pending_task);
-            }
+                    m_manager.m_task_scheduler.enqueue_task(m_manager.m_transient_memory_resource, pending_task);
 
-            m_manager.m_pending_textures.clear();
+                    std::swap(m_manager.m_opening_textures[i], m_manager.m_opening_textures.back());
+                    m_manager.m_opening_textures.pop_back();
+                } else {
+                    i++;
+                }
+            }
         }
     }
 
@@ -168,6 +223,7 @@ TextureManager::TextureManager(const TextureManagerDescriptor& descriptor)
     , m_transient_memory_allocation(descriptor.transient_memory_allocation)
     , m_textures(*descriptor.persistent_memory_resource)
     , m_pending_textures(*descriptor.persistent_memory_resource)
+    , m_opening_textures(*descriptor.persistent_memory_resource)
     , m_loading_textures(*descriptor.persistent_memory_resource)
 {
     KW_ASSERT(descriptor.render != nullptr);
@@ -177,11 +233,18 @@ TextureManager::TextureManager(const TextureManagerDescriptor& descriptor)
 
     m_textures.reserve(32);
     m_pending_textures.reserve(32);
+    m_opening_textures.reserve(32);
     m_loading_textures.reserve(32);
 }
 
 TextureManager::~TextureManager() {
+    // Background threads write to texture loaders, so wait for them before destroying anything.
+    for (const OpeningTexture& opening_texture : m_opening_textures) {
+        opening_texture.handle.wait();
+    }
+
     m_pending_textures.clear();
+    m_opening_textures.clear();
     m_loading_textures.clear();
 
     for (auto& [relative_path, texture] : m_textures) {
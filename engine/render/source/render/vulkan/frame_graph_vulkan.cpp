@@ -5410,6 +5410,7 @@ FrameGraphVulkan::RenderPassData::RenderPassData(RenderPassData&& other)
 FrameGraphVulkan::AcquireTask::AcquireTask(FrameGraphVulkan& frame_graph)
     : m_frame_graph(frame_graph)
 {
+    set_priority(TaskPriority::CRITICAL);
 }
 
 void FrameGraphVulkan::AcquireTask::run() {
@@ -5561,6 +5562,8 @@ const char* FrameGraphVulkan::AcquireTask::get_name() const {
 FrameGraphVulkan::PresentTask::PresentTask(FrameGraphVulkan& frame_graph)
     : m_frame_graph(frame_graph)
 {
+    // Everything that present transitively depends on inherits this priority.
+    set_priority(TaskPriority::CRITICAL);
 }
 
 void FrameGraphVulkan::PresentTask::run() {
@@ -3,6 +3,7 @@
 #include "render/vulkan/vulkan_utils.h"
 
 #include <core/debug/assert.h>
+#include <core/debug/cpu_profiler.h>
 #include <core/debug/log.h>
 #include <core/math/scalar.h>
 
@@ -441,6 +442,8 @@ void RenderVulkan::upload_vertex_buffer(VertexBuffer* vertex_buffer, const void*
     KW_ASSERT(data != nullptr, "Invalid data.");
     KW_ASSERT(size > 0, "Invalid data size.");
 
+    KW_CPU_PROFILER_COUNTER("Uploaded Bytes", size);
+
     VertexBufferVulkan* vertex_buffer_vulkan = static_cast<VertexBufferVulkan*>(vertex_buffer);
 
     void* device_memory_mapping = m_buffer_device_data[vertex_buffer_vulkan->device_data_index].memory_mapping;
@@ -563,6 +566,8 @@ void RenderVulkan::upload_index_buffer(IndexBuffer* index_buffer, const void* da
     KW_ASSERT(data != nullptr, "Invalid data.");
     KW_ASSERT(size > 0, "Invalid data size.");
 
+    KW_CPU_PROFILER_COUNTER("Uploaded Bytes", size);
+
     IndexBufferVulkan* index_buffer_vulkan = static_cast<IndexBufferVulkan*>(index_buffer);
 
     void* device_memory_mapping = m_buffer_device_data[index_buffer_vulkan->device_data_index].memory_mapping;
@@ -765,6 +770,8 @@ void RenderVulkan::upload_texture(const UploadTextureDescriptor& upload_texture_
     KW_ASSERT(upload_texture_descriptor.data != nullptr, "Invalid data.");
     KW_ASSERT(upload_texture_descriptor.size > 0, "Invalid data size.");
 
+    KW_CPU_PROFILER_COUNTER("Uploaded Bytes", upload_texture_descriptor.size);
+
     TextureVulkan* texture_vulkan = static_cast<TextureVulkan*>(upload_texture_descriptor.texture);
     KW_ASSERT(texture_vulkan != nullptr);
 
@@ -11,7 +11,7 @@
 #undef RELATIVE
 
 #include <render/acceleration_structure/linear_acceleration_structure.h>
-#include <render/acceleration_structure/octree_acceleration_structure.h>
+#include <render/acceleration_structure/snapshot_acceleration_structure.h>
 #include <render/animation/animated_geometry_primitive.h>
 #include <render/animation/animation_manager.h>
 #include <render/animation/animation_player.h>
@@ -29,6 +29,7 @@
 #include <render/geometry/skeleton.h>
 #include <render/light/point_light_primitive.h>
 #include <render/material/material_manager.h>
+#include <render/occlusion/occlusion_culler.h>
 #include <render/particles/particle_system_manager.h>
 #include <render/particles/particle_system_player.h>
 #include <render/particles/particle_system_primitive.h>
@@ -63,12 +64,14 @@
 #include <core/containers/set.h>
 #include <core/debug/assert.h>
 #include <core/debug/cpu_profiler.h>
+#include <core/debug/cpu_profiler_exporter.h>
 #include <core/debug/debug_utils.h>
 #include <core/debug/log.h>
 #include <core/error.h>
 #include <core/math/float4x4.h>
 #include <core/memory/malloc_memory_resource.h>
 #include <core/memory/scratch_memory_resource.h>
+#include <core/memory/small_object_memory_resource.h>
 
 using namespace kw;
 
@@ -77,7 +80,7 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
 
     ConcurrencyUtils::set_current_thread_name("Main Thread");
 
-    MallocMemoryResource& persistent_memory_resource = MallocMemoryResource::instance();
+    SmallObjectMemoryResource persistent_memory_resource(MallocMemoryResource::instance());
     ScratchMemoryResource transient_memory_resource(persistent_memory_resource, 16 * 1024 * 1024);
 
     EventLoop event_loop;
@@ -93,7 +96,7 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
 
     Timer timer;
 
-    TaskScheduler task_scheduler(persistent_memory_resource, 3);
+    TaskScheduler task_scheduler(persistent_memory_resource, 3, 1);
     
     RenderDescriptor render_descriptor{};
     render_descriptor.api = RenderApi::VULKAN;
@@ -124,6 +127,7 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
     geometry_manager_descriptor.task_scheduler = &task_scheduler;
     geometry_manager_descriptor.persistent_memory_resource = &persistent_memory_resource;
     geometry_manager_descriptor.transient_memory_resource = &transient_memory_resource;
+    geometry_manager_descriptor.max_occluder_triangle_count = 4096;
 
     GeometryManager geometry_manager(geometry_manager_descriptor);
 
@@ -163,9 +167,17 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
 
     ContainerManager container_manager(container_manager_descriptor);
 
+    SnapshotAccelerationStructure geometry_acceleration_structure(persistent_memory_resource);
+
+    CameraManager camera_manager;
+
     AnimationPlayerDescriptor animation_player_descriptor{};
     animation_player_descriptor.timer = &timer;
     animation_player_descriptor.task_scheduler = &task_scheduler;
+    animation_player_descriptor.camera_manager = &camera_manager;
+    animation_player_descriptor.lod_screen_size = 0.1f;
+    animation_player_descriptor.lod_update_interval = 2;
+    animation_player_descriptor.invisible_update_interval = 8;
     animation_player_descriptor.persistent_memory_resource = &persistent_memory_resource;
     animation_player_descriptor.transient_memory_resource = &transient_memory_resource;
 
@@ -190,11 +202,9 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
 
     ReflectionProbeManager reflection_probe_manager(reflection_probe_manager_descriptor);
 
-    OctreeAccelerationStructure geometry_acceleration_structure(persistent_memory_resource);
-
     LinearAccelerationStructure light_acceleration_structure(persistent_memory_resource);
 
-    LinearAccelerationStructure particle_system_acceleration_structure(persistent_memory_resource);
+    SnapshotAccelerationStructure particle_system_acceleration_structure(persistent_memory_resource);
 
     LinearAccelerationStructure reflection_probe_acceleration_structure(persistent_memory_resource);
 
@@ -211,8 +221,6 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
 
     Scene scene(scene_descriptor);
 
-    CameraManager camera_manager;
-
     CameraControllerDescriptor camera_controller_descriptor{};
     camera_controller_descriptor.window = &window;
     camera_controller_descriptor.input = &input;
@@ -234,10 +242,17 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
 
     CpuProfilerOverlayDescriptor cpu_profiler_overlay_descriptor{};
     cpu_profiler_overlay_descriptor.imgui_manager = &imgui_manager;
+    cpu_profiler_overlay_descriptor.task_scheduler = &task_scheduler;
     cpu_profiler_overlay_descriptor.transient_memory_resource = &transient_memory_resource;
 
     CpuProfilerOverlay cpu_profiler_overlay(cpu_profiler_overlay_descriptor);
 
+    CpuProfilerExporterDescriptor cpu_profiler_exporter_descriptor{};
+    cpu_profiler_exporter_descriptor.memory_budget = 16 * 1024 * 1024;
+    cpu_profiler_exporter_descriptor.persistent_memory_resource = &persistent_memory_resource;
+
+    CpuProfilerExporter cpu_profiler_exporter(cpu_profiler_exporter_descriptor);
+
     ShadowManagerDescriptor shadow_manager_descriptor{};
     shadow_manager_descriptor.render = render.get();
     shadow_manager_descriptor.scene = &scene;
@@ -249,6 +264,18 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
 
     ShadowManager shadow_manager(shadow_manager_descriptor);
 
+    OcclusionCullerDescriptor occlusion_culler_descriptor{};
+    occlusion_culler_descriptor.scene = &scene;
+    occlusion_culler_descriptor.camera_manager = &camera_manager;
+    occlusion_culler_descriptor.task_scheduler = &task_scheduler;
+    occlusion_culler_descriptor.width = 256;
+    occlusion_culler_descriptor.height = 128;
+    occlusion_culler_descriptor.max_occluder_count = 32;
+    occlusion_culler_descriptor.persistent_memory_resource = &persistent_memory_resource;
+    occlusion_culler_descriptor.transient_memory_resource = &transient_memory_resource;
+
+    OcclusionCuller occlusion_culler(occlusion_culler_descriptor);
+
     OpaqueShadowRenderPassDescriptor opaque_shadow_render_pass_descriptor{};
     opaque_shadow_render_pass_descriptor.scene = &scene;
     opaque_shadow_render_pass_descriptor.shadow_manager = &shadow_manager;
@@ -268,6 +295,7 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
     GeometryRenderPassDescriptor geometry_render_pass_descriptor{};
     geometry_render_pass_descriptor.scene = &scene;
     geometry_render_pass_descriptor.camera_manager = &camera_manager;
+    geometry_render_pass_descriptor.occlusion_culler = &occlusion_culler;
     geometry_render_pass_descriptor.transient_memory_resource = &transient_memory_resource;
 
     GeometryRenderPass geometry_render_pass(geometry_render_pass_descriptor);
@@ -299,6 +327,7 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
     ParticleSystemRenderPassDescriptor particle_system_render_pass_descriptor{};
     particle_system_render_pass_descriptor.scene = &scene;
     particle_system_render_pass_descriptor.camera_manager = &camera_manager;
+    particle_system_render_pass_descriptor.occlusion_culler = &occlusion_culler;
     particle_system_render_pass_descriptor.transient_memory_resource = &transient_memory_resource;
 
     ParticleSystemRenderPass particle_system_render_pass(particle_system_render_pass_descriptor);
@@ -445,6 +474,18 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
             reflection_probe_manager.bake(*render, scene);
         }
 
+        if (input.is_key_pressed(Scancode::F5) && !cpu_profiler_exporter.is_capturing()) {
+            if (!cpu_profiler_exporter.begin_capture("cpu_profile.json", 300)) {
+                Log::print("Failed to begin CPU profiler capture.");
+            }
+        }
+
+        // Compare CPU profiler captures with and without occlusion culling.
+        if (input.is_key_pressed(Scancode::F6)) {
+            occlusion_culler.set_enabled(!occlusion_culler.is_enabled());
+            Log::print("Occlusion culling is %s.", occlusion_culler.is_enabled() ? "enabled" : "disabled");
+        }
+
         auto [animation_player_begin, animation_player_end] = animation_player.create_tasks();
         auto [particle_system_player_begin, particle_system_player_end] = particle_system_player.create_tasks();
         auto [texture_manager_begin, texture_manager_end] = texture_manager.create_tasks();
@@ -453,9 +494,12 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
         auto [animation_manager_begin, animation_manager_end] = animation_manager.create_tasks();
         auto [particle_system_manager_begin, particle_system_manager_end] = particle_system_manager.create_tasks();
         auto [container_manager_begin, container_manager_end] = container_manager.create_tasks();
+        Task* geometry_acceleration_structure_task = geometry_acceleration_structure.create_task(transient_memory_resource);
+        Task* particle_system_acceleration_structure_task = particle_system_acceleration_structure.create_task(transient_memory_resource);
         auto [acquire_frame_task, present_frame_task] = frame_graph->create_tasks();
         auto [reflection_probe_manager_begin, reflection_probe_manager_end] = reflection_probe_manager.create_tasks();
         Task* shadow_manager_task = shadow_manager.create_task();
+        auto [occlusion_culler_begin, occlusion_culler_end] = occlusion_culler.create_tasks();
         auto [opaque_shadow_render_pass_task_begin, opaque_shadow_render_pass_task_end] = opaque_shadow_render_pass.create_tasks();
         auto [transcluent_shadow_render_pass_task_begin, transcluent_shadow_render_pass_task_end] = transcluent_shadow_render_pass.create_tasks();
         Task* geometry_render_pass_task = geometry_render_pass.create_task();
@@ -479,7 +523,12 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
         material_manager_tasks.begin->add_input_dependencies(transient_memory_resource, { particle_system_manager_end, container_manager_end });
         material_manager_tasks.material_end->add_input_dependencies(transient_memory_resource, { material_manager_tasks.begin });
         material_manager_tasks.graphics_pipeline_end->add_input_dependencies(transient_memory_resource, { material_manager_tasks.material_end });
-        texture_manager_begin->add_input_dependencies(transient_memory_resource, { material_manager_tasks.material_end, container_manager_end });
+        // Texture streaming replaces textures and their image views, so it can't run while render passes (including
+        // reflection probe bakes) are recorded. It runs after them instead, which keeps it off the critical path of
+        // this frame's present. Textures uploaded after the flush are transferred to device on the next frame.
+        texture_manager_begin->add_input_dependencies(transient_memory_resource, {
+            material_manager_tasks.material_end, container_manager_end, flush_task, reflection_probe_manager_end
+        });
         texture_manager_end->add_input_dependencies(transient_memory_resource, { texture_manager_begin });
         geometry_manager_begin->add_input_dependencies(transient_memory_resource, { container_manager_end });
         geometry_manager_end->add_input_dependencies(transient_memory_resource, { geometry_manager_begin });
@@ -488,16 +537,21 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
         particle_system_manager_begin->add_input_dependencies(transient_memory_resource, { container_manager_end });
         particle_system_manager_end->add_input_dependencies(transient_memory_resource, { particle_system_manager_begin });
         container_manager_end->add_input_dependencies(transient_memory_resource, { container_manager_begin });
-        acquire_frame_task->add_input_dependencies(transient_memory_resource, { animation_manager_end, material_manager_tasks.graphics_pipeline_end, texture_manager_end, geometry_manager_end });
+        // Containers may destroy their primitives, so acceleration structures are committed before they're queried.
+        geometry_acceleration_structure_task->add_input_dependencies(transient_memory_resource, { container_manager_end });
+        particle_system_acceleration_structure_task->add_input_dependencies(transient_memory_resource, { container_manager_end, particle_system_player_end });
+        acquire_frame_task->add_input_dependencies(transient_memory_resource, { animation_manager_end, material_manager_tasks.graphics_pipeline_end, geometry_manager_end });
         opaque_shadow_render_pass_task_begin->add_input_dependencies(transient_memory_resource, { acquire_frame_task, animation_player_end, shadow_manager_task });
         opaque_shadow_render_pass_task_end->add_input_dependencies(transient_memory_resource, { opaque_shadow_render_pass_task_begin });
-        transcluent_shadow_render_pass_task_begin->add_input_dependencies(transient_memory_resource, { acquire_frame_task, particle_system_player_end, shadow_manager_task });
+        transcluent_shadow_render_pass_task_begin->add_input_dependencies(transient_memory_resource, { acquire_frame_task, particle_system_acceleration_structure_task, shadow_manager_task });
         transcluent_shadow_render_pass_task_end->add_input_dependencies(transient_memory_resource, { transcluent_shadow_render_pass_task_begin });
-        geometry_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task, animation_player_end });
+        occlusion_culler_begin->add_input_dependencies(transient_memory_resource, { acquire_frame_task, animation_player_end });
+        occlusion_culler_end->add_input_dependencies(transient_memory_resource, { occlusion_culler_begin });
+        geometry_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task, animation_player_end, occlusion_culler_end });
         lighting_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task, shadow_manager_task });
         reflection_probe_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task });
         emission_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task });
-        particle_system_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task, particle_system_player_end });
+        particle_system_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task, particle_system_acceleration_structure_task, occlusion_culler_end });
         tonemapping_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task });
         antialiasing_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task });
         debug_draw_render_pass_task->add_input_dependencies(transient_memory_resource, { acquire_frame_task });
@@ -534,8 +588,12 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
         task_scheduler.enqueue_task(transient_memory_resource, texture_manager_end);
         task_scheduler.enqueue_task(transient_memory_resource, geometry_manager_begin);
         task_scheduler.enqueue_task(transient_memory_resource, geometry_manager_end);
+        task_scheduler.enqueue_task(transient_memory_resource, geometry_acceleration_structure_task);
+        task_scheduler.enqueue_task(transient_memory_resource, particle_system_acceleration_structure_task);
         task_scheduler.enqueue_task(transient_memory_resource, acquire_frame_task);
         task_scheduler.enqueue_task(transient_memory_resource, shadow_manager_task);
+        task_scheduler.enqueue_task(transient_memory_resource, occlusion_culler_begin);
+        task_scheduler.enqueue_task(transient_memory_resource, occlusion_culler_end);
         task_scheduler.enqueue_task(transient_memory_resource, opaque_shadow_render_pass_task_begin);
         task_scheduler.enqueue_task(transient_memory_resource, opaque_shadow_render_pass_task_end);
         task_scheduler.enqueue_task(transient_memory_resource, transcluent_shadow_render_pass_task_begin);
@@ -555,6 +613,7 @@ int WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPSTR /
         task_scheduler.join();
 
         CpuProfiler::instance().update();
+        cpu_profiler_exporter.update();
     }
 
     imgui_render_pass.destroy_graphics_pipelines(*frame_graph);
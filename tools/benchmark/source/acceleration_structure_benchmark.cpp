@@ -0,0 +1,438 @@
+#include "benchmark.h"
+
+#include <render/acceleration_structure/acceleration_structure_primitive.h>
+#include <render/acceleration_structure/bvh_acceleration_structure.h>
+#include <render/acceleration_structure/linear_acceleration_structure.h>
+#include <render/acceleration_structure/octree_acceleration_structure.h>
+#include <render/acceleration_structure/query_views.h>
+#include <render/acceleration_structure/snapshot_acceleration_structure.h>
+#include <render/container/container_primitive.h>
+
+#include <core/math/float4x4.h>
+#include <core/math/scalar.h>
+#include <core/memory/malloc_memory_resource.h>
+
+#include <bitset>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+
+using namespace kw;
+
+static constexpr size_t CONTAINER_COUNT = 16;
+static constexpr size_t CONTAINER_PRIMITIVE_COUNT = 64;
+static constexpr size_t CONTAINER_MOVE_COUNT = 1000;
+static constexpr size_t CONTAINER_REPETITION_COUNT = 5;
+
+static constexpr size_t CITY_PRIMITIVE_COUNT = 500000;
+static constexpr float CITY_EXTENT = 1000.f;
+static constexpr size_t CITY_QUERY_COUNT = 200;
+
+static constexpr size_t SPONZA_QUERY_COUNT = 10000;
+
+static constexpr size_t MULTI_VIEW_PRIMITIVE_COUNT = 100000;
+static constexpr float MULTI_VIEW_EXTENT = 200.f;
+static constexpr size_t MULTI_VIEW_LIGHT_COUNT = 64;
+static constexpr float MULTI_VIEW_NEAR_PLANE = 0.1f;
+static constexpr float MULTI_VIEW_FAR_PLANE = 20.f;
+static constexpr size_t MULTI_VIEW_REPETITION_COUNT = 5;
+
+struct CubemapVectors {
+    float3 direction;
+    float3 up;
+};
+
+static CubemapVectors CUBEMAP_VECTORS[] = {
+    { float3( 1.f,  0.f,  0.f), float3(0.f, 1.f,  0.f) },
+    { float3(-1.f,  0.f,  0.f), float3(0.f, 1.f,  0.f) },
+    { float3( 0.f,  1.f,  0.f), float3(0.f, 0.f, -1.f) },
+    { float3( 0.f, -1.f,  0.f), float3(0.f, 0.f,  1.f) },
+    { float3( 0.f,  0.f,  1.f), float3(0.f, 1.f,  0.f) },
+    { float3( 0.f,  0.f, -1.f), float3(0.f, 1.f,  0.f) },
+};
+
+// World space bounds of geometry primitives from the render example's "resource/containers/sponza.kwm": the skybox,
+// 24 sponza meshes and 4 knights. Few large overlapping primitives, unlike the synthetic city.
+static const aabbox SPONZA_BOUNDS[] = {
+    aabbox(float3( 0.000f, 0.000f,  0.000f), float3(32.000f, 32.000f, 32.000f)),
+    aabbox(float3(-0.484f, 10.840f, -0.310f), float3(14.883f, 0.596f, 9.153f)),
+    aabbox(float3(-0.516f, 0.788f, -0.299f), float3(4.926f, 1.013f, 2.430f)),
+    aabbox(float3(-0.524f, 0.462f, -0.296f), float3(7.419f, 0.123f, 1.799f)),
+    aabbox(float3(-0.526f, 0.209f, -0.289f), float3(7.400f, 0.241f, 1.724f)),
+    aabbox(float3(-0.514f, 3.197f, -0.299f), float3(10.913f, 2.871f, 1.008f)),
+    aabbox(float3(-0.481f, 4.883f, -0.397f), float3(14.455f, 5.895f, 8.715f)),
+    aabbox(float3(-0.524f, 5.946f, -0.289f), float3(7.899f, 4.254f, 2.256f)),
+    aabbox(float3(-0.509f, 5.919f, -0.281f), float3(10.927f, 4.192f, 4.880f)),
+    aabbox(float3(-0.526f, 0.874f, -0.281f), float3(7.931f, 0.894f, 2.254f)),
+    aabbox(float3(-0.520f, 1.652f, -0.285f), float3(10.938f, 1.672f, 4.878f)),
+    aabbox(float3(-0.508f, 3.512f, -0.285f), float3(10.934f, 2.051f, 4.891f)),
+    aabbox(float3( 3.223f, 2.859f, -0.186f), float3(7.301f, 2.876f, 5.026f)),
+    aabbox(float3(-0.521f, 4.825f, -0.300f), float3(7.780f, 0.772f, 2.178f)),
+    aabbox(float3(-0.514f, 1.379f, -0.287f), float3(10.906f, 0.739f, 0.630f)),
+    aabbox(float3(-0.514f, 4.644f, -0.322f), float3(7.156f, 2.445f, 1.995f)),
+    aabbox(float3(-0.527f, 3.440f, -0.289f), float3(5.743f, 0.725f, 2.307f)),
+    aabbox(float3(-0.552f, 3.440f, -0.289f), float3(5.743f, 0.725f, 2.307f)),
+    aabbox(float3(-0.540f, 3.440f, -0.289f), float3(2.807f, 0.725f, 2.307f)),
+    aabbox(float3( 0.970f, 1.133f, -0.327f), float3(5.591f, 1.136f, 2.035f)),
+    aabbox(float3(-0.504f, 1.133f, -0.327f), float3(7.066f, 1.136f, 2.035f)),
+    aabbox(float3(-1.993f, 1.133f, -0.303f), float3(5.577f, 1.136f, 2.011f)),
+    aabbox(float3(-0.526f, 1.392f, -0.305f), float3(4.633f, 0.323f, 1.466f)),
+    aabbox(float3(-0.526f, 1.262f, -0.305f), float3(4.707f, 0.473f, 1.669f)),
+    aabbox(float3(-0.330f, 0.529f, -0.181f), float3(9.883f, 0.535f, 4.007f)),
+    aabbox(float3( 8.847f, 0.863f,  0.953f), float3(0.599f, 0.863f, 0.899f)),
+    aabbox(float3( 8.847f, 0.863f, -1.697f), float3(0.599f, 0.863f, 0.899f)),
+    aabbox(float3(-9.847f, 0.863f,  1.047f), float3(0.599f, 0.863f, 0.899f)),
+    aabbox(float3(-9.847f, 0.863f, -1.603f), float3(0.599f, 0.863f, 0.899f)),
+};
+
+// Acceleration structure primitive with constant local bounds, like a geometry primitive.
+class BoxPrimitive : public AccelerationStructurePrimitive {
+public:
+    BoxPrimitive(const aabbox& local_bounds, const transform& local_transform)
+        : AccelerationStructurePrimitive(local_transform)
+        , m_local_bounds(local_bounds)
+    {
+        update_bounds();
+    }
+
+    UniquePtr<Primitive> clone(MemoryResource& memory_resource) const override {
+        return static_pointer_cast<Primitive>(allocate_unique<BoxPrimitive>(memory_resource, *this));
+    }
+
+protected:
+    void update_bounds() override {
+        m_bounds = m_local_bounds * get_global_transform();
+    }
+
+private:
+    aabbox m_local_bounds;
+};
+
+// Some acceleration structures apply changes in a task that runs once per frame.
+static void commit(AccelerationStructure& acceleration_structure) {
+    if (SnapshotAccelerationStructure* snapshot_acceleration_structure = dynamic_cast<SnapshotAccelerationStructure*>(&acceleration_structure)) {
+        snapshot_acceleration_structure->commit();
+    } else if (BvhAccelerationStructure* bvh_acceleration_structure = dynamic_cast<BvhAccelerationStructure*>(&acceleration_structure)) {
+        bvh_acceleration_structure->rebuild_if_needed();
+    }
+}
+
+void run_container_benchmark() {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position_distribution(-16.f, 16.f);
+    std::uniform_real_distribution<float> extent_distribution(0.1f, 2.f);
+
+    OctreeAccelerationStructure container_acceleration_structure(memory_resource);
+    OctreeAccelerationStructure primitive_acceleration_structure(memory_resource);
+
+    // The root container holds nested containers, which hold render primitives.
+    ContainerPrimitive root(memory_resource);
+
+    // The same render primitives without containers, their local transforms are the global transforms above.
+    Vector<UniquePtr<BoxPrimitive>> primitives(memory_resource);
+    primitives.reserve(CONTAINER_COUNT * CONTAINER_PRIMITIVE_COUNT);
+
+    Vector<transform> primitive_transforms(memory_resource);
+    primitive_transforms.reserve(CONTAINER_COUNT * CONTAINER_PRIMITIVE_COUNT);
+
+    for (size_t i = 0; i < CONTAINER_COUNT; i++) {
+        transform container_transform(float3(position_distribution(random), 0.f, position_distribution(random)));
+
+        UniquePtr<ContainerPrimitive> container = allocate_unique<ContainerPrimitive>(memory_resource, memory_resource, nullptr, container_transform);
+
+        for (size_t j = 0; j < CONTAINER_PRIMITIVE_COUNT; j++) {
+            aabbox local_bounds(float3(), float3(extent_distribution(random), extent_distribution(random), extent_distribution(random)));
+            transform local_transform(float3(position_distribution(random), position_distribution(random), position_distribution(random)));
+
+            UniquePtr<BoxPrimitive> child = allocate_unique<BoxPrimitive>(memory_resource, local_bounds, local_transform);
+            container_acceleration_structure.add(*child);
+            container->add_child(std::move(child));
+
+            UniquePtr<BoxPrimitive>& primitive = primitives.emplace_back(allocate_unique<BoxPrimitive>(memory_resource, local_bounds, local_transform * container_transform));
+            primitive_acceleration_structure.add(*primitive);
+            primitive_transforms.push_back(primitive->get_local_transform());
+        }
+
+        root.add_child(std::move(container));
+    }
+
+    // Move all render primitives with one transform change.
+    double container_time = measure(CONTAINER_REPETITION_COUNT, [&] {
+        for (size_t i = 0; i < CONTAINER_MOVE_COUNT; i++) {
+            root.set_local_transform(transform(float3(static_cast<float>(i % 64), 0.f, 0.f)));
+        }
+    });
+
+    // Same bounds changes, but render primitives are moved one by one.
+    double primitive_time = measure(CONTAINER_REPETITION_COUNT, [&] {
+        for (size_t i = 0; i < CONTAINER_MOVE_COUNT; i++) {
+            transform offset(float3(static_cast<float>(i % 64), 0.f, 0.f));
+
+            for (size_t j = 0; j < primitives.size(); j++) {
+                primitives[j]->set_local_transform(primitive_transforms[j] * offset);
+            }
+        }
+    });
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "    " << primitives.size() << " primitives in " << CONTAINER_COUNT << " containers" << std::endl
+              << "    container move    " << container_time * 1e3 / CONTAINER_MOVE_COUNT << " us" << std::endl
+              << "    primitive moves   " << primitive_time * 1e3 / CONTAINER_MOVE_COUNT << " us" << std::endl;
+}
+
+// Add, query and move a synthetic city of small boxes spread over a large plane.
+static void run_city(const char* name, AccelerationStructure& acceleration_structure, const Vector<aabbox>& bounds) {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    Vector<UniquePtr<BoxPrimitive>> primitives(memory_resource);
+    primitives.reserve(bounds.size());
+
+    for (const aabbox& box : bounds) {
+        primitives.push_back(allocate_unique<BoxPrimitive>(memory_resource, aabbox(float3(), box.extent), transform(box.center)));
+    }
+
+    // Some acceleration structures defer their build until commit, it's a part of adding primitives.
+    double add_time = measure(1, [&] {
+        for (UniquePtr<BoxPrimitive>& primitive : primitives) {
+            acceleration_structure.add(*primitive);
+        }
+
+        commit(acceleration_structure);
+    });
+
+    // The camera stands in the middle of the city and turns around.
+    size_t visible_count = 0;
+    double query_time = measure(1, [&] {
+        for (size_t i = 0; i < CITY_QUERY_COUNT; i++) {
+            float angle = static_cast<float>(i) * 0.1f;
+            float3 direction(std::cos(angle), 0.f, std::sin(angle));
+
+            frustum frustum(float4x4::look_at_lh(float3(0.f, 10.f, 0.f), float3(0.f, 10.f, 0.f) + direction, float3(0.f, 1.f, 0.f)) *
+                            float4x4::perspective_lh(1.2f, 16.f / 9.f, 0.1f, 300.f));
+
+            visible_count += acceleration_structure.query(memory_resource, frustum).size();
+        }
+    });
+
+    double update_time = measure(1, [&] {
+        for (UniquePtr<BoxPrimitive>& primitive : primitives) {
+            primitive->set_local_translation(primitive->get_local_translation() + float3(1.f, 0.f, 0.f));
+        }
+
+        commit(acceleration_structure);
+    });
+
+    double remove_time = measure(1, [&] {
+        for (UniquePtr<BoxPrimitive>& primitive : primitives) {
+            acceleration_structure.remove(*primitive);
+        }
+
+        commit(acceleration_structure);
+    });
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "    " << std::left << std::setw(10) << name << std::right
+              << "add " << std::setw(7) << add_time << " ms   "
+              << "query " << std::setw(6) << std::setprecision(2) << query_time / CITY_QUERY_COUNT << " ms   "
+              << "move all " << std::setw(8) << std::setprecision(1) << update_time << " ms   "
+              << "remove " << std::setw(7) << remove_time << " ms   "
+              << visible_count / CITY_QUERY_COUNT << " visible" << std::endl;
+}
+
+// Query the sponza scene with the render example's default camera walking along the nave and turning around.
+static void run_sponza(const char* name, AccelerationStructure& acceleration_structure) {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    Vector<UniquePtr<BoxPrimitive>> primitives(memory_resource);
+
+    for (const aabbox& box : SPONZA_BOUNDS) {
+        primitives.push_back(allocate_unique<BoxPrimitive>(memory_resource, aabbox(float3(), box.extent), transform(box.center)));
+        acceleration_structure.add(*primitives.back());
+    }
+
+    // Build deferred acceleration structures before measuring.
+    commit(acceleration_structure);
+
+    size_t visible_count = 0;
+    double query_time = measure(1, [&] {
+        for (size_t i = 0; i < SPONZA_QUERY_COUNT; i++) {
+            float offset = static_cast<float>(i) / SPONZA_QUERY_COUNT * 20.f - 10.f;
+            float angle = static_cast<float>(i) * 0.01f;
+
+            float3 eye(offset, 1.7f, 0.3f);
+            float3 direction(std::cos(angle), 0.f, std::sin(angle));
+
+            frustum frustum(float4x4::look_at_lh(eye, eye + direction, float3(0.f, 1.f, 0.f)) *
+                            float4x4::perspective_lh(radians(70.f), 16.f / 9.f, 0.05f, 50.f));
+
+            acceleration_structure.query(frustum, [&](AccelerationStructurePrimitive* const*, size_t count) {
+                visible_count += count;
+            });
+        }
+    });
+
+    for (UniquePtr<BoxPrimitive>& primitive : primitives) {
+        acceleration_structure.remove(*primitive);
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "    " << std::left << std::setw(10) << name << std::right
+              << "query " << std::setw(6) << query_time * 1e3 / SPONZA_QUERY_COUNT << " us   "
+              << std::setprecision(1) << static_cast<double>(visible_count) / SPONZA_QUERY_COUNT << " visible" << std::endl;
+}
+
+void run_acceleration_structure_benchmark() {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position_distribution(-CITY_EXTENT, CITY_EXTENT);
+    std::uniform_real_distribution<float> extent_distribution(0.1f, 5.f);
+
+    // Buildings are taller than wide and stand on the ground.
+    Vector<aabbox> bounds(memory_resource);
+    bounds.reserve(CITY_PRIMITIVE_COUNT);
+
+    for (size_t i = 0; i < CITY_PRIMITIVE_COUNT; i++) {
+        float3 extent(extent_distribution(random), extent_distribution(random) * 4.f, extent_distribution(random));
+        bounds.push_back(aabbox(float3(position_distribution(random), extent.y, position_distribution(random)), extent));
+    }
+
+    std::cout << "    " << CITY_PRIMITIVE_COUNT << " primitives, " << CITY_QUERY_COUNT << " frustum queries" << std::endl;
+
+    {
+        LinearAccelerationStructure acceleration_structure(memory_resource);
+        run_city("linear", acceleration_structure, bounds);
+    }
+
+    {
+        OctreeAccelerationStructure acceleration_structure(memory_resource, float3(), float3(CITY_EXTENT + 24.f));
+        run_city("octree", acceleration_structure, bounds);
+    }
+
+    {
+        BvhAccelerationStructure acceleration_structure(memory_resource);
+        run_city("bvh", acceleration_structure, bounds);
+    }
+
+    {
+        SnapshotAccelerationStructure acceleration_structure(memory_resource);
+        run_city("snapshot", acceleration_structure, bounds);
+    }
+
+    std::cout << "    sponza, " << std::size(SPONZA_BOUNDS) << " primitives, " << SPONZA_QUERY_COUNT << " frustum queries" << std::endl;
+
+    {
+        LinearAccelerationStructure acceleration_structure(memory_resource);
+        run_sponza("linear", acceleration_structure);
+    }
+
+    {
+        OctreeAccelerationStructure acceleration_structure(memory_resource, float3(), float3(64.f));
+        run_sponza("octree", acceleration_structure);
+    }
+
+    {
+        BvhAccelerationStructure acceleration_structure(memory_resource);
+        run_sponza("bvh", acceleration_structure);
+    }
+
+    {
+        SnapshotAccelerationStructure acceleration_structure(memory_resource);
+        run_sponza("snapshot", acceleration_structure);
+    }
+}
+
+// Cull point light shadow maps like shadow render passes do: six faces per light.
+void run_multi_view_benchmark() {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position_distribution(-MULTI_VIEW_EXTENT, MULTI_VIEW_EXTENT);
+    std::uniform_real_distribution<float> height_distribution(0.f, 20.f);
+    std::uniform_real_distribution<float> extent_distribution(0.1f, 2.f);
+
+    OctreeAccelerationStructure acceleration_structure(memory_resource, float3(), float3(MULTI_VIEW_EXTENT + 8.f));
+
+    Vector<UniquePtr<BoxPrimitive>> primitives(memory_resource);
+    primitives.reserve(MULTI_VIEW_PRIMITIVE_COUNT);
+
+    for (size_t i = 0; i < MULTI_VIEW_PRIMITIVE_COUNT; i++) {
+        aabbox local_bounds(float3(), float3(extent_distribution(random), extent_distribution(random), extent_distribution(random)));
+        transform local_transform(float3(position_distribution(random), height_distribution(random), position_distribution(random)));
+
+        primitives.push_back(allocate_unique<BoxPrimitive>(memory_resource, local_bounds, local_transform));
+        acceleration_structure.add(*primitives.back());
+    }
+
+    Vector<float3> lights(memory_resource);
+    Vector<frustum> frustums(memory_resource);
+
+    for (size_t i = 0; i < MULTI_VIEW_LIGHT_COUNT; i++) {
+        float3 translation(position_distribution(random), height_distribution(random), position_distribution(random));
+        lights.push_back(translation);
+
+        for (const CubemapVectors& cubemap_vectors : CUBEMAP_VECTORS) {
+            float4x4 view = float4x4::look_at_lh(translation, translation + cubemap_vectors.direction, cubemap_vectors.up);
+            float4x4 projection = float4x4::perspective_lh(PI / 2.f, 1.f, MULTI_VIEW_NEAR_PLANE, MULTI_VIEW_FAR_PLANE);
+            frustums.push_back(frustum(view * projection));
+        }
+    }
+
+    // Number of primitive and face pairs, the same for all methods if they are equally precise.
+    size_t face_count = 0;
+
+    double face_time = measure(MULTI_VIEW_REPETITION_COUNT, [&] {
+        face_count = 0;
+
+        for (const frustum& frustum : frustums) {
+            acceleration_structure.query(frustum, [&](AccelerationStructurePrimitive* const*, size_t count) {
+                face_count += count;
+            });
+        }
+    });
+
+    size_t frustums_face_count = 0;
+
+    double frustums_time = measure(MULTI_VIEW_REPETITION_COUNT, [&] {
+        frustums_face_count = 0;
+
+        for (size_t i = 0; i < MULTI_VIEW_LIGHT_COUNT; i++) {
+            QueryViews views(frustums.data() + i * 6, 6);
+
+            acceleration_structure.query(views, [&](AccelerationStructurePrimitive* const*, const uint64_t* masks, size_t count) {
+                for (size_t j = 0; j < count; j++) {
+                    frustums_face_count += std::bitset<64>(masks[j]).count();
+                }
+            });
+        }
+    });
+
+    size_t cubemap_face_count = 0;
+
+    double cubemap_time = measure(MULTI_VIEW_REPETITION_COUNT, [&] {
+        cubemap_face_count = 0;
+
+        for (const float3& light : lights) {
+            QueryViews views(light, MULTI_VIEW_NEAR_PLANE, MULTI_VIEW_FAR_PLANE);
+
+            acceleration_structure.query(views, [&](AccelerationStructurePrimitive* const*, const uint64_t* masks, size_t count) {
+                for (size_t j = 0; j < count; j++) {
+                    cubemap_face_count += std::bitset<64>(masks[j]).count();
+                }
+            });
+        }
+    });
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "    " << MULTI_VIEW_PRIMITIVE_COUNT << " primitives, " << MULTI_VIEW_LIGHT_COUNT << " point lights" << std::endl
+              << "    six frustum queries  " << face_time * 1e3 / MULTI_VIEW_LIGHT_COUNT << " us per light, "
+              << face_count << " primitive faces" << std::endl
+              << "    six frustum views    " << frustums_time * 1e3 / MULTI_VIEW_LIGHT_COUNT << " us per light, "
+              << frustums_face_count << " primitive faces" << std::endl
+              << "    cubemap views        " << cubemap_time * 1e3 / MULTI_VIEW_LIGHT_COUNT << " us per light, "
+              << cubemap_face_count << " primitive faces" << std::endl;
+}
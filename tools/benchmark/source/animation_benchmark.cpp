@@ -0,0 +1,452 @@
+#include "benchmark.h"
+
+#include <render/animation/animation.h>
+#include <render/animation/animation_blend_tree.h>
+#include <render/animation/animation_cursor.h>
+#include <render/geometry/skeleton.h>
+#include <render/geometry/skeleton_pose.h>
+
+#include <core/containers/shared_ptr.h>
+#include <core/math/float4x4.h>
+#include <core/memory/malloc_memory_resource.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+
+using namespace kw;
+
+static constexpr uint32_t ANIMATION_JOINT_COUNT = 61;
+static constexpr uint32_t ANIMATION_KEYFRAME_COUNT = 120;
+static constexpr float ANIMATION_DURATION = 4.f;
+static constexpr float ANIMATION_FRAME_TIME = 1.f / 60.f;
+
+static constexpr size_t SAMPLING_INSTANCE_COUNT = 100;
+static constexpr size_t SAMPLING_FRAME_COUNT = 240;
+static constexpr size_t SAMPLING_REPETITION_COUNT = 5;
+
+static constexpr size_t BLEND_TREE_CHARACTER_COUNT = 500;
+static constexpr size_t BLEND_TREE_CLIP_COUNT = 3;
+static constexpr size_t BLEND_TREE_FRAME_COUNT = 60;
+
+static constexpr size_t SKELETON_POSE_COUNT = 500;
+static constexpr size_t SKELETON_POSE_REPETITION_COUNT = 60;
+
+// Joint hierarchies of the knight and robot models from render example resources.
+static const uint32_t KNIGHT_PARENT_JOINTS[] = {
+    UINT32_MAX, 0, 1, 2, 3, 4, 5, 3, 7, 8, 9, 10, 11, 12, 13, 10, 15, 16, 17, 10, 19, 20, 21, 10, 23, 24, 25, 10, 27, 28,
+    29, 9, 3, 32, 33, 34, 35, 36, 37, 38, 35, 40, 41, 42, 35, 44, 45, 46, 35, 48, 49, 50, 35, 52, 53, 54, 35, 0, 57, 58,
+    59, 60, 0, 62, 63, 64, 65,
+};
+
+static const uint32_t ROBOT_PARENT_JOINTS[] = {
+    UINT32_MAX, 0, 1, 2, 3, 4, 3, 6, 7, 8, 3, 10, 11, 12, 0, 14, 15, 16, 0, 18, 19, 20,
+};
+
+// Must match the compressed animation format in `render/animation/animation.cpp`.
+static constexpr float QUANTIZED_TIMESTAMP_MAX = 65535.f;
+static constexpr float QUANTIZED_VALUE_MAX = 65535.f;
+static constexpr float QUANTIZED_ROTATION_MAX = 32767.f;
+static constexpr float ROTATION_COMPONENT_MAX = 0.70710678f;
+
+// Smoothly changing random joint transforms, like a motion captured clip. Keyframes are evenly spaced.
+static Vector<Animation::JointAnimation> create_joint_animations(std::mt19937& random, uint32_t joint_count) {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    Vector<Animation::JointAnimation> joint_animations(memory_resource);
+    joint_animations.reserve(joint_count);
+
+    for (uint32_t joint_index = 0; joint_index < joint_count; joint_index++) {
+        Animation::JointAnimation& joint_animation = joint_animations.emplace_back(Animation::JointAnimation{ Vector<Animation::JointKeyframe>(memory_resource) });
+        joint_animation.keyframes.reserve(ANIMATION_KEYFRAME_COUNT);
+
+        float3 translation(distribution(random), distribution(random), distribution(random));
+        quaternion rotation = normalize(quaternion(distribution(random), distribution(random), distribution(random), distribution(random)));
+
+        for (uint32_t keyframe_index = 0; keyframe_index < ANIMATION_KEYFRAME_COUNT; keyframe_index++) {
+            float timestamp = ANIMATION_DURATION * keyframe_index / (ANIMATION_KEYFRAME_COUNT - 1);
+
+            translation += float3(distribution(random), distribution(random), distribution(random)) * 0.01f;
+            rotation = slerp(rotation, normalize(quaternion(distribution(random), distribution(random), distribution(random), distribution(random))), 0.05f);
+
+            joint_animation.keyframes.push_back(Animation::JointKeyframe{ timestamp, transform(translation, rotation) });
+        }
+    }
+
+    return joint_animations;
+}
+
+// Each joint's parent is one of the few previous joints.
+static Vector<uint32_t> create_parent_joints(std::mt19937& random, uint32_t joint_count) {
+    Vector<uint32_t> parent_joints(MallocMemoryResource::instance());
+    parent_joints.reserve(joint_count);
+
+    for (uint32_t joint_index = 0; joint_index < joint_count; joint_index++) {
+        parent_joints.push_back(joint_index > 0 ? joint_index - 1 - random() % std::min(joint_index, 3U) : UINT32_MAX);
+    }
+
+    return parent_joints;
+}
+
+// Bind pose is identity, joint names are their indices.
+static Skeleton create_skeleton(Vector<uint32_t>&& parent_joints) {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    size_t joint_count = parent_joints.size();
+
+    UnorderedMap<String, uint32_t> joint_mapping(memory_resource);
+    for (uint32_t joint_index = 0; joint_index < joint_count; joint_index++) {
+        joint_mapping.emplace(String(std::to_string(joint_index).c_str(), memory_resource), joint_index);
+    }
+
+    Vector<float4x4> inverse_bind_matrices(joint_count, float4x4(), memory_resource);
+    Vector<float4x4> bind_matrices(joint_count, float4x4(), memory_resource);
+
+    return Skeleton(std::move(parent_joints), std::move(inverse_bind_matrices), std::move(bind_matrices), std::move(joint_mapping));
+}
+
+static Skeleton create_skeleton(const uint32_t* parent_joints, size_t joint_count) {
+    return create_skeleton(Vector<uint32_t>(parent_joints, parent_joints + joint_count, MallocMemoryResource::instance()));
+}
+
+static Animation create_animation(std::mt19937& random, uint32_t joint_count) {
+    return Animation(create_joint_animations(random, joint_count));
+}
+
+// Quantize all keyframes like geometry converter does, but without keyframe reduction, so compressed animation is
+// sampled from the same keyframes as the raw one. Scale tracks are constant.
+static Animation create_compressed_animation(const Vector<Animation::JointAnimation>& joint_animations) {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    Vector<Animation::CompressedTrack> tracks(memory_resource);
+    Vector<uint16_t> keyframes(memory_resource);
+
+    for (const Animation::JointAnimation& joint_animation : joint_animations) {
+        Animation::CompressedTrack translation_track{};
+        translation_track.keyframe_count = static_cast<uint32_t>(joint_animation.keyframes.size());
+
+        float3 minimum = joint_animation.keyframes.front().transform.translation;
+        float3 maximum = minimum;
+
+        for (const Animation::JointKeyframe& keyframe : joint_animation.keyframes) {
+            minimum = min(minimum, keyframe.transform.translation);
+            maximum = max(maximum, keyframe.transform.translation);
+        }
+
+        for (size_t i = 0; i < 3; i++) {
+            translation_track.minimum[i] = minimum[i];
+            translation_track.extent[i] = maximum[i] - minimum[i];
+        }
+
+        for (const Animation::JointKeyframe& keyframe : joint_animation.keyframes) {
+            keyframes.push_back(static_cast<uint16_t>(std::round(keyframe.timestamp / ANIMATION_DURATION * QUANTIZED_TIMESTAMP_MAX)));
+
+            for (size_t i = 0; i < 3; i++) {
+                float normalized = (keyframe.transform.translation[i] - minimum[i]) / translation_track.extent[i];
+                keyframes.push_back(static_cast<uint16_t>(std::round(normalized * QUANTIZED_VALUE_MAX)));
+            }
+        }
+
+        Animation::CompressedTrack rotation_track{};
+        rotation_track.keyframe_count = static_cast<uint32_t>(joint_animation.keyframes.size());
+
+        for (const Animation::JointKeyframe& keyframe : joint_animation.keyframes) {
+            keyframes.push_back(static_cast<uint16_t>(std::round(keyframe.timestamp / ANIMATION_DURATION * QUANTIZED_TIMESTAMP_MAX)));
+
+            float4 rotation(keyframe.transform.rotation.x, keyframe.transform.rotation.y, keyframe.transform.rotation.z, keyframe.transform.rotation.w);
+
+            size_t largest_index = 0;
+            for (size_t i = 1; i < 4; i++) {
+                if (std::abs(rotation[i]) > std::abs(rotation[largest_index])) {
+                    largest_index = i;
+                }
+            }
+
+            // The largest component is restored assuming it's positive.
+            if (rotation[largest_index] < 0.f) {
+                rotation = -rotation;
+            }
+
+            uint16_t components[3];
+            for (size_t i = 0, j = 0; i < 4; i++) {
+                if (i != largest_index) {
+                    float normalized = (rotation[i] + ROTATION_COMPONENT_MAX) / (2.f * ROTATION_COMPONENT_MAX);
+                    components[j++] = static_cast<uint16_t>(std::round(std::clamp(normalized, 0.f, 1.f) * QUANTIZED_ROTATION_MAX));
+                }
+            }
+
+            keyframes.push_back(static_cast<uint16_t>(((largest_index >> 1) << 15) | components[0]));
+            keyframes.push_back(static_cast<uint16_t>(((largest_index & 1) << 15) | components[1]));
+            keyframes.push_back(components[2]);
+        }
+
+        Animation::CompressedTrack scale_track{};
+        scale_track.minimum[0] = 1.f;
+        scale_track.minimum[1] = 1.f;
+        scale_track.minimum[2] = 1.f;
+
+        tracks.push_back(translation_track);
+        tracks.push_back(rotation_track);
+        tracks.push_back(scale_track);
+    }
+
+    return Animation(ANIMATION_DURATION, std::move(tracks), std::move(keyframes), Vector<float>(memory_resource));
+}
+
+void run_animation_sampling_benchmark() {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+    Animation animation = create_animation(random, ANIMATION_JOINT_COUNT);
+
+    // Instances play the same animation with different time offsets, like a crowd.
+    std::uniform_real_distribution<float> offset_distribution(0.f, ANIMATION_DURATION);
+
+    Vector<float> offsets(memory_resource);
+    Vector<AnimationCursor> cursors(memory_resource);
+
+    for (size_t i = 0; i < SAMPLING_INSTANCE_COUNT; i++) {
+        offsets.push_back(offset_distribution(random));
+        cursors.emplace_back(memory_resource);
+    }
+
+    SkeletonPose skeleton_pose(memory_resource);
+
+    // Per joint sampling, which was used by animation player before `sample_pose`.
+    Vector<float4x4> joint_matrices(ANIMATION_JOINT_COUNT, memory_resource);
+
+    double joint_time = measure(SAMPLING_REPETITION_COUNT, [&] {
+        for (size_t frame = 0; frame < SAMPLING_FRAME_COUNT; frame++) {
+            for (size_t i = 0; i < SAMPLING_INSTANCE_COUNT; i++) {
+                for (uint32_t joint_index = 0; joint_index < ANIMATION_JOINT_COUNT; joint_index++) {
+                    joint_matrices[joint_index] = animation.get_joint_transform(joint_index, offsets[i] + frame * ANIMATION_FRAME_TIME);
+                }
+            }
+        }
+    });
+
+    double pose_time = measure(SAMPLING_REPETITION_COUNT, [&] {
+        for (size_t frame = 0; frame < SAMPLING_FRAME_COUNT; frame++) {
+            for (size_t i = 0; i < SAMPLING_INSTANCE_COUNT; i++) {
+                animation.sample_pose(offsets[i] + frame * ANIMATION_FRAME_TIME, skeleton_pose);
+            }
+        }
+    });
+
+    double cursor_time = measure(SAMPLING_REPETITION_COUNT, [&] {
+        for (size_t frame = 0; frame < SAMPLING_FRAME_COUNT; frame++) {
+            for (size_t i = 0; i < SAMPLING_INSTANCE_COUNT; i++) {
+                animation.sample_pose(offsets[i] + frame * ANIMATION_FRAME_TIME, skeleton_pose, &cursors[i]);
+            }
+        }
+    });
+
+    double joint_count = static_cast<double>(SAMPLING_FRAME_COUNT) * SAMPLING_INSTANCE_COUNT * ANIMATION_JOINT_COUNT;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "    " << ANIMATION_JOINT_COUNT << " joints, " << ANIMATION_KEYFRAME_COUNT << " keyframes per joint" << std::endl
+              << "    get_joint_transform      " << joint_time * 1e6 / joint_count << " ns per joint" << std::endl
+              << "    sample_pose              " << pose_time * 1e6 / joint_count << " ns per joint" << std::endl
+              << "    sample_pose with cursor  " << cursor_time * 1e6 / joint_count << " ns per joint" << std::endl;
+}
+
+void run_animation_compression_benchmark() {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+    Vector<Animation::JointAnimation> joint_animations = create_joint_animations(random, ANIMATION_JOINT_COUNT);
+
+    Animation compressed_animation = create_compressed_animation(joint_animations);
+    Animation raw_animation(std::move(joint_animations));
+
+    std::uniform_real_distribution<float> offset_distribution(0.f, ANIMATION_DURATION);
+
+    Vector<float> offsets(memory_resource);
+    Vector<AnimationCursor> cursors(memory_resource);
+
+    for (size_t i = 0; i < SAMPLING_INSTANCE_COUNT; i++) {
+        offsets.push_back(offset_distribution(random));
+        cursors.emplace_back(memory_resource);
+    }
+
+    SkeletonPose raw_pose(memory_resource);
+    SkeletonPose compressed_pose(memory_resource);
+
+    double raw_time = measure(SAMPLING_REPETITION_COUNT, [&] {
+        for (size_t frame = 0; frame < SAMPLING_FRAME_COUNT; frame++) {
+            for (size_t i = 0; i < SAMPLING_INSTANCE_COUNT; i++) {
+                raw_animation.sample_pose(offsets[i] + frame * ANIMATION_FRAME_TIME, raw_pose, &cursors[i]);
+            }
+        }
+    });
+
+    double compressed_time = measure(SAMPLING_REPETITION_COUNT, [&] {
+        for (size_t frame = 0; frame < SAMPLING_FRAME_COUNT; frame++) {
+            for (size_t i = 0; i < SAMPLING_INSTANCE_COUNT; i++) {
+                compressed_animation.sample_pose(offsets[i] + frame * ANIMATION_FRAME_TIME, compressed_pose, &cursors[i]);
+            }
+        }
+    });
+
+    // Compare poses at a timestamp between keyframes.
+    float max_error = 0.f;
+
+    raw_animation.sample_pose(1.01f, raw_pose);
+    compressed_animation.sample_pose(1.01f, compressed_pose);
+
+    for (size_t joint_index = 0; joint_index < ANIMATION_JOINT_COUNT; joint_index++) {
+        const transform& expected = raw_pose.get_joint_space_transforms()[joint_index];
+        const transform& actual = compressed_pose.get_joint_space_transforms()[joint_index];
+
+        for (size_t i = 0; i < 3; i++) {
+            max_error = std::max(max_error, std::abs(expected.translation[i] - actual.translation[i]));
+        }
+
+        // Opposite quaternions represent the same rotation.
+        float4 expected_rotation(expected.rotation.x, expected.rotation.y, expected.rotation.z, expected.rotation.w);
+        float4 actual_rotation(actual.rotation.x, actual.rotation.y, actual.rotation.z, actual.rotation.w);
+        float4 difference = dot(expected_rotation, actual_rotation) < 0.f ? expected_rotation + actual_rotation : expected_rotation - actual_rotation;
+
+        for (size_t i = 0; i < 4; i++) {
+            max_error = std::max(max_error, std::abs(difference[i]));
+        }
+    }
+
+    // Raw keyframe is a timestamp and a transform, compressed keyframe is four 16-bit values.
+    size_t raw_size = ANIMATION_JOINT_COUNT * ANIMATION_KEYFRAME_COUNT * sizeof(Animation::JointKeyframe);
+    size_t compressed_size = ANIMATION_JOINT_COUNT * (Animation::COMPRESSED_TRACK_COUNT * sizeof(Animation::CompressedTrack) +
+                                                      2 * ANIMATION_KEYFRAME_COUNT * 4 * sizeof(uint16_t));
+
+    double joint_count = static_cast<double>(SAMPLING_FRAME_COUNT) * SAMPLING_INSTANCE_COUNT * ANIMATION_JOINT_COUNT;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "    " << ANIMATION_JOINT_COUNT << " joints, " << ANIMATION_KEYFRAME_COUNT << " keyframes per joint, no keyframe reduction" << std::endl
+              << "    raw         " << raw_time * 1e6 / joint_count << " ns per joint, " << raw_size << " bytes" << std::endl
+              << "    compressed  " << compressed_time * 1e6 / joint_count << " ns per joint, " << compressed_size << " bytes" << std::endl
+              << std::scientific << std::setprecision(1)
+              << "    max error   " << max_error << std::endl;
+}
+
+// Characters sample and blend their clips and build model space matrices, like animation player does each frame. When
+// joint indices are specified, only these joints are sampled, but matrices are still built for all joints.
+static double measure_blend_tree(const Skeleton& skeleton, const Vector<SharedPtr<Animation>>& animations, size_t clip_count,
+                                 const Vector<uint32_t>* joint_indices) {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> time_distribution(0.f, ANIMATION_DURATION);
+
+    Vector<AnimationBlendTree> blend_trees(memory_resource);
+    Vector<SkeletonPose> skeleton_poses(memory_resource);
+
+    blend_trees.reserve(BLEND_TREE_CHARACTER_COUNT);
+    skeleton_poses.reserve(BLEND_TREE_CHARACTER_COUNT);
+
+    for (size_t i = 0; i < BLEND_TREE_CHARACTER_COUNT; i++) {
+        AnimationBlendTree& blend_tree = blend_trees.emplace_back(memory_resource);
+
+        for (size_t j = 0; j < clip_count; j++) {
+            uint32_t clip_index = blend_tree.add_clip(0, animations[j], 1.f + j);
+            blend_tree.set_clip_time(0, clip_index, time_distribution(random));
+        }
+
+        SkeletonPose& skeleton_pose = skeleton_poses.emplace_back(memory_resource);
+        skeleton_pose.set_bind_pose(skeleton);
+    }
+
+    return measure(BLEND_TREE_FRAME_COUNT, [&] {
+        for (size_t i = 0; i < BLEND_TREE_CHARACTER_COUNT; i++) {
+            blend_trees[i].update(ANIMATION_FRAME_TIME);
+            blend_trees[i].sample_pose(skeleton_poses[i], joint_indices);
+            skeleton_poses[i].build_model_space_matrices(skeleton);
+        }
+    });
+}
+
+void run_blend_tree_benchmark() {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+    Skeleton skeleton = create_skeleton(create_parent_joints(random, ANIMATION_JOINT_COUNT));
+
+    Vector<SharedPtr<Animation>> animations(memory_resource);
+    for (size_t i = 0; i < BLEND_TREE_CLIP_COUNT; i++) {
+        animations.push_back(allocate_shared<Animation>(memory_resource, create_animation(random, ANIMATION_JOINT_COUNT)));
+    }
+
+    double single_time = measure_blend_tree(skeleton, animations, 1, nullptr);
+    double blend_time = measure_blend_tree(skeleton, animations, BLEND_TREE_CLIP_COUNT, nullptr);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "    " << BLEND_TREE_CHARACTER_COUNT << " characters, " << ANIMATION_JOINT_COUNT << " joints" << std::endl
+              << "    1 clip    " << single_time << " ms per frame" << std::endl
+              << "    " << BLEND_TREE_CLIP_COUNT << " clips   " << blend_time << " ms per frame" << std::endl;
+}
+
+static void print_skeleton_pose_result(const char* name, const Skeleton& skeleton) {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    Vector<SkeletonPose> skeleton_poses(memory_resource);
+    skeleton_poses.reserve(SKELETON_POSE_COUNT);
+
+    for (size_t i = 0; i < SKELETON_POSE_COUNT; i++) {
+        SkeletonPose& skeleton_pose = skeleton_poses.emplace_back(memory_resource);
+        skeleton_pose.set_bind_pose(skeleton);
+
+        for (uint32_t joint_index = 0; joint_index < skeleton.get_joint_count(); joint_index++) {
+            float3 translation(distribution(random), distribution(random), distribution(random));
+            quaternion rotation = normalize(quaternion(distribution(random), distribution(random), distribution(random), distribution(random)));
+            skeleton_pose.set_joint_space_transform(joint_index, transform(translation, rotation));
+        }
+    }
+
+    double milliseconds = measure(SKELETON_POSE_REPETITION_COUNT, [&] {
+        for (SkeletonPose& skeleton_pose : skeleton_poses) {
+            skeleton_pose.build_model_space_matrices(skeleton);
+        }
+    });
+
+    std::cout << std::fixed << std::setprecision(0)
+              << "    " << std::left << std::setw(8) << name << std::right << std::setw(2) << skeleton.get_joint_count() << " joints   "
+              << milliseconds * 1e3 << " us per " << SKELETON_POSE_COUNT << " poses" << std::endl;
+}
+
+void run_skeleton_pose_benchmark() {
+    print_skeleton_pose_result("knight", create_skeleton(KNIGHT_PARENT_JOINTS, std::size(KNIGHT_PARENT_JOINTS)));
+    print_skeleton_pose_result("robot", create_skeleton(ROBOT_PARENT_JOINTS, std::size(ROBOT_PARENT_JOINTS)));
+}
+
+static void print_animation_lod_result(const char* name, const Skeleton& skeleton) {
+    MemoryResource& memory_resource = MallocMemoryResource::instance();
+
+    std::mt19937 random(1);
+
+    Vector<SharedPtr<Animation>> animations(memory_resource);
+    for (size_t i = 0; i < BLEND_TREE_CLIP_COUNT; i++) {
+        animations.push_back(allocate_shared<Animation>(memory_resource, create_animation(random, static_cast<uint32_t>(skeleton.get_joint_count()))));
+    }
+
+    double full_time = measure_blend_tree(skeleton, animations, BLEND_TREE_CLIP_COUNT, nullptr);
+    double lod_time = measure_blend_tree(skeleton, animations, BLEND_TREE_CLIP_COUNT, &skeleton.get_lod_joints());
+
+    std::cout << std::fixed << std::setprecision(0)
+              << "    " << std::left << std::setw(8) << name << std::right
+              << std::setw(2) << skeleton.get_joint_count() << " joints " << full_time * 1e3 << " us   "
+              << std::setw(2) << skeleton.get_lod_joints().size() << " LOD joints " << lod_time * 1e3 << " us" << std::endl;
+}
+
+void run_animation_lod_benchmark() {
+    std::cout << "    " << BLEND_TREE_CHARACTER_COUNT << " characters, " << BLEND_TREE_CLIP_COUNT << " clips" << std::endl;
+
+    print_animation_lod_result("knight", create_skeleton(KNIGHT_PARENT_JOINTS, std::size(KNIGHT_PARENT_JOINTS)));
+    print_animation_lod_result("robot", create_skeleton(ROBOT_PARENT_JOINTS, std::size(ROBOT_PARENT_JOINTS)));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Run the given function the given number of times and return the median duration in milliseconds. Median is less
+// sensitive than average to the outliers caused by context switches.
+template <typename Function>
+double measure(size_t repetition_count, Function&& function) {
+    std::vector<double> durations;
+    durations.reserve(repetition_count);
+
+    for (size_t i = 0; i < repetition_count; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+
+        durations.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+    }
+
+    std::sort(durations.begin(), durations.end());
+
+    return durations[durations.size() / 2];
+}
+
+// Benchmarks print their results to the standard output.
+void run_concurrent_pool_benchmark();
+void run_buddy_benchmark();
+void run_math_benchmark();
+void run_frustum_benchmark();
+void run_container_benchmark();
+void run_acceleration_structure_benchmark();
+void run_multi_view_benchmark();
+void run_animation_sampling_benchmark();
+void run_animation_compression_benchmark();
+void run_blend_tree_benchmark();
+void run_skeleton_pose_benchmark();
+void run_animation_lod_benchmark();
+void run_cpu_profiler_benchmark();
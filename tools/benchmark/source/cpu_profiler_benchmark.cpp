@@ -0,0 +1,105 @@
+#include "benchmark.h"
+
+#include <core/debug/cpu_profiler.h>
+
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+using namespace kw;
+
+static constexpr size_t PROFILER_SCOPE_COUNT = 1000000;
+static constexpr size_t PROFILER_REPETITION_COUNT = 5;
+
+// Profiler supports at most 64 threads over the lifetime of the process. Each thread count runs on fresh threads, so
+// the largest thread count is limited.
+static constexpr size_t PROFILER_MAX_THREAD_COUNT = 16;
+
+static const char* const DYNAMIC_SCOPE_NAMES[] = {
+    "Dynamic Scope A",
+    "Dynamic Scope B",
+    "Dynamic Scope C",
+    "Dynamic Scope D",
+};
+
+static void record_scopes() {
+    for (size_t i = 0; i < PROFILER_SCOPE_COUNT; i++) {
+        KW_CPU_PROFILER("Benchmark Scope");
+    }
+}
+
+static void record_dynamic_scopes() {
+    for (size_t i = 0; i < PROFILER_SCOPE_COUNT; i++) {
+        KW_CPU_PROFILER_DYNAMIC(DYNAMIC_SCOPE_NAMES[i % std::size(DYNAMIC_SCOPE_NAMES)]);
+    }
+}
+
+static void add_counter_values() {
+    for (size_t i = 0; i < PROFILER_SCOPE_COUNT; i++) {
+        KW_CPU_PROFILER_COUNTER("Benchmark Counter", 1);
+    }
+}
+
+struct ProfilerResult {
+    double scope_time;
+    double dynamic_scope_time;
+    double counter_time;
+};
+
+// Run all tests on the given number of threads at once. Each thread measures its own medians, because profiler never
+// destroys thread buffers and threads can't be created for each repetition. Return averages of those medians in
+// nanoseconds per record.
+static ProfilerResult measure_threads(size_t thread_count) {
+    std::vector<ProfilerResult> results(thread_count);
+    std::vector<std::thread> threads;
+
+    // Threads start recording together, otherwise the first threads could finish before the last ones are created.
+    std::atomic<size_t> ready_count(0);
+
+    for (size_t i = 0; i < thread_count; i++) {
+        threads.emplace_back([&, i] {
+            ready_count.fetch_add(1, std::memory_order_relaxed);
+            while (ready_count.load(std::memory_order_relaxed) < thread_count) {
+                std::this_thread::yield();
+            }
+
+            results[i].scope_time = measure(PROFILER_REPETITION_COUNT, record_scopes);
+            results[i].dynamic_scope_time = measure(PROFILER_REPETITION_COUNT, record_dynamic_scopes);
+            results[i].counter_time = measure(PROFILER_REPETITION_COUNT, add_counter_values);
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    ProfilerResult total{};
+
+    for (const ProfilerResult& result : results) {
+        total.scope_time += result.scope_time;
+        total.dynamic_scope_time += result.dynamic_scope_time;
+        total.counter_time += result.counter_time;
+    }
+
+    double scale = 1e6 / (thread_count * PROFILER_SCOPE_COUNT);
+
+    return ProfilerResult{ total.scope_time * scale, total.dynamic_scope_time * scale, total.counter_time * scale };
+}
+
+void run_cpu_profiler_benchmark() {
+    size_t max_thread_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1U), PROFILER_MAX_THREAD_COUNT);
+
+    std::cout << "    threads   scope   dynamic scope   counter (ns per record)" << std::endl;
+
+    for (size_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+        ProfilerResult result = measure_threads(thread_count);
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "    " << std::setw(7) << thread_count
+                  << "   " << std::setw(5) << result.scope_time
+                  << "   " << std::setw(13) << result.dynamic_scope_time
+                  << "   " << std::setw(7) << result.counter_time << std::endl;
+    }
+}
@@ -0,0 +1,50 @@
+#include "benchmark.h"
+
+#include <cstring>
+#include <iostream>
+
+struct Benchmark {
+    const char* name;
+    void (*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+    { "concurrent_pool",        run_concurrent_pool_benchmark        },
+    { "buddy",                  run_buddy_benchmark                  },
+    { "math",                   run_math_benchmark                   },
+    { "frustum",                run_frustum_benchmark                },
+    { "container",              run_container_benchmark              },
+    { "acceleration_structure", run_acceleration_structure_benchmark },
+    { "multi_view",             run_multi_view_benchmark             },
+    { "animation_sampling",     run_animation_sampling_benchmark     },
+    { "animation_compression",  run_animation_compression_benchmark  },
+    { "blend_tree",             run_blend_tree_benchmark             },
+    { "skeleton_pose",          run_skeleton_pose_benchmark          },
+    { "animation_lod",          run_animation_lod_benchmark          },
+    { "cpu_profiler",           run_cpu_profiler_benchmark           },
+};
+
+int main(int argc, char* argv[]) {
+    // Optional argument is the name of a benchmark to run, all benchmarks are run otherwise.
+    bool is_found = false;
+
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        if (argc < 2 || std::strcmp(argv[1], benchmark.name) == 0) {
+            std::cout << benchmark.name << ":" << std::endl;
+            benchmark.run();
+            is_found = true;
+        }
+    }
+
+    if (!is_found) {
+        std::cout << "Unknown benchmark \"" << argv[1] << "\". Available benchmarks:" << std::endl;
+
+        for (const Benchmark& benchmark : BENCHMARKS) {
+            std::cout << "    " << benchmark.name << std::endl;
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include "benchmark.h"
+
+#include <core/math/aabbox.h>
+#include <core/math/float4x4.h>
+#include <core/math/frustum.h>
+#include <core/math/transform.h>
+
+#include <bitset>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace kw;
+
+static constexpr size_t MATH_ITEM_COUNT = 1 << 16;
+static constexpr size_t MATH_REPETITION_COUNT = 20;
+
+static constexpr size_t FRUSTUM_BOX_COUNTS[] = { 10000, 100000, 1000000 };
+static constexpr size_t FRUSTUM_REPETITION_COUNT = 20;
+
+// Print the median time of the given function per item. The function must write its results to memory, so the
+// compiler can't discard the computations.
+template <typename Function>
+static void print_math_result(const char* name, Function&& function) {
+    double milliseconds = measure(MATH_REPETITION_COUNT, function);
+
+    std::cout << "    " << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(2)
+              << milliseconds * 1e6 / MATH_ITEM_COUNT << " ns" << std::endl;
+}
+
+void run_math_benchmark() {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-2.f, 2.f);
+
+    std::vector<float4x4> matrices(MATH_ITEM_COUNT + 1);
+    std::vector<float4> vectors(MATH_ITEM_COUNT);
+    std::vector<quaternion> quaternions(MATH_ITEM_COUNT + 1);
+    std::vector<transform> transforms(MATH_ITEM_COUNT + 1);
+    std::vector<aabbox> bounds(MATH_ITEM_COUNT);
+
+    for (size_t i = 0; i <= MATH_ITEM_COUNT; i++) {
+        quaternion rotation = normalize(quaternion(distribution(random), distribution(random), distribution(random), distribution(random)));
+        float3 translation(distribution(random), distribution(random), distribution(random));
+        float3 scale(1.f + distribution(random) * 0.2f, 1.f + distribution(random) * 0.2f, 1.f + distribution(random) * 0.2f);
+
+        quaternions[i] = rotation;
+        transforms[i] = transform(translation, rotation, scale);
+        matrices[i] = float4x4(transforms[i]);
+
+        if (i < MATH_ITEM_COUNT) {
+            vectors[i] = float4(translation, 1.f);
+            bounds[i] = aabbox(translation, scale);
+        }
+    }
+
+    std::vector<float4x4> matrix_results(MATH_ITEM_COUNT);
+    std::vector<float4> vector_results(MATH_ITEM_COUNT);
+    std::vector<float> float_results(MATH_ITEM_COUNT);
+    std::vector<quaternion> quaternion_results(MATH_ITEM_COUNT);
+    std::vector<transform> transform_results(MATH_ITEM_COUNT);
+    std::vector<aabbox> bounds_results(MATH_ITEM_COUNT);
+
+#ifdef KW_SIMD
+    std::cout << "    SIMD path, define KW_MATH_SCALAR to measure the scalar path" << std::endl;
+#else
+    std::cout << "    Scalar path" << std::endl;
+#endif
+
+    print_math_result("float4x4 * float4x4", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            matrix_results[i] = matrices[i] * matrices[i + 1];
+        }
+    });
+
+    print_math_result("float4 * float4x4", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            vector_results[i] = vectors[i] * matrices[i];
+        }
+    });
+
+    print_math_result("dot(float4)", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            float_results[i] = dot(vectors[i], vectors[MATH_ITEM_COUNT - 1 - i]);
+        }
+    });
+
+    print_math_result("normalize(float4)", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            vector_results[i] = normalize(vectors[i]);
+        }
+    });
+
+    print_math_result("lerp(float4)", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            vector_results[i] = lerp(vectors[i], vectors[MATH_ITEM_COUNT - 1 - i], 0.3f);
+        }
+    });
+
+    print_math_result("transpose(float4x4)", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            matrix_results[i] = transpose(matrices[i]);
+        }
+    });
+
+    print_math_result("inverse(float4x4)", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            matrix_results[i] = inverse(matrices[i]);
+        }
+    });
+
+    print_math_result("quaternion * quaternion", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            quaternion_results[i] = quaternions[i] * quaternions[i + 1];
+        }
+    });
+
+    print_math_result("slerp(quaternion)", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            quaternion_results[i] = slerp(quaternions[i], quaternions[i + 1], 0.3f);
+        }
+    });
+
+    print_math_result("transform * transform", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            transform_results[i] = transforms[i] * transforms[i + 1];
+        }
+    });
+
+    print_math_result("transform * transform[]", [&] {
+        multiply(transforms.data(), transforms[MATH_ITEM_COUNT], transform_results.data(), MATH_ITEM_COUNT);
+    });
+
+    print_math_result("aabbox * float4x4", [&] {
+        for (size_t i = 0; i < MATH_ITEM_COUNT; i++) {
+            bounds_results[i] = bounds[i] * matrices[i];
+        }
+    });
+}
+
+static void run_frustum(size_t box_count) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position_distribution(-100.f, 100.f);
+    std::uniform_real_distribution<float> extent_distribution(0.1f, 2.f);
+
+    std::vector<aabbox> bounds(box_count);
+
+    std::vector<float> center_x(box_count);
+    std::vector<float> center_y(box_count);
+    std::vector<float> center_z(box_count);
+    std::vector<float> extent_x(box_count);
+    std::vector<float> extent_y(box_count);
+    std::vector<float> extent_z(box_count);
+
+    for (size_t i = 0; i < box_count; i++) {
+        bounds[i] = aabbox(float3(position_distribution(random), position_distribution(random), position_distribution(random)),
+                           float3(extent_distribution(random), extent_distribution(random), extent_distribution(random)));
+
+        center_x[i] = bounds[i].center.x;
+        center_y[i] = bounds[i].center.y;
+        center_z[i] = bounds[i].center.z;
+        extent_x[i] = bounds[i].extent.x;
+        extent_y[i] = bounds[i].extent.y;
+        extent_z[i] = bounds[i].extent.z;
+    }
+
+    frustum frustum(float4x4::look_at_lh(float3(), float3(0.f, 0.f, 1.f), float3(0.f, 1.f, 0.f)) *
+                    float4x4::perspective_lh(1.2f, 16.f / 9.f, 0.1f, 100.f));
+
+    std::vector<uint64_t> intersect_mask((box_count + 63) / 64);
+    std::vector<uint64_t> inside_mask((box_count + 63) / 64);
+
+    double single_time = measure(FRUSTUM_REPETITION_COUNT, [&] {
+        std::fill(intersect_mask.begin(), intersect_mask.end(), 0);
+
+        for (size_t i = 0; i < box_count; i++) {
+            if (intersect(bounds[i], frustum)) {
+                intersect_mask[i / 64] |= 1ull << (i % 64);
+            }
+        }
+    });
+
+    size_t visible_count = 0;
+    for (uint64_t mask : intersect_mask) {
+        visible_count += std::bitset<64>(mask).count();
+    }
+
+    double batch_time = measure(FRUSTUM_REPETITION_COUNT, [&] {
+        intersect(center_x.data(), center_y.data(), center_z.data(), extent_x.data(), extent_y.data(), extent_z.data(),
+                  box_count, frustum, intersect_mask.data());
+    });
+
+    double batch_inside_time = measure(FRUSTUM_REPETITION_COUNT, [&] {
+        intersect(center_x.data(), center_y.data(), center_z.data(), extent_x.data(), extent_y.data(), extent_z.data(),
+                  box_count, frustum, intersect_mask.data(), inside_mask.data());
+    });
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "    " << visible_count << " of " << box_count << " boxes are visible" << std::endl
+              << "    single box      " << single_time * 1e6 / box_count << " ns per box" << std::endl
+              << "    batch           " << batch_time * 1e6 / box_count << " ns per box" << std::endl
+              << "    batch + inside  " << batch_inside_time * 1e6 / box_count << " ns per box" << std::endl;
+}
+
+void run_frustum_benchmark() {
+    for (size_t box_count : FRUSTUM_BOX_COUNTS) {
+        run_frustum(box_count);
+    }
+}
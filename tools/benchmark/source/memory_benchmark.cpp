@@ -0,0 +1,270 @@
+#include "benchmark.h"
+
+#include <core/memory/buddy_memory_resource.h>
+#include <core/memory/concurrent_paged_pool_memory_resource.h>
+#include <core/memory/malloc_memory_resource.h>
+
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+
+using namespace kw;
+
+static constexpr size_t POOL_ITEM_SIZE = 64;
+static constexpr size_t POOL_BATCH_SIZE = 64;
+static constexpr size_t POOL_ITERATION_COUNT = 20000;
+static constexpr size_t POOL_REPETITION_COUNT = 5;
+static constexpr size_t POOL_CROSS_THREAD_COUNT = 8;
+
+static constexpr size_t BUDDY_ROOT_SIZE_LOG2 = 26;
+static constexpr size_t BUDDY_LEAF_SIZE_LOG2 = 6;
+static constexpr size_t BUDDY_OPERATION_COUNT = 2000000;
+static constexpr size_t BUDDY_REPETITION_COUNT = 5;
+static constexpr size_t BUDDY_SMALL_SIZE = 4096;
+static constexpr size_t BUDDY_LARGE_SIZE = 1 << 18;
+static constexpr size_t BUDDY_REPORT_COUNT = 8;
+
+// Allocate a batch of items, write to each of them and deallocate them. Items are deallocated in the allocation order,
+// so the free list doesn't return to the same state after each batch.
+static void allocate_batches(MemoryResource& memory_resource) {
+    void* items[POOL_BATCH_SIZE];
+
+    for (size_t iteration = 0; iteration < POOL_ITERATION_COUNT; iteration++) {
+        for (size_t i = 0; i < POOL_BATCH_SIZE; i++) {
+            items[i] = memory_resource.allocate(POOL_ITEM_SIZE, alignof(size_t));
+            *static_cast<size_t*>(items[i]) = i;
+        }
+
+        for (size_t i = 0; i < POOL_BATCH_SIZE; i++) {
+            memory_resource.deallocate(items[i]);
+        }
+    }
+}
+
+// Same as `allocate_batches`, but returns each batch to the pool with a single atomic operation.
+static void allocate_batches_bulk(ConcurrentPagedPoolMemoryResource& memory_resource) {
+    void* items[POOL_BATCH_SIZE];
+
+    for (size_t iteration = 0; iteration < POOL_ITERATION_COUNT; iteration++) {
+        for (size_t i = 0; i < POOL_BATCH_SIZE; i++) {
+            items[i] = memory_resource.allocate(POOL_ITEM_SIZE, alignof(size_t));
+            *static_cast<size_t*>(items[i]) = i;
+        }
+
+        memory_resource.deallocate(items, POOL_BATCH_SIZE);
+    }
+}
+
+// Run the given function on the given number of threads at once. Return nanoseconds per allocation.
+template <typename Function>
+static double measure_threads(size_t thread_count, Function&& function) {
+    double milliseconds = measure(POOL_REPETITION_COUNT, [&] {
+        std::vector<std::thread> threads;
+
+        for (size_t i = 0; i < thread_count; i++) {
+            threads.emplace_back(function);
+        }
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+
+    return milliseconds * 1e6 / (thread_count * POOL_ITERATION_COUNT * POOL_BATCH_SIZE);
+}
+
+// A batch of items handed from one thread to the next one.
+struct alignas(64) PoolMailbox {
+    std::atomic<bool> is_full{ false };
+    void* items[POOL_BATCH_SIZE];
+};
+
+// Deallocate the items in the given mailbox if there are any.
+static void drain_mailbox(MemoryResource& memory_resource, PoolMailbox& mailbox) {
+    if (mailbox.is_full.load(std::memory_order_acquire)) {
+        for (void* item : mailbox.items) {
+            memory_resource.deallocate(item);
+        }
+
+        mailbox.is_full.store(false, std::memory_order_release);
+    }
+}
+
+// Same as `allocate_batches`, but threads are arranged in a ring and each batch is deallocated by the next thread.
+// Return nanoseconds per allocation.
+static double measure_cross_thread(size_t thread_count, MemoryResource& memory_resource) {
+    double milliseconds = measure(POOL_REPETITION_COUNT, [&] {
+        std::unique_ptr<PoolMailbox[]> mailboxes(new PoolMailbox[thread_count]);
+        std::atomic<size_t> finished_count{ 0 };
+
+        std::vector<std::thread> threads;
+
+        for (size_t thread_index = 0; thread_index < thread_count; thread_index++) {
+            threads.emplace_back([&, thread_index] {
+                PoolMailbox& inbox = mailboxes[thread_index];
+                PoolMailbox& outbox = mailboxes[(thread_index + 1) % thread_count];
+
+                void* items[POOL_BATCH_SIZE];
+
+                for (size_t iteration = 0; iteration < POOL_ITERATION_COUNT; iteration++) {
+                    for (size_t i = 0; i < POOL_BATCH_SIZE; i++) {
+                        items[i] = memory_resource.allocate(POOL_ITEM_SIZE, alignof(size_t));
+                        *static_cast<size_t*>(items[i]) = i;
+                    }
+
+                    // Keep draining own inbox while waiting, otherwise all threads could wait for each other.
+                    while (outbox.is_full.load(std::memory_order_acquire)) {
+                        drain_mailbox(memory_resource, inbox);
+                        std::this_thread::yield();
+                    }
+
+                    std::copy(std::begin(items), std::end(items), outbox.items);
+                    outbox.is_full.store(true, std::memory_order_release);
+
+                    drain_mailbox(memory_resource, inbox);
+                }
+
+                finished_count.fetch_add(1, std::memory_order_acq_rel);
+
+                // The previous thread may still be sending batches.
+                while (finished_count.load(std::memory_order_acquire) < thread_count) {
+                    drain_mailbox(memory_resource, inbox);
+                    std::this_thread::yield();
+                }
+            });
+        }
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        for (size_t i = 0; i < thread_count; i++) {
+            drain_mailbox(memory_resource, mailboxes[i]);
+        }
+    });
+
+    return milliseconds * 1e6 / (thread_count * POOL_ITERATION_COUNT * POOL_BATCH_SIZE);
+}
+
+void run_concurrent_pool_benchmark() {
+    MallocMemoryResource& malloc_memory_resource = MallocMemoryResource::instance();
+
+    size_t max_thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+
+    std::cout << "    threads   malloc   pool   pool bulk (ns per allocation)" << std::endl;
+
+    for (size_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+        ConcurrentPagedPoolMemoryResource pool_memory_resource(malloc_memory_resource, POOL_ITEM_SIZE, 1024);
+
+        double malloc_time = measure_threads(thread_count, [&] {
+            allocate_batches(malloc_memory_resource);
+        });
+
+        double pool_time = measure_threads(thread_count, [&] {
+            allocate_batches(pool_memory_resource);
+        });
+
+        double pool_bulk_time = measure_threads(thread_count, [&] {
+            allocate_batches_bulk(pool_memory_resource);
+        });
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "    " << std::setw(7) << thread_count
+                  << "   " << std::setw(6) << malloc_time
+                  << "   " << std::setw(4) << pool_time
+                  << "   " << std::setw(9) << pool_bulk_time << std::endl;
+    }
+
+    // Thread count is fixed, so the cross thread run stresses the free list even on machines with few cores.
+    ConcurrentPagedPoolMemoryResource pool_memory_resource(malloc_memory_resource, POOL_ITEM_SIZE, 1024);
+
+    double malloc_time = measure_cross_thread(POOL_CROSS_THREAD_COUNT, malloc_memory_resource);
+    double pool_time = measure_cross_thread(POOL_CROSS_THREAD_COUNT, pool_memory_resource);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "    " << POOL_CROSS_THREAD_COUNT << " threads, deallocated on another thread: malloc "
+              << malloc_time << " ns, pool " << pool_time << " ns per allocation" << std::endl;
+}
+
+// Randomly allocate, reallocate and deallocate with the same seed, so all memory resources get the same operations.
+// Most sizes are small, some are large to fragment the memory. `report` is called `BUDDY_REPORT_COUNT` times at even
+// intervals with the number of performed operations. Return the number of in place reallocations.
+template <typename Function>
+static size_t allocate_randomly(MemoryResource& memory_resource, Function&& report) {
+    std::mt19937 random(1);
+
+    std::vector<void*> allocations;
+    size_t in_place_count = 0;
+
+    for (size_t i = 0; i < BUDDY_OPERATION_COUNT; i++) {
+        uint32_t operation = random() % 3;
+
+        if (operation == 0 || allocations.empty()) {
+            size_t size = random() % 50 == 0 ? 1 + random() % BUDDY_LARGE_SIZE : 1 + random() % BUDDY_SMALL_SIZE;
+
+            void* memory = memory_resource.allocate(size, 8);
+            if (memory != nullptr) {
+                allocations.push_back(memory);
+            }
+        } else if (operation == 1) {
+            size_t index = random() % allocations.size();
+
+            memory_resource.deallocate(allocations[index]);
+
+            allocations[index] = allocations.back();
+            allocations.pop_back();
+        } else {
+            void*& allocation = allocations[random() % allocations.size()];
+
+            void* memory = memory_resource.reallocate(allocation, 1 + random() % 8192, 8);
+            if (memory != nullptr) {
+                in_place_count += memory == allocation;
+                allocation = memory;
+            }
+        }
+
+        if ((i + 1) % (BUDDY_OPERATION_COUNT / BUDDY_REPORT_COUNT) == 0) {
+            report(i + 1);
+        }
+    }
+
+    for (void* allocation : allocations) {
+        memory_resource.deallocate(allocation);
+    }
+
+    return in_place_count;
+}
+
+void run_buddy_benchmark() {
+    MallocMemoryResource& malloc_memory_resource = MallocMemoryResource::instance();
+
+    size_t malloc_in_place_count = 0;
+    double malloc_time = measure(BUDDY_REPETITION_COUNT, [&] {
+        malloc_in_place_count = allocate_randomly(malloc_memory_resource, [](size_t) {});
+    });
+
+    size_t buddy_in_place_count = 0;
+    double buddy_time = measure(BUDDY_REPETITION_COUNT, [&] {
+        BuddyMemoryResource buddy_memory_resource(malloc_memory_resource, BUDDY_ROOT_SIZE_LOG2, BUDDY_LEAF_SIZE_LOG2);
+        buddy_in_place_count = allocate_randomly(buddy_memory_resource, [](size_t) {});
+    });
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "    malloc " << malloc_time * 1e6 / BUDDY_OPERATION_COUNT << " ns per operation, "
+              << malloc_in_place_count << " in place reallocations" << std::endl
+              << "    buddy  " << buddy_time * 1e6 / BUDDY_OPERATION_COUNT << " ns per operation, "
+              << buddy_in_place_count << " in place reallocations" << std::endl;
+
+    // Fragmentation is reported from a separate untimed run, because walking the free lists is slow.
+    std::cout << "    operations   largest free   free below " << BUDDY_LARGE_SIZE / 1024 << " KiB (KiB)" << std::endl;
+
+    BuddyMemoryResource buddy_memory_resource(malloc_memory_resource, BUDDY_ROOT_SIZE_LOG2, BUDDY_LEAF_SIZE_LOG2);
+    allocate_randomly(buddy_memory_resource, [&](size_t operation_count) {
+        std::cout << "    " << std::setw(10) << operation_count
+                  << "   " << std::setw(12) << buddy_memory_resource.get_largest_free_size() / 1024
+                  << "   " << std::setw(21) << buddy_memory_resource.get_free_size_below(BUDDY_LARGE_SIZE) / 1024 << std::endl;
+    });
+}
@@ -7,6 +7,8 @@
 #include <core/math/transform.h>
 #include <core/utils/enum_utils.h>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -61,6 +63,21 @@ struct Animation {
     std::vector<JointAnimation> joint_animations;
 };
 
+// See `Animation::CompressedTrack`.
+struct CompressedTrack {
+    uint32_t keyframe_count;
+    bool is_raw;
+    float minimum[4];
+    float extent[3];
+};
+
+struct CompressedAnimation {
+    float duration;
+    std::vector<CompressedTrack> tracks;
+    std::vector<uint16_t> keyframes;
+    std::vector<float> raw_values;
+};
+
 enum class Attributes {
     NONE       = 0,
     POSITION   = 1 << 0,
@@ -149,6 +166,17 @@ static Animation::JointKeyframe swap_le(Animation::JointKeyframe keyframe) {
 
 constexpr uint32_t KWG_SIGNATURE = ' GWK';
 constexpr uint32_t KWA_SIGNATURE = ' AWK';
+constexpr uint32_t KWA_COMPRESSED_SIGNATURE = 'CAWK';
+
+// Maximum error of compressed translation, rotation and scale components.
+constexpr float TRANSLATION_TOLERANCE = 1e-4f;
+constexpr float ROTATION_TOLERANCE = 1e-4f;
+constexpr float SCALE_TOLERANCE = 1e-4f;
+
+constexpr float QUANTIZED_TIMESTAMP_MAX = 65535.f;
+constexpr float QUANTIZED_VALUE_MAX = 65535.f;
+constexpr float QUANTIZED_ROTATION_MAX = 32767.f;
+constexpr float ROTATION_COMPONENT_MAX = 0.70710678f;
 
 static bool save_result_geometry(const char* path) {
     BinaryWriter writer(path);
@@ -217,6 +245,305 @@ static bool save_result_animation(const char* path) {
     return true;
 }
 
+static void encode_value(const float4& value, const CompressedTrack& track, bool is_rotation, uint16_t* output) {
+    if (is_rotation) {
+        size_t largest_index = 0;
+        for (size_t i = 1; i < 4; i++) {
+            if (std::abs(value[i]) > std::abs(value[largest_index])) {
+                largest_index = i;
+            }
+        }
+
+        // The largest component is restored from the other three assuming it's positive.
+        float4 rotation = value[largest_index] < 0.f ? -value : value;
+
+        uint16_t components[3];
+        for (size_t i = 0, j = 0; i < 4; i++) {
+            if (i != largest_index) {
+                float normalized = (rotation[i] + ROTATION_COMPONENT_MAX) / (2.f * ROTATION_COMPONENT_MAX);
+                components[j++] = static_cast<uint16_t>(std::round(std::clamp(normalized, 0.f, 1.f) * QUANTIZED_ROTATION_MAX));
+            }
+        }
+
+        output[0] = static_cast<uint16_t>(((largest_index >> 1) << 15) | components[0]);
+        output[1] = static_cast<uint16_t>(((largest_index & 1) << 15) | components[1]);
+        output[2] = components[2];
+    } else {
+        for (size_t i = 0; i < 3; i++) {
+            float normalized = track.extent[i] > 0.f ? (value[i] - track.minimum[i]) / track.extent[i] : 0.f;
+            output[i] = static_cast<uint16_t>(std::round(std::clamp(normalized, 0.f, 1.f) * QUANTIZED_VALUE_MAX));
+        }
+    }
+}
+
+// Must match how `Animation::get_compressed_joint_keyframes` decodes keyframes in `render/animation/animation.cpp`.
+static float4 decode_value(const uint16_t* input, const CompressedTrack& track, bool is_rotation) {
+    if (is_rotation) {
+        float a = (input[0] & 0x7FFF) * (2.f * ROTATION_COMPONENT_MAX / QUANTIZED_ROTATION_MAX) - ROTATION_COMPONENT_MAX;
+        float b = (input[1] & 0x7FFF) * (2.f * ROTATION_COMPONENT_MAX / QUANTIZED_ROTATION_MAX) - ROTATION_COMPONENT_MAX;
+        float c = (input[2] & 0x7FFF) * (2.f * ROTATION_COMPONENT_MAX / QUANTIZED_ROTATION_MAX) - ROTATION_COMPONENT_MAX;
+        float largest = std::sqrt(std::max(1.f - a * a - b * b - c * c, 0.f));
+
+        switch (((input[0] >> 15) << 1) | (input[1] >> 15)) {
+        case 0:
+            return float4(largest, a, b, c);
+        case 1:
+            return float4(a, largest, b, c);
+        case 2:
+            return float4(a, b, largest, c);
+        default:
+            return float4(a, b, c, largest);
+        }
+    } else {
+        return float4(track.minimum[0] + input[0] * (track.extent[0] / QUANTIZED_VALUE_MAX),
+                      track.minimum[1] + input[1] * (track.extent[1] / QUANTIZED_VALUE_MAX),
+                      track.minimum[2] + input[2] * (track.extent[2] / QUANTIZED_VALUE_MAX),
+                      0.f);
+    }
+}
+
+// Must match `interpolate_compressed_joint` in `render/animation/animation.cpp`.
+static float4 interpolate_value(const float4& from, float4 to, float factor, bool is_rotation) {
+    if (is_rotation) {
+        if (dot(from, to) < 0.f) {
+            to = -to;
+        }
+        return normalize(lerp(from, to, factor));
+    }
+    return lerp(from, to, factor);
+}
+
+static float compute_error(const float4& expected, const float4& actual, bool is_rotation) {
+    // Opposite quaternions represent the same rotation.
+    float4 difference = is_rotation && dot(expected, actual) < 0.f ? expected + actual : expected - actual;
+    return std::max(std::max(std::abs(difference.x), std::abs(difference.y)), std::max(std::abs(difference.z), std::abs(difference.w)));
+}
+
+// Tracks that can't be quantized within the given tolerance store raw values instead, so one wide translation range
+// doesn't leave the whole animation uncompressed.
+static void compress_track(const std::vector<float>& timestamps, const std::vector<float4>& values, float tolerance, bool is_rotation,
+                           CompressedAnimation& compressed_animation) {
+    CompressedTrack track{};
+
+    // Tracks that don't change store only their value.
+    bool is_constant = true;
+    for (const float4& value : values) {
+        if (compute_error(values.front(), value, is_rotation) > tolerance) {
+            is_constant = false;
+            break;
+        }
+    }
+
+    if (is_constant) {
+        for (size_t i = 0; i < 4; i++) {
+            track.minimum[i] = values.front()[i];
+        }
+
+        compressed_animation.tracks.push_back(track);
+        return;
+    }
+
+    if (!is_rotation) {
+        float4 minimum = values.front();
+        float4 maximum = values.front();
+
+        for (const float4& value : values) {
+            minimum = min(minimum, value);
+            maximum = max(maximum, value);
+        }
+
+        for (size_t i = 0; i < 3; i++) {
+            track.minimum[i] = minimum[i];
+            track.extent[i] = maximum[i] - minimum[i];
+        }
+    }
+
+    // The quantization step of a wide translation range may exceed the tolerance.
+    for (size_t i = 0; i < values.size() && !track.is_raw; i++) {
+        uint16_t value[3];
+        encode_value(values[i], track, is_rotation, value);
+        track.is_raw = compute_error(values[i], decode_value(value, track, is_rotation), is_rotation) > tolerance;
+    }
+
+    // Keyframes are reduced after quantization, so the error of the reduced keyframes includes the quantization error.
+    std::vector<uint16_t> keyframes;
+    std::vector<float4> keyframe_values;
+    std::vector<float4> decoded_values;
+
+    for (size_t i = 0; i < timestamps.size(); i++) {
+        uint16_t keyframe[4];
+
+        float normalized = timestamps[i] / compressed_animation.duration;
+        keyframe[0] = static_cast<uint16_t>(std::round(std::clamp(normalized, 0.f, 1.f) * QUANTIZED_TIMESTAMP_MAX));
+
+        float4 decoded_value = values[i];
+
+        // Keyframes of raw tracks store only timestamps.
+        if (track.is_raw) {
+            std::fill(keyframe + 1, keyframe + 4, 0);
+        } else {
+            encode_value(values[i], track, is_rotation, keyframe + 1);
+            decoded_value = decode_value(keyframe + 1, track, is_rotation);
+        }
+
+        // Interpolation divides by the difference of adjacent timestamps, so keyframes closer than the timestamp
+        // quantization step are merged and the later one wins.
+        if (!keyframes.empty() && keyframes[keyframes.size() - 4] == keyframe[0]) {
+            keyframes.resize(keyframes.size() - 4);
+            keyframe_values.pop_back();
+            decoded_values.pop_back();
+        }
+
+        keyframes.insert(keyframes.end(), keyframe, keyframe + 4);
+        keyframe_values.push_back(values[i]);
+        decoded_values.push_back(decoded_value);
+    }
+
+    size_t keyframe_count = decoded_values.size();
+
+    // Greedily extend each segment while all the skipped keyframes are interpolated within the tolerance.
+    std::vector<size_t> kept_keyframes{ 0 };
+
+    size_t anchor = 0;
+    for (size_t end = anchor + 2; end < keyframe_count; end++) {
+        float anchor_timestamp = keyframes[anchor * 4];
+        float end_timestamp = keyframes[end * 4];
+
+        bool is_within_tolerance = true;
+        for (size_t i = anchor + 1; i < end && is_within_tolerance; i++) {
+            float factor = (keyframes[i * 4] - anchor_timestamp) / (end_timestamp - anchor_timestamp);
+            float4 value = interpolate_value(decoded_values[anchor], decoded_values[end], factor, is_rotation);
+            is_within_tolerance = compute_error(keyframe_values[i], value, is_rotation) <= tolerance;
+        }
+
+        if (!is_within_tolerance) {
+            anchor = end - 1;
+            kept_keyframes.push_back(anchor);
+        }
+    }
+
+    if (keyframe_count > 1) {
+        kept_keyframes.push_back(keyframe_count - 1);
+    }
+
+    for (size_t keyframe : kept_keyframes) {
+        compressed_animation.keyframes.insert(compressed_animation.keyframes.end(), keyframes.begin() + keyframe * 4, keyframes.begin() + keyframe * 4 + 4);
+
+        if (track.is_raw) {
+            for (size_t i = 0; i < 4; i++) {
+                compressed_animation.raw_values.push_back(keyframe_values[keyframe][i]);
+            }
+        }
+    }
+
+    track.keyframe_count = static_cast<uint32_t>(kept_keyframes.size());
+
+    compressed_animation.tracks.push_back(track);
+}
+
+// Return false if the animation can't be compressed, i.e. it has zero duration.
+static bool compress_result_animation(CompressedAnimation& compressed_animation) {
+    compressed_animation = CompressedAnimation{};
+
+    for (const Animation::JointAnimation& joint_animation : result_animation.joint_animations) {
+        if (!joint_animation.keyframes.empty()) {
+            compressed_animation.duration = std::max(compressed_animation.duration, joint_animation.keyframes.back().timestamp);
+        }
+    }
+
+    // Compressed timestamps are relative to the duration.
+    if (!(compressed_animation.duration > 0.f) || !std::isfinite(compressed_animation.duration)) {
+        return false;
+    }
+
+    std::vector<float> timestamps;
+    std::vector<float4> translations;
+    std::vector<float4> rotations;
+    std::vector<float4> scales;
+
+    for (const Animation::JointAnimation& joint_animation : result_animation.joint_animations) {
+        timestamps.clear();
+        translations.clear();
+        rotations.clear();
+        scales.clear();
+
+        for (const Animation::JointKeyframe& keyframe : joint_animation.keyframes) {
+            timestamps.push_back(keyframe.timestamp);
+            translations.push_back(float4(keyframe.transform.translation, 0.f));
+            rotations.push_back(float4(keyframe.transform.rotation));
+            scales.push_back(float4(keyframe.transform.scale, 0.f));
+        }
+
+        compress_track(timestamps, translations, TRANSLATION_TOLERANCE, false, compressed_animation);
+        compress_track(timestamps, rotations, ROTATION_TOLERANCE, true, compressed_animation);
+        compress_track(timestamps, scales, SCALE_TOLERANCE, false, compressed_animation);
+    }
+
+    return true;
+}
+
+static bool save_result_animation_compressed(const char* path) {
+    CompressedAnimation compressed_animation;
+    if (!compress_result_animation(compressed_animation)) {
+        std::cout << "Animation \"" << path << "\" has zero duration and can't be compressed, saving it uncompressed." << std::endl;
+        return save_result_animation(path);
+    }
+
+    BinaryWriter writer(path);
+
+    if (!writer) {
+        std::cout << "Failed to open output animation file \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    writer.write_le<uint32_t>(KWA_COMPRESSED_SIGNATURE);
+    writer.write_le<uint32_t>(result_animation.joint_animations.size());
+    writer.write_le<uint32_t>(compressed_animation.keyframes.size() / 4);
+    writer.write_le<float>(compressed_animation.duration);
+
+    for (CompressedTrack& track : compressed_animation.tracks) {
+        writer.write_le<uint32_t>(track.keyframe_count);
+        writer.write_le<uint32_t>(track.is_raw ? 1 : 0);
+        writer.write_le<float>(track.minimum, std::size(track.minimum));
+        writer.write_le<float>(track.extent, std::size(track.extent));
+    }
+
+    writer.write_le<uint16_t>(compressed_animation.keyframes.data(), compressed_animation.keyframes.size());
+    writer.write_le<float>(compressed_animation.raw_values.data(), compressed_animation.raw_values.size());
+
+    if (!writer) {
+        std::cout << "Failed to write to output animation file \"" << path << "\"." << std::endl;
+        return false;
+    }
+
+    size_t raw_size = sizeof(uint32_t) * 2;
+    size_t raw_keyframe_count = 0;
+    for (const Animation::JointAnimation& joint_animation : result_animation.joint_animations) {
+        raw_size += sizeof(uint32_t) + sizeof(Animation::JointKeyframe) * joint_animation.keyframes.size();
+        raw_keyframe_count += joint_animation.keyframes.size() * 3;
+    }
+
+    size_t compressed_size = sizeof(uint32_t) * 3 + sizeof(float) +
+                             (sizeof(uint32_t) * 2 + sizeof(float) * 7) * compressed_animation.tracks.size() +
+                             sizeof(uint16_t) * compressed_animation.keyframes.size() +
+                             sizeof(float) * compressed_animation.raw_values.size();
+
+    size_t constant_track_count = std::count_if(compressed_animation.tracks.begin(), compressed_animation.tracks.end(), [](const CompressedTrack& track) {
+        return track.keyframe_count == 0;
+    });
+
+    size_t raw_track_count = std::count_if(compressed_animation.tracks.begin(), compressed_animation.tracks.end(), [](const CompressedTrack& track) {
+        return track.is_raw;
+    });
+
+    std::cout << "Compressed animation \"" << path << "\": " << raw_size << " -> " << compressed_size << " bytes, "
+              << raw_keyframe_count << " -> " << compressed_animation.keyframes.size() / 4 << " track keyframes, "
+              << constant_track_count << " of " << compressed_animation.tracks.size() << " tracks are constant, "
+              << raw_track_count << " are raw." << std::endl;
+
+    return true;
+}
+
 static transform sample_animation(const std::map<float, transform>& animation, float timestamp) {
     transform result;
 
@@ -768,6 +1095,9 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Optional third argument enables compressed animation output.
+    bool compress_animation = argc > 3 && std::string(argv[3]) == "--compress";
+
     filename = argv[1];
 
     gltf.SetImageLoader(image_loader_dummy, nullptr);
@@ -820,8 +1150,14 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        if (!save_result_animation(argv[2])) {
-            return 1;
+        if (compress_animation) {
+            if (!save_result_animation_compressed(argv[2])) {
+                return 1;
+            }
+        } else {
+            if (!save_result_animation(argv[2])) {
+                return 1;
+            }
         }
     } else {
         if (!save_result_geometry(argv[2])) {